@@ -1,5 +1,5 @@
-// const socket = new WebSocket(`ws://192.168.1.133:81`);
-const socket = new WebSocket(`ws://${window.location.host}:81`);
+// const socket = new WebSocket(`ws://192.168.1.133/ws`);
+const socket = new WebSocket(`ws://${window.location.host}/ws`);
 
 const data = {};
 const on_data = [];
@@ -0,0 +1,68 @@
+/*******************************************************************
+ * Analog.h
+ *
+ * EBC analog inputs, continuous (DMA) ADC acquisition
+ *
+ *******************************************************************/
+#ifndef ANALOG_HEADER
+#define ANALOG_HEADER
+
+#include <stdint.h>
+
+/*******************************************************************
+ * JSON and Websocket keys
+ *******************************************************************/
+#define JSON_ANALOG_STEERWHEEL_COUNTS "analog_steerwheel_counts"
+#define JSON_ANALOG_STEERWHEEL_MV "analog_steerwheel_mv"
+#define JSON_ANALOG_THROTTLE_COUNTS "analog_throttle_counts"
+#define JSON_ANALOG_THROTTLE_MV "analog_throttle_mv"
+
+/*******************************************************************
+ * Analog inputs (ADC1 only, ADC2 is not available with WiFi)
+ *******************************************************************/
+typedef enum {
+  ANALOG_STEERWHEEL,
+  ANALOG_THROTTLE,
+  ANALOG_NUM_INPUTS
+} analog_input_t;
+
+/*******************************************************************
+ * Returns the latest decimated value in counts (0 ... 4095).
+ *
+ * Falls back to analogRead() when continuous mode is not running.
+ *******************************************************************/
+extern int ANALOG_get_raw(analog_input_t input);
+
+/*******************************************************************
+ * Returns the latest decimated value in millivolt (eFuse calibrated).
+ *******************************************************************/
+extern int ANALOG_get_mv(analog_input_t input);
+
+/*******************************************************************
+ * Number of decimated values produced, a changed value means a
+ * new sample is available.
+ *******************************************************************/
+extern uint32_t ANALOG_get_sequence(analog_input_t input);
+
+/*******************************************************************
+ * True when continuous (DMA) acquisition is running.
+ *******************************************************************/
+extern bool ANALOG_continuous(void);
+
+/*******************************************************************
+ * False while continuous acquisition has not produced a value for
+ * the input yet, the value must not be used to drive.
+ *******************************************************************/
+extern bool ANALOG_ready(analog_input_t input);
+
+/*******************************************************************
+ * Setup and start
+ *
+ * ANALOG_start() returns ESP_FAIL when continuous acquisition
+ * produced no values in time, ANALOG_ready() stays false until
+ * the first values arrive.
+ *******************************************************************/
+extern void ANALOG_setup(void);
+extern int ANALOG_start(void);
+
+#endif  // ANALOG_HEADER
@@ -39,6 +39,7 @@ extern int AZIMUTH_get_actual(void);
 extern void AZIMUTH_set_actual(int value);
 
 extern void AZIMUTH_set_steering(int value);
+extern void AZIMUTH_set_output(int value, int linear);
 extern void AZIMUTH_set_output_manual(int value);
 
 extern int AZIMUTH_get_timeout(void);
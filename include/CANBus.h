@@ -0,0 +1,91 @@
+/*******************************************************************
+ * CANBus.h
+ *
+ * CAN frame pool and dispatch to subscribed modules, shared by the
+ * TWAI and MCP channels
+ *
+ *******************************************************************/
+#ifndef CANBUS_HEADER
+#define CANBUS_HEADER
+
+#include <stdint.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * JSON keys
+ *******************************************************************/
+#define JSON_CANBUS_FRAMES "frames"
+#define JSON_CANBUS_UNMATCHED "unmatched"
+#define JSON_CANBUS_POOL_FREE "pool-free"
+#define JSON_CANBUS_POOL_LOW "pool-low-water"
+#define JSON_CANBUS_POOL_EMPTY "pool-empty"
+#define JSON_CANBUS_SUBSCRIPTIONS "subscriptions"
+
+/*******************************************************************
+ * CAN channels, CAN_frame_t::channel
+ *******************************************************************/
+typedef enum {
+  CAN_CHANNEL_TWAI,
+  CAN_CHANNEL_MCP1,
+  CAN_NUM_CHANNELS
+} can_channel_t;
+
+typedef void (*canbus_change_fn)(void);
+
+/*******************************************************************
+ * Subscribes a handler to an identifier and mask, see
+ * DISPATCH_subscribe(). Handlers run in the CAN dispatch task and
+ * get the pooled frame by reference.
+ *
+ * @return Subscription index, -1 when the table is full.
+ *******************************************************************/
+extern int CANBUS_subscribe(const char *name, uint32_t id, uint32_t mask, DISPATCH_handler_fn handler, void *context = nullptr);
+
+/*******************************************************************
+ * Enables or disables a subscription, a disabled one gets no frames
+ * and is left out of the hardware filters.
+ *
+ * @return ESP_OK, or ESP_FAIL for an unknown subscription.
+ *******************************************************************/
+extern int CANBUS_enable(int index, bool enable);
+
+/*******************************************************************
+ * Identifier/mask rules of all enabled subscriptions, the channels
+ * compile them into their hardware acceptance filters. Frames the
+ * hardware filter can not narrow are rejected in software by the
+ * dispatch table.
+ *
+ * @return Number of rules.
+ *******************************************************************/
+extern int CANBUS_rules(CANFILTER_rule_t *rules, int max_rules);
+
+/*******************************************************************
+ * Registers a callback for changed subscriptions (called from the
+ * subscribing task, the channel reprograms its filters later).
+ *
+ * @return ESP_OK, or ESP_FAIL when all callback slots are taken.
+ *******************************************************************/
+extern int CANBUS_on_change(canbus_change_fn callback);
+
+/*******************************************************************
+ * Frames of a channel that passed the hardware filter without a
+ * subscription (rejected in software).
+ *******************************************************************/
+extern uint32_t CANBUS_rejected(can_channel_t channel);
+
+/*******************************************************************
+ * Receive side of the channels: take a free frame from the pool,
+ * fill it and post it to the dispatch task. Returns nullptr when
+ * the pool is empty (frame dropped).
+ *******************************************************************/
+extern CAN_frame_t *CANBUS_frame_alloc(void);
+extern void CANBUS_frame_post(CAN_frame_t *frame);
+
+/*******************************************************************
+ * Setup, called by every channel setup (only the first creates
+ * the pool and the dispatch task)
+ *******************************************************************/
+extern void CANBUS_setup(void);
+
+#endif  // CANBUS_HEADER
@@ -0,0 +1,81 @@
+/*******************************************************************
+ * CANCapture.h
+ *
+ * Binary capture of the CAN traffic of all channels to flash, and
+ * replay of a capture into the CAN dispatch
+ *
+ *******************************************************************/
+#ifndef CANCAPTURE_HEADER
+#define CANCAPTURE_HEADER
+
+#include <stdint.h>
+
+#include "CANBus.h"
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * JSON keys
+ *******************************************************************/
+#define JSON_CANCAP_STATE "state"
+#define JSON_CANCAP_ARMED "armed"
+#define JSON_CANCAP_REASON "reason"
+#define JSON_CANCAP_RECORDS "records"
+#define JSON_CANCAP_DROPPED "dropped"
+#define JSON_CANCAP_WRITE_ERRORS "write-errors"
+#define JSON_CANCAP_TRIGGERS "triggers"
+#define JSON_CANCAP_FILE "file"
+#define JSON_CANCAP_FILES "files"
+#define JSON_CANCAP_REPLAYED "replayed"
+#define JSON_CANCAP_REPLAY_DROPPED "replay-dropped"
+
+/*******************************************************************
+ * Records a received or transmitted frame while capturing, cheap
+ * when not. Called by the channels from their tasks.
+ *******************************************************************/
+extern void CANCAP_frame(const CAN_frame_t *frame, bool tx);
+
+/*******************************************************************
+ * Records a transmitted frame given by its fields
+ *******************************************************************/
+extern void CANCAP_tx(can_channel_t channel, uint32_t id, bool ext, bool rtr, uint8_t length, const uint8_t *data);
+
+/*******************************************************************
+ * Starts a capture into a new file of the ring.
+ *
+ * @param reason Shown in the status (not copied).
+ * @param duration_ms Stops by itself after this time, 0 runs until
+ *                    CANCAP_stop().
+ * @return ESP_OK, or ESP_FAIL while a replay is running.
+ *******************************************************************/
+extern int CANCAP_start(const char *reason, uint32_t duration_ms = 0);
+
+/*******************************************************************
+ * Stops a capture, or a running replay
+ *******************************************************************/
+extern void CANCAP_stop(void);
+
+/*******************************************************************
+ * Bus error trigger, starts a capture of one minute when armed. The
+ * trigger disarms itself so the capture of the first error is kept.
+ *
+ * @param reason Error description (not copied).
+ *******************************************************************/
+extern void CANCAP_trigger(const char *reason);
+
+/*******************************************************************
+ * Replays the received frames of a capture file into the CAN
+ * dispatch with their original timing.
+ *
+ * @param file File number of the ring.
+ * @param speed_pct Replay speed, 100 is real time.
+ * @return ESP_OK, or ESP_FAIL while capturing or when the file is
+ *         missing.
+ *******************************************************************/
+extern int CANCAP_replay(int file, uint16_t speed_pct = 100);
+
+/*******************************************************************
+ * Setup, called by CANBUS_setup() (needs LittleFS)
+ *******************************************************************/
+extern void CANCAP_setup(void);
+
+#endif  // CANCAPTURE_HEADER
@@ -0,0 +1,68 @@
+/*******************************************************************
+ * CANDiag.h
+ *
+ * Diagnostic server on the TWAI channel: UDS services over ISO-TP
+ * for calibration values, counters, state and routines
+ *
+ *******************************************************************/
+#ifndef CANDIAG_HEADER
+#define CANDIAG_HEADER
+
+#include <stdint.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * CAN identifiers, 11 bit, physical addressing
+ *******************************************************************/
+#define CANDIAG_REQUEST_ID 0x7E0
+#define CANDIAG_RESPONSE_ID 0x7E8
+
+/*******************************************************************
+ * Data identifiers
+ *******************************************************************/
+#define CANDIAG_DID_CALIBRATION 0x0100  // + calibration field, int32
+#define CANDIAG_DID_CALIBRATION_ALL 0x0200
+#define CANDIAG_DID_COUNTERS 0x0300
+#define CANDIAG_DID_STATE 0x0400
+#define CANDIAG_DID_SOFTWARE_VERSION 0xF195
+#define CANDIAG_DID_SYSTEM_NAME 0xF197
+
+/*******************************************************************
+ * Routine identifiers
+ *******************************************************************/
+#define CANDIAG_RID_LIFT_HOMING 0x0201
+#define CANDIAG_RID_AZIMUTH_HOMING 0x0202
+#define CANDIAG_RID_SELF_TEST 0x0203
+
+/*******************************************************************
+ * Self-test result bits, 0 is passed
+ *******************************************************************/
+#define CANDIAG_TEST_EMERGENCY_STOP 0x01
+#define CANDIAG_TEST_LIFT_SENSORS 0x02  // Up and down at once
+#define CANDIAG_TEST_STEERWHEEL 0x04    // Outside the calibration
+#define CANDIAG_TEST_AZIMUTH 0x08       // Outside the calibration
+#define CANDIAG_TEST_CAN 0x10           // Bus-off
+
+/*******************************************************************
+ * JSON keys
+ *******************************************************************/
+#define JSON_CANDIAG_BLOCK_SIZE "block-size"
+#define JSON_CANDIAG_ST_MIN "st-min"
+#define JSON_CANDIAG_SESSION "session"
+#define JSON_CANDIAG_REQUESTS "requests"
+#define JSON_CANDIAG_NEGATIVE "negative"
+#define JSON_CANDIAG_BUSY "busy"
+#define JSON_CANDIAG_RX_MESSAGES "rx-messages"
+#define JSON_CANDIAG_TX_MESSAGES "tx-messages"
+#define JSON_CANDIAG_RX_FRAMES "rx-frames"
+#define JSON_CANDIAG_TX_FRAMES "tx-frames"
+#define JSON_CANDIAG_ERRORS "errors"
+#define JSON_CANDIAG_DROPPED "dropped"
+
+/*******************************************************************
+ * Setup, called by CANBUS_setup()
+ *******************************************************************/
+extern void CANDIAG_setup(void);
+
+#endif  // CANDIAG_HEADER
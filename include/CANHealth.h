@@ -0,0 +1,51 @@
+/*******************************************************************
+ * CANHealth.h
+ *
+ * CAN bus health: bus load, error state and trend per channel, and
+ * bus-off recovery with exponential backoff
+ *
+ *******************************************************************/
+#ifndef CANHEALTH_HEADER
+#define CANHEALTH_HEADER
+
+#include <stdint.h>
+
+#include "CANBus.h"
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * JSON keys
+ *******************************************************************/
+#define JSON_CANHEALTH_CHANNEL "channel"
+#define JSON_CANHEALTH_ACTIVE "active"
+#define JSON_CANHEALTH_BITRATE "bitrate"
+#define JSON_CANHEALTH_LOAD "load-pct"
+#define JSON_CANHEALTH_LOAD_MAX "load-max-pct"
+#define JSON_CANHEALTH_FRAME_RATE "frames-per-sec"
+#define JSON_CANHEALTH_STATE "state"
+#define JSON_CANHEALTH_VERDICT "verdict"
+#define JSON_CANHEALTH_TEC "tec"
+#define JSON_CANHEALTH_REC "rec"
+#define JSON_CANHEALTH_TEC_TREND "tec-trend"
+#define JSON_CANHEALTH_REC_TREND "rec-trend"
+#define JSON_CANHEALTH_TEC_MAX "tec-max"
+#define JSON_CANHEALTH_REC_MAX "rec-max"
+#define JSON_CANHEALTH_BUS_ERRORS "bus-errors"
+#define JSON_CANHEALTH_ENTERED "entered"
+#define JSON_CANHEALTH_BUS_OFFS "bus-offs"
+#define JSON_CANHEALTH_RECOVERIES "recoveries"
+#define JSON_CANHEALTH_BACKOFF "backoff-ms"
+#define JSON_CANHEALTH_CHANNELS "channels"
+
+/*******************************************************************
+ * Counts a frame seen on a channel, received or transmitted, into
+ * the bus load. Called by the channel tasks.
+ *******************************************************************/
+extern void CANHEALTH_observe(can_channel_t channel, uint32_t id, bool ext, bool rtr, uint8_t length, const uint8_t *data);
+
+/*******************************************************************
+ * Setup, called by CANBUS_setup()
+ *******************************************************************/
+extern void CANHEALTH_setup(void);
+
+#endif  // CANHEALTH_HEADER
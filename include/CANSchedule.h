@@ -0,0 +1,60 @@
+/*******************************************************************
+ * CANSchedule.h
+ *
+ * Cyclic and one-shot CAN transmit schedule, shared by the TWAI and
+ * MCP channels
+ *
+ *******************************************************************/
+#ifndef CANSCHEDULE_HEADER
+#define CANSCHEDULE_HEADER
+
+#include <stdint.h>
+
+#include "CANBus.h"
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * JSON keys
+ *******************************************************************/
+#define JSON_CANSCHED_BACKLOG_MAX "backlog-max"
+#define JSON_CANSCHED_ONCE_SENT "one-shot-sent"
+#define JSON_CANSCHED_ONCE_FAILED "one-shot-failed"
+#define JSON_CANSCHED_ONCE_MISSED "one-shot-missed"
+#define JSON_CANSCHED_TX_PENDING "tx-pending"
+#define JSON_CANSCHED_TX_PENDING_MAX "tx-pending-max"
+#define JSON_CANSCHED_ENTRIES "entries"
+
+/*******************************************************************
+ * Adds a cyclic frame, the payload is sent as is or refreshed by
+ * the producer just before every release (in the scheduler task,
+ * keep it short). A producer returning false skips the release.
+ *
+ * @param name Name shown in the statistics (not copied).
+ * @param channel Channel to send the frame on.
+ * @param period_ms Period, the deadline is one period.
+ * @param phase_ms First release after now, spreads frames with
+ *                 the same period.
+ * @param priority 0 is most urgent, breaks ties between frames due
+ *                 at the same time.
+ * @return Entry index, -1 when the schedule is full.
+ *******************************************************************/
+extern int CANSCHED_add(const char *name, can_channel_t channel, uint32_t id, bool ext, uint8_t length,
+                        const uint8_t *data, uint32_t period_ms, uint32_t phase_ms, uint8_t priority,
+                        SCHED_produce_fn produce = nullptr, void *context = nullptr);
+
+/*******************************************************************
+ * Sends a frame once, merged into the same timeline as the cyclic
+ * frames.
+ *
+ * @param deadline_ms Allowed lateness, 0 is none.
+ * @return ESP_OK, or ESP_FAIL when the schedule is full.
+ *******************************************************************/
+extern int CANSCHED_send(can_channel_t channel, uint32_t id, bool ext, uint8_t length, const uint8_t *data,
+                         uint8_t priority = 0, uint32_t deadline_ms = 0);
+
+/*******************************************************************
+ * Setup, called by the first CANSCHED_add() or CANSCHED_send()
+ *******************************************************************/
+extern void CANSCHED_setup(void);
+
+#endif  // CANSCHEDULE_HEADER
@@ -35,6 +35,11 @@ extern void cli_set_output(cli_output_t value);
  *******************************************************************/
 extern void CLI_webserial_task(uint8_t* data, size_t len);
 
+/********************************************************************
+ * Serial console on UART0, off while a gateway owns the port
+ *******************************************************************/
+extern void CLI_serial_enable(bool enable);
+
 /********************************************************************
  * Output ComandlIne interface data
  *******************************************************************/
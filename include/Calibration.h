@@ -0,0 +1,111 @@
+/*******************************************************************
+ * Calibration.h
+ *
+ * Typed in-RAM calibration and configuration registry
+ *
+ *******************************************************************/
+#ifndef CALIBRATION_HEADER
+#define CALIBRATION_HEADER
+
+#include <stdint.h>
+
+/*******************************************************************
+ * Calibration fields
+ *******************************************************************/
+typedef enum {
+  CAL_STEERWHEEL_LEFT,
+  CAL_STEERWHEEL_MIDDLE,
+  CAL_STEERWHEEL_RIGHT,
+  CAL_STEERWHEEL_DEADBAND,
+  CAL_STEERWHEEL_HYSTERESIS,
+  CAL_STEERWHEEL_MEDIAN,
+  CAL_STEERWHEEL_IIR,
+  CAL_STEERWHEEL_RATE_LIMIT,
+  CAL_AZIMUTH_LOW,
+  CAL_AZIMUTH_MIDDLE,
+  CAL_AZIMUTH_HIGH,
+  CAL_AZIMUTH_TIMEOUT,
+  CAL_LIFT_MOVE_TIMEOUT,
+  CAL_STEERING_RATE,
+  CAL_NUM_FIELDS
+} calibration_field_t;
+
+#define CALIBRATION_MASK(field) (1u << (field))
+#define CALIBRATION_MASK_ALL (CALIBRATION_MASK(CAL_NUM_FIELDS) - 1u)
+
+/*******************************************************************
+ * Calibration snapshot (POD)
+ *******************************************************************/
+typedef struct {
+  int value[CAL_NUM_FIELDS];
+} calibration_t;
+
+/*******************************************************************
+ * Change callback, called once per update with the mask of the
+ * changed fields and the values right after the update (not from
+ * the spinlock, may block).
+ *******************************************************************/
+typedef void (*calibration_change_fn)(uint32_t changed, const calibration_t *values);
+
+/*******************************************************************
+ * Returns one calibration value.
+ *******************************************************************/
+extern int CALIBRATION_get(calibration_field_t field);
+
+/*******************************************************************
+ * Copies all calibration values at once, concurrent updates are
+ * never seen half way.
+ *******************************************************************/
+extern void CALIBRATION_snapshot(calibration_t *snapshot);
+
+/*******************************************************************
+ * Sets a calibration value.
+ *
+ * @param field The calibration field.
+ * @param value The new value, checked against the field range.
+ * @param persist Also write the value to storage.
+ *
+ * @return ESP_OK, or ESP_FAIL when the value is out of range.
+ *******************************************************************/
+extern int CALIBRATION_set(calibration_field_t field, int value, bool persist = true);
+
+/*******************************************************************
+ * Sets several calibration values at once. All masked fields are
+ * range checked first, then swapped in one critical section,
+ * persisted with one storage write and notified once.
+ *
+ * @param values The new values, only the masked fields are used.
+ * @param mask CALIBRATION_MASK() of the fields to set.
+ * @param persist Also write the values to storage.
+ *
+ * @return ESP_OK, or ESP_FAIL (nothing applied) when a value is
+ *         out of range.
+ *******************************************************************/
+extern int CALIBRATION_update(const calibration_t *values, uint32_t mask, bool persist = true);
+
+/*******************************************************************
+ * Reloads the masked calibration values from storage in one update
+ * (undo RAM-only sets).
+ *******************************************************************/
+extern void CALIBRATION_restore(uint32_t mask);
+
+/*******************************************************************
+ * Registers a change callback.
+ *
+ * @return ESP_OK, or ESP_FAIL when all callback slots are used.
+ *******************************************************************/
+extern int CALIBRATION_on_change(calibration_change_fn callback);
+
+/*******************************************************************
+ * Storage key and range of a field.
+ *******************************************************************/
+extern const char *CALIBRATION_key(calibration_field_t field);
+extern int CALIBRATION_min(calibration_field_t field);
+extern int CALIBRATION_max(calibration_field_t field);
+
+/*******************************************************************
+ * Setup, loads all values from storage (defaults when missing).
+ *******************************************************************/
+extern void CALIBRATION_setup(void);
+
+#endif  // CALIBRATION_HEADER
@@ -25,6 +25,8 @@
 #ifndef CONFIG_HEADER_ID
 #define CONFIG_HEADER_ID
 
+#include "EBC_Utils.h"  // LINEAR_MIN, LINEAR_MIDDLE, LINEAR_MAX
+
 /*******************************************************************
  * Program name and version definitions
  *******************************************************************/
@@ -40,11 +42,6 @@
  *******************************************************************/
 #define DEBUG_API
 
-/*******************************************************************
- * CAN receive handler
- *******************************************************************/
-typedef void (*CANReceiveHandler)(uint32_t id, uint8_t *buffer, uint8_t size, bool rtr, bool ext);
-
 /*******************************************************************
  * Communication
  *******************************************************************/
@@ -144,11 +141,4 @@ typedef void (*CANReceiveHandler)(uint32_t id, uint8_t *buffer, uint8_t size, bo
  *******************************************************************/
 #define DMC_ENABLE_PIN 4
 
-/*******************************************************************
- * Application definitions
- *******************************************************************/
-#define LINEAR_MIN    0
-#define LINEAR_MIDDLE 2048
-#define LINEAR_MAX    4096
-
 #endif  // CONFIG_HEADER_ID
@@ -7,6 +7,32 @@
 
 #include <StateMachineLib.h>
 
+/*******************************************************************
+ * JSON and Websocket keys
+ *******************************************************************/
+#define JSON_CONTROLLER_STATE "controller_state"
+#define JSON_CONTROLLER_WAKEUPS "controller_wakeups"
+#define JSON_CONTROLLER_REACTION_LAST "controller_reaction_last_us"
+#define JSON_CONTROLLER_REACTION_MAX "controller_reaction_max_us"
+
+#define JSON_STEERING_CYCLES "steering_cycles"
+#define JSON_STEERING_JITTER_LAST "steering_jitter_last_us"
+#define JSON_STEERING_JITTER_MAX "steering_jitter_max_us"
+#define JSON_STEERING_EXEC_LAST "steering_exec_last_us"
+#define JSON_STEERING_EXEC_MAX "steering_exec_max_us"
+#define JSON_STEERING_OVERRUNS "steering_overruns"
+#define JSON_STEERING_MISSED "steering_missed"
+#define JSON_STEERING_LUT_BUILDS "steering_lut_builds"
+#define JSON_STEERING_LUT_BUILD_TIME "steering_lut_build_us"
+
+/*******************************************************************
+ * Storage keys and defaults
+ *******************************************************************/
+#define JSON_STEERING_RATE "steering_rate_hz"
+#define STEERING_RATE_DEFAULT 100
+#define STEERING_RATE_MIN 50
+#define STEERING_RATE_MAX 500
+
 /*******************************************************************
  * Requests maintenance mode for the controller.
  * 
@@ -15,6 +41,15 @@
  *******************************************************************/
 extern void CONTROLLER_request_maintenance(void);
 
+/*******************************************************************
+ * Wakes the controller task from an interrupt service routine.
+ *
+ * Called on an edge of the lift sensors, lift buttons and the
+ * emergency stop, so the statemachine is evaluated immediately
+ * instead of on the next periodic tick.
+ *******************************************************************/
+extern void CONTROLLER_wakeup_from_isr(void);
+
 /*******************************************************************
  * Setup and start
  *******************************************************************/
@@ -11,6 +11,11 @@
  * JSON and Websocket keys
  *******************************************************************/
 #define JSON_EMERGENCY_STOP "emergency_stop"
+#define JSON_EMERGENCY_STOP_LATCHED "emergency_stop_latched"
+#define JSON_EMERGENCY_STOP_COUNT "emergency_stop_count"
+#define JSON_EMERGENCY_STOP_SHUTDOWN_LAST "emergency_stop_shutdown_last_us"
+#define JSON_EMERGENCY_STOP_SHUTDOWN_MAX "emergency_stop_shutdown_max_us"
+#define JSON_EMERGENCY_STOP_WRITE_FAILED "emergency_stop_write_failed"
 
 /*******************************************************************
  *  Blinking intervals
@@ -43,6 +48,13 @@ extern uint8_t MCP4725_R_address;
  *******************************************************************/
 extern bool EMERGENCY_STOP_active(void);
 
+/*******************************************************************
+ * Emergency stop latch, set from the e-stop interrupt, the outputs
+ * are already switched off when the statemachine sees the latch.
+ *******************************************************************/
+extern bool EMERGENCY_STOP_latched(void);
+extern void EMERGENCY_STOP_clear(void);
+
 /*******************************************************************
   * LED blink timing
  *******************************************************************/
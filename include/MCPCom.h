@@ -9,6 +9,8 @@
 
 #include <stdint.h>
 
+#include "EBC_Utils.h"
+
 /*******************************************************************
  * JSON fields
  *******************************************************************/
@@ -20,12 +22,23 @@
 #define JSON_MCP_RX_MISSED "rx-missed"
 #define JSON_MCP_RX_OVERRUN "rx-overrun"
 #define JSON_MCP_RX_QUEUED "rx-queued"
+#define JSON_MCP_RX_DROPPED "rx-dropped"
+#define JSON_MCP_RX_INTERRUPTS "rx-interrupts"
+#define JSON_MCP_RX_BURST_MAX "rx-burst-max"
+#define JSON_MCP_RX_DRAIN_CAPPED "rx-drain-capped"
+#define JSON_MCP_RX_REJECTED "rx-rejected"
+#define JSON_MCP_RX_REJECTED_RATE "rx-rejected-per-sec"
 #define JSON_MCP_TX_FRAMES "tx-frames"
 #define JSON_MCP_TX_ERRORS "tx-errors"
 #define JSON_MCP_TX_FAILED "tx-failed"
 #define JSON_MCP_TX_QUEUED "tx-queued"
+#define JSON_MCP_TX_DROPPED "tx-dropped"
 #define JSON_MCP_ARB_LOST  "arbitrage-lost"
 #define JSON_MCP_BUS_ERROR "bus-errors"
+#define JSON_MCP_FILTER_MASKS "filter-masks"
+#define JSON_MCP_FILTERS "filters"
+#define JSON_MCP_FILTER_ACCEPT "filter-accept-pct"
+#define JSON_MCP_FILTER_ERRORS "filter-errors"
 
 /********************************************************************
  * Constants
@@ -49,14 +62,32 @@ extern bool MCP1_rx_frames(void);
 extern bool MCP1_tx_frames(void);
 
 /*******************************************************************
- * MCP send frame
+ * MCP send frame, ESP_FAIL when the transmit queue is full
+ *******************************************************************/
+extern int MCP1_send(uint32_t id, const uint8_t* buffer, uint8_t length, bool rtr=false, bool ext=false);
+
+/*******************************************************************
+ * MCP frames waiting in the transmit queue
+ *******************************************************************/
+extern int MCP1_tx_pending(void);
+
+/*******************************************************************
+ * MCP bus bit rate in bits/s
+ *******************************************************************/
+extern uint32_t MCP1_baudrate(void);
+
+/*******************************************************************
+ * MCP error state from the EFLG register, the error counters are
+ * HEALTH_COUNTER_UNKNOWN. ESP_FAIL before MCP1_setup().
  *******************************************************************/
-extern int MCP1_send(uint32_t id, uint8_t* buffer, uint8_t length, bool rtr=false, bool ext=false);
+extern int MCP1_bus_status(HEALTH_status_t* status);
 
 /*******************************************************************
- * Set receive handler 
+ * MCP bus-off recovery: hold keeps the controller off the bus in
+ * configuration mode, recover resets and reinitialises it
  *******************************************************************/
-extern void MCP1_rx_handler(CANReceiveHandler handler);
+extern void MCP1_bus_hold(void);
+extern int MCP1_bus_recover(void);
 
 /*******************************************************************
  * Externals
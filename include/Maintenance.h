@@ -9,6 +9,11 @@
 
 #include <ArduinoJson.h>
 
+/*******************************************************************
+ * JSON and Websocket keys
+ *******************************************************************/
+#define JSON_MAINTENANCE_ENABLED "maintenance_enabled"
+
 /********************************************************************
  * Enables maintenance mode if the emergency stop is not active.
  * 
@@ -39,6 +44,15 @@ extern bool MAINTENANCE_enabled(void);
  *******************************************************************/
 extern int MAINTENANCE_command_handler(const char *data);
 
+/********************************************************************
+ * Queues a command for the maintenance task, for callers that must
+ * not block (websocket events).
+ *
+ * @return ESP_OK, or ESP_FAIL when the command is too long or the
+ *         queue is full.
+ *******************************************************************/
+extern int MAINTENANCE_queue_command(const char *data, size_t len);
+
 /********************************************************************
  * Setup and start
  *******************************************************************/
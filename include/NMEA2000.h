@@ -0,0 +1,54 @@
+/*******************************************************************
+ * NMEA2000.h
+ *
+ * NMEA2000 on the TWAI channel: address claim, ISO requests,
+ * azimuth and thruster status broadcast and engine data reception
+ *
+ *******************************************************************/
+#ifndef NMEA2000_HEADER
+#define NMEA2000_HEADER
+
+#include <stdint.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * JSON keys
+ *******************************************************************/
+#define JSON_NMEA2000_ADDRESS "address"
+#define JSON_NMEA2000_NAME "name"
+#define JSON_NMEA2000_CONFLICTS "claim-conflicts"
+#define JSON_NMEA2000_FRAMES "rx-frames"
+#define JSON_NMEA2000_REQUESTS "requests"
+#define JSON_NMEA2000_NAKS "requests-nak"
+#define JSON_NMEA2000_FP_COMPLETED "fast-packet-completed"
+#define JSON_NMEA2000_FP_LOST "fast-packet-lost"
+#define JSON_NMEA2000_FP_DROPPED "fast-packet-dropped"
+#define JSON_NMEA2000_FP_TIMEOUTS "fast-packet-timeouts"
+#define JSON_NMEA2000_PGNS "pgns"
+
+/*******************************************************************
+ * Sends a PGN from the codec table, fast-packet PGNs are split in
+ * frames. Fails while no address is claimed.
+ *
+ * @param values One value per field, NAN is not available.
+ * @param destination N2K_ADDRESS_GLOBAL, or an address for PDU1
+ *                    PGNs.
+ * @return ESP_OK, or ESP_FAIL.
+ *******************************************************************/
+extern int NMEA2000_send(const N2K_pgn_t *pgn, const double *values, uint8_t destination = N2K_ADDRESS_GLOBAL);
+
+/*******************************************************************
+ * Last received values of a PGN from the codec table.
+ *
+ * @param values Receives one value per field.
+ * @return Age in ms, -1 when never received.
+ *******************************************************************/
+extern int32_t NMEA2000_received(uint32_t pgn, double *values);
+
+/*******************************************************************
+ * Setup, sets up the TWAI channel and claims an address
+ *******************************************************************/
+extern void NMEA2000_setup(int mode);
+
+#endif  // NMEA2000_HEADER
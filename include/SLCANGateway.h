@@ -0,0 +1,60 @@
+/*******************************************************************
+ * SLCANGateway.h
+ *
+ * SLCAN (LAWICEL) gateway, exposes a CAN channel to a PC over UART0
+ * or a TCP socket
+ *
+ *******************************************************************/
+#ifndef SLCANGATEWAY_HEADER
+#define SLCANGATEWAY_HEADER
+
+#include <stdint.h>
+
+#include "CANBus.h"
+#include "EBC_Utils.h"
+
+#define SLCANGW_TCP_PORT 3333
+#define SLCANGW_UART_BAUD 2000000  // Full bus load of 1 Mbit/s needs about 1.2 Mbaud
+
+/*******************************************************************
+ * JSON keys
+ *******************************************************************/
+#define JSON_SLCANGW_PORT "port"
+#define JSON_SLCANGW_CHANNEL "channel"
+#define JSON_SLCANGW_STATE "state"
+#define JSON_SLCANGW_CLIENT "client"
+#define JSON_SLCANGW_RX_FRAMES "rx-frames"
+#define JSON_SLCANGW_RX_OVERFLOW "rx-overflow"
+#define JSON_SLCANGW_TX_FRAMES "tx-frames"
+#define JSON_SLCANGW_TX_FAILED "tx-failed"
+#define JSON_SLCANGW_ERRORS "command-errors"
+#define JSON_SLCANGW_WRITES "writes"
+#define JSON_SLCANGW_WRITE_MAX "write-max"
+
+typedef enum {
+  SLCANGW_PORT_NONE,
+  SLCANGW_PORT_UART,  // UART0, the serial console is released
+  SLCANGW_PORT_TCP
+} slcangw_port_t;
+
+/*******************************************************************
+ * Starts the gateway on a channel, the PC opens the CAN channel
+ * with the SLCAN O or L command. A running gateway is stopped
+ * first.
+ *
+ * @param baud UART0 baud rate, ignored for TCP.
+ * @return ESP_OK, or ESP_FAIL for an unknown port.
+ *******************************************************************/
+extern int SLCANGW_start(slcangw_port_t port, can_channel_t channel, uint32_t baud = SLCANGW_UART_BAUD);
+
+/*******************************************************************
+ * Stops the gateway, UART0 returns to the serial console
+ *******************************************************************/
+extern void SLCANGW_stop(void);
+
+/*******************************************************************
+ * Setup, called by CANBUS_setup()
+ *******************************************************************/
+extern void SLCANGW_setup(void);
+
+#endif  // SLCANGATEWAY_HEADER
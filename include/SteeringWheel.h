@@ -17,6 +17,11 @@
 #define JSON_STEERWHEEL_ACTUAL "steering_actual_counts"
 
 #define JSON_STEERWHEEL_DEADBAND "steering_middle_deadband"
+#define JSON_STEERWHEEL_HYSTERESIS "steering_middle_hysteresis"
+
+#define JSON_STEERWHEEL_MEDIAN "steering_filter_median"          // Window, 0 or 1 is off
+#define JSON_STEERWHEEL_IIR "steering_filter_iir_permille"       // Alpha, 1000 is off
+#define JSON_STEERWHEEL_RATE_LIMIT "steering_filter_rate_limit"  // Counts per sample, 0 is off
 
 /*******************************************************************
  * Steering wheel
@@ -30,6 +35,19 @@ extern void STEERWHEEL_set_middle(int value);
 extern int STEERWHEEL_get_deadband(void);
 extern void STEERWHEEL_set_deadband(int value);
 
+/********************************************************************
+ * @brief Samples the steering wheel (oversampled continuous ADC).
+ *
+ * Called every cycle of the steering control loop.
+ *******************************************************************/
+extern void STEERWHEEL_update(void);
+
+/********************************************************************
+ * @brief False until the analog input delivered a steering wheel
+ * sample, the position must not be used to drive before.
+ *******************************************************************/
+extern bool STEERWHEEL_ready(void);
+
 /********************************************************************
  * @brief Get the actual steering wheel position.
  * 
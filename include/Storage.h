@@ -38,6 +38,11 @@ extern int STORAGE_get_string(const char* key, String &value);
  *******************************************************************/
 extern int STORAGE_set_int(const char* key, int value);
 
+/********************************************************************
+ * Set integer fields, written to storage once
+ *******************************************************************/
+extern int STORAGE_set_ints(const char* const keys[], const int values[], int count);
+
 /********************************************************************
  * Get string field
  *******************************************************************/
@@ -11,6 +11,8 @@
 #include <driver/twai.h>
 #include <esp_err.h>
 
+#include "EBC_Utils.h"
+
 /*******************************************************************
  * JSON fields
  *******************************************************************/
@@ -22,12 +24,25 @@
 #define JSON_TWAI_RX_MISSED "rx-missed"
 #define JSON_TWAI_RX_OVERRUN "rx-overrun"
 #define JSON_TWAI_RX_QUEUED "rx-queued"
+#define JSON_TWAI_RX_DROPPED "rx-dropped"
+#define JSON_TWAI_RX_RATE "rx-frames-per-sec"
+#define JSON_TWAI_RX_BURST_MAX "rx-burst-max"
+#define JSON_TWAI_RX_REJECTED "rx-rejected"
+#define JSON_TWAI_RX_REJECTED_RATE "rx-rejected-per-sec"
 #define JSON_TWAI_TX_FRAMES "tx-frames"
 #define JSON_TWAI_TX_ERRORS "tx-errors"
 #define JSON_TWAI_TX_FAILED "tx-failed"
 #define JSON_TWAI_TX_QUEUED "tx-queued"
+#define JSON_TWAI_TX_DROPPED "tx-dropped"
+#define JSON_TWAI_TX_TIMEOUT "tx-timeout"
+#define JSON_TWAI_TX_RATE "tx-frames-per-sec"
+#define JSON_TWAI_TX_QUEUE_HWM "tx-queue-high-water"
 #define JSON_TWAI_ARB_LOST  "arbitrage-lost"
 #define JSON_TWAI_BUS_ERROR "bus-errors"
+#define JSON_TWAI_FILTER_MODE "filter-mode"
+#define JSON_TWAI_FILTER_CODE "filter-code"
+#define JSON_TWAI_FILTER_MASK "filter-mask"
+#define JSON_TWAI_FILTER_ACCEPT "filter-accept-pct"
 
 /********************************************************************
  * Constants
@@ -62,9 +77,26 @@ extern bool TWAI_rx_frame(void);
 extern int TWAI_send(uint32_t id, const uint8_t *buffer, uint8_t length, bool rtr=false, bool extd=false);
 
 /*******************************************************************
- * Set receive handler
+ *  Frames waiting in the transmit queue
+ *******************************************************************/
+extern int TWAI_tx_pending(void);
+
+/*******************************************************************
+ *  Bus bit rate in bits/s
+ *******************************************************************/
+extern uint32_t TWAI_baudrate(void);
+
+/*******************************************************************
+ *  Error counters and state, ESP_FAIL when the driver is not
+ *  installed
+ *******************************************************************/
+extern int TWAI_bus_status(HEALTH_status_t *status);
+
+/*******************************************************************
+ *  Bus-off recovery: starts the recovery of a bus-off controller,
+ *  and restarts a recovered (stopped) one
  *******************************************************************/
-extern void TWAI_rx_handler(CANReceiveHandler handler);
+extern int TWAI_bus_recover(void);
 
 /*******************************************************************
  *  Setup TWAICom
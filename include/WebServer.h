@@ -16,15 +16,53 @@
 
 #define JSON_WEBS_HEAP_TOTAL "heap-total"
 #define JSON_WEBS_HEAP_FREE "heap-free"
+#define JSON_WEBS_HEAP_MIN "heap-min"
 
 #define JSON_WEBS_CHIP_ID "chip-id"
 
+#define JSON_WEBS_WS_KEYS "ws-keys"
+#define JSON_WEBS_WS_CHANGED "ws-changed"
+#define JSON_WEBS_WS_UNCHANGED "ws-unchanged"
+#define JSON_WEBS_WS_REJECTED "ws-rejected"
+#define JSON_WEBS_WS_FRAMES "ws-frames"
+#define JSON_WEBS_WS_FRAMES_TICK "ws-frames-tick"
+#define JSON_WEBS_WS_PAIRS_TICK "ws-pairs-tick"
+#define JSON_WEBS_WS_BYTE_RATE "ws-bytes-per-sec"
+#define JSON_WEBS_WS_SERIALIZE "ws-serialize-us"
+#define JSON_WEBS_WS_SERIALIZE_MAX "ws-serialize-max-us"
+#define JSON_WEBS_WS_CLIENTS "ws-clients"
+#define JSON_WEBS_WS_RESYNCS "ws-resyncs"
+
+#define JSON_WEBS_PAGE_SIZE "page-size"
+#define JSON_WEBS_PAGE_RENDERS "page-renders"
+#define JSON_WEBS_PAGE_RENDER "page-render-us"
+#define JSON_WEBS_PAGE_REQUESTS "page-requests"
+#define JSON_WEBS_PAGE_NOT_MODIFIED "page-not-modified"
+#define JSON_WEBS_PAGE_RESPONSE "page-response-us"
+#define JSON_WEBS_PAGE_RESPONSE_MAX "page-response-max-us"
+
+#define JSON_WEBS_ASSET_REQUESTS "asset-requests"
+#define JSON_WEBS_ASSET_GZIP "asset-gzip"
+#define JSON_WEBS_ASSET_NOT_MODIFIED "asset-not-modified"
+#define JSON_WEBS_ASSET_NOT_FOUND "asset-not-found"
+
+#define JSON_WEBS_REST_READS "rest-reads"
+#define JSON_WEBS_REST_BYTES "rest-bytes"
+#define JSON_WEBS_REST_ALLOCATIONS "rest-allocations"
+#define JSON_WEBS_REST_HEAP_ALLOCATIONS "rest-heap-allocations"
+#define JSON_WEBS_REST_ARENA_PEAK "rest-arena-peak"
+#define JSON_WEBS_REST_HEAP_PEAK "rest-heap-peak"
+#define JSON_WEBS_REST_RESPONSE "rest-response-us"
+#define JSON_WEBS_REST_RESPONSE_MAX "rest-response-max-us"
+
 /********************************************************************
  * Type defintions
  *********************************************************************/
 typedef void (*RestApiHandler1) (AsyncWebServerRequest *request);
 typedef void (*RestApiHandler2) (AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
 
+typedef JsonDocument (*JsonBuilder) (ArduinoJson::Allocator *allocator);
+
 typedef struct {
   char uri[64];
   char comment[64];
@@ -37,15 +75,30 @@ typedef struct {
 
 extern AsyncWebServer web_server;
 
+/********************************************************************
+ * Allocator of the JSON builders outside a REST read
+ *********************************************************************/
+extern ArduinoJson::Allocator *const JSON_HEAP;
+
 /********************************************************************
  * Setup REST API handlers
  *********************************************************************/
 extern void setup_uri(rest_api_t *uri_hdl);
 
+/********************************************************************
+ * Sends a JSON document as REST response, serialised straight into
+ * a response stream of the measured size.
+ *
+ * @param request The request to answer.
+ * @param builder Builds the document with the given allocator, the
+ *                request arena of the web server.
+ *********************************************************************/
+extern void WEBSERVER_send_json(AsyncWebServerRequest *request, JsonBuilder builder);
+extern void WEBSERVER_send_json(AsyncWebServerRequest *request, const JsonDocument &doc);
+
 /********************************************************************
  * Updates the WebSocket JSON data with the given key-value pair.
- * If the key does not exist in the WebSocket JSON data, it is added with a null value.
- * Then, the key-value pair is stored and sent via WebSocket.
+ * A changed value is sent with the other changes of the tick.
  *
  * @param kv The key-value pair to update.
  *********************************************************************/
@@ -59,7 +112,8 @@ extern void WEBSOCKET_update_pair(JsonPair kv);
 extern void WEBSOCKET_update_doc(JsonDocument doc);
 
 /********************************************************************
- * Sends a JSON key-value pair to the WebSocket connection.
+ * Sends a JSON key-value pair to the WebSocket connection, with the
+ * next tick even when the value did not change.
  *
  * @param key The key of the JSON pair to push.
  * @param doc The JSON document containing the key-value pairs.
@@ -67,7 +121,8 @@ extern void WEBSOCKET_update_doc(JsonDocument doc);
 extern void WEBSOCKET_send(String key, JsonDocument doc);
 
 /********************************************************************
- * Sends a JSON document over a WebSocket connection.
+ * Sends a JSON document over a WebSocket connection, all values
+ * with the next tick.
  * 
  * @param doc The JSON document to send.
  *********************************************************************/
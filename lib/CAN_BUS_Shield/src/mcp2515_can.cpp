@@ -1380,6 +1380,49 @@ void mcp2515_can::clearBufferTransmitIfFlags(byte flags) {
     mcp2515_modifyRegister(MCP_CANINTF, flags, 0);
 }
 
+/*******************************************************************
+** Function name:           clearErrorIfFlags
+** Descriptions:            Clear the error and message error interrupt flags
+*********************************************************************************************************/
+void mcp2515_can::clearErrorIfFlags(void) {
+    mcp2515_modifyRegister(MCP_CANINTF, MCP_ERRIF | MCP_MERRF, 0);
+}
+
+/*******************************************************************
+** Function name:           enableErrorInterrupt
+** Descriptions:            enable or disable the error interrupt (ERRIF), set
+**                          on every change of the error flag register
+*********************************************************************************************************/
+void mcp2515_can::enableErrorInterrupt(bool enable) {
+    mcp2515_modifyRegister(MCP_CANINTE, MCP_ERRIF, enable ? MCP_ERRIF : 0);
+}
+
+/*******************************************************************
+** Function name:           init_MaskFilt
+** Descriptions:            init both masks and all six filters in one
+**                          configuration mode pass, without delays
+*********************************************************************************************************/
+byte mcp2515_can::init_MaskFilt(const byte mask_ext[2], const unsigned long masks[2],
+                                const byte filt_ext[6], const unsigned long filters[6]) {
+    static const byte filt_addr[6] = {MCP_RXF0SIDH, MCP_RXF1SIDH, MCP_RXF2SIDH,
+                                      MCP_RXF3SIDH, MCP_RXF4SIDH, MCP_RXF5SIDH};
+    byte res;
+
+    res = mcp2515_setCANCTRL_Mode(MODE_CONFIG);
+    if (res > 0) {
+        mcp2515_setCANCTRL_Mode(mcpMode);
+        return res;
+    }
+
+    mcp2515_write_id(MCP_RXM0SIDH, mask_ext[0], masks[0]);
+    mcp2515_write_id(MCP_RXM1SIDH, mask_ext[1], masks[1]);
+    for (byte i = 0; i < 6; i++) {
+        mcp2515_write_id(filt_addr[i], filt_ext[i], filters[i]);
+    }
+
+    return mcp2515_setCANCTRL_Mode(mcpMode);
+}
+
 /*******************************************************************
 ** Function name:           checkReceive
 ** Descriptions:            check if got something
@@ -95,6 +95,9 @@ public:
     using MCP_CAN::sendMsgBuf; // make other overloads visible
 
     virtual void clearBufferTransmitIfFlags(byte flags = 0);                                                                                            // Clear transmit flags according to status
+    void clearErrorIfFlags(void);                                                                                                                       // Clear the ERRIF and MERRF interrupt flags
+    void enableErrorInterrupt(bool enable = true);                                                                                                      // ERRIF on /INT, error flag (EFLG) changes
+    byte init_MaskFilt(const byte mask_ext[2], const unsigned long masks[2], const byte filt_ext[6], const unsigned long filters[6]);                   // init masks and filters in one configuration mode pass
     virtual byte readRxTxStatus(void);                                                                                                                  // read has something send or received
     virtual byte checkClearRxStatus(byte *status);                                                                                                      // read and clear and return first found rx status bit
     virtual byte checkClearTxStatus(byte *status, byte iTxBuf = 0xff);                                                                                  // read and clear and return first found or buffer specified tx status bit
@@ -25,6 +25,27 @@
 #define DAC_MIN 0
 #define DAC_MAX 4095
 
+/*******************************************************************
+ * I2C bus owner
+ *******************************************************************/
+typedef enum {
+  I2C_PRIO_SAFETY,      // Digital outputs (PCF8574)
+  I2C_PRIO_DAC,         // Analog outputs (MCP4725)
+  I2C_PRIO_DIAGNOSTIC,  // Scans, status and EEPROM reads
+  I2C_PRIO_COUNT
+} I2C_prio_t;
+
+typedef int (*I2C_job_fn)(void *arg);
+
+typedef struct {
+  uint32_t count;             // Completed transactions
+  uint32_t wait_last_us;      // Time in queue
+  uint32_t wait_max_us;
+  uint32_t latency_last_us;   // Submit to completion
+  uint32_t latency_max_us;
+  uint64_t latency_total_us;  // For the average
+} I2C_stats_t;
+
 /*******************************************************************
  * @brief Starts the I2C/TwoWire driver.
  *
@@ -53,6 +74,36 @@ extern bool I2C_setup(int sda0, int scl0);
  *******************************************************************/
 extern int I2C_scan(uint8_t *I2C_list, int len);
 
+/*******************************************************************
+ * @brief Starts the I2C bus owner task.
+ *
+ * All I2C transactions are executed by one task, in order of
+ * priority class: safety outputs, DAC updates, diagnostics.
+ * Before the task is started transactions run in the caller.
+ *******************************************************************/
+extern void I2C_start(void);
+
+/*******************************************************************
+ * @brief Executes a transaction on the I2C bus owner task.
+ *
+ * The caller blocks until the transaction is completed.
+ *
+ * @param prio Priority class of the transaction.
+ * @param fn Function executed with exclusive access to the bus.
+ * @param arg Argument passed to fn.
+ *
+ * @return The return value of fn.
+ *******************************************************************/
+extern int I2C_transaction(I2C_prio_t prio, I2C_job_fn fn, void *arg);
+
+/*******************************************************************
+ * @brief Latency statistics per priority class.
+ *
+ * @return False for an invalid priority class.
+ *******************************************************************/
+extern bool I2C_statistics(I2C_prio_t prio, I2C_stats_t *stats);
+extern void I2C_statistics_clear(void);
+
 /*******************************************************************
  * @brief Writes a value to a PCF8574 I2C device.
  *
@@ -66,6 +117,31 @@ extern int I2C_scan(uint8_t *I2C_list, int len);
  *******************************************************************/
 extern bool PCF8574_write(uint8_t address, int pin, int value);
 
+/*******************************************************************
+ * @brief Writes the shadow mask again, re-asserts the outputs after
+ *        a reset of the PCF8574.
+ *******************************************************************/
+extern bool PCF8574_refresh(uint8_t address);
+
+/*******************************************************************
+ * @brief Output transaction on the PCF8574 shadow mask.
+ *
+ * Stage any number of pin changes between begin and commit, the
+ * outermost commit writes them in one I2C transaction. Calls to
+ * PCF8574_write() inside a transaction are staged as well.
+ *
+ *   PCF8574_begin(address);
+ *   PCF8574_stage(pin, PCF8574_OFF);
+ *   ...
+ *   PCF8574_commit();
+ *
+ * @note Do not block (vTaskDelay) inside a transaction, other tasks
+ *       including the emergency stop wait for the commit.
+ *******************************************************************/
+extern void PCF8574_begin(uint8_t address);
+extern void PCF8574_stage(int pin, int value);
+extern bool PCF8574_commit(void);
+
 /*******************************************************************
  * @brief Reads the state of a specified output pin from a PCF8574 I2C device.
  *
@@ -31,18 +31,31 @@ extern TwoWire I2C_1;
  *
  * @return 0 if successful, -1 otherwise.
  *******************************************************************/
-static int MCP4725_read(uint8_t address, uint8_t *data, int len) {
-  int result, ndx = 0;
+typedef struct {
+  uint8_t address;
+  uint8_t *data;
+  int len;
+} MCP4725_read_job_t;
 
-  if (address != 0) {
-    I2C_1.requestFrom((int)address, len);
-    vTaskDelay(5 / portTICK_PERIOD_MS);  // Wait for the data to be available
-    if (!I2C_1.endTransmission()) {
-      while (I2C_1.available() && (ndx++ < len)) {
-        *data++ = I2C_1.read();
-      }
-      return 0;  // Ok
+static int MCP4725_read_job(void *arg) {
+  MCP4725_read_job_t *job = (MCP4725_read_job_t *)arg;
+  uint8_t *data = job->data;
+  int ndx = 0;
+
+  I2C_1.requestFrom((int)job->address, job->len);  // Synchronous, no wait on the bus owner
+  if (!I2C_1.endTransmission()) {
+    while (I2C_1.available() && (ndx++ < job->len)) {
+      *data++ = I2C_1.read();
     }
+    return 0;  // Ok
+  }
+  return -1;
+}
+
+static int MCP4725_read(uint8_t address, uint8_t *data, int len) {
+  if (address != 0) {
+    MCP4725_read_job_t job = {address, data, len};
+    return I2C_transaction(I2C_PRIO_DIAGNOSTIC, MCP4725_read_job, &job);
   }
   return -1;  // Invalid address
 }
@@ -99,21 +112,32 @@ int MCP4725_read_status(uint8_t address) {
  *
  * @return 0 if successful, -1 otherwise.
  *******************************************************************/
-int MCP4725_write(uint8_t address, uint16_t value) {
+typedef struct {
+  uint8_t address;
+  uint16_t value;
+} MCP4725_write_job_t;
 
-  if (address != 0) {
-    value <<= 4;  // Shift 12 Bit Value to 16 Bit
-
-    I2C_1.beginTransmission(address);             // Set the MCP4725 address
-    if (I2C_1.write(MCP4725_CMD_WRITEDAC) == 1) { // Write command to analog output
-      if (I2C_1.write(highByte(value)) == 1) {    // Upper data bits (D11.D10.D9.D8.D7.D6.D5.D4)
-        if (I2C_1.write(lowByte(value)) == 1) {   // Lower data bits (D3.D2.D1.D0.x.x.x.x)
-          return int(I2C_1.endTransmission());    // End transmission
-        }
+static int MCP4725_write_job(void *arg) {
+  MCP4725_write_job_t *job = (MCP4725_write_job_t *)arg;
+  uint16_t value = job->value << 4;  // Shift 12 Bit Value to 16 Bit
+
+  I2C_1.beginTransmission(job->address);        // Set the MCP4725 address
+  if (I2C_1.write(MCP4725_CMD_WRITEDAC) == 1) { // Write command to analog output
+    if (I2C_1.write(highByte(value)) == 1) {    // Upper data bits (D11.D10.D9.D8.D7.D6.D5.D4)
+      if (I2C_1.write(lowByte(value)) == 1) {   // Lower data bits (D3.D2.D1.D0.x.x.x.x)
+        return int(I2C_1.endTransmission());    // End transmission
       }
     }
-    return 0; // Ok
+  }
+  return 0; // Ok
+}
+
+int MCP4725_write(uint8_t address, uint16_t value) {
+
+  if (address != 0) {
+    MCP4725_write_job_t job = {address, value};
+    return I2C_transaction(I2C_PRIO_DAC, MCP4725_write_job, &job);
   }
 
   return -1;  // Write failed
-}
\ No newline at end of file
+}
@@ -16,6 +16,13 @@
 extern TwoWire I2C_1;
 static int PCF8574_mask = 0xFF;
 
+/* Output transaction */
+static SemaphoreHandle_t PCF8574_lock = NULL;
+static int PCF8574_depth = 0;
+static bool PCF8574_dirty = false;
+static bool PCF8574_result = true;
+static uint8_t PCF8574_commit_address = 0;
+
 /*******************************************************************
  * @brief Sets the value of a PCF8574 I2C device.
  *
@@ -26,20 +33,106 @@ static int PCF8574_mask = 0xFF;
  *
  * @return True if the transmission was successful, false otherwise.
  *******************************************************************/
-static bool PCF8574_set(uint8_t address, uint8_t data) {
-  if (!address) return false;  // No valid I2C address
+typedef struct {
+  uint8_t address;
+  uint8_t data;
+} PCF8574_job_t;
+
+static int PCF8574_set_job(void *arg) {
+  PCF8574_job_t *job = (PCF8574_job_t *)arg;
 
-  I2C_1.beginTransmission(address);
-  if (I2C_1.write(data) == 1) {
+  I2C_1.beginTransmission(job->address);
+  if (I2C_1.write(job->data) == 1) {
     return (!I2C_1.endTransmission()) ? true : false;
   }
   return false;
 }
 
+static bool PCF8574_set(uint8_t address, uint8_t data) {
+  if (!address) return false;  // No valid I2C address
+
+  PCF8574_job_t job = {address, data};
+  return I2C_transaction(I2C_PRIO_SAFETY, PCF8574_set_job, &job);
+}
+
+/*******************************************************************
+ * @brief Opens an output transaction on the PCF8574 shadow mask.
+ *
+ * Transactions nest, only the outermost commit writes the mask.
+ * The transaction is owned by the calling task until committed.
+ *
+ * @param address The I2C address of the PCF8574 device.
+ *******************************************************************/
+void PCF8574_begin(uint8_t address) {
+  if (!PCF8574_lock)
+    PCF8574_lock = xSemaphoreCreateRecursiveMutex();  // First call from setup()
+
+  xSemaphoreTakeRecursive(PCF8574_lock, portMAX_DELAY);
+  if (PCF8574_depth++ == 0) {
+    PCF8574_commit_address = address;
+    PCF8574_result = true;
+  }
+}
+
+/*******************************************************************
+ * @brief Stages a pin change in the open output transaction.
+ *
+ * @param pin The output pin number to be set.
+ * @param value PCF8574_ON, PCF8574_OFF or PCF8574_RESET (all off).
+ *******************************************************************/
+void PCF8574_stage(int pin, int value) {
+  int mask = PCF8574_mask;
+
+  switch (value) {
+    case PCF8574_RESET:
+      mask = 0xFF;  // Reset
+      PCF8574_dirty = true;  // Always written
+      break;
+    case PCF8574_OFF:
+      mask |= (1 << pin);  // 1 is output OFF
+      break;
+    case PCF8574_ON:
+      mask &= ~(1 << pin);  // 0 is output ON
+      break;
+    default:
+      // No action
+      break;
+  }
+
+  if (mask != PCF8574_mask) {
+    PCF8574_mask = mask;
+    PCF8574_dirty = true;
+  }
+}
+
+/*******************************************************************
+ * @brief Closes an output transaction.
+ *
+ * The outermost commit writes all staged changes in one I2C
+ * transaction, nothing is written when the mask did not change and
+ * the previous write succeeded.
+ *
+ * @return True if the (last) write was successful, false otherwise.
+ *******************************************************************/
+bool PCF8574_commit(void) {
+  bool result;
+
+  if (--PCF8574_depth == 0 && PCF8574_dirty) {
+    PCF8574_result = PCF8574_set(PCF8574_commit_address, PCF8574_mask);
+    PCF8574_dirty = !PCF8574_result;  // Not written, retried with the next commit
+  }
+  result = PCF8574_result;
+
+  xSemaphoreGiveRecursive(PCF8574_lock);
+  return result;
+}
+
 /*******************************************************************
  * @brief Writes a value to a PCF8574 I2C device.
  *
  * This function writes a value to a PCF8574 I2C device at the specified address.
+ * The mask is written even when the pin did not change. Inside an open
+ * transaction the change is only staged.
  *
  * @param address The I2C address of the PCF8574 device.
  * @param pin The output pin number to be set.
@@ -48,30 +141,26 @@ static bool PCF8574_set(uint8_t address, uint8_t data) {
  * @return True if the write was successful, false otherwise.
  *******************************************************************/
 bool PCF8574_write(uint8_t address, int pin, int value) {
-    switch (value) {
-        case PCF8574_RESET:
-            /**
-             * @brief Resets the PCF8574 device.
-             */
-            PCF8574_mask = 0xFF;  // Reset
-            break;
-        case PCF8574_OFF:
-            /**
-             * @brief Sets the specified output pin to OFF.
-             */
-            PCF8574_mask |= (1 << pin);  // 1 is output OFF
-            break;
-        case PCF8574_ON:
-            /**
-             * @brief Sets the specified output pin to ON.
-             */
-            PCF8574_mask &= ~(1 << pin);  // 0 is output ON
-            break;
-        default:
-            // No action
-            break;
-    }
-    return PCF8574_set(address, PCF8574_mask);
+  PCF8574_begin(address);
+  PCF8574_stage(pin, value);
+  PCF8574_dirty = true;  // Always written, the chip may have been reset
+  return PCF8574_commit();
+}
+
+/*******************************************************************
+ * @brief Writes the shadow mask again.
+ *
+ * A brown-out or power-on reset of the PCF8574 turns all outputs
+ * OFF behind the shadow mask, called periodically to re-assert it.
+ *
+ * @param address The I2C address of the PCF8574 device.
+ *
+ * @return True if the write was successful, false otherwise.
+ *******************************************************************/
+bool PCF8574_refresh(uint8_t address) {
+  PCF8574_begin(address);
+  PCF8574_dirty = true;
+  return PCF8574_commit();
 }
 
 /*******************************************************************
@@ -85,7 +174,16 @@ bool PCF8574_write(uint8_t address, int pin, int value) {
  * @return PCF8575_ON if the specified output was ON, PCF8575_OFF otherwise.
  *******************************************************************/
 int PCF8574_read(uint8_t address, int pin) {
+    int mask;
+
     (void)address;
 
-    return (PCF8574_mask & (1 << pin)) ? PCF8574_OFF : PCF8574_ON;
+    if (!PCF8574_lock)
+        return (PCF8574_mask & (1 << pin)) ? PCF8574_OFF : PCF8574_ON;  // Before setup
+
+    xSemaphoreTakeRecursive(PCF8574_lock, portMAX_DELAY);
+    mask = PCF8574_mask;
+    xSemaphoreGiveRecursive(PCF8574_lock);
+
+    return (mask & (1 << pin)) ? PCF8574_OFF : PCF8574_ON;
 }
\ No newline at end of file
@@ -6,15 +6,176 @@
  *******************************************************************/
 #include "EBC_IOLib.h"
 
+#include <esp_timer.h>
+
 /*******************************************************************
  * Definitions
  *******************************************************************/
+#define I2C_QUEUE_LEN 8  // Pending transactions per priority
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+typedef struct {
+  I2C_job_fn fn;
+  void *arg;
+  int *result;
+  volatile bool *done;
+  TaskHandle_t caller;
+  int64_t queued_us;
+} I2C_job_t;
 
 /*******************************************************************
  * Variables
  *******************************************************************/
 TwoWire I2C_1 = TwoWire(0);
 
+static QueueHandle_t I2C_queue[I2C_PRIO_COUNT];
+static SemaphoreHandle_t I2C_pending = NULL;
+static TaskHandle_t I2C_task_handle = NULL;
+static I2C_stats_t I2C_stats[I2C_PRIO_COUNT];
+
+/*******************************************************************
+ * @brief Updates the latency statistics of a priority class.
+ *
+ * @param prio The priority class of the transaction.
+ * @param queued_us Time the transaction was submitted.
+ * @param started_us Time the bus owner started the transaction.
+ *******************************************************************/
+static void I2C_stats_update(int prio, int64_t queued_us, int64_t started_us) {
+  I2C_stats_t *stats = &I2C_stats[prio];
+  int64_t now = esp_timer_get_time();
+
+  stats->count++;
+  stats->wait_last_us = (uint32_t)(started_us - queued_us);
+  stats->latency_last_us = (uint32_t)(now - queued_us);
+  stats->latency_total_us += stats->latency_last_us;
+
+  if (stats->wait_last_us > stats->wait_max_us)
+    stats->wait_max_us = stats->wait_last_us;
+  if (stats->latency_last_us > stats->latency_max_us)
+    stats->latency_max_us = stats->latency_last_us;
+}
+
+/*******************************************************************
+ * @brief I2C bus owner task.
+ *
+ * Executes queued transactions one at a time, always taking the
+ * highest priority queue first, and signals the waiting caller.
+ *******************************************************************/
+static void I2C_owner_task(void *parameter) {
+  (void)parameter;
+  I2C_job_t job;
+  int prio;
+
+  while (true) {
+    xSemaphoreTake(I2C_pending, portMAX_DELAY);
+
+    for (prio = 0; prio < I2C_PRIO_COUNT; prio++) {
+      if (xQueueReceive(I2C_queue[prio], &job, 0) == pdTRUE)
+        break;
+    }
+    if (prio == I2C_PRIO_COUNT)
+      continue;
+
+    int64_t started_us = esp_timer_get_time();
+    *job.result = job.fn(job.arg);
+    I2C_stats_update(prio, job.queued_us, started_us);
+
+    /* The caller waits for *done, it is the last access to its stack */
+    xTaskNotifyGive(job.caller);
+    *job.done = true;
+  }
+}
+
+/*******************************************************************
+ * @brief Executes a transaction on the I2C bus owner task.
+ *
+ * Before I2C_start() (setup) and when called from the owner task
+ * itself the transaction is executed directly.
+ *
+ * @param prio Priority class (safety, DAC, diagnostics).
+ * @param fn Transaction function, executed with exclusive bus access.
+ * @param arg Argument passed to fn.
+ *
+ * @return The return value of fn.
+ *******************************************************************/
+int I2C_transaction(I2C_prio_t prio, I2C_job_fn fn, void *arg) {
+  volatile bool done = false;
+  uint32_t taken = 0;
+  I2C_job_t job;
+  int result = -1;
+
+  if (!I2C_task_handle || (xTaskGetCurrentTaskHandle() == I2C_task_handle)) {
+    int64_t started_us = esp_timer_get_time();
+    result = fn(arg);
+    I2C_stats_update(prio, started_us, started_us);
+    return result;
+  }
+
+  job.fn = fn;
+  job.arg = arg;
+  job.result = &result;
+  job.done = &done;
+  job.caller = xTaskGetCurrentTaskHandle();
+  job.queued_us = esp_timer_get_time();
+
+  xQueueSend(I2C_queue[prio], &job, portMAX_DELAY);
+  xSemaphoreGive(I2C_pending);
+
+  /*
+   * Completion. The caller may use its notification for other wakeups
+   * (steering tick), exactly one is consumed and the others are given
+   * back. The owner notifies before it sets done, the short timeout
+   * covers a wakeup between the two.
+   */
+  while (!done) {
+    taken += ulTaskNotifyTake(pdFALSE, 1) ? 1 : 0;
+  }
+  if (taken == 0) {
+    ulTaskNotifyTake(pdFALSE, 0);
+  }
+  while (taken-- > 1) {
+    xTaskNotifyGive(job.caller);
+  }
+
+  return result;
+}
+
+/*******************************************************************
+ * @brief Returns a copy of the statistics of a priority class.
+ *******************************************************************/
+bool I2C_statistics(I2C_prio_t prio, I2C_stats_t *stats) {
+  if ((prio < 0) || (prio >= I2C_PRIO_COUNT))
+    return false;
+
+  *stats = I2C_stats[prio];
+  return true;
+}
+
+/*******************************************************************
+ * @brief Clears the statistics of all priority classes.
+ *******************************************************************/
+void I2C_statistics_clear(void) {
+  memset(I2C_stats, 0, sizeof(I2C_stats));
+}
+
+/*******************************************************************
+ * @brief Starts the I2C bus owner task.
+ *
+ * From now on all bus transactions are serialised by this task.
+ *******************************************************************/
+void I2C_start(void) {
+  if (I2C_task_handle)
+    return;
+
+  for (int prio = 0; prio < I2C_PRIO_COUNT; prio++)
+    I2C_queue[prio] = xQueueCreate(I2C_QUEUE_LEN, sizeof(I2C_job_t));
+  I2C_pending = xSemaphoreCreateCounting(I2C_PRIO_COUNT * I2C_QUEUE_LEN, 0);
+
+  xTaskCreate(I2C_owner_task, "I2C bus", 2048, NULL, configMAX_PRIORITIES - 2, &I2C_task_handle);
+}
+
 /*******************************************************************
  * @brief Starts the I2C/TwoWire driver.
  *
@@ -43,20 +204,33 @@ bool I2C_setup(int sda0, int scl0) {
  * @return The number of devices found on the I2C bus. 
  * If no devices are found, it returns 0.
  *******************************************************************/
-int I2C_scan(uint8_t *I2C_list, int len) {
+typedef struct {
+  uint8_t *list;
+  int len;
+} I2C_scan_job_t;
+
+static int I2C_scan_job(void *arg) {
+  I2C_scan_job_t *job = (I2C_scan_job_t *)arg;
+  uint8_t *I2C_list = job->list;
   byte address;
   int index = 0;
 
-  memset(I2C_list, 0, len);
+  memset(I2C_list, 0, job->len);
 
   for (address = 1; address < 127; address++) {
     I2C_1.beginTransmission(address);
     if (!I2C_1.endTransmission()) {
-      if (index < len) {
+      if (index < job->len) {
         *I2C_list++ = address;  // Store address in array
         index++;
       }
     }
   }
   return index;
+}
+
+int I2C_scan(uint8_t *I2C_list, int len) {
+  I2C_scan_job_t job = {I2C_list, len};
+
+  return I2C_transaction(I2C_PRIO_DIAGNOSTIC, I2C_scan_job, &job);
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+/*******************************************************************
+ * Arena.cpp
+ *
+ * Bump allocator over a fixed buffer, reset as a whole.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define ARENA_HEADER ARENA_ALIGN  // Block size, keeps the data aligned
+#define ARENA_NONE 0xFFFFFFFFu    // No last block
+
+static uint32_t ARENA_round(uint32_t size) {
+  return (size + ARENA_ALIGN - 1) & ~(uint32_t)(ARENA_ALIGN - 1);
+}
+
+static uint32_t *ARENA_header(const void *block) {
+  return (uint32_t *)((uint8_t *)block - ARENA_HEADER);
+}
+
+static bool ARENA_is_last(const ARENA_t *arena, const void *block) {
+  return (arena->last != ARENA_NONE) && ((const uint8_t *)block == &arena->buffer[arena->last + ARENA_HEADER]);
+}
+
+/*******************************************************************
+ * Arena
+ *******************************************************************/
+void ARENA_init(ARENA_t *arena, void *buffer, uint32_t size) {
+  const uintptr_t start = ((uintptr_t)buffer + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+  const uint32_t skip = (uint32_t)(start - (uintptr_t)buffer);
+
+  memset(arena, 0, sizeof(*arena));
+  arena->buffer = (uint8_t *)start;
+  arena->size = (size > skip) ? ((size - skip) & ~(uint32_t)(ARENA_ALIGN - 1)) : 0;
+  arena->last = ARENA_NONE;
+}
+
+void ARENA_reset(ARENA_t *arena) {
+  arena->used = 0;
+  arena->last = ARENA_NONE;
+}
+
+bool ARENA_owns(const ARENA_t *arena, const void *block) {
+  return ((const uint8_t *)block >= arena->buffer) && ((const uint8_t *)block < &arena->buffer[arena->size]);
+}
+
+uint32_t ARENA_block_size(const ARENA_t *arena, const void *block) {
+  return ARENA_owns(arena, block) ? *ARENA_header(block) : 0;
+}
+
+/*******************************************************************
+ * Blocks
+ *******************************************************************/
+void *ARENA_alloc(ARENA_t *arena, uint32_t size) {
+  const uint32_t needed = ARENA_HEADER + ARENA_round(size);
+
+  if ((size > arena->size) || (needed > arena->size - arena->used)) {
+    arena->full++;
+    return nullptr;
+  }
+
+  uint8_t *header = &arena->buffer[arena->used];
+  *(uint32_t *)header = size;
+  arena->last = arena->used;
+  arena->used += needed;
+  arena->allocations++;
+  if (arena->used > arena->peak) {
+    arena->peak = arena->used;
+  }
+  return header + ARENA_HEADER;
+}
+
+void *ARENA_realloc(ARENA_t *arena, void *block, uint32_t size) {
+  if (!block) {
+    return ARENA_alloc(arena, size);
+  }
+
+  if (ARENA_is_last(arena, block)) {
+    const uint32_t end = arena->last + ARENA_HEADER + ARENA_round(size);
+
+    if ((size > arena->size) || (end > arena->size)) {
+      arena->full++;
+      return nullptr;
+    }
+    *ARENA_header(block) = size;
+    arena->used = end;
+    if (arena->used > arena->peak) {
+      arena->peak = arena->used;
+    }
+    return block;
+  }
+
+  const uint32_t old_size = *ARENA_header(block);
+  if (size <= old_size) {
+    *ARENA_header(block) = size;  // Shrinks, the space stays until the reset
+    return block;
+  }
+
+  void *moved = ARENA_alloc(arena, size);
+  if (moved) {
+    memcpy(moved, block, old_size);
+  }
+  return moved;
+}
+
+void ARENA_free(ARENA_t *arena, void *block) {
+  if (block && ARENA_is_last(arena, block)) {
+    arena->used = arena->last;
+    arena->last = ARENA_NONE;  // The one before is not known, stays
+  }
+}
@@ -0,0 +1,337 @@
+/*******************************************************************
+ * CanFilter.cpp
+ *
+ * Compiles identifier/mask rules into CAN controller acceptance
+ * filters (ESP32 TWAI, MCP2515).
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define CANFILTER_MAX_RULES 32
+
+/* ESP32 TWAI register layout, single filter mode */
+#define TWAI_SINGLE_STD_SHIFT 21
+#define TWAI_SINGLE_EXT_SHIFT 3
+#define TWAI_SINGLE_STD_BITS 0xFFE00000UL
+#define TWAI_SINGLE_EXT_BITS 0xFFFFFFF8UL
+
+/* Dual filter mode, per 16 bit filter. Extended frames compare
+ * ID28..ID13 (shifted down), the low nibble is left open as it
+ * overlaps the data nibble of filter 1 for standard frames. */
+#define TWAI_DUAL_STD_SHIFT 5
+#define TWAI_DUAL_EXT_SHIFT -13
+#define TWAI_DUAL_STD_BITS 0xFFE0UL
+#define TWAI_DUAL_EXT_BITS 0xFFF0UL
+
+/* MCP2515 register layout, SID in bits 28..18 */
+#define MCP_STD_SHIFT 18
+#define MCP_STD_BITS 0x1FFC0000UL
+#define MCP_EXT_BITS 0x1FFFFFFFUL
+#define MCP_GROUP0_FILTERS 2
+#define MCP_GROUP1_FILTERS 4
+
+typedef struct {
+  uint32_t code;
+  uint32_t care;  // 1 is compare
+  uint8_t ext;
+} CANFILTER_item_t;
+
+static int CANFILTER_bits(uint32_t value) {
+  return __builtin_popcount(value);
+}
+
+static uint32_t CANFILTER_shift(uint32_t value, int shift) {
+  return (shift < 0) ? (value >> -shift) : (value << shift);
+}
+
+static uint32_t CANFILTER_accept(uint32_t care, uint32_t bits) {
+  return CANFILTER_ACCEPT_ALL >> CANFILTER_bits(care & bits);
+}
+
+static uint32_t CANFILTER_average(uint32_t std_ppm, uint32_t ext_ppm) {
+  if (std_ppm > CANFILTER_ACCEPT_ALL) {
+    std_ppm = CANFILTER_ACCEPT_ALL;
+  }
+  if (ext_ppm > CANFILTER_ACCEPT_ALL) {
+    ext_ppm = CANFILTER_ACCEPT_ALL;
+  }
+  return (std_ppm + ext_ppm) / 2;
+}
+
+/*******************************************************************
+ * Rules to filter items in a register layout, a negative shift
+ * moves the identifier down.
+ *******************************************************************/
+static int CANFILTER_items(const CANFILTER_rule_t *rules, int num_rules, CANFILTER_item_t *items,
+                           int std_shift, uint32_t std_bits, int ext_shift, uint32_t ext_bits) {
+  if (num_rules > CANFILTER_MAX_RULES) {
+    num_rules = CANFILTER_MAX_RULES;
+  }
+
+  for (int i = 0; i < num_rules; i++) {
+    CANFILTER_item_t *item = &items[i];
+    const bool ext = (rules[i].id & DISPATCH_ID_EXT) ? true : false;
+
+    if (ext) {
+      item->code = CANFILTER_shift(rules[i].id & DISPATCH_MASK_EXT, ext_shift);
+      item->care = CANFILTER_shift(rules[i].mask & DISPATCH_MASK_EXT, ext_shift) & ext_bits;
+    } else {
+      item->code = CANFILTER_shift(rules[i].id & DISPATCH_MASK_STD, std_shift);
+      item->care = CANFILTER_shift(rules[i].mask & DISPATCH_MASK_STD, std_shift) & std_bits;
+    }
+    item->code &= item->care;
+    item->ext = ext ? 1 : 0;
+  }
+
+  return num_rules;
+}
+
+/*******************************************************************
+ * Merges the pair of items that keeps the most compared bits until
+ * at most `target` items are left.
+ *******************************************************************/
+static int CANFILTER_merge(CANFILTER_item_t *items, int count, int target, bool same_format) {
+  while (count > target) {
+    int best_i = -1, best_j = -1, best_bits = -1;
+    uint32_t best_care = 0;
+
+    for (int i = 0; i < count; i++) {
+      for (int j = i + 1; j < count; j++) {
+        if (same_format && (items[i].ext != items[j].ext)) {
+          continue;
+        }
+
+        uint32_t care = items[i].care & items[j].care & ~(items[i].code ^ items[j].code);
+        int bits = CANFILTER_bits(care);
+
+        if (bits > best_bits) {
+          best_i = i;
+          best_j = j;
+          best_bits = bits;
+          best_care = care;
+        }
+      }
+    }
+
+    if (best_i < 0) {
+      break;
+    }
+
+    items[best_i].care = best_care;
+    items[best_i].code &= best_care;
+    items[best_j] = items[--count];
+  }
+
+  return count;
+}
+
+/*******************************************************************
+ * TWAI, single filter mode
+ *******************************************************************/
+static void CANFILTER_twai_single(const CANFILTER_rule_t *rules, int num_rules, CANFILTER_twai_t *twai) {
+  CANFILTER_item_t items[CANFILTER_MAX_RULES];
+  int count = CANFILTER_items(rules, num_rules, items, TWAI_SINGLE_STD_SHIFT, TWAI_SINGLE_STD_BITS,
+                              TWAI_SINGLE_EXT_SHIFT, TWAI_SINGLE_EXT_BITS);
+
+  CANFILTER_merge(items, count, 1, false);
+
+  twai->mode = CANFILTER_TWAI_SINGLE;
+  twai->code = items[0].code;
+  twai->mask = ~items[0].care;
+  twai->accept_ppm = CANFILTER_average(CANFILTER_accept(items[0].care, TWAI_SINGLE_STD_BITS),
+                                       CANFILTER_accept(items[0].care, TWAI_SINGLE_EXT_BITS));
+}
+
+/*******************************************************************
+ * TWAI, dual filter mode
+ *******************************************************************/
+static void CANFILTER_twai_dual(const CANFILTER_rule_t *rules, int num_rules, CANFILTER_twai_t *twai) {
+  CANFILTER_item_t items[CANFILTER_MAX_RULES];
+  int count = CANFILTER_items(rules, num_rules, items, TWAI_DUAL_STD_SHIFT, TWAI_DUAL_STD_BITS,
+                              TWAI_DUAL_EXT_SHIFT, TWAI_DUAL_EXT_BITS);
+
+  count = CANFILTER_merge(items, count, 2, false);
+  if (count < 2) {
+    items[1] = items[0];
+  }
+
+  twai->mode = CANFILTER_TWAI_DUAL;
+  twai->code = (items[0].code << 16) | items[1].code;
+  twai->mask = ~((items[0].care << 16) | items[1].care);
+
+  uint32_t std_ppm = CANFILTER_accept(items[0].care, TWAI_DUAL_STD_BITS);
+  uint32_t ext_ppm = CANFILTER_accept(items[0].care, TWAI_DUAL_EXT_BITS);
+  if ((items[1].code != items[0].code) || (items[1].care != items[0].care)) {
+    std_ppm += CANFILTER_accept(items[1].care, TWAI_DUAL_STD_BITS);
+    ext_ppm += CANFILTER_accept(items[1].care, TWAI_DUAL_EXT_BITS);
+  }
+  twai->accept_ppm = CANFILTER_average(std_ppm, ext_ppm);
+}
+
+/*******************************************************************
+ * Compiles rules into the ESP32 TWAI acceptance filter.
+ *******************************************************************/
+void CANFILTER_twai(const CANFILTER_rule_t *rules, int num_rules, CANFILTER_twai_t *twai) {
+  CANFILTER_twai_t dual;
+
+  if (num_rules <= 0) {
+    twai->mode = CANFILTER_TWAI_SINGLE;
+    twai->code = 0;
+    twai->mask = 0xFFFFFFFFUL;
+    twai->accept_ppm = CANFILTER_ACCEPT_ALL;
+    return;
+  }
+
+  CANFILTER_twai_single(rules, num_rules, twai);
+  CANFILTER_twai_dual(rules, num_rules, &dual);
+
+  if (dual.accept_ppm < twai->accept_ppm) {
+    *twai = dual;
+  }
+}
+
+/*******************************************************************
+ * MCP2515, mask of a filter group
+ *******************************************************************/
+static uint32_t CANFILTER_mcp_mask(const CANFILTER_item_t *items, int count, uint32_t group) {
+  uint32_t mask = MCP_EXT_BITS;
+
+  for (int i = 0; i < count; i++) {
+    if (group & (1UL << i)) {
+      mask &= items[i].care;
+      if (!items[i].ext) {
+        mask &= MCP_STD_BITS;  // EID bits compare data bytes of standard frames
+      }
+    }
+  }
+
+  return mask;
+}
+
+/*******************************************************************
+ * MCP2515, acceptance of one assignment of items to the groups
+ *******************************************************************/
+static uint32_t CANFILTER_mcp_score(const CANFILTER_item_t *items, int count, uint32_t group0) {
+  uint32_t std_ppm = 0, ext_ppm = 0;
+
+  for (int g = 0; g < CANFILTER_MCP_MASKS; g++) {
+    const uint32_t group = g ? (~group0 & ((1UL << count) - 1)) : group0;
+    const uint32_t mask = CANFILTER_mcp_mask(items, count, group);
+
+    for (int i = 0; i < count; i++) {
+      bool duplicate = false;
+
+      if (!(group & (1UL << i))) {
+        continue;
+      }
+      for (int j = 0; j < i; j++) {
+        if ((group & (1UL << j)) && (items[j].ext == items[i].ext) &&
+            ((items[j].code & mask) == (items[i].code & mask))) {
+          duplicate = true;
+        }
+      }
+      if (duplicate) {
+        continue;
+      }
+
+      if (items[i].ext) {
+        ext_ppm += CANFILTER_accept(mask, MCP_EXT_BITS);
+      } else {
+        std_ppm += CANFILTER_accept(mask, MCP_STD_BITS);
+      }
+    }
+  }
+
+  return CANFILTER_average(std_ppm, ext_ppm);
+}
+
+/*******************************************************************
+ * MCP2515, fills the registers of one group
+ *******************************************************************/
+static void CANFILTER_mcp_group(const CANFILTER_item_t *items, int count, uint32_t group,
+                                CANFILTER_mcp_t *mcp, int num, int first, int slots) {
+  int slot = first;
+
+  mcp->mask[num] = CANFILTER_mcp_mask(items, count, group);
+
+  for (int i = 0; i < count && slot < first + slots; i++) {
+    if (group & (1UL << i)) {
+      mcp->filter[slot] = items[i].code & mcp->mask[num];
+      mcp->ext[slot] = items[i].ext;
+      slot++;
+    }
+  }
+
+  /* Unused filters repeat the first one */
+  for (; slot < first + slots; slot++) {
+    mcp->filter[slot] = mcp->filter[first];
+    mcp->ext[slot] = mcp->ext[first];
+  }
+}
+
+/*******************************************************************
+ * Compiles rules into the MCP2515 masks and filters.
+ *******************************************************************/
+void CANFILTER_mcp2515(const CANFILTER_rule_t *rules, int num_rules, CANFILTER_mcp_t *mcp) {
+  CANFILTER_item_t items[CANFILTER_MAX_RULES];
+  uint32_t best_group0 = 0, best_ppm = 0xFFFFFFFFUL;
+
+  memset(mcp, 0, sizeof(*mcp));
+
+  if (num_rules <= 0) {
+    /* Masks cleared, RXB0 filters standard and RXB1 filters extended
+     * frames (EXIDE is compared whatever the mask) */
+    for (int slot = MCP_GROUP0_FILTERS; slot < CANFILTER_MCP_FILTERS; slot++) {
+      mcp->ext[slot] = 1;
+    }
+    mcp->accept_ppm = CANFILTER_ACCEPT_ALL;
+    return;
+  }
+
+  int count = CANFILTER_items(rules, num_rules, items, MCP_STD_SHIFT, MCP_STD_BITS, 0, MCP_EXT_BITS);
+  count = CANFILTER_merge(items, count, CANFILTER_MCP_FILTERS, true);
+
+  /* Try every split over RXM0 (2 filters) and RXM1 (4 filters) */
+  for (uint32_t group0 = 0; group0 < (1UL << count); group0++) {
+    const int size0 = CANFILTER_bits(group0);
+
+    if ((size0 > MCP_GROUP0_FILTERS) || ((count - size0) > MCP_GROUP1_FILTERS)) {
+      continue;
+    }
+
+    uint32_t ppm = CANFILTER_mcp_score(items, count, group0);
+    if (ppm < best_ppm) {
+      best_ppm = ppm;
+      best_group0 = group0;
+    }
+  }
+
+  const uint32_t group1 = ~best_group0 & ((1UL << count) - 1);
+
+  CANFILTER_mcp_group(items, count, best_group0, mcp, 0, 0, MCP_GROUP0_FILTERS);
+  CANFILTER_mcp_group(items, count, group1, mcp, 1, MCP_GROUP0_FILTERS, MCP_GROUP1_FILTERS);
+
+  /* An empty group compares all bits against a filter of the other
+   * group, it accepts nothing the other group does not accept */
+  if (!best_group0) {
+    mcp->mask[0] = MCP_EXT_BITS;
+    for (int slot = 0; slot < MCP_GROUP0_FILTERS; slot++) {
+      mcp->filter[slot] = mcp->filter[MCP_GROUP0_FILTERS];
+      mcp->ext[slot] = mcp->ext[MCP_GROUP0_FILTERS];
+    }
+  }
+  if (!group1) {
+    mcp->mask[1] = MCP_EXT_BITS;
+    for (int slot = MCP_GROUP0_FILTERS; slot < CANFILTER_MCP_FILTERS; slot++) {
+      mcp->filter[slot] = mcp->filter[0];
+      mcp->ext[slot] = mcp->ext[0];
+    }
+  }
+
+  mcp->accept_ppm = best_ppm;
+}
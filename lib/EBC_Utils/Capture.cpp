@@ -0,0 +1,160 @@
+/*******************************************************************
+ * Capture.cpp
+ *
+ * Binary CAN capture records, candump text and the double buffer
+ * between the receive path and the flash writer.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************
+ * File header
+ *******************************************************************/
+void CAPTURE_header_init(CAPTURE_header_t *header, uint64_t base_us) {
+  memset(header, 0, sizeof(*header));
+  header->magic = CAPTURE_MAGIC;
+  header->version = CAPTURE_VERSION;
+  header->record_size = sizeof(CAPTURE_record_t);
+  header->base_us = base_us;
+}
+
+bool CAPTURE_header_valid(const CAPTURE_header_t *header) {
+  return (header->magic == CAPTURE_MAGIC) && (header->version == CAPTURE_VERSION) &&
+         (header->record_size == sizeof(CAPTURE_record_t));
+}
+
+/*******************************************************************
+ * Records
+ *******************************************************************/
+void CAPTURE_encode(const CAN_frame_t *frame, bool tx, uint64_t now_us, CAPTURE_record_t *record) {
+  record->time_us = (uint32_t)now_us;
+  record->id = frame->id & (frame->ext ? DISPATCH_MASK_EXT : DISPATCH_MASK_STD);
+  record->id |= (frame->ext ? CAPTURE_ID_EXT : 0) | (frame->rtr ? CAPTURE_ID_RTR : 0) | (tx ? CAPTURE_ID_TX : 0);
+  record->length = (frame->length > 8) ? 8 : frame->length;
+  record->channel = frame->channel;
+  record->reserved = 0;
+  memcpy(record->data, frame->data, sizeof(record->data));
+}
+
+void CAPTURE_decode(const CAPTURE_record_t *record, CAN_frame_t *frame, bool *tx) {
+  frame->ext = (record->id & CAPTURE_ID_EXT) ? 1 : 0;
+  frame->rtr = (record->id & CAPTURE_ID_RTR) ? 1 : 0;
+  frame->id = record->id & (frame->ext ? DISPATCH_MASK_EXT : DISPATCH_MASK_STD);
+  frame->length = (record->length > 8) ? 8 : record->length;
+  frame->channel = record->channel;
+  memcpy(frame->data, record->data, sizeof(frame->data));
+
+  if (tx) {
+    *tx = (record->id & CAPTURE_ID_TX) != 0;
+  }
+}
+
+uint64_t CAPTURE_time(uint64_t previous_us, const CAPTURE_record_t *record) {
+  return previous_us + (int64_t)(int32_t)(record->time_us - (uint32_t)previous_us);
+}
+
+/*******************************************************************
+ * candump log line, "(seconds.micros) canN id#data"
+ *******************************************************************/
+int CAPTURE_candump(const CAPTURE_record_t *record, uint64_t time_us, char *line, int size) {
+  static const char hex[] = "0123456789ABCDEF";
+  const bool ext = (record->id & CAPTURE_ID_EXT) != 0;
+  const uint8_t length = (record->length > 8) ? 8 : record->length;
+  char data[17];
+  int n;
+
+  if (record->id & CAPTURE_ID_RTR) {
+    strcpy(data, "R");
+  } else {
+    for (int i = 0; i < length; i++) {
+      data[2 * i] = hex[record->data[i] >> 4];
+      data[2 * i + 1] = hex[record->data[i] & 0x0F];
+    }
+    data[2 * length] = '\0';
+  }
+
+  n = snprintf(line, size, ext ? "(%lu.%06lu) can%u %08lX#%s\n" : "(%lu.%06lu) can%u %03lX#%s\n",
+               (unsigned long)(time_us / 1000000), (unsigned long)(time_us % 1000000), (unsigned)record->channel,
+               (unsigned long)(record->id & (ext ? DISPATCH_MASK_EXT : DISPATCH_MASK_STD)), data);
+
+  return (n < size) ? n : size - 1;
+}
+
+/*******************************************************************
+ * Double buffer
+ *******************************************************************/
+void CAPTURE_buffer_init(CAPTURE_buffer_t *buffer) {
+  buffer->count[0] = buffer->count[1] = 0;
+  buffer->full[0] = buffer->full[1] = false;
+  buffer->fill = 0;
+  buffer->records = 0;
+  buffer->dropped = 0;
+}
+
+static void CAPTURE_buffer_hand_over(CAPTURE_buffer_t *buffer) {
+  buffer->full[buffer->fill] = true;
+  if (!buffer->full[buffer->fill ^ 1]) {
+    buffer->fill ^= 1;
+  }
+}
+
+bool CAPTURE_buffer_put(CAPTURE_buffer_t *buffer, const CAPTURE_record_t *record) {
+  if (buffer->full[buffer->fill] && !buffer->full[buffer->fill ^ 1]) {
+    buffer->fill ^= 1;  // Writer released the other half
+  }
+  if (buffer->full[buffer->fill]) {
+    buffer->dropped++;
+    return false;
+  }
+
+  buffer->record[buffer->fill][buffer->count[buffer->fill]++] = *record;
+  buffer->records++;
+
+  if (buffer->count[buffer->fill] == CAPTURE_BUFFER_RECORDS) {
+    CAPTURE_buffer_hand_over(buffer);
+  }
+  return true;
+}
+
+bool CAPTURE_buffer_flush(CAPTURE_buffer_t *buffer) {
+  if (buffer->full[buffer->fill] || !buffer->count[buffer->fill]) {
+    return false;
+  }
+
+  CAPTURE_buffer_hand_over(buffer);
+  return true;
+}
+
+int CAPTURE_buffer_take(CAPTURE_buffer_t *buffer, uint16_t *count) {
+  int half;
+
+  /* The half not being filled was handed over first */
+  if (buffer->full[buffer->fill ^ 1]) {
+    half = buffer->fill ^ 1;
+  } else if (buffer->full[buffer->fill]) {
+    half = buffer->fill;
+  } else {
+    return -1;
+  }
+
+  *count = buffer->count[half];
+  return half;
+}
+
+void CAPTURE_buffer_release(CAPTURE_buffer_t *buffer, int half) {
+  buffer->count[half] = 0;
+  buffer->full[half] = false;
+}
+
+/*******************************************************************
+ * Replay pacing
+ *******************************************************************/
+uint64_t CAPTURE_replay_offset(uint64_t first_us, uint64_t time_us, uint16_t speed) {
+  if (!speed || (time_us < first_us)) {
+    return 0;
+  }
+  return (time_us - first_us) * 100 / speed;
+}
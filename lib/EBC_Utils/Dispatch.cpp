@@ -0,0 +1,249 @@
+/*******************************************************************
+ * Dispatch.cpp
+ *
+ * CAN frame dispatch to subscriptions on identifier and mask.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+static uint32_t DISPATCH_key(const CAN_frame_t *frame) {
+  return frame->ext ? ((frame->id & DISPATCH_MASK_EXT) | DISPATCH_ID_EXT) : (frame->id & DISPATCH_MASK_STD);
+}
+
+/*******************************************************************
+ * Calls one subscription handler and keeps the statistics.
+ *******************************************************************/
+static void DISPATCH_call(DISPATCH_table_t *table, const DISPATCH_call_t *call, const CAN_frame_t *frame) {
+  DISPATCH_subscription_t *sub = &table->sub[call->index];
+
+  sub->frames++;
+
+  if (!table->clock) {
+    call->handler(frame, call->context);
+    return;
+  }
+
+  uint32_t start = table->clock();
+  if (sub->frames > 1) {
+    const uint32_t interval = start - sub->arrival;
+
+    sub->interval.bucket[DISPATCH_interval_bucket(interval)]++;
+    if ((sub->frames == 2) || (interval < sub->interval.min)) {
+      sub->interval.min = interval;
+    }
+    if (interval > sub->interval.max) {
+      sub->interval.max = interval;
+    }
+  }
+  sub->arrival = start;
+
+  call->handler(frame, call->context);
+  sub->cost_last = table->clock() - start;
+  sub->cost_total += sub->cost_last;
+
+  if (sub->cost_last > sub->cost_max) {
+    sub->cost_max = sub->cost_last;
+  }
+  if (sub->budget && (sub->cost_last > sub->budget)) {
+    sub->over_budget++;
+  }
+}
+
+/*******************************************************************
+ * First entry in the sorted exact index with an id >= key.
+ *******************************************************************/
+static uint8_t DISPATCH_lower_bound(const DISPATCH_table_t *table, uint32_t key) {
+  uint8_t low = 0, high = table->num_exact;
+
+  while (low < high) {
+    uint8_t mid = (low + high) / 2;
+
+    if (table->sub[table->exact[mid]].id < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+/*******************************************************************
+ * Initialises an empty dispatch table.
+ *******************************************************************/
+void DISPATCH_init(DISPATCH_table_t *table, DISPATCH_clock_fn clock) {
+  memset(table, 0, sizeof(*table));
+  table->clock = clock;
+}
+
+/*******************************************************************
+ * Adds a subscription, full mask subscriptions are inserted in the
+ * sorted index behind those with the same identifier.
+ *******************************************************************/
+int DISPATCH_subscribe(DISPATCH_table_t *table, const char *name, uint32_t id, uint32_t mask,
+                       DISPATCH_handler_fn handler, void *context, uint32_t budget) {
+  if (!handler || (table->num_subs >= DISPATCH_MAX_SUBSCRIPTIONS)) {
+    return -1;
+  }
+
+  const uint32_t all = (id & DISPATCH_ID_EXT) ? DISPATCH_MASK_EXT : DISPATCH_MASK_STD;
+  const uint8_t index = table->num_subs++;
+  DISPATCH_subscription_t *sub = &table->sub[index];
+
+  memset(sub, 0, sizeof(*sub));
+  sub->name = name;
+  sub->mask = (mask & all) | DISPATCH_ID_EXT;
+  sub->id = id & sub->mask;
+  sub->handler = handler;
+  sub->context = context;
+  sub->budget = budget;
+  sub->enabled = true;
+
+  if ((mask & all) != all) {
+    table->masked[table->num_masked++] = index;
+    return index;
+  }
+
+  const uint8_t pos = DISPATCH_lower_bound(table, sub->id + 1);  // Behind the same id, id is at most 0x9FFFFFFF
+
+  memmove(&table->exact[pos + 1], &table->exact[pos], table->num_exact - pos);
+  table->exact[pos] = index;
+  table->num_exact++;
+
+  return index;
+}
+
+/*******************************************************************
+ * Enables or disables a subscription.
+ *******************************************************************/
+int DISPATCH_enable(DISPATCH_table_t *table, int index, bool enable) {
+  if ((index < 0) || (index >= table->num_subs)) {
+    return -1;
+  }
+  table->sub[index].enabled = enable;
+  return 0;
+}
+
+/*******************************************************************
+ * Collects the handlers of all matching subscriptions.
+ *******************************************************************/
+static void DISPATCH_add(DISPATCH_call_t *calls, int *num_calls, uint8_t index, const DISPATCH_subscription_t *sub) {
+  calls[*num_calls].index = index;
+  calls[*num_calls].handler = sub->handler;
+  calls[*num_calls].context = sub->context;
+  (*num_calls)++;
+}
+
+int DISPATCH_match(DISPATCH_table_t *table, const CAN_frame_t *frame, DISPATCH_call_t calls[DISPATCH_MAX_SUBSCRIPTIONS]) {
+  const uint32_t key = DISPATCH_key(frame);
+  int num_calls = 0;
+
+  table->frames++;
+
+  for (uint8_t i = DISPATCH_lower_bound(table, key); i < table->num_exact; i++) {
+    const DISPATCH_subscription_t *sub = &table->sub[table->exact[i]];
+
+    if (sub->id != key) {
+      break;
+    }
+    if (sub->enabled) {
+      DISPATCH_add(calls, &num_calls, table->exact[i], sub);
+    }
+  }
+
+  for (uint8_t i = 0; i < table->num_masked; i++) {
+    const DISPATCH_subscription_t *sub = &table->sub[table->masked[i]];
+
+    if (sub->enabled && ((key & sub->mask) == sub->id)) {
+      DISPATCH_add(calls, &num_calls, table->masked[i], sub);
+    }
+  }
+
+  if (!num_calls) {
+    table->unmatched++;
+  }
+
+  return num_calls;
+}
+
+/*******************************************************************
+ * Calls the collected handlers in order.
+ *******************************************************************/
+void DISPATCH_deliver(DISPATCH_table_t *table, const DISPATCH_call_t *calls, int num_calls, const CAN_frame_t *frame) {
+  for (int i = 0; i < num_calls; i++) {
+    DISPATCH_call(table, &calls[i], frame);
+  }
+}
+
+/*******************************************************************
+ * Delivers a frame to all matching subscriptions.
+ *******************************************************************/
+int DISPATCH_frame(DISPATCH_table_t *table, const CAN_frame_t *frame) {
+  DISPATCH_call_t calls[DISPATCH_MAX_SUBSCRIPTIONS];
+  const int num_calls = DISPATCH_match(table, frame, calls);
+
+  DISPATCH_deliver(table, calls, num_calls, frame);
+  return num_calls;
+}
+
+/*******************************************************************
+ * Clears the frame and handler statistics.
+ *******************************************************************/
+void DISPATCH_reset_stats(DISPATCH_table_t *table) {
+  table->frames = 0;
+  table->unmatched = 0;
+
+  for (uint8_t i = 0; i < table->num_subs; i++) {
+    DISPATCH_subscription_t *sub = &table->sub[i];
+
+    sub->frames = 0;
+    sub->cost_last = 0;
+    sub->cost_max = 0;
+    sub->cost_total = 0;
+    sub->over_budget = 0;
+    memset(&sub->interval, 0, sizeof(sub->interval));
+  }
+}
+
+/*******************************************************************
+ * Inter-arrival histogram
+ *******************************************************************/
+int DISPATCH_interval_bucket(uint32_t interval) {
+  int bucket = 0;
+
+  interval >>= DISPATCH_INTERVAL_SHIFT;
+  while (interval && (bucket < DISPATCH_INTERVAL_BUCKETS - 1)) {
+    interval >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+uint32_t DISPATCH_interval_bound(int bucket) {
+  return (bucket < DISPATCH_INTERVAL_BUCKETS - 1) ? (1UL << (DISPATCH_INTERVAL_SHIFT + bucket)) : UINT32_MAX;
+}
+
+uint32_t DISPATCH_interval_percentile(const DISPATCH_interval_t *interval, uint8_t percent) {
+  uint64_t total = 0;
+  uint64_t count = 0;
+
+  for (int i = 0; i < DISPATCH_INTERVAL_BUCKETS; i++) {
+    total += interval->bucket[i];
+  }
+  if (!total) {
+    return 0;
+  }
+
+  for (int i = 0; i < DISPATCH_INTERVAL_BUCKETS; i++) {
+    count += interval->bucket[i];
+    if (count * 100 >= total * percent) {
+      return DISPATCH_interval_bound(i);
+    }
+  }
+  return UINT32_MAX;
+}
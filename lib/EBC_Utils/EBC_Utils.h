@@ -7,6 +7,8 @@
 #ifndef EBC_UTILS_HEADER
 #define EBC_UTILS_HEADER
 
+#include <stdint.h>
+
 /*******************************************************************
  * Maps a value from one range to another range.
  *
@@ -35,4 +37,1402 @@ extern long mapl(long x, long in_min, long in_max, long out_min, long out_max);
  *******************************************************************/
 extern float mapf(float x, float in_min, float in_max, float out_min, float out_max);
 
+/*******************************************************************
+ * Steering linearisation
+ *
+ * Steering wheel ADC counts are linearised to LINEAR_MIN ...
+ * LINEAR_MAX with the middle at LINEAR_MIDDLE (left and right half
+ * calibrated separately), the linear value is mapped to the azimuth
+ * DAC output in the same way.
+ *******************************************************************/
+#define LINEAR_MIN 0
+#define LINEAR_MIDDLE 2048
+#define LINEAR_MAX 4096
+
+#define STEERING_LUT_SIZE 4096  // 12 bit steering wheel ADC
+
+typedef struct {
+  long left;    // Steering wheel ADC counts
+  long middle;
+  long right;
+} STEERING_wheel_cal_t;
+
+typedef struct {
+  long low;     // Azimuth DAC counts
+  long middle;
+  long high;
+} STEERING_azimuth_cal_t;
+
+typedef struct {
+  uint16_t linear[STEERING_LUT_SIZE];  // ADC to linear steering value
+  uint16_t dac[STEERING_LUT_SIZE];     // ADC to azimuth DAC output
+} STEERING_lut_t;
+
+/*******************************************************************
+ * Linearises a steering wheel ADC value (double linearisation).
+ *
+ * @param cal Steering wheel calibration.
+ * @param value ADC counts.
+ * @return Linear value, LINEAR_MIN ... LINEAR_MAX.
+ *******************************************************************/
+extern long STEERING_wheel_linear(const STEERING_wheel_cal_t *cal, long value);
+
+/*******************************************************************
+ * Maps a linear steering value to the azimuth DAC output.
+ *
+ * @param cal Azimuth calibration.
+ * @param value Linear value, LINEAR_MIN ... LINEAR_MAX.
+ * @return DAC counts, 0 ... 4095.
+ *******************************************************************/
+extern long STEERING_azimuth_output(const STEERING_azimuth_cal_t *cal, long value);
+
+/*******************************************************************
+ * Builds the steering wheel ADC to azimuth DAC lookup table.
+ *
+ * Equal to STEERING_wheel_linear() followed by
+ * STEERING_azimuth_output() for every ADC value.
+ *******************************************************************/
+extern void STEERING_lut_build(STEERING_lut_t *lut, const STEERING_wheel_cal_t *wheel, const STEERING_azimuth_cal_t *azimuth);
+
+/*******************************************************************
+ * Signal filter chain (fixed-point)
+ *
+ * A chain runs up to FILTER_MAX_STAGES stages in order, each stage
+ * takes and returns an integer sample (ADC counts). All math is
+ * integer, every stage has a fixed worst case cost.
+ *
+ *   FILTER_MEDIAN      Spike rejection, median of the last `window`
+ *                      samples (3, 5 or 7).
+ *   FILTER_IIR         First-order low pass, y += alpha * (x - y),
+ *                      alpha in Q15 (FILTER_IIR_ONE is no filtering).
+ *   FILTER_RATE_LIMIT  Output moves at most `step` counts per sample.
+ *   FILTER_DEADBAND    Output is `centre` within +/- `width`, leaving
+ *                      the band needs `width + hysteresis`.
+ *******************************************************************/
+#define FILTER_MAX_STAGES 4
+#define FILTER_MEDIAN_MAX 7
+#define FILTER_IIR_SHIFT 15
+#define FILTER_IIR_ONE (1L << FILTER_IIR_SHIFT)
+
+typedef enum {
+  FILTER_MEDIAN,
+  FILTER_IIR,
+  FILTER_RATE_LIMIT,
+  FILTER_DEADBAND,
+  FILTER_NUM_TYPES
+} FILTER_type_t;
+
+typedef struct {
+  FILTER_type_t type;
+  int32_t window;      // FILTER_MEDIAN
+  int32_t alpha;       // FILTER_IIR, Q15
+  int32_t step;        // FILTER_RATE_LIMIT, counts per sample
+  int32_t centre;      // FILTER_DEADBAND
+  int32_t width;
+  int32_t hysteresis;
+  uint32_t budget;     // Cost budget in clock units, 0 is none
+} FILTER_stage_cfg_t;
+
+typedef struct {
+  FILTER_stage_cfg_t cfg;
+  bool primed;         // First sample seen
+  int64_t acc;         // FILTER_IIR accumulator, Q15
+  int32_t last;        // FILTER_RATE_LIMIT output
+  bool inside;         // FILTER_DEADBAND state
+  int32_t history[FILTER_MEDIAN_MAX];
+  uint8_t index;
+  uint8_t count;
+  uint32_t cost_last;  // Clock units, only with a clock
+  uint32_t cost_max;
+  uint32_t over_budget;
+} FILTER_stage_t;
+
+typedef uint32_t (*FILTER_clock_fn)(void);
+
+typedef struct {
+  uint8_t num_stages;
+  FILTER_stage_t stage[FILTER_MAX_STAGES];
+  FILTER_clock_fn clock;  // Optional, measures the cost per stage
+} FILTER_chain_t;
+
+/*******************************************************************
+ * Initialises a filter chain.
+ *
+ * @param chain The chain.
+ * @param cfg Stage configurations, run in this order.
+ * @param num_stages Number of stages, at most FILTER_MAX_STAGES.
+ * @param clock Optional clock to measure the cost per stage.
+ * @return Number of stages used.
+ *******************************************************************/
+extern int FILTER_chain_init(FILTER_chain_t *chain, const FILTER_stage_cfg_t *cfg, int num_stages, FILTER_clock_fn clock);
+
+/*******************************************************************
+ * Clears the state of all stages, the next sample primes the chain.
+ *******************************************************************/
+extern void FILTER_chain_reset(FILTER_chain_t *chain);
+
+/*******************************************************************
+ * Runs one sample through a single stage.
+ *******************************************************************/
+extern int32_t FILTER_stage_run(FILTER_stage_t *stage, int32_t value);
+
+/*******************************************************************
+ * Runs one sample through the chain.
+ *
+ * @return The filtered sample.
+ *******************************************************************/
+extern int32_t FILTER_chain_run(FILTER_chain_t *chain, int32_t value);
+
+/*******************************************************************
+ * Name of a filter type.
+ *******************************************************************/
+extern const char *FILTER_type_name(FILTER_type_t type);
+
+/*******************************************************************
+ * CAN frame dispatch
+ *
+ * Modules subscribe to a CAN identifier with a mask, a frame is
+ * delivered to every subscription where (id & mask) matches. Full
+ * mask subscriptions are kept in an array sorted on identifier and
+ * found with a binary search, masked (range) subscriptions are
+ * checked one by one after that. Full mask subscriptions are called
+ * before masked ones, both in the order they subscribed.
+ *
+ * Standard and extended identifiers never match each other, the
+ * extended flag (DISPATCH_ID_EXT) is part of the identifier.
+ *******************************************************************/
+#define DISPATCH_MAX_SUBSCRIPTIONS 16
+#define DISPATCH_ID_EXT (1UL << 31)     // Extended (29 bit) identifier
+#define DISPATCH_MASK_STD 0x000007FFUL  // All bits of a standard identifier
+#define DISPATCH_MASK_EXT 0x1FFFFFFFUL  // All bits of an extended identifier
+#define DISPATCH_INTERVAL_BUCKETS 12
+#define DISPATCH_INTERVAL_SHIFT 10      // First bucket below 2^10 clock units, 1 ms with a microsecond clock
+
+typedef struct {
+  uint32_t id;         // 11 or 29 bit identifier
+  uint8_t ext;         // Extended identifier
+  uint8_t rtr;         // Remote request
+  uint8_t length;      // Data length code
+  uint8_t channel;     // Receiving or transmitting CAN channel
+  uint8_t data[8];
+} CAN_frame_t;
+
+typedef void (*DISPATCH_handler_fn)(const CAN_frame_t *frame, void *context);
+typedef uint32_t (*DISPATCH_clock_fn)(void);
+
+typedef struct {
+  uint32_t bucket[DISPATCH_INTERVAL_BUCKETS];  // Doubling widths, the last one open ended
+  uint32_t min;
+  uint32_t max;
+} DISPATCH_interval_t;
+
+typedef struct {
+  const char *name;
+  uint32_t id;         // Including DISPATCH_ID_EXT
+  uint32_t mask;
+  DISPATCH_handler_fn handler;
+  void *context;
+  uint32_t budget;     // Handler time budget in clock units, 0 is none
+  bool enabled;        // Disabled subscriptions match no frames
+  uint32_t frames;     // Frames delivered
+  uint32_t cost_last;  // Clock units, only with a clock
+  uint32_t cost_max;
+  uint64_t cost_total;
+  uint32_t over_budget;
+  uint32_t arrival;              // Clock of the last frame
+  DISPATCH_interval_t interval;  // Time between frames, only with a clock
+} DISPATCH_subscription_t;
+
+typedef struct {
+  DISPATCH_subscription_t sub[DISPATCH_MAX_SUBSCRIPTIONS];
+  uint8_t num_subs;
+  uint8_t exact[DISPATCH_MAX_SUBSCRIPTIONS];   // Full mask, sorted on id
+  uint8_t num_exact;
+  uint8_t masked[DISPATCH_MAX_SUBSCRIPTIONS];  // Range, subscription order
+  uint8_t num_masked;
+  DISPATCH_clock_fn clock;  // Optional, measures the handler time
+  uint32_t frames;          // Frames dispatched
+  uint32_t unmatched;       // Frames without subscription
+} DISPATCH_table_t;
+
+typedef struct {
+  uint8_t index;  // Subscription, for the statistics
+  DISPATCH_handler_fn handler;
+  void *context;
+} DISPATCH_call_t;
+
+/*******************************************************************
+ * Initialises an empty dispatch table.
+ *
+ * @param table The table.
+ * @param clock Optional clock to measure the handler time.
+ *******************************************************************/
+extern void DISPATCH_init(DISPATCH_table_t *table, DISPATCH_clock_fn clock);
+
+/*******************************************************************
+ * Adds a subscription.
+ *
+ * @param table The table.
+ * @param name Name shown in the statistics (not copied).
+ * @param id Identifier, or DISPATCH_ID_EXT for an extended one.
+ * @param mask Identifier bits to compare, DISPATCH_MASK_STD or
+ *        DISPATCH_MASK_EXT for a single identifier.
+ * @param handler Called for every matching frame.
+ * @param context Passed to the handler.
+ * @param budget Handler time budget in clock units, 0 is none.
+ * @return Subscription index, -1 when the table is full.
+ *******************************************************************/
+extern int DISPATCH_subscribe(DISPATCH_table_t *table, const char *name, uint32_t id, uint32_t mask,
+                              DISPATCH_handler_fn handler, void *context, uint32_t budget);
+
+/*******************************************************************
+ * Enables or disables a subscription, subscriptions start enabled.
+ * Subscriptions are never removed, a module that stops listening
+ * disables its subscription.
+ *
+ * @return 0, or -1 for an unknown subscription.
+ *******************************************************************/
+extern int DISPATCH_enable(DISPATCH_table_t *table, int index, bool enable);
+
+/*******************************************************************
+ * Delivers a frame to all matching subscriptions. The frame is
+ * passed by reference, handlers must not keep the pointer.
+ *
+ * @return Number of handlers called.
+ *******************************************************************/
+extern int DISPATCH_frame(DISPATCH_table_t *table, const CAN_frame_t *frame);
+
+/*******************************************************************
+ * DISPATCH_frame() in two steps, so the table can be locked while
+ * matching and the handlers run without the lock. Subscriptions are
+ * never removed, the statistics of a collected call stay valid.
+ *
+ * DISPATCH_match() copies the handler and context of all matching
+ * subscriptions to calls, in delivery order, and returns the count.
+ * DISPATCH_deliver() calls them and keeps the handler statistics.
+ *******************************************************************/
+extern int DISPATCH_match(DISPATCH_table_t *table, const CAN_frame_t *frame,
+                          DISPATCH_call_t calls[DISPATCH_MAX_SUBSCRIPTIONS]);
+extern void DISPATCH_deliver(DISPATCH_table_t *table, const DISPATCH_call_t *calls, int num_calls,
+                             const CAN_frame_t *frame);
+
+/*******************************************************************
+ * Clears the frame and handler statistics.
+ *******************************************************************/
+extern void DISPATCH_reset_stats(DISPATCH_table_t *table);
+
+/*******************************************************************
+ * Inter-arrival histogram of a subscription. Bucket 0 counts
+ * intervals below 2^DISPATCH_INTERVAL_SHIFT clock units, every next
+ * bucket is twice as wide.
+ *
+ * @return bucket: bucket of an interval,
+ *         bound: first interval above a bucket, UINT32_MAX for the
+ *         last one,
+ *         percentile: bound of the bucket holding the percentile,
+ *         0 without intervals.
+ *******************************************************************/
+extern int DISPATCH_interval_bucket(uint32_t interval);
+extern uint32_t DISPATCH_interval_bound(int bucket);
+extern uint32_t DISPATCH_interval_percentile(const DISPATCH_interval_t *interval, uint8_t percent);
+
+/*******************************************************************
+ * CAN hardware acceptance filters
+ *
+ * Compiles a set of identifier/mask rules (DISPATCH key encoding,
+ * DISPATCH_ID_EXT for extended identifiers) into controller filter
+ * settings. The hardware filter always accepts every frame that
+ * matches a rule, it may accept more (software filtering in the
+ * dispatch table rejects those). Rules are merged pairwise, keeping
+ * as many compared identifier bits as possible, until they fit
+ * the filters of the controller.
+ *
+ * The acceptance estimate is the fraction of random identifiers
+ * (standard and extended averaged) the filter passes, in ppm.
+ *******************************************************************/
+#define CANFILTER_MCP_MASKS 2    // RXM0 (RXF0, RXF1), RXM1 (RXF2 ... RXF5)
+#define CANFILTER_MCP_FILTERS 6
+#define CANFILTER_ACCEPT_ALL 1000000UL
+
+typedef struct {
+  uint32_t id;         // Including DISPATCH_ID_EXT
+  uint32_t mask;       // Identifier bits to compare
+} CANFILTER_rule_t;
+
+typedef enum {
+  CANFILTER_TWAI_SINGLE,
+  CANFILTER_TWAI_DUAL,
+} CANFILTER_twai_mode_t;
+
+typedef struct {
+  CANFILTER_twai_mode_t mode;
+  uint32_t code;       // twai_filter_config_t acceptance_code
+  uint32_t mask;       // twai_filter_config_t acceptance_mask, 1 is don't care
+  uint32_t accept_ppm;
+} CANFILTER_twai_t;
+
+typedef struct {
+  uint32_t mask[CANFILTER_MCP_MASKS];      // 29 bit, SID in bits 28..18
+  uint32_t filter[CANFILTER_MCP_FILTERS];  // 29 bit, SID in bits 28..18
+  uint8_t ext[CANFILTER_MCP_FILTERS];      // EXIDE
+  uint32_t accept_ppm;
+} CANFILTER_mcp_t;
+
+/*******************************************************************
+ * Compiles rules into the ESP32 TWAI acceptance filter, single or
+ * dual filter mode whichever accepts less. No rules is accept all.
+ *******************************************************************/
+extern void CANFILTER_twai(const CANFILTER_rule_t *rules, int num_rules, CANFILTER_twai_t *twai);
+
+/*******************************************************************
+ * Compiles rules into the MCP2515 masks and filters. No rules is
+ * accept all (masks cleared).
+ *******************************************************************/
+extern void CANFILTER_mcp2515(const CANFILTER_rule_t *rules, int num_rules, CANFILTER_mcp_t *mcp);
+
+/*******************************************************************
+ * CAN transmit schedule
+ *
+ * A timeline of cyclic and one-shot frames. A cyclic entry is due
+ * every `period` clock units starting `phase` after it was added,
+ * a one-shot entry is due when added and freed once sent. Of all
+ * due entries the one with the lowest priority value (most urgent,
+ * like CAN arbitration) goes first, the earliest due on equal
+ * priority. The producer callback updates the payload in place
+ * just before the frame is sent.
+ *
+ * Clock units are free (microseconds on the target), all time
+ * compares are wrap-around safe.
+ *
+ *   missed   Releases sent after their deadline (the period for
+ *            cyclic entries) or dropped because the next release
+ *            was already due.
+ *   jitter   Absolute difference between the achieved and the
+ *            configured period.
+ *******************************************************************/
+#define SCHED_MAX_ENTRIES 16
+#define SCHED_IDLE UINT32_MAX  // SCHED_wait(), nothing scheduled
+
+typedef bool (*SCHED_produce_fn)(CAN_frame_t *frame, void *context);
+
+typedef struct {
+  const char *name;
+  CAN_frame_t frame;        // Payload, updated in place
+  uint32_t period;          // 0 is one-shot
+  uint32_t deadline;        // Allowed lateness, 0 is none
+  uint8_t priority;         // 0 is most urgent
+  SCHED_produce_fn produce; // Optional, false skips the release
+  void *context;
+  bool active;
+  uint32_t due;             // Next release
+  uint32_t last;            // Last send
+  uint32_t sent;
+  uint32_t missed;
+  uint32_t skipped;         // Producer declined
+  uint32_t jitter_last;
+  uint32_t jitter_max;
+  uint64_t jitter_total;
+} SCHED_entry_t;
+
+typedef struct {
+  SCHED_entry_t entry[SCHED_MAX_ENTRIES];
+  uint8_t num_entries;      // Highest slot in use + 1
+  uint32_t backlog;         // Entries due at the last SCHED_next()
+  uint32_t backlog_max;
+} SCHED_table_t;
+
+/*******************************************************************
+ * Initialises an empty schedule.
+ *******************************************************************/
+extern void SCHED_init(SCHED_table_t *table);
+
+/*******************************************************************
+ * Adds a cyclic frame.
+ *
+ * @param table The schedule.
+ * @param name Name shown in the statistics (not copied).
+ * @param frame Initial frame (identifier, length and payload).
+ * @param period Period in clock units, must not be 0.
+ * @param phase First release after `now`, spreads the load.
+ * @param priority 0 is most urgent.
+ * @param produce Optional payload producer.
+ * @param context Passed to the producer.
+ * @param now Current clock.
+ * @return Entry index, -1 when the schedule is full.
+ *******************************************************************/
+extern int SCHED_add(SCHED_table_t *table, const char *name, const CAN_frame_t *frame, uint32_t period,
+                     uint32_t phase, uint8_t priority, SCHED_produce_fn produce, void *context, uint32_t now);
+
+/*******************************************************************
+ * Adds a one-shot frame, due now.
+ *
+ * @param deadline Allowed lateness, 0 is none.
+ * @return Entry index, -1 when the schedule is full.
+ *******************************************************************/
+extern int SCHED_once(SCHED_table_t *table, const CAN_frame_t *frame, uint8_t priority, uint32_t deadline, uint32_t now);
+
+/*******************************************************************
+ * Takes the most urgent due frame.
+ *
+ * @param frame Receives a copy of the frame to send.
+ * @return Entry index, -1 when nothing is due.
+ *******************************************************************/
+extern int SCHED_next(SCHED_table_t *table, uint32_t now, CAN_frame_t *frame);
+
+/*******************************************************************
+ * Clock units until the next release, 0 when one is due and
+ * SCHED_IDLE when the schedule is empty.
+ *******************************************************************/
+extern uint32_t SCHED_wait(const SCHED_table_t *table, uint32_t now);
+
+/*******************************************************************
+ * Clears the statistics of all entries.
+ *******************************************************************/
+extern void SCHED_reset_stats(SCHED_table_t *table);
+
+/*******************************************************************
+ * NMEA2000
+ *
+ * Identifier codec, ISO address claim, fast-packet transport and
+ * table driven PGN encoding, the TWAI glue is in NMEA2000.cpp.
+ *
+ * Fast-packet messages are reassembled in a fixed pool of slots,
+ * one per (PGN, source) in progress, a complete message is returned
+ * by reference to its slot. Physical values are doubles in SI units
+ * (rad, K, Pa, s), a field that is not available is NAN.
+ *******************************************************************/
+#define N2K_PGN_ISO_ACK 59392UL
+#define N2K_PGN_ISO_REQUEST 59904UL
+#define N2K_PGN_ADDRESS_CLAIM 60928UL
+#define N2K_PGN_RUDDER 127245UL
+#define N2K_PGN_ENGINE_RAPID 127488UL
+#define N2K_PGN_ENGINE_DYNAMIC 127489UL
+#define N2K_PGN_THRUSTER_STATUS 128006UL
+
+#define N2K_ADDRESS_GLOBAL 255
+#define N2K_ADDRESS_NULL 254       // No address, claim lost
+#define N2K_ADDRESS_MAX 251        // Highest claimable address
+#define N2K_FAST_PACKET_MAX 223    // Payload bytes
+#define N2K_FP_SLOTS 8             // Messages reassembled in parallel
+#define N2K_FP_TIMEOUT 750         // Clock units (ms) between frames
+
+typedef struct {
+  uint8_t priority;
+  uint32_t pgn;
+  uint8_t source;
+  uint8_t destination;  // N2K_ADDRESS_GLOBAL for PDU2 PGNs
+} N2K_header_t;
+
+typedef struct {
+  N2K_header_t header;
+  uint8_t length;
+  const uint8_t *data;  // Valid until the next frame of the pool
+} N2K_message_t;
+
+typedef struct {
+  uint32_t pgn;
+  uint8_t source;
+  uint8_t sequence;     // Sequence counter of the message (3 bit)
+  uint8_t next;         // Expected frame counter
+  uint8_t length;       // Announced payload bytes
+  uint8_t received;
+  bool active;
+  uint32_t last;        // Clock of the last frame
+  uint8_t data[N2K_FAST_PACKET_MAX];
+} N2K_fp_slot_t;
+
+typedef struct {
+  N2K_fp_slot_t slot[N2K_FP_SLOTS];
+  uint32_t completed;
+  uint32_t lost;        // Missing or out of order frame
+  uint32_t dropped;     // No free slot
+  uint32_t timeouts;    // Stale slot taken over
+} N2K_fp_pool_t;
+
+typedef struct {
+  uint32_t identity;        // 21 bit unique number
+  uint16_t manufacturer;    // 11 bit
+  uint8_t device_instance;
+  uint8_t device_function;
+  uint8_t device_class;     // 7 bit
+  uint8_t system_instance;  // 4 bit
+  uint8_t industry_group;   // 3 bit, 4 is marine
+  bool arbitrary_address;
+} N2K_name_fields_t;
+
+typedef struct {
+  uint64_t name;
+  uint8_t preferred;
+  uint8_t address;          // Claimed address or N2K_ADDRESS_NULL
+  uint32_t conflicts;
+} N2K_claim_t;
+
+typedef struct {
+  const char *name;
+  uint16_t offset;     // Bit offset in the payload
+  uint8_t bits;        // Up to 32
+  bool sign;
+  double resolution;   // Physical value of one count
+} N2K_field_t;
+
+typedef struct {
+  uint32_t pgn;
+  const char *name;
+  uint8_t priority;    // Default priority
+  uint8_t length;      // Payload bytes
+  bool fast;           // Fast-packet transport
+  uint8_t num_fields;
+  const N2K_field_t *field;
+} N2K_pgn_t;
+
+/* Field indices of the PGNs in the codec table */
+enum {
+  N2K_RUDDER_INSTANCE,
+  N2K_RUDDER_DIRECTION,    // 0 none, 1 starboard, 2 port
+  N2K_RUDDER_ANGLE_ORDER,
+  N2K_RUDDER_POSITION,
+  N2K_RUDDER_FIELDS
+};
+
+enum {
+  N2K_THRUSTER_SID,
+  N2K_THRUSTER_IDENTIFIER,
+  N2K_THRUSTER_DIRECTION,  // 0 off, 1 ready, 2 port, 3 starboard
+  N2K_THRUSTER_POWER,      // 0 off, 1 on
+  N2K_THRUSTER_RETRACT,    // 0 off, 1 extend, 2 retract
+  N2K_THRUSTER_SPEED,      // Percent
+  N2K_THRUSTER_EVENTS,
+  N2K_THRUSTER_TIMEOUT,
+  N2K_THRUSTER_AZIMUTH,
+  N2K_THRUSTER_FIELDS
+};
+
+enum {
+  N2K_ENGINE_RAPID_INSTANCE,
+  N2K_ENGINE_RAPID_SPEED,  // rpm
+  N2K_ENGINE_RAPID_BOOST,
+  N2K_ENGINE_RAPID_TRIM,   // Percent
+  N2K_ENGINE_RAPID_FIELDS
+};
+
+enum {
+  N2K_ENGINE_INSTANCE,
+  N2K_ENGINE_OIL_PRESSURE,
+  N2K_ENGINE_OIL_TEMPERATURE,
+  N2K_ENGINE_TEMPERATURE,
+  N2K_ENGINE_ALTERNATOR,   // V
+  N2K_ENGINE_FUEL_RATE,    // l/h
+  N2K_ENGINE_HOURS,
+  N2K_ENGINE_COOLANT_PRESSURE,
+  N2K_ENGINE_FUEL_PRESSURE,
+  N2K_ENGINE_STATUS_1,
+  N2K_ENGINE_STATUS_2,
+  N2K_ENGINE_LOAD,         // Percent
+  N2K_ENGINE_TORQUE,       // Percent
+  N2K_ENGINE_FIELDS
+};
+
+/*******************************************************************
+ * 29 bit identifier to header and back.
+ *******************************************************************/
+extern void N2K_id_decode(uint32_t id, N2K_header_t *header);
+extern uint32_t N2K_id_encode(const N2K_header_t *header);
+
+/*******************************************************************
+ * Clears a fast-packet pool.
+ *******************************************************************/
+extern void N2K_fp_init(N2K_fp_pool_t *pool);
+
+/*******************************************************************
+ * Adds a fast-packet frame to the pool.
+ *
+ * @param now Clock in ms, stale slots are taken over after
+ *            N2K_FP_TIMEOUT.
+ * @param message Receives the complete message.
+ * @return true when the frame completed a message.
+ *******************************************************************/
+extern bool N2K_fp_receive(N2K_fp_pool_t *pool, const N2K_header_t *header, const uint8_t *data,
+                           uint8_t length, uint32_t now, N2K_message_t *message);
+
+/*******************************************************************
+ * Number of frames to send a fast-packet payload.
+ *******************************************************************/
+extern uint8_t N2K_fp_frames(uint8_t length);
+
+/*******************************************************************
+ * Builds one frame of a fast-packet payload, unused bytes are 0xFF.
+ *
+ * @param sequence Sequence counter of the message (3 bit).
+ * @param index Frame counter, 0 ... N2K_fp_frames() - 1.
+ * @param frame Receives 8 bytes.
+ *******************************************************************/
+extern void N2K_fp_frame(uint8_t sequence, const uint8_t *payload, uint8_t length, uint8_t index, uint8_t *frame);
+
+/*******************************************************************
+ * ISO address claim.
+ *
+ * N2K_claim_received() handles the claim of another device, on a
+ * conflict the lower NAME keeps the address. An arbitrary address
+ * capable device moves to the next free address, else it ends up
+ * with N2K_ADDRESS_NULL.
+ *
+ * @return true when the own claim has to be sent (again).
+ *******************************************************************/
+extern uint64_t N2K_name(const N2K_name_fields_t *fields);
+extern void N2K_claim_init(N2K_claim_t *claim, uint64_t name, uint8_t preferred);
+extern bool N2K_claim_received(N2K_claim_t *claim, uint8_t source, uint64_t name);
+extern uint64_t N2K_name_decode(const uint8_t *data, uint8_t length);
+extern void N2K_name_encode(uint64_t name, uint8_t *data);
+
+/*******************************************************************
+ * ISO request and acknowledgement.
+ *
+ * @return true when the request holds a PGN.
+ *******************************************************************/
+extern bool N2K_request_decode(const uint8_t *data, uint8_t length, uint32_t *pgn);
+extern void N2K_request_encode(uint32_t pgn, uint8_t *data);
+extern void N2K_nak_encode(uint32_t pgn, uint8_t *data);
+
+/*******************************************************************
+ * PGN codec.
+ *
+ * N2K_decode() fills one value per field, a missing or not available
+ * field is NAN. N2K_encode() writes NAN as not available and keeps
+ * reserved bits set.
+ *
+ * @return Decoded fields, encoded payload bytes.
+ *******************************************************************/
+extern const N2K_pgn_t *N2K_pgn_find(uint32_t pgn);
+extern int N2K_decode(const N2K_pgn_t *pgn, const uint8_t *data, uint8_t length, double *values);
+extern uint8_t N2K_encode(const N2K_pgn_t *pgn, const double *values, uint8_t *data);
+
+/*******************************************************************
+ * CAN capture
+ *
+ * Binary capture file: a header followed by fixed size records.
+ * Records hold the low 32 bits of the microsecond clock, readers
+ * unwrap them against the previous record starting at the header
+ * base (gaps up to 35 minutes). Records are collected in a double
+ * buffer, one half fills while the other is written to flash.
+ *******************************************************************/
+#define CAPTURE_MAGIC 0x50414345UL  // "ECAP"
+#define CAPTURE_VERSION 1
+#define CAPTURE_BUFFER_RECORDS 256  // Per half
+#define CAPTURE_ID_EXT (1UL << 31)  // Record id flags
+#define CAPTURE_ID_RTR (1UL << 30)
+#define CAPTURE_ID_TX (1UL << 29)
+#define CAPTURE_CANDUMP_MAX 64      // Text line, including the terminator
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t record_size;
+  uint64_t base_us;      // Clock when the file was started
+} CAPTURE_header_t;
+
+typedef struct {
+  uint32_t time_us;      // Low 32 bits of the clock
+  uint32_t id;           // Identifier and CAPTURE_ID_ flags
+  uint8_t length;
+  uint8_t channel;
+  uint16_t reserved;
+  uint8_t data[8];
+} CAPTURE_record_t;
+
+typedef struct {
+  CAPTURE_record_t record[2][CAPTURE_BUFFER_RECORDS];
+  uint16_t count[2];
+  bool full[2];          // Waiting for the writer
+  uint8_t fill;          // Half being filled
+  uint32_t records;
+  uint32_t dropped;      // Both halves full
+} CAPTURE_buffer_t;
+
+/*******************************************************************
+ * File header.
+ *******************************************************************/
+extern void CAPTURE_header_init(CAPTURE_header_t *header, uint64_t base_us);
+extern bool CAPTURE_header_valid(const CAPTURE_header_t *header);
+
+/*******************************************************************
+ * Frame to record and back.
+ *******************************************************************/
+extern void CAPTURE_encode(const CAN_frame_t *frame, bool tx, uint64_t now_us, CAPTURE_record_t *record);
+extern void CAPTURE_decode(const CAPTURE_record_t *record, CAN_frame_t *frame, bool *tx);
+
+/*******************************************************************
+ * Full clock of a record, from the full clock of the previous
+ * record (or the header base).
+ *******************************************************************/
+extern uint64_t CAPTURE_time(uint64_t previous_us, const CAPTURE_record_t *record);
+
+/*******************************************************************
+ * Formats a record as a candump log line (candump -l), channel n
+ * is interface "can<n>".
+ *
+ * @param time_us Full clock of the record, see CAPTURE_time().
+ * @return Characters written, excluding the terminator.
+ *******************************************************************/
+extern int CAPTURE_candump(const CAPTURE_record_t *record, uint64_t time_us, char *line, int size);
+
+/*******************************************************************
+ * Double buffer.
+ *
+ * CAPTURE_buffer_put() adds a record to the half being filled and
+ * hands a full half to the writer. CAPTURE_buffer_flush() hands
+ * over a partly filled half. The writer takes the oldest full half
+ * with CAPTURE_buffer_take() and gives it back with
+ * CAPTURE_buffer_release(). The caller serialises the calls, the
+ * records of a taken half can be written without a lock.
+ *
+ * @return put: false when the record was dropped,
+ *         flush: true when a half was handed over,
+ *         take: half index with `count` records, -1 when none.
+ *******************************************************************/
+extern void CAPTURE_buffer_init(CAPTURE_buffer_t *buffer);
+extern bool CAPTURE_buffer_put(CAPTURE_buffer_t *buffer, const CAPTURE_record_t *record);
+extern bool CAPTURE_buffer_flush(CAPTURE_buffer_t *buffer);
+extern int CAPTURE_buffer_take(CAPTURE_buffer_t *buffer, uint16_t *count);
+extern void CAPTURE_buffer_release(CAPTURE_buffer_t *buffer, int half);
+
+/*******************************************************************
+ * Replay pacing, clock units from the first record to a record.
+ *
+ * @param speed Percent of the original speed, 0 is no pacing.
+ *******************************************************************/
+extern uint64_t CAPTURE_replay_offset(uint64_t first_us, uint64_t time_us, uint16_t speed);
+
+/*******************************************************************
+ * SLCAN (LAWICEL CAN232/CANUSB ASCII protocol)
+ *
+ * Commands and frames are lines ending in a carriage return. The
+ * reader collects one line in a fixed buffer, the parser and the
+ * formatter work on caller buffers, nothing is allocated.
+ *******************************************************************/
+#define SLCAN_LINE_MAX 32          // "Tiiiiiiiildd..dd" + timestamp, terminator
+#define SLCAN_OK '\r'
+#define SLCAN_ERROR '\a'
+#define SLCAN_NUM_BITRATES 9       // S0 .. S8
+
+#define SLCAN_FLAG_RX_FULL (1 << 0)  // Status flags, command F
+#define SLCAN_FLAG_TX_FULL (1 << 1)
+#define SLCAN_FLAG_ERROR_WARNING (1 << 2)
+#define SLCAN_FLAG_OVERRUN (1 << 3)
+#define SLCAN_FLAG_ERROR_PASSIVE (1 << 5)
+#define SLCAN_FLAG_BUS_ERROR (1 << 7)
+
+typedef enum {
+  SLCAN_CMD_INVALID,
+  SLCAN_CMD_SETUP,      // Sn, argument is the bit rate in bits/s
+  SLCAN_CMD_OPEN,       // O
+  SLCAN_CMD_LISTEN,     // L
+  SLCAN_CMD_CLOSE,      // C
+  SLCAN_CMD_TRANSMIT,   // t, T, r, R, frame
+  SLCAN_CMD_FLAGS,      // F
+  SLCAN_CMD_TIMESTAMP,  // Zn, argument is 0 or 1
+  SLCAN_CMD_AUTOPOLL,   // Xn, argument is 0 or 1
+  SLCAN_CMD_POLL,       // P, A
+  SLCAN_CMD_VERSION,    // V, v
+  SLCAN_CMD_SERIAL,     // N
+  SLCAN_CMD_IGNORED,    // s, M, m, W, U, Q: accepted, no effect
+} SLCAN_cmd_t;
+
+typedef struct {
+  char line[SLCAN_LINE_MAX];
+  uint8_t length;
+  bool overflow;        // Discarding a too long line
+  uint32_t overflows;
+} SLCAN_reader_t;
+
+/*******************************************************************
+ * Line reader.
+ *
+ * @return true when `c` completed a line, reader->line holds it
+ *         without the carriage return. Empty and too long lines
+ *         are not returned.
+ *******************************************************************/
+extern void SLCAN_reader_init(SLCAN_reader_t *reader);
+extern bool SLCAN_reader_put(SLCAN_reader_t *reader, char c);
+
+/*******************************************************************
+ * Parses a command line.
+ *
+ * @param frame Frame of a transmit command.
+ * @param argument Bit rate or switch of a command.
+ *******************************************************************/
+extern SLCAN_cmd_t SLCAN_parse(const char *line, CAN_frame_t *frame, uint32_t *argument);
+
+/*******************************************************************
+ * Formats a received frame, "tiiildd..[tttt]\r".
+ *
+ * @param timestamp Adds the time stamp, milliseconds modulo 60000.
+ * @return Characters written, excluding the terminator, 0 when
+ *         `size` is too small.
+ *******************************************************************/
+extern int SLCAN_format(const CAN_frame_t *frame, bool timestamp, uint32_t time_ms, char *out, int size);
+
+/*******************************************************************
+ * CAN bus health
+ *
+ * Bus load from the bit time of every observed frame: the exact
+ * number of bits on the wire including stuff bits, CRC, ACK, end of
+ * frame and intermission. Error state from the error counters, with
+ * their trend over the last samples. Bus-off recovery is held off
+ * with an exponential backoff so a faulty node can not keep
+ * disturbing the bus.
+ *******************************************************************/
+#define HEALTH_TREND_SAMPLES 10
+#define HEALTH_COUNTER_UNKNOWN 0xFFFF  // Controller does not report the error counters
+#define HEALTH_CONGESTED_LOAD 800      // 0.1 %, load above is reported as congested
+
+typedef enum {
+  HEALTH_ERROR_ACTIVE,
+  HEALTH_ERROR_WARNING,  // An error counter at 96 or more
+  HEALTH_ERROR_PASSIVE,  // An error counter at 128 or more
+  HEALTH_BUS_OFF,
+  HEALTH_RECOVERING,     // Recovery started, not on the bus yet
+  HEALTH_NUM_STATES
+} HEALTH_state_t;
+
+typedef enum {
+  HEALTH_OK,
+  HEALTH_CONGESTED,      // High load, no errors
+  HEALTH_TX_ERRORS,      // Transmit errors rising or bus-off, this node or its wiring
+  HEALTH_BUS_ERRORS,     // Receive or bus errors rising, another node or the bus
+} HEALTH_verdict_t;
+
+typedef struct {
+  HEALTH_state_t state;
+  uint16_t tec;          // Or HEALTH_COUNTER_UNKNOWN
+  uint16_t rec;
+  uint32_t bus_errors;   // Running count, 0 when not reported
+} HEALTH_status_t;
+
+typedef struct {
+  uint32_t bitrate;      // Bits/s
+  uint32_t window;       // Clock units (microseconds)
+  uint32_t start;        // Current window
+  uint32_t bits;
+  uint32_t frames;
+  uint16_t load;         // Last window, 0.1 %
+  uint16_t load_max;
+  uint32_t frame_rate;   // Last window, frames/s
+} HEALTH_load_t;
+
+typedef struct {
+  uint16_t tec[HEALTH_TREND_SAMPLES];  // Ring, one sample per period
+  uint16_t rec[HEALTH_TREND_SAMPLES];
+  uint8_t index;         // Next sample
+  uint8_t count;
+  HEALTH_state_t state;
+  uint32_t entered[HEALTH_NUM_STATES];  // Times a state was entered
+  uint32_t bus_errors;   // Last running count
+  uint32_t bus_errors_delta;            // Since the previous sample
+  uint16_t tec_max;
+  uint16_t rec_max;
+} HEALTH_errors_t;
+
+typedef struct {
+  uint32_t base;         // Clock units
+  uint32_t max;
+  uint32_t stable;       // On the bus this long resets the delay
+  uint32_t delay;        // Hold-off of the next bus-off
+  uint32_t due;
+  uint32_t since;        // Last recovery
+  bool pending;
+  uint32_t bus_offs;
+  uint32_t recoveries;
+} HEALTH_backoff_t;
+
+/*******************************************************************
+ * Bits on the wire of a frame, stuff bits and intermission included.
+ *******************************************************************/
+extern uint16_t HEALTH_frame_bits(const CAN_frame_t *frame);
+
+/*******************************************************************
+ * Bus load over fixed windows.
+ *
+ * HEALTH_load_add() counts a frame, HEALTH_load_update() closes the
+ * elapsed windows (call it periodically, also without traffic).
+ *
+ * @return update: true when a window was closed.
+ *******************************************************************/
+extern void HEALTH_load_init(HEALTH_load_t *load, uint32_t bitrate, uint32_t window, uint32_t now);
+extern void HEALTH_load_add(HEALTH_load_t *load, uint16_t bits, uint32_t now);
+extern bool HEALTH_load_update(HEALTH_load_t *load, uint32_t now);
+
+/*******************************************************************
+ * Error state and counter trend.
+ *
+ * @return state: error state of the counters,
+ *         trend: newest minus oldest sample of the transmit or
+ *         receive error counter, 0 when not reported.
+ *******************************************************************/
+extern HEALTH_state_t HEALTH_state(uint16_t tec, uint16_t rec);
+extern void HEALTH_errors_init(HEALTH_errors_t *errors);
+extern void HEALTH_errors_add(HEALTH_errors_t *errors, const HEALTH_status_t *status);
+extern int HEALTH_errors_trend(const HEALTH_errors_t *errors, bool transmit);
+
+/*******************************************************************
+ * Tells a congested bus from a faulty one.
+ *******************************************************************/
+extern HEALTH_verdict_t HEALTH_diagnose(const HEALTH_load_t *load, const HEALTH_errors_t *errors);
+
+/*******************************************************************
+ * Bus-off recovery backoff.
+ *
+ * HEALTH_backoff_bus_off() schedules a recovery after the current
+ * delay and doubles the delay up to `max`. HEALTH_backoff_due()
+ * returns true once when the recovery is to be started.
+ * HEALTH_backoff_ok() is called while on the bus, the delay returns
+ * to `base` after `stable` without a bus-off.
+ *******************************************************************/
+extern void HEALTH_backoff_init(HEALTH_backoff_t *backoff, uint32_t base, uint32_t max, uint32_t stable);
+extern void HEALTH_backoff_bus_off(HEALTH_backoff_t *backoff, uint32_t now);
+extern bool HEALTH_backoff_due(HEALTH_backoff_t *backoff, uint32_t now);
+extern void HEALTH_backoff_ok(HEALTH_backoff_t *backoff, uint32_t now);
+
+/*******************************************************************
+ * Names for JSON and CLI.
+ *******************************************************************/
+extern const char *HEALTH_state_name(HEALTH_state_t state);
+extern const char *HEALTH_verdict_name(HEALTH_verdict_t verdict);
+
+/*******************************************************************
+ * ISO-TP (ISO 15765-2) transport on classic CAN
+ *
+ * Messages up to ISOTP_MAX_LENGTH bytes in 8 byte frames: single
+ * frame, or a first frame and consecutive frames paced by the flow
+ * control of the receiver (block size, STmin). Payloads are never
+ * buffered: a transmitted message is pulled from a source callback
+ * and a received one is pushed to a sink callback, a few bytes per
+ * frame at their offset in the message.
+ *
+ * Clock units are microseconds (STmin goes down to 100 us). Send
+ * and receive are independent, a link is full duplex.
+ *******************************************************************/
+#define ISOTP_MAX_LENGTH 4095  // 12 bit first frame length
+#define ISOTP_WAIT_MAX 8       // Flow control WAIT frames accepted in a row
+#define ISOTP_IDLE UINT32_MAX  // ISOTP_wait(), nothing to do
+
+typedef enum {
+  ISOTP_OK,
+  ISOTP_TIMEOUT,      // N_Bs (no flow control) or N_Cr (no consecutive frame)
+  ISOTP_WRONG_SN,     // Consecutive frame out of order
+  ISOTP_OVERFLOW,     // Receiver refused the length
+  ISOTP_ABORTED,      // New message, sink refused data or too many WAITs
+} ISOTP_result_t;
+
+/* Transmits a frame, false when the queue is full (retried) */
+typedef bool (*ISOTP_send_fn)(const CAN_frame_t *frame, void *context);
+/* Fills `length` bytes of the message at `offset` */
+typedef void (*ISOTP_source_fn)(uint16_t offset, uint8_t *data, uint8_t length, void *context);
+/* Takes `length` bytes at `offset` of a `total` byte message, false refuses it */
+typedef bool (*ISOTP_sink_fn)(uint16_t offset, const uint8_t *data, uint8_t length, uint16_t total, void *context);
+/* Message sent (tx) or received, or failed */
+typedef void (*ISOTP_done_fn)(bool tx, ISOTP_result_t result, void *context);
+
+typedef struct {
+  uint32_t tx_id;      // Identifier of the frames sent
+  uint32_t rx_id;      // Identifier of the frames received
+  bool ext;            // 29 bit identifiers
+  uint8_t block_size;  // Frames between our flow controls, 0 is all
+  uint8_t st_min;      // Requested frame separation, ISO encoding
+  uint8_t padding;     // Fill byte, frames are always 8 bytes
+  uint32_t timeout;    // N_Bs and N_Cr, clock units
+  ISOTP_send_fn send;
+  ISOTP_source_fn source;
+  ISOTP_sink_fn sink;
+  ISOTP_done_fn done;
+  void *context;
+} ISOTP_config_t;
+
+typedef enum {
+  ISOTP_TX_IDLE,
+  ISOTP_TX_WAIT_FC,  // First frame or block sent
+  ISOTP_TX_SENDING,  // Consecutive frames
+} ISOTP_tx_state_t;
+
+typedef struct {
+  ISOTP_config_t config;
+
+  ISOTP_tx_state_t tx_state;
+  uint16_t tx_length;
+  uint16_t tx_offset;
+  uint8_t tx_sn;        // Next sequence number
+  uint8_t tx_block;     // Frames left in the block, 0 is unlimited
+  uint8_t tx_block_size;
+  uint8_t tx_waits;
+  uint32_t tx_st_min;   // Clock units, from the receiver
+  uint32_t tx_due;      // Next frame or flow control deadline
+
+  bool rx_active;
+  uint16_t rx_length;
+  uint16_t rx_offset;
+  uint8_t rx_sn;
+  uint8_t rx_block;     // Frames since our flow control
+  uint32_t rx_due;      // Consecutive frame deadline
+
+  CAN_frame_t pending;  // Flow control the queue did not take
+  bool has_pending;
+
+  uint32_t tx_messages;
+  uint32_t rx_messages;
+  uint32_t tx_frames;
+  uint32_t rx_frames;
+  uint32_t errors;
+} ISOTP_link_t;
+
+/*******************************************************************
+ * Initialises a link.
+ *******************************************************************/
+extern void ISOTP_init(ISOTP_link_t *link, const ISOTP_config_t *config);
+
+/*******************************************************************
+ * Starts sending a message of `length` bytes, pulled from the source
+ * callback. A single frame goes out at once, longer messages wait
+ * for the flow control of the receiver.
+ *
+ * @return 0, or -1 when a message is being sent or the length is
+ *         0 or above ISOTP_MAX_LENGTH.
+ *******************************************************************/
+extern int ISOTP_send(ISOTP_link_t *link, uint16_t length, uint32_t now);
+
+/*******************************************************************
+ * Handles a received frame with the rx identifier of the link.
+ *******************************************************************/
+extern void ISOTP_receive(ISOTP_link_t *link, const CAN_frame_t *frame, uint32_t now);
+
+/*******************************************************************
+ * Sends due consecutive frames and checks the timeouts.
+ *******************************************************************/
+extern void ISOTP_poll(ISOTP_link_t *link, uint32_t now);
+
+/*******************************************************************
+ * Clock units until ISOTP_poll() has work, 0 when it has now and
+ * ISOTP_IDLE when nothing is in progress.
+ *******************************************************************/
+extern uint32_t ISOTP_wait(const ISOTP_link_t *link, uint32_t now);
+
+/*******************************************************************
+ * STmin byte to clock units: 0..127 ms, 0xF1..0xF9 100..900 us,
+ * reserved values are 127 ms.
+ *******************************************************************/
+extern uint32_t ISOTP_st_min(uint8_t st_min);
+
+/*******************************************************************
+ * UDS (ISO 14229) diagnostic server, a small subset
+ *
+ * Services: session control, tester present, read and write data by
+ * identifier and routine control. Data identifiers (DIDs) and
+ * routines come from tables of the application. DID data is read
+ * and written through callbacks at an offset, requests and
+ * responses stream through ISO-TP and are never held as a whole,
+ * only the service header is kept.
+ *
+ * Writing and routines need the extended session, it falls back to
+ * the default session after `s3` clock units without a request.
+ *******************************************************************/
+#define UDS_SID_SESSION_CONTROL 0x10
+#define UDS_SID_READ_DID 0x22
+#define UDS_SID_WRITE_DID 0x2E
+#define UDS_SID_ROUTINE_CONTROL 0x31
+#define UDS_SID_TESTER_PRESENT 0x3E
+#define UDS_NEGATIVE_RESPONSE 0x7F
+#define UDS_POSITIVE_OFFSET 0x40
+
+#define UDS_SESSION_DEFAULT 0x01
+#define UDS_SESSION_EXTENDED 0x03
+#define UDS_SUPPRESS_RESPONSE 0x80  // Sub-function bit
+
+#define UDS_ROUTINE_START 0x01
+#define UDS_ROUTINE_STOP 0x02
+#define UDS_ROUTINE_RESULTS 0x03
+
+#define UDS_NRC_SERVICE_NOT_SUPPORTED 0x11
+#define UDS_NRC_SUBFUNCTION_NOT_SUPPORTED 0x12
+#define UDS_NRC_INCORRECT_LENGTH 0x13
+#define UDS_NRC_BUSY 0x21
+#define UDS_NRC_CONDITIONS_NOT_CORRECT 0x22
+#define UDS_NRC_OUT_OF_RANGE 0x31
+#define UDS_NRC_GENERAL_PROGRAMMING_FAILURE 0x72
+#define UDS_NRC_NOT_IN_SESSION 0x7F
+
+#define UDS_HEADER_MAX 4        // Service header bytes of a request
+#define UDS_RESPONSE_MAX 16     // Response without DID data
+
+/* Reads `length` bytes of a DID at `offset` */
+typedef void (*UDS_read_fn)(uint16_t offset, uint8_t *data, uint16_t length, void *context);
+/* Writes `length` bytes of a DID at `offset`, data of a request in progress */
+typedef void (*UDS_write_fn)(uint16_t offset, const uint8_t *data, uint16_t length, void *context);
+/* Complete write received, 0 or a negative response code */
+typedef uint8_t (*UDS_commit_fn)(void *context);
+/* Routine start, stop or results, fills up to `*length` result bytes, 0 or a negative response code */
+typedef uint8_t (*UDS_routine_fn)(uint8_t control, uint8_t *result, uint8_t *length, void *context);
+
+typedef struct {
+  uint16_t did;
+  const char *name;
+  uint16_t length;       // Bytes, fixed
+  UDS_read_fn read;
+  UDS_write_fn write;    // nullptr is read only
+  UDS_commit_fn commit;
+  void *context;
+} UDS_did_t;
+
+typedef struct {
+  uint16_t rid;
+  const char *name;
+  UDS_routine_fn control;
+  void *context;
+} UDS_routine_t;
+
+typedef struct {
+  const UDS_did_t *did;
+  uint8_t num_dids;
+  const UDS_routine_t *routine;
+  uint8_t num_routines;
+
+  uint8_t session;
+  uint32_t s3;              // Session timeout, clock units
+  uint32_t last_request;
+
+  uint8_t header[UDS_HEADER_MAX];  // Request in progress
+  uint16_t total;
+  const UDS_did_t *target;  // DID written by the request
+  uint8_t nrc;              // Found while receiving
+
+  uint8_t response[UDS_RESPONSE_MAX];
+  uint8_t response_header;  // Bytes of `response` before the DID data
+  const UDS_did_t *response_did;
+  bool responding;          // Response being sent, requests are refused
+
+  uint32_t requests;
+  uint32_t negative;
+  uint32_t busy;
+} UDS_server_t;
+
+/*******************************************************************
+ * Initialises a server in the default session.
+ *******************************************************************/
+extern void UDS_init(UDS_server_t *server, const UDS_did_t *did, uint8_t num_dids, const UDS_routine_t *routine,
+                     uint8_t num_routines, uint32_t s3);
+
+/*******************************************************************
+ * Request data, an ISOTP_sink_fn with the server as context.
+ * Refuses a request while the previous response is being sent.
+ *******************************************************************/
+extern bool UDS_request_data(uint16_t offset, const uint8_t *data, uint8_t length, uint16_t total, void *context);
+
+/*******************************************************************
+ * Handles a complete request.
+ *
+ * @return Length of the response to send, 0 for none. The response
+ *         is read with UDS_response_data() until UDS_response_done().
+ *******************************************************************/
+extern uint16_t UDS_request_done(UDS_server_t *server, uint32_t now);
+
+/*******************************************************************
+ * Response data, an ISOTP_source_fn with the server as context.
+ *******************************************************************/
+extern void UDS_response_data(uint16_t offset, uint8_t *data, uint8_t length, void *context);
+extern void UDS_response_done(UDS_server_t *server);
+
+/*******************************************************************
+ * Session timeout.
+ *******************************************************************/
+extern void UDS_poll(UDS_server_t *server, uint32_t now);
+
+/*******************************************************************
+ * Websocket telemetry
+ *
+ * Fixed slot cache of the published key/value pairs. A value is
+ * kept as its JSON literal, an update is compared with the stored
+ * text and marks the slot dirty when it changed. Once per tick all
+ * dirty pairs are collected into compact JSON objects, as many per
+ * frame as fit, so a burst of changes costs one message.
+ *
+ * Keys are found by their FNV-1a hash in an open addressed table,
+ * slots are never freed.
+ *******************************************************************/
+#define TELEM_MAX_SLOTS 80
+#define TELEM_KEY_MAX 32     // Including the terminator
+#define TELEM_VALUE_MAX 32   // JSON literal, including the terminator
+#define TELEM_FRAME_MIN (TELEM_KEY_MAX + TELEM_VALUE_MAX + 4)  // Longest pair, braces and terminator
+
+typedef struct {
+  uint32_t hash;            // 0 is a free slot
+  char key[TELEM_KEY_MAX];
+  char value[TELEM_VALUE_MAX];
+  bool dirty;
+} TELEM_slot_t;
+
+typedef struct {
+  TELEM_slot_t slot[TELEM_MAX_SLOTS];
+  uint16_t num_keys;
+  uint16_t num_dirty;
+  uint32_t changed;         // Updates with a new value
+  uint32_t unchanged;
+  uint32_t rejected;        // Cache full, key or value too long
+} TELEM_cache_t;
+
+typedef struct {
+  uint32_t window;          // Clock units (microseconds)
+  uint32_t start;           // Current window
+  uint32_t window_bytes;
+  uint32_t ticks;
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t pairs;
+  uint32_t frames_last;     // Last tick
+  uint32_t pairs_last;
+  uint32_t serialize_last;  // Clock units per tick
+  uint32_t serialize_max;
+  uint32_t byte_rate;       // Last window, bytes/s
+} TELEM_stats_t;
+
+/*******************************************************************
+ * Initialises an empty cache.
+ *******************************************************************/
+extern void TELEM_init(TELEM_cache_t *cache);
+
+/*******************************************************************
+ * Updates a pair.
+ *
+ * @param key The key, copied.
+ * @param value The value as JSON literal (quoted string, number,
+ *              true/false/null), copied.
+ * @param force Marks the pair dirty even when the value is the same.
+ * @return 1 when the pair is dirty, 0 when unchanged, -1 when the
+ *         pair does not fit (send it directly).
+ *******************************************************************/
+extern int TELEM_set(TELEM_cache_t *cache, const char *key, const char *value, bool force);
+
+/*******************************************************************
+ * Value of a key, nullptr when not in the cache.
+ *******************************************************************/
+extern const char *TELEM_get(const TELEM_cache_t *cache, const char *key);
+
+/*******************************************************************
+ * Marks all pairs dirty, a new client gets the complete state.
+ *******************************************************************/
+extern void TELEM_touch_all(TELEM_cache_t *cache);
+
+/*******************************************************************
+ * Builds one frame of dirty pairs, `{"key":value,...}`, and clears
+ * their dirty flag. Call until it returns 0.
+ *
+ * @param buffer The frame, terminated.
+ * @param size Buffer size, at least TELEM_FRAME_MIN.
+ * @param all Takes every pair instead of the dirty ones.
+ * @param cursor Slot to continue from, 0 on the first call.
+ * @return Frame length, 0 when no pair is left.
+ *******************************************************************/
+extern int TELEM_frame(TELEM_cache_t *cache, char *buffer, int size, bool all, uint16_t *cursor);
+
+/*******************************************************************
+ * Tick statistics: frames, bytes and pairs sent, serialisation time
+ * and the byte rate per window.
+ *******************************************************************/
+extern void TELEM_stats_init(TELEM_stats_t *stats, uint32_t window, uint32_t now);
+extern void TELEM_stats_tick(TELEM_stats_t *stats, uint32_t frames, uint32_t bytes, uint32_t pairs,
+                             uint32_t serialize, uint32_t now);
+
+/*******************************************************************
+ * Rendered pages
+ *
+ * A page template is rendered once into a buffer that is served as
+ * is. A field replaces the text between its opening marker and the
+ * next closing marker, both markers are kept, so the element stays
+ * addressable by the page scripts. Without a closing marker the
+ * opening marker itself is replaced.
+ *
+ * The entity tag is the quoted FNV-1a hash of the content, a page
+ * or a static asset hashed in chunks as it is read.
+ *******************************************************************/
+#define PAGE_ETAG_SIZE 11  // "xxxxxxxx", quotes and terminator
+#define PAGE_HASH_INIT 2166136261u
+
+typedef struct {
+  const char *open;   // Marker, e.g. <span id="ip_address">
+  const char *close;  // End of the replaced text, nullptr replaces the marker
+  const char *value;
+} PAGE_field_t;
+
+/*******************************************************************
+ * Renders a template in a single pass.
+ *
+ * @param source The template, need not be terminated.
+ * @param buffer The page, terminated. nullptr only measures.
+ * @param size Buffer size, rendered length plus one.
+ * @return Rendered length, -1 when the buffer is too small.
+ *******************************************************************/
+extern int PAGE_render(const char *source, int length, const PAGE_field_t *field, int num_fields, char *buffer,
+                       int size);
+
+/*******************************************************************
+ * Content hash, PAGE_HASH_INIT on the first chunk, and the entity
+ * tag of the final hash, quoted and terminated.
+ *******************************************************************/
+extern uint32_t PAGE_hash(uint32_t hash, const void *data, int length);
+extern void PAGE_etag(uint32_t hash, char etag[PAGE_ETAG_SIZE]);
+
+/*******************************************************************
+ * Checks an If-None-Match header: a list of tags, weak ones
+ * included, or "*".
+ *******************************************************************/
+extern bool PAGE_etag_match(const char *header, const char *etag);
+
+/*******************************************************************
+ * Media type by file extension, case insensitive. A trailing .gz
+ * is not stripped, pass the name of the uncompressed file.
+ *******************************************************************/
+extern const char *PAGE_content_type(const char *path);
+
+/*******************************************************************
+ * Arena
+ *
+ * Bump allocator over a fixed buffer for short lived documents, a
+ * REST response is built in it and the arena is reset afterwards.
+ * Each block is preceded by its size. Freeing or resizing the last
+ * block works in place, other blocks are released by the reset only.
+ * When a block does not fit the caller falls back to the heap.
+ *******************************************************************/
+#define ARENA_ALIGN 8
+
+typedef struct {
+  uint8_t *buffer;
+  uint32_t size;
+  uint32_t used;
+  uint32_t last;          // Offset of the last block, its header
+  uint32_t allocations;
+  uint32_t full;          // Blocks that did not fit
+  uint32_t peak;          // Since ARENA_init
+} ARENA_t;
+
+extern void ARENA_init(ARENA_t *arena, void *buffer, uint32_t size);
+extern void ARENA_reset(ARENA_t *arena);
+
+/*******************************************************************
+ * Allocates a block, aligned, nullptr when it does not fit.
+ *******************************************************************/
+extern void *ARENA_alloc(ARENA_t *arena, uint32_t size);
+
+/*******************************************************************
+ * Resizes a block of the arena, in place for the last block. Moves
+ * it otherwise, the old block stays until the reset.
+ *
+ * @return The block, nullptr when it does not fit (the block is
+ *         left as it was).
+ *******************************************************************/
+extern void *ARENA_realloc(ARENA_t *arena, void *block, uint32_t size);
+
+/*******************************************************************
+ * Frees a block, only the last one returns its space.
+ *******************************************************************/
+extern void ARENA_free(ARENA_t *arena, void *block);
+
+extern bool ARENA_owns(const ARENA_t *arena, const void *block);
+extern uint32_t ARENA_block_size(const ARENA_t *arena, const void *block);
+
 #endif // EBC_UTILS_HEADER
\ No newline at end of file
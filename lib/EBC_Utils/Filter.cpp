@@ -0,0 +1,197 @@
+/*******************************************************************
+ * Filter.cpp
+ *
+ * Fixed-point signal filter chain.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+static const char *FILTER_names[FILTER_NUM_TYPES] = {"median", "iir", "rate-limit", "deadband"};
+
+static int32_t FILTER_constrain(int32_t value, int32_t low, int32_t high) {
+  return (value < low) ? low : ((value > high) ? high : value);
+}
+
+static int32_t FILTER_abs(int32_t value) {
+  return (value < 0) ? -value : value;
+}
+
+/*******************************************************************
+ * Median of the last window samples, insertion sort of at most
+ * FILTER_MEDIAN_MAX values.
+ *******************************************************************/
+static int32_t FILTER_median(FILTER_stage_t *stage, int32_t value) {
+  int32_t sorted[FILTER_MEDIAN_MAX];
+  const uint8_t window = (uint8_t)stage->cfg.window;
+
+  stage->history[stage->index] = value;
+  stage->index = (stage->index + 1) % window;
+  if (stage->count < window) {
+    stage->count++;
+  }
+
+  for (uint8_t i = 0; i < stage->count; i++) {
+    int32_t sample = stage->history[i];
+    uint8_t j = i;
+
+    while (j > 0 && sorted[j - 1] > sample) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = sample;
+  }
+
+  return sorted[stage->count / 2];
+}
+
+/*******************************************************************
+ * First-order low pass, accumulator in Q15.
+ *******************************************************************/
+static int32_t FILTER_iir(FILTER_stage_t *stage, int32_t value) {
+  const int64_t x = (int64_t)value << FILTER_IIR_SHIFT;
+
+  if (!stage->primed) {
+    stage->acc = x;
+  } else {
+    stage->acc += ((x - stage->acc) * stage->cfg.alpha) >> FILTER_IIR_SHIFT;
+  }
+
+  return (int32_t)((stage->acc + (FILTER_IIR_ONE / 2)) >> FILTER_IIR_SHIFT);
+}
+
+/*******************************************************************
+ * Slew rate limit.
+ *******************************************************************/
+static int32_t FILTER_rate_limit(FILTER_stage_t *stage, int32_t value) {
+  if (!stage->primed) {
+    stage->last = value;
+  } else {
+    stage->last += FILTER_constrain(value - stage->last, -stage->cfg.step, stage->cfg.step);
+  }
+
+  return stage->last;
+}
+
+/*******************************************************************
+ * Centre deadband with hysteresis.
+ *******************************************************************/
+static int32_t FILTER_deadband(FILTER_stage_t *stage, int32_t value) {
+  const int32_t distance = FILTER_abs(value - stage->cfg.centre);
+
+  if (!stage->primed) {
+    stage->inside = (distance <= stage->cfg.width);
+  } else if (stage->inside) {
+    stage->inside = (distance <= stage->cfg.width + stage->cfg.hysteresis);
+  } else {
+    stage->inside = (distance <= stage->cfg.width);
+  }
+
+  return stage->inside ? stage->cfg.centre : value;
+}
+
+/*******************************************************************
+ * Runs one sample through a single stage.
+ *******************************************************************/
+int32_t FILTER_stage_run(FILTER_stage_t *stage, int32_t value) {
+  switch (stage->cfg.type) {
+    case FILTER_MEDIAN:
+      value = FILTER_median(stage, value);
+      break;
+
+    case FILTER_IIR:
+      value = FILTER_iir(stage, value);
+      break;
+
+    case FILTER_RATE_LIMIT:
+      value = FILTER_rate_limit(stage, value);
+      break;
+
+    case FILTER_DEADBAND:
+      value = FILTER_deadband(stage, value);
+      break;
+
+    default:
+      break;
+  }
+
+  stage->primed = true;
+  return value;
+}
+
+/*******************************************************************
+ * Runs one sample through the chain.
+ *******************************************************************/
+int32_t FILTER_chain_run(FILTER_chain_t *chain, int32_t value) {
+  for (uint8_t i = 0; i < chain->num_stages; i++) {
+    FILTER_stage_t *stage = &chain->stage[i];
+
+    if (!chain->clock) {
+      value = FILTER_stage_run(stage, value);
+      continue;
+    }
+
+    uint32_t start = chain->clock();
+    value = FILTER_stage_run(stage, value);
+    stage->cost_last = chain->clock() - start;
+
+    if (stage->cost_last > stage->cost_max) {
+      stage->cost_max = stage->cost_last;
+    }
+    if (stage->cfg.budget && (stage->cost_last > stage->cfg.budget)) {
+      stage->over_budget++;
+    }
+  }
+
+  return value;
+}
+
+/*******************************************************************
+ * Clears the state of all stages.
+ *******************************************************************/
+void FILTER_chain_reset(FILTER_chain_t *chain) {
+  for (uint8_t i = 0; i < chain->num_stages; i++) {
+    FILTER_stage_t *stage = &chain->stage[i];
+
+    stage->primed = false;
+    stage->index = 0;
+    stage->count = 0;
+  }
+}
+
+/*******************************************************************
+ * Initialises a filter chain, parameters are forced into range.
+ *******************************************************************/
+int FILTER_chain_init(FILTER_chain_t *chain, const FILTER_stage_cfg_t *cfg, int num_stages, FILTER_clock_fn clock) {
+  memset(chain, 0, sizeof(*chain));
+  chain->clock = clock;
+
+  if (num_stages > FILTER_MAX_STAGES) {
+    num_stages = FILTER_MAX_STAGES;
+  }
+
+  for (int i = 0; i < num_stages; i++) {
+    FILTER_stage_cfg_t *stage = &chain->stage[i].cfg;
+
+    *stage = cfg[i];
+    stage->window = FILTER_constrain(stage->window | 1, 1, FILTER_MEDIAN_MAX);  // Odd
+    stage->alpha = FILTER_constrain(stage->alpha, 1, FILTER_IIR_ONE);
+    stage->step = FILTER_constrain(stage->step, 1, INT32_MAX);
+    stage->width = FILTER_constrain(stage->width, 0, INT32_MAX);
+    stage->hysteresis = FILTER_constrain(stage->hysteresis, 0, INT32_MAX - stage->width);
+  }
+
+  chain->num_stages = (uint8_t)num_stages;
+  return num_stages;
+}
+
+/*******************************************************************
+ * Name of a filter type.
+ *******************************************************************/
+const char *FILTER_type_name(FILTER_type_t type) {
+  return (type < FILTER_NUM_TYPES) ? FILTER_names[type] : "unknown";
+}
@@ -0,0 +1,268 @@
+/*******************************************************************
+ * Health.cpp
+ *
+ * CAN bus load from frame bit times, error state and trend, and the
+ * bus-off recovery backoff.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define HEALTH_CRC15_POLY 0x4599
+#define HEALTH_TAIL_BITS 13   // CRC delimiter, ACK slot and delimiter, EOF, intermission
+#define HEALTH_MAX_BITS 120   // Stuffed part of an extended frame with 8 bytes
+#define HEALTH_WARNING_LIMIT 96
+#define HEALTH_PASSIVE_LIMIT 128
+#define HEALTH_BUS_OFF_LIMIT 256
+
+static const char *HEALTH_STATE_NAMES[] = {"error-active", "error-warning", "error-passive", "bus-off", "recovering"};
+static const char *HEALTH_VERDICT_NAMES[] = {"ok", "congested", "transmit-errors", "bus-errors"};
+
+typedef struct {
+  uint8_t bit[HEALTH_MAX_BITS];
+  int count;
+} HEALTH_bits_t;
+
+static void HEALTH_push(HEALTH_bits_t *bits, uint32_t value, int width) {
+  for (int i = width - 1; i >= 0; i--) {
+    bits->bit[bits->count++] = (value >> i) & 1;
+  }
+}
+
+/*******************************************************************
+ * Frame bit time
+ *******************************************************************/
+uint16_t HEALTH_frame_bits(const CAN_frame_t *frame) {
+  const uint8_t length = (frame->length > 8) ? 8 : frame->length;
+  HEALTH_bits_t bits;
+  uint16_t crc = 0;
+  int stuffed = 0;
+  int run = 1;
+
+  bits.count = 0;
+  HEALTH_push(&bits, 0, 1);  // SOF
+  if (frame->ext) {
+    HEALTH_push(&bits, (frame->id >> 18) & 0x7FF, 11);
+    HEALTH_push(&bits, 1, 1);  // SRR
+    HEALTH_push(&bits, 1, 1);  // IDE
+    HEALTH_push(&bits, frame->id & 0x3FFFF, 18);
+    HEALTH_push(&bits, frame->rtr ? 1 : 0, 1);
+    HEALTH_push(&bits, 0, 2);  // r1, r0
+  } else {
+    HEALTH_push(&bits, frame->id & 0x7FF, 11);
+    HEALTH_push(&bits, frame->rtr ? 1 : 0, 1);
+    HEALTH_push(&bits, 0, 2);  // IDE, r0
+  }
+  HEALTH_push(&bits, length, 4);
+  if (!frame->rtr) {
+    for (uint8_t i = 0; i < length; i++) {
+      HEALTH_push(&bits, frame->data[i], 8);
+    }
+  }
+
+  for (int i = 0; i < bits.count; i++) {
+    const bool next = bits.bit[i] ^ ((crc >> 14) & 1);
+
+    crc = (crc << 1) & 0x7FFF;
+    if (next) {
+      crc ^= HEALTH_CRC15_POLY;
+    }
+  }
+  HEALTH_push(&bits, crc, 15);
+
+  /* A stuff bit follows five equal bits and starts the next run */
+  uint8_t last = bits.bit[0];
+  for (int i = 1; i < bits.count; i++) {
+    if (bits.bit[i] == last) {
+      run++;
+    } else {
+      last = bits.bit[i];
+      run = 1;
+    }
+    if (run == 5) {
+      stuffed++;
+      last ^= 1;
+      run = 1;
+    }
+  }
+
+  return (uint16_t)(bits.count + stuffed + HEALTH_TAIL_BITS);
+}
+
+/*******************************************************************
+ * Bus load
+ *******************************************************************/
+void HEALTH_load_init(HEALTH_load_t *load, uint32_t bitrate, uint32_t window, uint32_t now) {
+  memset(load, 0, sizeof(*load));
+  load->bitrate = bitrate;
+  load->window = window;
+  load->start = now;
+}
+
+bool HEALTH_load_update(HEALTH_load_t *load, uint32_t now) {
+  const uint32_t elapsed = now - load->start;
+
+  if (!load->window || !load->bitrate || (elapsed < load->window)) {
+    return false;
+  }
+
+  const uint64_t capacity = (uint64_t)load->bitrate * load->window;  // Bits * 10^6
+  const uint64_t permille = ((uint64_t)load->bits * 1000000000ULL) / capacity;
+
+  load->load = (permille > 1000) ? 1000 : (uint16_t)permille;
+  load->frame_rate = (uint32_t)(((uint64_t)load->frames * 1000000ULL) / load->window);
+  if (load->load > load->load_max) {
+    load->load_max = load->load;
+  }
+
+  if (elapsed >= 2 * load->window) {
+    load->load = 0;  // Later windows were quiet
+    load->frame_rate = 0;
+  }
+
+  load->start += (elapsed / load->window) * load->window;
+  load->bits = 0;
+  load->frames = 0;
+  return true;
+}
+
+void HEALTH_load_add(HEALTH_load_t *load, uint16_t bits, uint32_t now) {
+  HEALTH_load_update(load, now);
+  load->bits += bits;
+  load->frames++;
+}
+
+/*******************************************************************
+ * Error state and trend
+ *******************************************************************/
+HEALTH_state_t HEALTH_state(uint16_t tec, uint16_t rec) {
+  if ((tec != HEALTH_COUNTER_UNKNOWN) && (tec >= HEALTH_BUS_OFF_LIMIT)) {
+    return HEALTH_BUS_OFF;
+  }
+  if (((tec != HEALTH_COUNTER_UNKNOWN) && (tec >= HEALTH_PASSIVE_LIMIT)) ||
+      ((rec != HEALTH_COUNTER_UNKNOWN) && (rec >= HEALTH_PASSIVE_LIMIT))) {
+    return HEALTH_ERROR_PASSIVE;
+  }
+  if (((tec != HEALTH_COUNTER_UNKNOWN) && (tec >= HEALTH_WARNING_LIMIT)) ||
+      ((rec != HEALTH_COUNTER_UNKNOWN) && (rec >= HEALTH_WARNING_LIMIT))) {
+    return HEALTH_ERROR_WARNING;
+  }
+  return HEALTH_ERROR_ACTIVE;
+}
+
+void HEALTH_errors_init(HEALTH_errors_t *errors) {
+  memset(errors, 0, sizeof(*errors));
+  errors->state = HEALTH_ERROR_ACTIVE;
+}
+
+void HEALTH_errors_add(HEALTH_errors_t *errors, const HEALTH_status_t *status) {
+  errors->tec[errors->index] = status->tec;
+  errors->rec[errors->index] = status->rec;
+  errors->index = (errors->index + 1) % HEALTH_TREND_SAMPLES;
+  if (errors->count < HEALTH_TREND_SAMPLES) {
+    errors->count++;
+  }
+
+  if ((status->tec != HEALTH_COUNTER_UNKNOWN) && (status->tec > errors->tec_max)) {
+    errors->tec_max = status->tec;
+  }
+  if ((status->rec != HEALTH_COUNTER_UNKNOWN) && (status->rec > errors->rec_max)) {
+    errors->rec_max = status->rec;
+  }
+
+  errors->bus_errors_delta = status->bus_errors - errors->bus_errors;
+  errors->bus_errors = status->bus_errors;
+
+  if (status->state != errors->state) {
+    errors->entered[status->state]++;
+    errors->state = status->state;
+  }
+}
+
+int HEALTH_errors_trend(const HEALTH_errors_t *errors, bool transmit) {
+  const uint16_t *counter = transmit ? errors->tec : errors->rec;
+
+  if (errors->count < 2) {
+    return 0;
+  }
+
+  const uint16_t newest = counter[(errors->index + HEALTH_TREND_SAMPLES - 1) % HEALTH_TREND_SAMPLES];
+  const uint16_t oldest = counter[(errors->index + HEALTH_TREND_SAMPLES - errors->count) % HEALTH_TREND_SAMPLES];
+
+  if ((newest == HEALTH_COUNTER_UNKNOWN) || (oldest == HEALTH_COUNTER_UNKNOWN)) {
+    return 0;
+  }
+  return (int)newest - (int)oldest;
+}
+
+/*******************************************************************
+ * Diagnosis
+ *******************************************************************/
+HEALTH_verdict_t HEALTH_diagnose(const HEALTH_load_t *load, const HEALTH_errors_t *errors) {
+  if ((errors->state == HEALTH_BUS_OFF) || (errors->state == HEALTH_RECOVERING) ||
+      (HEALTH_errors_trend(errors, true) > 0)) {
+    return HEALTH_TX_ERRORS;
+  }
+  if ((HEALTH_errors_trend(errors, false) > 0) || errors->bus_errors_delta ||
+      (errors->state == HEALTH_ERROR_PASSIVE)) {
+    return HEALTH_BUS_ERRORS;
+  }
+  if (load->load >= HEALTH_CONGESTED_LOAD) {
+    return HEALTH_CONGESTED;
+  }
+  return HEALTH_OK;
+}
+
+/*******************************************************************
+ * Bus-off recovery backoff
+ *******************************************************************/
+void HEALTH_backoff_init(HEALTH_backoff_t *backoff, uint32_t base, uint32_t max, uint32_t stable) {
+  memset(backoff, 0, sizeof(*backoff));
+  backoff->base = base;
+  backoff->max = max;
+  backoff->stable = stable;
+  backoff->delay = base;
+}
+
+void HEALTH_backoff_bus_off(HEALTH_backoff_t *backoff, uint32_t now) {
+  if (backoff->pending) {
+    return;
+  }
+
+  backoff->pending = true;
+  backoff->bus_offs++;
+  backoff->due = now + backoff->delay;
+  backoff->delay = (backoff->delay > backoff->max / 2) ? backoff->max : 2 * backoff->delay;
+}
+
+bool HEALTH_backoff_due(HEALTH_backoff_t *backoff, uint32_t now) {
+  if (!backoff->pending || ((int32_t)(now - backoff->due) < 0)) {
+    return false;
+  }
+
+  backoff->pending = false;
+  backoff->recoveries++;
+  backoff->since = now;
+  return true;
+}
+
+void HEALTH_backoff_ok(HEALTH_backoff_t *backoff, uint32_t now) {
+  if (!backoff->pending && (backoff->delay != backoff->base) && ((now - backoff->since) >= backoff->stable)) {
+    backoff->delay = backoff->base;
+  }
+}
+
+/*******************************************************************
+ * Names
+ *******************************************************************/
+const char *HEALTH_state_name(HEALTH_state_t state) {
+  return (state < HEALTH_NUM_STATES) ? HEALTH_STATE_NAMES[state] : "unknown";
+}
+
+const char *HEALTH_verdict_name(HEALTH_verdict_t verdict) {
+  return (verdict <= HEALTH_BUS_ERRORS) ? HEALTH_VERDICT_NAMES[verdict] : "unknown";
+}
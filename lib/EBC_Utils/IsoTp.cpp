@@ -0,0 +1,337 @@
+/*******************************************************************
+ * IsoTp.cpp
+ *
+ * ISO-TP (ISO 15765-2) transport on classic CAN, normal addressing,
+ * 8 byte padded frames and 12 bit message lengths.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define ISOTP_PCI_SINGLE 0x0
+#define ISOTP_PCI_FIRST 0x1
+#define ISOTP_PCI_CONSECUTIVE 0x2
+#define ISOTP_PCI_FLOW_CONTROL 0x3
+
+#define ISOTP_FC_CONTINUE 0x0
+#define ISOTP_FC_WAIT 0x1
+#define ISOTP_FC_OVERFLOW 0x2
+
+#define ISOTP_SINGLE_MAX 7  // Payload of a single frame
+#define ISOTP_FIRST_DATA 6  // Payload of a first frame
+#define ISOTP_CONSECUTIVE_DATA 7
+
+/*******************************************************************
+ * Frames
+ *******************************************************************/
+static void ISOTP_frame(const ISOTP_link_t *link, CAN_frame_t *frame) {
+  memset(frame, 0, sizeof(*frame));
+  frame->id = link->config.tx_id;
+  frame->ext = link->config.ext ? 1 : 0;
+  frame->length = 8;
+  memset(frame->data, link->config.padding, sizeof(frame->data));
+}
+
+/* A frame the queue refuses is kept and sent first by ISOTP_poll() */
+static void ISOTP_emit(ISOTP_link_t *link, const CAN_frame_t *frame) {
+  if (!link->has_pending && link->config.send(frame, link->config.context)) {
+    link->tx_frames++;
+    return;
+  }
+  if (link->has_pending) {
+    link->errors++;  // Second frame waiting, lost
+    return;
+  }
+  link->pending = *frame;
+  link->has_pending = true;
+}
+
+static void ISOTP_flow_control(ISOTP_link_t *link, uint8_t status) {
+  CAN_frame_t frame;
+
+  ISOTP_frame(link, &frame);
+  frame.data[0] = (ISOTP_PCI_FLOW_CONTROL << 4) | status;
+  frame.data[1] = link->config.block_size;
+  frame.data[2] = link->config.st_min;
+  ISOTP_emit(link, &frame);
+}
+
+static void ISOTP_tx_fail(ISOTP_link_t *link, ISOTP_result_t result) {
+  link->tx_state = ISOTP_TX_IDLE;
+  link->errors++;
+  link->config.done(true, result, link->config.context);
+}
+
+static void ISOTP_rx_fail(ISOTP_link_t *link, ISOTP_result_t result) {
+  link->rx_active = false;
+  link->errors++;
+  link->config.done(false, result, link->config.context);
+}
+
+uint32_t ISOTP_st_min(uint8_t st_min) {
+  if (st_min <= 0x7F) {
+    return (uint32_t)st_min * 1000;
+  }
+  if ((st_min >= 0xF1) && (st_min <= 0xF9)) {
+    return (uint32_t)(st_min - 0xF0) * 100;
+  }
+  return 127000;
+}
+
+/*******************************************************************
+ * Link
+ *******************************************************************/
+void ISOTP_init(ISOTP_link_t *link, const ISOTP_config_t *config) {
+  memset(link, 0, sizeof(*link));
+  link->config = *config;
+  link->tx_state = ISOTP_TX_IDLE;
+}
+
+/*******************************************************************
+ * Transmit
+ *******************************************************************/
+int ISOTP_send(ISOTP_link_t *link, uint16_t length, uint32_t now) {
+  CAN_frame_t frame;
+
+  if ((link->tx_state != ISOTP_TX_IDLE) || !length || (length > ISOTP_MAX_LENGTH)) {
+    return -1;
+  }
+
+  ISOTP_frame(link, &frame);
+
+  if (length <= ISOTP_SINGLE_MAX) {
+    frame.data[0] = (ISOTP_PCI_SINGLE << 4) | length;
+    link->config.source(0, &frame.data[1], (uint8_t)length, link->config.context);
+    ISOTP_emit(link, &frame);
+    link->tx_messages++;
+    link->config.done(true, ISOTP_OK, link->config.context);
+    return 0;
+  }
+
+  frame.data[0] = (ISOTP_PCI_FIRST << 4) | (length >> 8);
+  frame.data[1] = length & 0xFF;
+  link->config.source(0, &frame.data[2], ISOTP_FIRST_DATA, link->config.context);
+  ISOTP_emit(link, &frame);
+
+  link->tx_length = length;
+  link->tx_offset = ISOTP_FIRST_DATA;
+  link->tx_sn = 1;
+  link->tx_waits = 0;
+  link->tx_state = ISOTP_TX_WAIT_FC;
+  link->tx_due = now + link->config.timeout;
+  return 0;
+}
+
+static void ISOTP_receive_flow_control(ISOTP_link_t *link, const CAN_frame_t *frame, uint32_t now) {
+  if (link->tx_state != ISOTP_TX_WAIT_FC) {
+    return;
+  }
+
+  switch (frame->data[0] & 0x0F) {
+    case ISOTP_FC_CONTINUE:
+      link->tx_block_size = frame->data[1];
+      link->tx_block = frame->data[1];
+      link->tx_st_min = ISOTP_st_min(frame->data[2]);
+      link->tx_waits = 0;
+      link->tx_state = ISOTP_TX_SENDING;
+      link->tx_due = now;
+      break;
+
+    case ISOTP_FC_WAIT:
+      if (++link->tx_waits > ISOTP_WAIT_MAX) {
+        ISOTP_tx_fail(link, ISOTP_ABORTED);
+        return;
+      }
+      link->tx_due = now + link->config.timeout;
+      break;
+
+    case ISOTP_FC_OVERFLOW:
+      ISOTP_tx_fail(link, ISOTP_OVERFLOW);
+      break;
+
+    default:
+      ISOTP_tx_fail(link, ISOTP_ABORTED);
+      break;
+  }
+}
+
+/*******************************************************************
+ * Receive
+ *******************************************************************/
+static void ISOTP_receive_single(ISOTP_link_t *link, const CAN_frame_t *frame) {
+  const uint8_t length = frame->data[0] & 0x0F;
+
+  if (!length || (length > ISOTP_SINGLE_MAX) || (length >= frame->length)) {
+    return;
+  }
+  if (link->rx_active) {
+    ISOTP_rx_fail(link, ISOTP_ABORTED);  // New message ends the one in progress
+  }
+
+  if (link->config.sink(0, &frame->data[1], length, length, link->config.context)) {
+    link->rx_messages++;
+    link->config.done(false, ISOTP_OK, link->config.context);
+  }
+}
+
+static void ISOTP_receive_first(ISOTP_link_t *link, const CAN_frame_t *frame, uint32_t now) {
+  const uint16_t length = ((frame->data[0] & 0x0F) << 8) | frame->data[1];
+
+  if ((length <= ISOTP_SINGLE_MAX) || (frame->length < 8)) {
+    return;
+  }
+  if (link->rx_active) {
+    ISOTP_rx_fail(link, ISOTP_ABORTED);
+  }
+
+  if (!link->config.sink(0, &frame->data[2], ISOTP_FIRST_DATA, length, link->config.context)) {
+    ISOTP_flow_control(link, ISOTP_FC_OVERFLOW);
+    return;
+  }
+
+  link->rx_active = true;
+  link->rx_length = length;
+  link->rx_offset = ISOTP_FIRST_DATA;
+  link->rx_sn = 1;
+  link->rx_block = 0;
+  link->rx_due = now + link->config.timeout;
+  ISOTP_flow_control(link, ISOTP_FC_CONTINUE);
+}
+
+static void ISOTP_receive_consecutive(ISOTP_link_t *link, const CAN_frame_t *frame, uint32_t now) {
+  if (!link->rx_active) {
+    return;
+  }
+  if ((frame->data[0] & 0x0F) != link->rx_sn) {
+    ISOTP_rx_fail(link, ISOTP_WRONG_SN);
+    return;
+  }
+
+  const uint16_t left = link->rx_length - link->rx_offset;
+  const uint8_t length = (left > ISOTP_CONSECUTIVE_DATA) ? ISOTP_CONSECUTIVE_DATA : (uint8_t)left;
+
+  if ((frame->length < length + 1) ||
+      !link->config.sink(link->rx_offset, &frame->data[1], length, link->rx_length, link->config.context)) {
+    ISOTP_rx_fail(link, ISOTP_ABORTED);
+    return;
+  }
+
+  link->rx_offset += length;
+  link->rx_sn = (link->rx_sn + 1) & 0x0F;
+
+  if (link->rx_offset >= link->rx_length) {
+    link->rx_active = false;
+    link->rx_messages++;
+    link->config.done(false, ISOTP_OK, link->config.context);
+    return;
+  }
+
+  link->rx_due = now + link->config.timeout;
+  if (link->config.block_size && (++link->rx_block >= link->config.block_size)) {
+    link->rx_block = 0;
+    ISOTP_flow_control(link, ISOTP_FC_CONTINUE);
+  }
+}
+
+void ISOTP_receive(ISOTP_link_t *link, const CAN_frame_t *frame, uint32_t now) {
+  if ((frame->id != link->config.rx_id) || ((frame->ext != 0) != link->config.ext) || frame->rtr || !frame->length) {
+    return;
+  }
+
+  link->rx_frames++;
+  switch (frame->data[0] >> 4) {
+    case ISOTP_PCI_SINGLE:
+      ISOTP_receive_single(link, frame);
+      break;
+    case ISOTP_PCI_FIRST:
+      ISOTP_receive_first(link, frame, now);
+      break;
+    case ISOTP_PCI_CONSECUTIVE:
+      ISOTP_receive_consecutive(link, frame, now);
+      break;
+    case ISOTP_PCI_FLOW_CONTROL:
+      ISOTP_receive_flow_control(link, frame, now);
+      break;
+    default:
+      break;
+  }
+}
+
+/*******************************************************************
+ * Timing
+ *******************************************************************/
+void ISOTP_poll(ISOTP_link_t *link, uint32_t now) {
+  CAN_frame_t frame;
+
+  if (link->has_pending) {
+    if (!link->config.send(&link->pending, link->config.context)) {
+      return;  // Still full, frames stay in order
+    }
+    link->has_pending = false;
+    link->tx_frames++;
+  }
+
+  if (link->rx_active && ((int32_t)(now - link->rx_due) >= 0)) {
+    ISOTP_rx_fail(link, ISOTP_TIMEOUT);
+  }
+
+  if ((link->tx_state == ISOTP_TX_WAIT_FC) && ((int32_t)(now - link->tx_due) >= 0)) {
+    ISOTP_tx_fail(link, ISOTP_TIMEOUT);
+    return;
+  }
+
+  while ((link->tx_state == ISOTP_TX_SENDING) && ((int32_t)(now - link->tx_due) >= 0)) {
+    const uint16_t left = link->tx_length - link->tx_offset;
+    const uint8_t length = (left > ISOTP_CONSECUTIVE_DATA) ? ISOTP_CONSECUTIVE_DATA : (uint8_t)left;
+
+    ISOTP_frame(link, &frame);
+    frame.data[0] = (ISOTP_PCI_CONSECUTIVE << 4) | link->tx_sn;
+    link->config.source(link->tx_offset, &frame.data[1], length, link->config.context);
+    if (!link->config.send(&frame, link->config.context)) {
+      return;  // Queue full, again on the next poll
+    }
+
+    link->tx_frames++;
+    link->tx_offset += length;
+    link->tx_sn = (link->tx_sn + 1) & 0x0F;
+
+    if (link->tx_offset >= link->tx_length) {
+      link->tx_state = ISOTP_TX_IDLE;
+      link->tx_messages++;
+      link->config.done(true, ISOTP_OK, link->config.context);
+      return;
+    }
+
+    if (link->tx_block_size && (--link->tx_block == 0)) {
+      link->tx_state = ISOTP_TX_WAIT_FC;
+      link->tx_due = now + link->config.timeout;
+      return;
+    }
+    link->tx_due = now + link->tx_st_min;
+  }
+}
+
+uint32_t ISOTP_wait(const ISOTP_link_t *link, uint32_t now) {
+  uint32_t wait = ISOTP_IDLE;
+
+  if (link->has_pending) {
+    return 0;
+  }
+
+  if (link->rx_active) {
+    const int32_t left = (int32_t)(link->rx_due - now);
+    wait = (left > 0) ? (uint32_t)left : 0;
+  }
+  if (link->tx_state != ISOTP_TX_IDLE) {
+    const int32_t left = (int32_t)(link->tx_due - now);
+    const uint32_t tx_wait = (left > 0) ? (uint32_t)left : 0;
+    if (tx_wait < wait) {
+      wait = tx_wait;
+    }
+  }
+  return wait;
+}
@@ -0,0 +1,446 @@
+/*******************************************************************
+ * Nmea2000.cpp
+ *
+ * NMEA2000 identifier codec, ISO address claim, fast-packet
+ * transport and table driven PGN encoding.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <math.h>
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define N2K_PDU2_FIRST 240  // PDU format of the first broadcast PGN
+#define N2K_FP_FIRST_BYTES 6
+#define N2K_FP_NEXT_BYTES 7
+#define N2K_NAME_ARBITRARY (1ULL << 63)
+
+/*******************************************************************
+ * PGN codec table, field layouts after NMEA2000 appendix B.
+ * Reserved bits are not listed, they are sent as ones.
+ *******************************************************************/
+static const N2K_field_t N2K_rudder_fields[N2K_RUDDER_FIELDS] = {
+    {"instance", 0, 8, false, 1},
+    {"direction-order", 8, 3, false, 1},
+    {"angle-order", 16, 16, true, 0.0001},
+    {"position", 32, 16, true, 0.0001},
+};
+
+static const N2K_field_t N2K_thruster_fields[N2K_THRUSTER_FIELDS] = {
+    {"sid", 0, 8, false, 1},
+    {"identifier", 8, 8, false, 1},
+    {"direction", 16, 4, false, 1},
+    {"power", 20, 2, false, 1},
+    {"retract", 22, 2, false, 1},
+    {"speed", 24, 8, false, 1},
+    {"events", 32, 8, false, 1},
+    {"timeout", 40, 8, false, 0.005},
+    {"azimuth", 48, 16, false, 0.0001},
+};
+
+static const N2K_field_t N2K_engine_rapid_fields[N2K_ENGINE_RAPID_FIELDS] = {
+    {"instance", 0, 8, false, 1},
+    {"speed", 8, 16, false, 0.25},
+    {"boost-pressure", 24, 16, false, 100},
+    {"trim", 40, 8, true, 1},
+};
+
+static const N2K_field_t N2K_engine_fields[N2K_ENGINE_FIELDS] = {
+    {"instance", 0, 8, false, 1},
+    {"oil-pressure", 8, 16, false, 100},
+    {"oil-temperature", 24, 16, false, 0.1},
+    {"temperature", 40, 16, false, 0.01},
+    {"alternator", 56, 16, true, 0.01},
+    {"fuel-rate", 72, 16, true, 0.1},
+    {"hours", 88, 32, false, 1},
+    {"coolant-pressure", 120, 16, false, 100},
+    {"fuel-pressure", 136, 16, false, 1000},
+    {"status-1", 160, 16, false, 1},
+    {"status-2", 176, 16, false, 1},
+    {"load", 192, 8, true, 1},
+    {"torque", 200, 8, true, 1},
+};
+
+static const N2K_pgn_t N2K_pgns[] = {
+    {N2K_PGN_RUDDER, "rudder", 2, 8, false, N2K_RUDDER_FIELDS, N2K_rudder_fields},
+    {N2K_PGN_ENGINE_RAPID, "engine-rapid", 2, 8, false, N2K_ENGINE_RAPID_FIELDS, N2K_engine_rapid_fields},
+    {N2K_PGN_ENGINE_DYNAMIC, "engine-dynamic", 2, 26, true, N2K_ENGINE_FIELDS, N2K_engine_fields},
+    {N2K_PGN_THRUSTER_STATUS, "thruster-status", 3, 8, false, N2K_THRUSTER_FIELDS, N2K_thruster_fields},
+};
+
+#define N2K_NUM_PGNS (sizeof(N2K_pgns) / sizeof(N2K_pgns[0]))
+
+/*******************************************************************
+ * Identifier
+ *******************************************************************/
+void N2K_id_decode(uint32_t id, N2K_header_t *header) {
+  const uint8_t pf = (uint8_t)(id >> 16);
+
+  header->priority = (uint8_t)((id >> 26) & 0x07);
+  header->source = (uint8_t)id;
+
+  if (pf < N2K_PDU2_FIRST) {
+    header->pgn = (id >> 8) & 0x3FF00;
+    header->destination = (uint8_t)(id >> 8);
+  } else {
+    header->pgn = (id >> 8) & 0x3FFFF;
+    header->destination = N2K_ADDRESS_GLOBAL;
+  }
+}
+
+uint32_t N2K_id_encode(const N2K_header_t *header) {
+  uint32_t id = ((uint32_t)(header->priority & 0x07) << 26) | ((header->pgn & 0x3FFFF) << 8) | header->source;
+
+  if (((header->pgn >> 8) & 0xFF) < N2K_PDU2_FIRST) {
+    id = (id & ~0xFF00UL) | ((uint32_t)header->destination << 8);
+  }
+  return id;
+}
+
+/*******************************************************************
+ * Fast-packet reassembly
+ *******************************************************************/
+void N2K_fp_init(N2K_fp_pool_t *pool) {
+  memset(pool, 0, sizeof(*pool));
+}
+
+static N2K_fp_slot_t *N2K_fp_find(N2K_fp_pool_t *pool, uint32_t pgn, uint8_t source) {
+  for (int i = 0; i < N2K_FP_SLOTS; i++) {
+    N2K_fp_slot_t *slot = &pool->slot[i];
+
+    if (slot->active && (slot->pgn == pgn) && (slot->source == source)) {
+      return slot;
+    }
+  }
+  return nullptr;
+}
+
+static N2K_fp_slot_t *N2K_fp_alloc(N2K_fp_pool_t *pool, uint32_t now) {
+  N2K_fp_slot_t *stale = nullptr;
+
+  for (int i = 0; i < N2K_FP_SLOTS; i++) {
+    N2K_fp_slot_t *slot = &pool->slot[i];
+
+    if (!slot->active) {
+      return slot;
+    }
+    if ((now - slot->last) > N2K_FP_TIMEOUT) {
+      stale = slot;
+    }
+  }
+
+  if (stale) {
+    pool->timeouts++;
+  }
+  return stale;
+}
+
+static bool N2K_fp_complete(N2K_fp_pool_t *pool, N2K_fp_slot_t *slot, const N2K_header_t *header,
+                            N2K_message_t *message) {
+  if (slot->received < slot->length) {
+    return false;
+  }
+
+  slot->active = false;  // Data stays valid until the slot is taken again
+  pool->completed++;
+
+  message->header = *header;
+  message->length = slot->length;
+  message->data = slot->data;
+  return true;
+}
+
+bool N2K_fp_receive(N2K_fp_pool_t *pool, const N2K_header_t *header, const uint8_t *data,
+                    uint8_t length, uint32_t now, N2K_message_t *message) {
+  N2K_fp_slot_t *slot;
+  uint8_t bytes;
+
+  if (length < 2) {
+    pool->lost++;
+    return false;
+  }
+
+  const uint8_t counter = data[0] & 0x1F;
+  const uint8_t sequence = data[0] >> 5;
+
+  slot = N2K_fp_find(pool, header->pgn, header->source);
+
+  if (counter == 0) {
+    if (data[1] > N2K_FAST_PACKET_MAX) {
+      pool->lost++;
+      return false;
+    }
+
+    if (slot) {
+      pool->lost++;  // Previous message of this source never completed
+    } else if (!(slot = N2K_fp_alloc(pool, now))) {
+      pool->dropped++;
+      return false;
+    }
+
+    slot->pgn = header->pgn;
+    slot->source = header->source;
+    slot->sequence = sequence;
+    slot->length = data[1];
+    slot->next = 1;
+    slot->active = true;
+    slot->last = now;
+
+    bytes = length - 2;
+    if (bytes > N2K_FP_FIRST_BYTES) {
+      bytes = N2K_FP_FIRST_BYTES;
+    }
+    if (bytes > slot->length) {
+      bytes = slot->length;
+    }
+    memcpy(slot->data, &data[2], bytes);
+    slot->received = bytes;
+
+    return N2K_fp_complete(pool, slot, header, message);
+  }
+
+  if (!slot) {
+    return false;  // Start of the message was missed, or dropped
+  }
+
+  if ((slot->sequence != sequence) || (slot->next != counter)) {
+    slot->active = false;
+    pool->lost++;
+    return false;
+  }
+
+  bytes = length - 1;
+  if (bytes > N2K_FP_NEXT_BYTES) {
+    bytes = N2K_FP_NEXT_BYTES;
+  }
+  if (bytes > slot->length - slot->received) {
+    bytes = slot->length - slot->received;
+  }
+  memcpy(&slot->data[slot->received], &data[1], bytes);
+  slot->received += bytes;
+  slot->next++;
+  slot->last = now;
+
+  return N2K_fp_complete(pool, slot, header, message);
+}
+
+/*******************************************************************
+ * Fast-packet transmission
+ *******************************************************************/
+uint8_t N2K_fp_frames(uint8_t length) {
+  if (length <= N2K_FP_FIRST_BYTES) {
+    return 1;
+  }
+  return 1 + (length - N2K_FP_FIRST_BYTES + N2K_FP_NEXT_BYTES - 1) / N2K_FP_NEXT_BYTES;
+}
+
+void N2K_fp_frame(uint8_t sequence, const uint8_t *payload, uint8_t length, uint8_t index, uint8_t *frame) {
+  int offset, bytes;
+
+  memset(frame, 0xFF, 8);
+  frame[0] = (uint8_t)((sequence << 5) | (index & 0x1F));
+
+  if (index == 0) {
+    frame[1] = length;
+    offset = 0;
+    bytes = N2K_FP_FIRST_BYTES;
+  } else {
+    offset = N2K_FP_FIRST_BYTES + (index - 1) * N2K_FP_NEXT_BYTES;
+    bytes = N2K_FP_NEXT_BYTES;
+  }
+
+  if (bytes > length - offset) {
+    bytes = length - offset;
+  }
+  if (bytes > 0) {
+    memcpy(&frame[8 - ((index == 0) ? N2K_FP_FIRST_BYTES : N2K_FP_NEXT_BYTES)], &payload[offset], bytes);
+  }
+}
+
+/*******************************************************************
+ * ISO address claim
+ *******************************************************************/
+uint64_t N2K_name(const N2K_name_fields_t *fields) {
+  uint64_t name = 0;
+
+  name |= (uint64_t)(fields->identity & 0x1FFFFF);
+  name |= (uint64_t)(fields->manufacturer & 0x7FF) << 21;
+  name |= (uint64_t)fields->device_instance << 32;
+  name |= (uint64_t)fields->device_function << 40;
+  name |= (uint64_t)(fields->device_class & 0x7F) << 49;
+  name |= (uint64_t)(fields->system_instance & 0x0F) << 56;
+  name |= (uint64_t)(fields->industry_group & 0x07) << 60;
+  if (fields->arbitrary_address) {
+    name |= N2K_NAME_ARBITRARY;
+  }
+  return name;
+}
+
+void N2K_claim_init(N2K_claim_t *claim, uint64_t name, uint8_t preferred) {
+  claim->name = name;
+  claim->preferred = (preferred > N2K_ADDRESS_MAX) ? 0 : preferred;
+  claim->address = claim->preferred;
+  claim->conflicts = 0;
+}
+
+bool N2K_claim_received(N2K_claim_t *claim, uint8_t source, uint64_t name) {
+  if ((source != claim->address) || (claim->address == N2K_ADDRESS_NULL) || (name == claim->name)) {
+    return false;
+  }
+
+  claim->conflicts++;
+
+  if (claim->name < name) {
+    return true;  // Lower NAME wins, defend the address
+  }
+
+  if (!(claim->name & N2K_NAME_ARBITRARY)) {
+    claim->address = N2K_ADDRESS_NULL;
+    return true;  // Cannot claim
+  }
+
+  uint8_t next = (claim->address >= N2K_ADDRESS_MAX) ? 0 : claim->address + 1;
+  claim->address = (next == claim->preferred) ? N2K_ADDRESS_NULL : next;
+  return true;
+}
+
+uint64_t N2K_name_decode(const uint8_t *data, uint8_t length) {
+  uint64_t name = 0;
+
+  for (int i = ((length < 8) ? length : 8) - 1; i >= 0; i--) {
+    name = (name << 8) | data[i];
+  }
+  return name;
+}
+
+void N2K_name_encode(uint64_t name, uint8_t *data) {
+  for (int i = 0; i < 8; i++) {
+    data[i] = (uint8_t)(name >> (8 * i));
+  }
+}
+
+/*******************************************************************
+ * ISO request and acknowledgement
+ *******************************************************************/
+bool N2K_request_decode(const uint8_t *data, uint8_t length, uint32_t *pgn) {
+  if (length < 3) {
+    return false;
+  }
+  *pgn = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)(data[2] & 0x03) << 16);
+  return true;
+}
+
+void N2K_request_encode(uint32_t pgn, uint8_t *data) {
+  data[0] = (uint8_t)pgn;
+  data[1] = (uint8_t)(pgn >> 8);
+  data[2] = (uint8_t)(pgn >> 16);
+}
+
+void N2K_nak_encode(uint32_t pgn, uint8_t *data) {
+  data[0] = 1;  // Control, negative acknowledgement
+  data[1] = 0xFF;
+  data[2] = 0xFF;
+  data[3] = 0xFF;
+  data[4] = 0xFF;
+  N2K_request_encode(pgn, &data[5]);
+}
+
+/*******************************************************************
+ * PGN codec
+ *******************************************************************/
+const N2K_pgn_t *N2K_pgn_find(uint32_t pgn) {
+  for (unsigned i = 0; i < N2K_NUM_PGNS; i++) {
+    if (N2K_pgns[i].pgn == pgn) {
+      return &N2K_pgns[i];
+    }
+  }
+  return nullptr;
+}
+
+static uint32_t N2K_bits_get(const uint8_t *data, uint16_t offset, uint8_t bits) {
+  const int first = offset / 8;
+  const int last = (offset + bits - 1) / 8;
+  uint64_t raw = 0;
+
+  for (int i = last; i >= first; i--) {
+    raw = (raw << 8) | data[i];
+  }
+  raw >>= offset % 8;
+
+  return (uint32_t)(raw & ((1ULL << bits) - 1));
+}
+
+static void N2K_bits_set(uint8_t *data, uint16_t offset, uint8_t bits, uint32_t value) {
+  const uint64_t mask = ((1ULL << bits) - 1) << (offset % 8);
+  const uint64_t shifted = ((uint64_t)value << (offset % 8)) & mask;
+  const int first = offset / 8;
+  const int last = (offset + bits - 1) / 8;
+
+  for (int i = first; i <= last; i++) {
+    const int shift = 8 * (i - first);
+    data[i] = (uint8_t)((data[i] & ~(mask >> shift)) | (shifted >> shift));
+  }
+}
+
+int N2K_decode(const N2K_pgn_t *pgn, const uint8_t *data, uint8_t length, double *values) {
+  int decoded = 0;
+
+  for (int i = 0; i < pgn->num_fields; i++) {
+    const N2K_field_t *field = &pgn->field[i];
+    const uint32_t all = (uint32_t)((1ULL << field->bits) - 1);
+
+    if ((field->offset + field->bits) > (length * 8)) {
+      values[i] = NAN;
+      continue;
+    }
+
+    const uint32_t raw = N2K_bits_get(data, field->offset, field->bits);
+
+    if (field->sign) {
+      if (raw == (all >> 1)) {
+        values[i] = NAN;
+      } else {
+        const int32_t value = (raw & (1UL << (field->bits - 1))) ? (int32_t)(raw | ~all) : (int32_t)raw;
+        values[i] = value * field->resolution;
+      }
+    } else {
+      values[i] = ((field->bits > 1) && (raw == all)) ? NAN : raw * field->resolution;
+    }
+    decoded++;
+  }
+
+  return decoded;
+}
+
+uint8_t N2K_encode(const N2K_pgn_t *pgn, const double *values, uint8_t *data) {
+  memset(data, 0xFF, pgn->length);
+
+  for (int i = 0; i < pgn->num_fields; i++) {
+    const N2K_field_t *field = &pgn->field[i];
+    const uint32_t all = (uint32_t)((1ULL << field->bits) - 1);
+    uint32_t raw;
+
+    if (isnan(values[i])) {
+      raw = field->sign ? (all >> 1) : all;
+    } else if (field->sign) {
+      const double max = (double)(all >> 1) - 1;
+      const double min = -(double)(all >> 1) - 1;
+      double counts = round(values[i] / field->resolution);
+
+      counts = (counts > max) ? max : ((counts < min) ? min : counts);
+      raw = (uint32_t)(int32_t)counts & all;
+    } else {
+      const double max = (field->bits > 1) ? (double)all - 1 : (double)all;
+      double counts = round(values[i] / field->resolution);
+
+      raw = (uint32_t)((counts > max) ? max : ((counts < 0) ? 0 : counts));
+    }
+
+    N2K_bits_set(data, field->offset, field->bits, raw);
+  }
+
+  return pgn->length;
+}
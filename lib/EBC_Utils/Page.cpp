@@ -0,0 +1,188 @@
+/*******************************************************************
+ * Page.cpp
+ *
+ * Single pass rendering of page templates, entity tags for the
+ * conditional requests of cached pages and the media types of the
+ * static assets.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define PAGE_FNV_PRIME 16777619u
+
+/*******************************************************************
+ * Position of a marker in source[from, length), -1 when not found
+ *******************************************************************/
+static int PAGE_find(const char *source, int from, int length, const char *marker) {
+  const int marker_length = (int)strlen(marker);
+
+  for (int i = from; i + marker_length <= length; i++) {
+    if ((source[i] == marker[0]) && !memcmp(&source[i], marker, marker_length)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*******************************************************************
+ * Appends text, only counts once the buffer is full
+ *******************************************************************/
+static void PAGE_emit(char *buffer, int size, int *length, const char *text, int text_length) {
+  if (buffer && (*length + text_length < size)) {
+    memcpy(&buffer[*length], text, text_length);
+  }
+  *length += text_length;
+}
+
+/*******************************************************************
+ * Render
+ *******************************************************************/
+int PAGE_render(const char *source, int length, const PAGE_field_t *field, int num_fields, char *buffer,
+                int size) {
+  int rendered = 0;
+  int copied = 0;  // Source emitted up to here
+  int i = 0;
+
+  while (i < length) {
+    int matched = -1;
+    int end = 0;
+
+    for (int f = 0; f < num_fields; f++) {
+      const int open_length = (int)strlen(field[f].open);
+
+      if ((source[i] != field[f].open[0]) || (i + open_length > length) ||
+          memcmp(&source[i], field[f].open, open_length)) {
+        continue;
+      }
+      if (!field[f].close) {
+        end = i + open_length;
+      } else if ((end = PAGE_find(source, i + open_length, length, field[f].close)) < 0) {
+        continue;  // Not closed, left as is
+      }
+      matched = f;
+      break;
+    }
+
+    if (matched < 0) {
+      i++;
+      continue;
+    }
+
+    const int keep = field[matched].close ? (int)strlen(field[matched].open) : 0;
+    PAGE_emit(buffer, size, &rendered, &source[copied], i + keep - copied);
+    PAGE_emit(buffer, size, &rendered, field[matched].value, (int)strlen(field[matched].value));
+    copied = i = end;
+  }
+  PAGE_emit(buffer, size, &rendered, &source[copied], length - copied);
+
+  if (buffer) {
+    if (rendered >= size) {
+      if (size > 0) {
+        buffer[0] = '\0';
+      }
+      return -1;
+    }
+    buffer[rendered] = '\0';
+  }
+  return rendered;
+}
+
+/*******************************************************************
+ * Entity tags
+ *******************************************************************/
+uint32_t PAGE_hash(uint32_t hash, const void *data, int length) {
+  const uint8_t *byte = (const uint8_t *)data;
+
+  for (int i = 0; i < length; i++) {
+    hash = (hash ^ byte[i]) * PAGE_FNV_PRIME;
+  }
+  return hash;
+}
+
+void PAGE_etag(uint32_t hash, char etag[PAGE_ETAG_SIZE]) {
+  snprintf(etag, PAGE_ETAG_SIZE, "\"%08x\"", (unsigned)hash);
+}
+
+bool PAGE_etag_match(const char *header, const char *etag) {
+  const int etag_length = (int)strlen(etag);
+
+  while (header && *header) {
+    while ((*header == ' ') || (*header == ',')) {
+      header++;
+    }
+    if (*header == '*') {
+      return true;
+    }
+    if (!strncmp(header, "W/", 2)) {
+      header += 2;  // Weak comparison
+    }
+
+    const char *next = strchr(header, ',');
+    int tag_length = next ? (int)(next - header) : (int)strlen(header);
+    while ((tag_length > 0) && (header[tag_length - 1] == ' ')) {
+      tag_length--;
+    }
+    if ((tag_length == etag_length) && !memcmp(header, etag, etag_length)) {
+      return true;
+    }
+    header = next;
+  }
+  return false;
+}
+
+/*******************************************************************
+ * Media types
+ *******************************************************************/
+static const struct {
+  const char *extension;
+  const char *type;
+} PAGE_TYPES[] = {
+    {"html", "text/html"},
+    {"htm", "text/html"},
+    {"css", "text/css"},
+    {"js", "text/javascript"},
+    {"mjs", "text/javascript"},
+    {"json", "application/json"},
+    {"map", "application/json"},
+    {"txt", "text/plain"},
+    {"cfg", "text/plain"},
+    {"csv", "text/csv"},
+    {"xml", "text/xml"},
+    {"svg", "image/svg+xml"},
+    {"png", "image/png"},
+    {"gif", "image/gif"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"webp", "image/webp"},
+    {"ico", "image/x-icon"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"ttf", "font/ttf"},
+    {"otf", "font/otf"},
+    {"eot", "application/vnd.ms-fontobject"},
+    {"wasm", "application/wasm"},
+    {"pdf", "application/pdf"},
+    {"zip", "application/zip"},
+    {"gz", "application/gzip"},
+    {"bin", "application/octet-stream"},
+};
+
+const char *PAGE_content_type(const char *path) {
+  const char *dot = strrchr(path, '.');
+
+  if (dot && !strchr(dot, '/')) {
+    for (const auto &entry : PAGE_TYPES) {
+      if (!strcasecmp(dot + 1, entry.extension)) {
+        return entry.type;
+      }
+    }
+  }
+  return "application/octet-stream";
+}
@@ -4,7 +4,7 @@
  * Miscellaneous utility functions.
  *
  *******************************************************************/
-#include <Arduino.h>
+#include "EBC_Utils.h"
 
 /*******************************************************************
  * Maps a value from one range to another range.
@@ -0,0 +1,236 @@
+/*******************************************************************
+ * Schedule.cpp
+ *
+ * CAN transmit schedule, cyclic and one-shot frames on one
+ * timeline.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+static bool SCHED_is_due(const SCHED_entry_t *entry, uint32_t now) {
+  return (int32_t)(now - entry->due) >= 0;
+}
+
+static bool SCHED_before(const SCHED_entry_t *a, const SCHED_entry_t *b) {
+  if (a->priority != b->priority) {
+    return a->priority < b->priority;
+  }
+  return (int32_t)(a->due - b->due) < 0;
+}
+
+/*******************************************************************
+ * Free slot, the highest slot in use is tracked to keep the scans
+ * short.
+ *******************************************************************/
+static SCHED_entry_t *SCHED_alloc(SCHED_table_t *table, int *index) {
+  for (int i = 0; i < SCHED_MAX_ENTRIES; i++) {
+    SCHED_entry_t *entry = &table->entry[i];
+
+    if (entry->active) {
+      continue;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->active = true;
+    if (i >= table->num_entries) {
+      table->num_entries = i + 1;
+    }
+    *index = i;
+    return entry;
+  }
+
+  return nullptr;
+}
+
+static void SCHED_free(SCHED_table_t *table, SCHED_entry_t *entry) {
+  entry->active = false;
+
+  while (table->num_entries && !table->entry[table->num_entries - 1].active) {
+    table->num_entries--;
+  }
+}
+
+/*******************************************************************
+ * Release bookkeeping, jitter and deadline of one send.
+ *******************************************************************/
+static void SCHED_release(SCHED_entry_t *entry, uint32_t now) {
+  const uint32_t lateness = now - entry->due;
+
+  if (entry->deadline && (lateness > entry->deadline)) {
+    entry->missed++;
+  }
+
+  if (!entry->period) {
+    return;
+  }
+
+  /* Releases that are already overdue are merged into this one */
+  const uint32_t overdue = lateness / entry->period;
+  entry->missed += overdue;
+  entry->due += (overdue + 1) * entry->period;
+}
+
+static void SCHED_jitter(SCHED_entry_t *entry, uint32_t now) {
+  if (entry->period && entry->sent) {
+    const uint32_t interval = now - entry->last;
+    const uint32_t jitter = (interval > entry->period) ? (interval - entry->period) : (entry->period - interval);
+
+    entry->jitter_last = jitter;
+    entry->jitter_total += jitter;
+    if (jitter > entry->jitter_max) {
+      entry->jitter_max = jitter;
+    }
+  }
+
+  entry->last = now;
+  entry->sent++;
+}
+
+/*******************************************************************
+ * Initialises an empty schedule.
+ *******************************************************************/
+void SCHED_init(SCHED_table_t *table) {
+  memset(table, 0, sizeof(*table));
+}
+
+/*******************************************************************
+ * Adds a cyclic frame.
+ *******************************************************************/
+int SCHED_add(SCHED_table_t *table, const char *name, const CAN_frame_t *frame, uint32_t period,
+              uint32_t phase, uint8_t priority, SCHED_produce_fn produce, void *context, uint32_t now) {
+  SCHED_entry_t *entry;
+  int index;
+
+  if (!period || !(entry = SCHED_alloc(table, &index))) {
+    return -1;
+  }
+
+  entry->name = name;
+  entry->frame = *frame;
+  entry->period = period;
+  entry->deadline = period;
+  entry->priority = priority;
+  entry->produce = produce;
+  entry->context = context;
+  entry->due = now + phase;
+
+  return index;
+}
+
+/*******************************************************************
+ * Adds a one-shot frame, due now.
+ *******************************************************************/
+int SCHED_once(SCHED_table_t *table, const CAN_frame_t *frame, uint8_t priority, uint32_t deadline, uint32_t now) {
+  SCHED_entry_t *entry;
+  int index;
+
+  if (!(entry = SCHED_alloc(table, &index))) {
+    return -1;
+  }
+
+  entry->name = "one-shot";
+  entry->frame = *frame;
+  entry->deadline = deadline;
+  entry->priority = priority;
+  entry->due = now;
+
+  return index;
+}
+
+/*******************************************************************
+ * Takes the most urgent due frame.
+ *******************************************************************/
+int SCHED_next(SCHED_table_t *table, uint32_t now, CAN_frame_t *frame) {
+  while (true) {
+    SCHED_entry_t *best = nullptr;
+    int index = -1;
+    uint32_t backlog = 0;
+
+    for (int i = 0; i < table->num_entries; i++) {
+      SCHED_entry_t *entry = &table->entry[i];
+
+      if (!entry->active || !SCHED_is_due(entry, now)) {
+        continue;
+      }
+
+      backlog++;
+      if (!best || SCHED_before(entry, best)) {
+        best = entry;
+        index = i;
+      }
+    }
+
+    table->backlog = backlog;
+    if (backlog > table->backlog_max) {
+      table->backlog_max = backlog;
+    }
+
+    if (!best) {
+      return -1;
+    }
+
+    SCHED_release(best, now);
+
+    if (best->produce && !best->produce(&best->frame, best->context)) {
+      best->skipped++;
+      if (!best->period) {
+        SCHED_free(table, best);
+      }
+      continue;
+    }
+
+    SCHED_jitter(best, now);
+    *frame = best->frame;
+
+    if (!best->period) {
+      SCHED_free(table, best);
+    }
+    return index;
+  }
+}
+
+/*******************************************************************
+ * Clock units until the next release.
+ *******************************************************************/
+uint32_t SCHED_wait(const SCHED_table_t *table, uint32_t now) {
+  uint32_t wait = SCHED_IDLE;
+
+  for (int i = 0; i < table->num_entries; i++) {
+    const SCHED_entry_t *entry = &table->entry[i];
+
+    if (!entry->active) {
+      continue;
+    }
+    if (SCHED_is_due(entry, now)) {
+      return 0;
+    }
+    if (entry->due - now < wait) {
+      wait = entry->due - now;
+    }
+  }
+
+  return wait;
+}
+
+/*******************************************************************
+ * Clears the statistics of all entries.
+ *******************************************************************/
+void SCHED_reset_stats(SCHED_table_t *table) {
+  table->backlog_max = 0;
+
+  for (int i = 0; i < table->num_entries; i++) {
+    SCHED_entry_t *entry = &table->entry[i];
+
+    entry->sent = 0;
+    entry->missed = 0;
+    entry->skipped = 0;
+    entry->jitter_last = 0;
+    entry->jitter_max = 0;
+    entry->jitter_total = 0;
+  }
+}
@@ -0,0 +1,220 @@
+/*******************************************************************
+ * Slcan.cpp
+ *
+ * SLCAN (LAWICEL CAN232/CANUSB) line reader, command parser and
+ * frame formatter, same command set as the LAWICEL v1.3 code in
+ * lib/CAN_BUS_Shield but without String or a channel of its own.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define SLCAN_TIMESTAMP_MOD 60000  // Standard time stamp wraps every minute
+
+static const uint32_t SLCAN_BITRATES[SLCAN_NUM_BITRATES] = {10000,  20000,  50000,  100000, 125000,
+                                                            250000, 500000, 800000, 1000000};
+
+static const char SLCAN_HEX[] = "0123456789ABCDEF";
+
+/*******************************************************************
+ * Hex helpers
+ *******************************************************************/
+static int SLCAN_nibble(char c) {
+  if ((c >= '0') && (c <= '9'))
+    return c - '0';
+  if ((c >= 'A') && (c <= 'F'))
+    return c - 'A' + 10;
+  if ((c >= 'a') && (c <= 'f'))
+    return c - 'a' + 10;
+  return -1;
+}
+
+static bool SLCAN_hex(const char *text, int digits, uint32_t *value) {
+  *value = 0;
+  for (int i = 0; i < digits; i++) {
+    const int nibble = SLCAN_nibble(text[i]);
+    if (nibble < 0) {
+      return false;
+    }
+    *value = (*value << 4) | (uint32_t)nibble;
+  }
+  return true;
+}
+
+static char *SLCAN_put_hex(char *out, uint32_t value, int digits) {
+  for (int i = digits - 1; i >= 0; i--) {
+    *out++ = SLCAN_HEX[(value >> (4 * i)) & 0x0F];
+  }
+  return out;
+}
+
+/*******************************************************************
+ * Line reader
+ *******************************************************************/
+void SLCAN_reader_init(SLCAN_reader_t *reader) {
+  memset(reader, 0, sizeof(*reader));
+}
+
+bool SLCAN_reader_put(SLCAN_reader_t *reader, char c) {
+  if ((c == '\r') || (c == '\n')) {
+    const bool complete = !reader->overflow && (reader->length > 0);
+
+    reader->line[reader->length] = '\0';
+    reader->length = 0;
+    reader->overflow = false;
+    return complete;
+  }
+
+  if (reader->overflow) {
+    return false;
+  }
+  if (reader->length >= SLCAN_LINE_MAX - 1) {
+    reader->overflow = true;
+    reader->overflows++;
+    reader->length = 0;
+    return false;
+  }
+
+  reader->line[reader->length++] = c;
+  return false;
+}
+
+/*******************************************************************
+ * Command parser
+ *******************************************************************/
+static SLCAN_cmd_t SLCAN_parse_frame(const char *line, CAN_frame_t *frame) {
+  const bool ext = (line[0] == 'T') || (line[0] == 'R');
+  const bool rtr = (line[0] == 'r') || (line[0] == 'R');
+  const int id_digits = ext ? 8 : 3;
+  const size_t length = strlen(line);
+  uint32_t value;
+
+  memset(frame, 0, sizeof(*frame));
+  if ((length < (size_t)id_digits + 2) || !SLCAN_hex(&line[1], id_digits, &value) ||
+      (value > (ext ? DISPATCH_MASK_EXT : DISPATCH_MASK_STD))) {
+    return SLCAN_CMD_INVALID;
+  }
+  frame->id = value;
+  frame->ext = ext ? 1 : 0;
+  frame->rtr = rtr ? 1 : 0;
+
+  if (!SLCAN_hex(&line[1 + id_digits], 1, &value) || (value > 8)) {
+    return SLCAN_CMD_INVALID;
+  }
+  frame->length = (uint8_t)value;
+
+  const char *data = &line[2 + id_digits];
+  if (rtr) {
+    return (*data == '\0') ? SLCAN_CMD_TRANSMIT : SLCAN_CMD_INVALID;
+  }
+  if (strlen(data) != (size_t)frame->length * 2) {
+    return SLCAN_CMD_INVALID;
+  }
+  for (uint8_t i = 0; i < frame->length; i++) {
+    if (!SLCAN_hex(&data[2 * i], 2, &value)) {
+      return SLCAN_CMD_INVALID;
+    }
+    frame->data[i] = (uint8_t)value;
+  }
+  return SLCAN_CMD_TRANSMIT;
+}
+
+static SLCAN_cmd_t SLCAN_parse_switch(const char *line, SLCAN_cmd_t cmd, uint32_t *argument) {
+  if ((line[1] != '0') && (line[1] != '1')) {
+    return SLCAN_CMD_INVALID;
+  }
+  *argument = (uint32_t)(line[1] - '0');
+  return (line[2] == '\0') ? cmd : SLCAN_CMD_INVALID;
+}
+
+SLCAN_cmd_t SLCAN_parse(const char *line, CAN_frame_t *frame, uint32_t *argument) {
+  const bool single = (line[0] != '\0') && (line[1] == '\0');
+
+  *argument = 0;
+  switch (line[0]) {
+    case 't':
+    case 'T':
+    case 'r':
+    case 'R':
+      return SLCAN_parse_frame(line, frame);
+
+    case 'S':
+      if ((line[1] < '0') || (line[1] >= '0' + SLCAN_NUM_BITRATES) || (line[2] != '\0')) {
+        return SLCAN_CMD_INVALID;
+      }
+      *argument = SLCAN_BITRATES[line[1] - '0'];
+      return SLCAN_CMD_SETUP;
+
+    case 'O':
+      return single ? SLCAN_CMD_OPEN : SLCAN_CMD_INVALID;
+    case 'L':
+      return single ? SLCAN_CMD_LISTEN : SLCAN_CMD_INVALID;
+    case 'C':
+      return single ? SLCAN_CMD_CLOSE : SLCAN_CMD_INVALID;
+    case 'F':
+      return single ? SLCAN_CMD_FLAGS : SLCAN_CMD_INVALID;
+    case 'P':
+    case 'A':
+      return single ? SLCAN_CMD_POLL : SLCAN_CMD_INVALID;
+    case 'V':
+    case 'v':
+      return single ? SLCAN_CMD_VERSION : SLCAN_CMD_INVALID;
+    case 'N':
+      return single ? SLCAN_CMD_SERIAL : SLCAN_CMD_INVALID;
+
+    case 'Z':
+      return SLCAN_parse_switch(line, SLCAN_CMD_TIMESTAMP, argument);
+    case 'X':
+      return SLCAN_parse_switch(line, SLCAN_CMD_AUTOPOLL, argument);
+
+    case 's':
+    case 'M':
+    case 'm':
+    case 'W':
+    case 'U':
+    case 'Q':
+      return SLCAN_CMD_IGNORED;
+
+    default:
+      return SLCAN_CMD_INVALID;
+  }
+}
+
+/*******************************************************************
+ * Frame formatter
+ *******************************************************************/
+int SLCAN_format(const CAN_frame_t *frame, bool timestamp, uint32_t time_ms, char *out, int size) {
+  const uint8_t length = (frame->length > 8) ? 8 : frame->length;
+  const int needed = 1 + (frame->ext ? 8 : 3) + 1 + (frame->rtr ? 0 : 2 * length) + (timestamp ? 4 : 0) + 1;
+  char *p = out;
+
+  if (needed + 1 > size) {
+    return 0;
+  }
+
+  if (frame->ext) {
+    *p++ = frame->rtr ? 'R' : 'T';
+    p = SLCAN_put_hex(p, frame->id & DISPATCH_MASK_EXT, 8);
+  } else {
+    *p++ = frame->rtr ? 'r' : 't';
+    p = SLCAN_put_hex(p, frame->id & DISPATCH_MASK_STD, 3);
+  }
+  *p++ = SLCAN_HEX[length];
+
+  if (!frame->rtr) {
+    for (uint8_t i = 0; i < length; i++) {
+      p = SLCAN_put_hex(p, frame->data[i], 2);
+    }
+  }
+  if (timestamp) {
+    p = SLCAN_put_hex(p, time_ms % SLCAN_TIMESTAMP_MOD, 4);
+  }
+  *p++ = SLCAN_OK;
+  *p = '\0';
+
+  return (int)(p - out);
+}
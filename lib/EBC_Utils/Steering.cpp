@@ -0,0 +1,73 @@
+/*******************************************************************
+ * Steering.cpp
+ *
+ * Steering wheel and azimuth linearisation.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define STEERING_DAC_MIN 0
+#define STEERING_DAC_MAX 4095
+
+/*******************************************************************
+ * Integer map, same rounding as Arduino map() (ESP32 core).
+ *******************************************************************/
+static long STEERING_map(long x, long in_min, long in_max, long out_min, long out_max) {
+  const long run = in_max - in_min;
+
+  if (run == 0) {
+    return -1;  // Like Arduino map()
+  }
+  return ((x - in_min) * (out_max - out_min)) / run + out_min;
+}
+
+static long STEERING_constrain(long value, long low, long high) {
+  return (value < low) ? low : ((value > high) ? high : value);
+}
+
+/*******************************************************************
+ * Linearises a steering wheel ADC value (double linearisation).
+ *******************************************************************/
+long STEERING_wheel_linear(const STEERING_wheel_cal_t *cal, long value) {
+  if (((cal->left < cal->middle) && (cal->middle < cal->right)) ||
+      ((cal->left > cal->middle) && (cal->middle > cal->right))) {
+    if (value < cal->middle) {
+      value = (int)STEERING_map(value, cal->left, cal->middle, LINEAR_MIN, LINEAR_MIDDLE - 1);
+    } else {
+      value = (int)STEERING_map(value, cal->middle, cal->right, LINEAR_MIDDLE, LINEAR_MAX);
+    }
+  }
+
+  return STEERING_constrain(value, LINEAR_MIN, LINEAR_MAX);
+}
+
+/*******************************************************************
+ * Maps a linear steering value to the azimuth DAC output.
+ *******************************************************************/
+long STEERING_azimuth_output(const STEERING_azimuth_cal_t *cal, long value) {
+  if (((cal->low < cal->middle) && (cal->middle < cal->high)) ||
+      ((cal->low > cal->middle) && (cal->middle > cal->high))) {
+    if (value < LINEAR_MIDDLE) {
+      value = STEERING_map(value, LINEAR_MIN, LINEAR_MIDDLE, cal->low, cal->middle);
+    } else {
+      value = STEERING_map(value, LINEAR_MIDDLE, LINEAR_MAX, cal->middle, cal->high);
+    }
+  }
+
+  return STEERING_constrain(value, STEERING_DAC_MIN, STEERING_DAC_MAX);
+}
+
+/*******************************************************************
+ * Builds the steering wheel ADC to azimuth DAC lookup table.
+ *******************************************************************/
+void STEERING_lut_build(STEERING_lut_t *lut, const STEERING_wheel_cal_t *wheel, const STEERING_azimuth_cal_t *azimuth) {
+  for (long adc = 0; adc < STEERING_LUT_SIZE; adc++) {
+    long linear = STEERING_wheel_linear(wheel, adc);
+
+    lut->linear[adc] = (uint16_t)linear;
+    lut->dac[adc] = (uint16_t)STEERING_azimuth_output(azimuth, linear);
+  }
+}
@@ -0,0 +1,180 @@
+/*******************************************************************
+ * Telemetry.cpp
+ *
+ * Websocket telemetry cache, change detection per key and coalesced
+ * frames of the changed pairs.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define TELEM_FNV_OFFSET 2166136261u
+#define TELEM_FNV_PRIME 16777619u
+
+static uint32_t TELEM_hash(const char *key) {
+  uint32_t hash = TELEM_FNV_OFFSET;
+
+  while (*key) {
+    hash = (hash ^ (uint8_t)*key++) * TELEM_FNV_PRIME;
+  }
+  return hash ? hash : 1;  // 0 marks a free slot
+}
+
+/*******************************************************************
+ * Slot of a key, or the free slot where it goes. nullptr when the
+ * key is not found and the cache is full.
+ *******************************************************************/
+static TELEM_slot_t *TELEM_find(const TELEM_cache_t *cache, const char *key, uint32_t hash) {
+  uint16_t index = hash % TELEM_MAX_SLOTS;
+
+  for (int probe = 0; probe < TELEM_MAX_SLOTS; probe++) {
+    TELEM_slot_t *slot = (TELEM_slot_t *)&cache->slot[index];
+
+    if (!slot->hash || ((slot->hash == hash) && !strcmp(slot->key, key))) {
+      return slot;
+    }
+    index = (index + 1) % TELEM_MAX_SLOTS;
+  }
+  return nullptr;
+}
+
+/*******************************************************************
+ * Cache
+ *******************************************************************/
+void TELEM_init(TELEM_cache_t *cache) {
+  memset(cache, 0, sizeof(*cache));
+}
+
+int TELEM_set(TELEM_cache_t *cache, const char *key, const char *value, bool force) {
+  const uint32_t hash = TELEM_hash(key);
+
+  if ((strlen(key) >= TELEM_KEY_MAX) || (strlen(value) >= TELEM_VALUE_MAX)) {
+    cache->rejected++;
+    return -1;
+  }
+
+  TELEM_slot_t *slot = TELEM_find(cache, key, hash);
+  if (!slot) {
+    cache->rejected++;
+    return -1;
+  }
+
+  if (!slot->hash) {
+    slot->hash = hash;
+    strcpy(slot->key, key);
+    cache->num_keys++;
+  } else if (!strcmp(slot->value, value)) {
+    if (!force) {
+      cache->unchanged++;
+      return slot->dirty ? 1 : 0;
+    }
+  } else {
+    cache->changed++;
+  }
+
+  strcpy(slot->value, value);
+  if (!slot->dirty) {
+    slot->dirty = true;
+    cache->num_dirty++;
+  }
+  return 1;
+}
+
+const char *TELEM_get(const TELEM_cache_t *cache, const char *key) {
+  const TELEM_slot_t *slot = TELEM_find(cache, key, TELEM_hash(key));
+
+  return (slot && slot->hash) ? slot->value : nullptr;
+}
+
+void TELEM_touch_all(TELEM_cache_t *cache) {
+  for (int i = 0; i < TELEM_MAX_SLOTS; i++) {
+    cache->slot[i].dirty = (cache->slot[i].hash != 0);
+  }
+  cache->num_dirty = cache->num_keys;
+}
+
+/*******************************************************************
+ * Frames
+ *******************************************************************/
+int TELEM_frame(TELEM_cache_t *cache, char *buffer, int size, bool all, uint16_t *cursor) {
+  int length = 1;
+
+  if (size < TELEM_FRAME_MIN) {
+    return 0;
+  }
+
+  buffer[0] = '{';
+  for (; *cursor < TELEM_MAX_SLOTS; (*cursor)++) {
+    TELEM_slot_t *slot = &cache->slot[*cursor];
+
+    if (!slot->hash || (!all && !slot->dirty)) {
+      continue;
+    }
+
+    const int key_length = (int)strlen(slot->key);
+    const int value_length = (int)strlen(slot->value);
+    const int pair = key_length + value_length + 3 + ((length > 1) ? 1 : 0);  // "": and the comma
+    if (length + pair + 2 > size) {
+      break;  // Closing brace and terminator, next frame
+    }
+
+    if (length > 1) {
+      buffer[length++] = ',';
+    }
+    buffer[length++] = '"';
+    memcpy(&buffer[length], slot->key, key_length);
+    length += key_length;
+    buffer[length++] = '"';
+    buffer[length++] = ':';
+    memcpy(&buffer[length], slot->value, value_length);
+    length += value_length;
+
+    if (slot->dirty) {
+      slot->dirty = false;
+      cache->num_dirty--;
+    }
+  }
+
+  if (length == 1) {
+    buffer[0] = '\0';
+    return 0;
+  }
+  buffer[length++] = '}';
+  buffer[length] = '\0';
+  return length;
+}
+
+/*******************************************************************
+ * Statistics
+ *******************************************************************/
+void TELEM_stats_init(TELEM_stats_t *stats, uint32_t window, uint32_t now) {
+  memset(stats, 0, sizeof(*stats));
+  stats->window = window;
+  stats->start = now;
+}
+
+void TELEM_stats_tick(TELEM_stats_t *stats, uint32_t frames, uint32_t bytes, uint32_t pairs, uint32_t serialize,
+                      uint32_t now) {
+  stats->ticks++;
+  stats->frames += frames;
+  stats->bytes += bytes;
+  stats->pairs += pairs;
+  stats->frames_last = frames;
+  stats->pairs_last = pairs;
+  stats->serialize_last = serialize;
+  if (serialize > stats->serialize_max) {
+    stats->serialize_max = serialize;
+  }
+
+  stats->window_bytes += bytes;
+  const uint32_t elapsed = now - stats->start;
+  if (elapsed >= stats->window) {
+    stats->byte_rate = (uint32_t)((uint64_t)stats->window_bytes * 1000000 / elapsed);
+    stats->window_bytes = 0;
+    stats->start = now;
+  }
+}
@@ -0,0 +1,310 @@
+/*******************************************************************
+ * Uds.cpp
+ *
+ * UDS (ISO 14229) diagnostic server on top of ISO-TP: session
+ * control, tester present, read/write data by identifier and
+ * routine control.
+ *
+ *******************************************************************/
+#include "EBC_Utils.h"
+
+#include <string.h>
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define UDS_DID_HEADER 3      // SID, DID high, DID low
+#define UDS_ROUTINE_HEADER 4  // SID, control, RID high, RID low
+#define UDS_P2_MS 50          // Response times reported by session control
+#define UDS_P2_STAR_MS 5000
+
+/*******************************************************************
+ * Tables
+ *******************************************************************/
+static const UDS_did_t *UDS_find_did(const UDS_server_t *server, uint16_t did) {
+  for (uint8_t i = 0; i < server->num_dids; i++) {
+    if (server->did[i].did == did) {
+      return &server->did[i];
+    }
+  }
+  return nullptr;
+}
+
+static const UDS_routine_t *UDS_find_routine(const UDS_server_t *server, uint16_t rid) {
+  for (uint8_t i = 0; i < server->num_routines; i++) {
+    if (server->routine[i].rid == rid) {
+      return &server->routine[i];
+    }
+  }
+  return nullptr;
+}
+
+/*******************************************************************
+ * Server
+ *******************************************************************/
+void UDS_init(UDS_server_t *server, const UDS_did_t *did, uint8_t num_dids, const UDS_routine_t *routine,
+              uint8_t num_routines, uint32_t s3) {
+  memset(server, 0, sizeof(*server));
+  server->did = did;
+  server->num_dids = num_dids;
+  server->routine = routine;
+  server->num_routines = num_routines;
+  server->session = UDS_SESSION_DEFAULT;
+  server->s3 = s3;
+}
+
+/*******************************************************************
+ * Request, the header is kept and DID data goes to the DID
+ *******************************************************************/
+static void UDS_write_target(UDS_server_t *server) {
+  const uint16_t did = ((uint16_t)server->header[1] << 8) | server->header[2];
+  const UDS_did_t *target = UDS_find_did(server, did);
+
+  if (!target || !target->write) {
+    server->nrc = UDS_NRC_OUT_OF_RANGE;
+  } else if (server->session != UDS_SESSION_EXTENDED) {
+    server->nrc = UDS_NRC_NOT_IN_SESSION;
+  } else if (server->total != UDS_DID_HEADER + target->length) {
+    server->nrc = UDS_NRC_INCORRECT_LENGTH;
+  } else {
+    server->target = target;
+  }
+}
+
+bool UDS_request_data(uint16_t offset, const uint8_t *data, uint8_t length, uint16_t total, void *context) {
+  UDS_server_t *server = (UDS_server_t *)context;
+
+  if (server->responding) {
+    server->busy++;
+    return false;
+  }
+
+  if (offset == 0) {
+    memset(server->header, 0, sizeof(server->header));
+    server->total = total;
+    server->target = nullptr;
+    server->nrc = 0;
+  }
+
+  for (uint8_t i = 0; i < length; i++) {
+    if (offset + i < UDS_HEADER_MAX) {
+      server->header[offset + i] = data[i];
+    }
+  }
+
+  if (server->header[0] != UDS_SID_WRITE_DID) {
+    return true;
+  }
+
+  /* The first frame carries the complete header */
+  if ((offset == 0) && (length >= UDS_DID_HEADER)) {
+    UDS_write_target(server);
+  }
+
+  const uint16_t start = (offset > UDS_DID_HEADER) ? offset : UDS_DID_HEADER;
+  const uint16_t end = offset + length;
+  if (server->target && !server->nrc && (start < end)) {
+    server->target->write(start - UDS_DID_HEADER, &data[start - offset], end - start, server->target->context);
+  }
+  return true;
+}
+
+/*******************************************************************
+ * Services, fill the response and return its length
+ *******************************************************************/
+static uint16_t UDS_session_control(UDS_server_t *server) {
+  const uint8_t session = server->header[1] & ~UDS_SUPPRESS_RESPONSE;
+
+  if (server->total != 2) {
+    server->nrc = UDS_NRC_INCORRECT_LENGTH;
+    return 0;
+  }
+  if ((session != UDS_SESSION_DEFAULT) && (session != UDS_SESSION_EXTENDED)) {
+    server->nrc = UDS_NRC_SUBFUNCTION_NOT_SUPPORTED;
+    return 0;
+  }
+
+  server->session = session;
+  if (server->header[1] & UDS_SUPPRESS_RESPONSE) {
+    return 0;
+  }
+
+  server->response[1] = session;
+  server->response[2] = UDS_P2_MS >> 8;
+  server->response[3] = UDS_P2_MS & 0xFF;
+  server->response[4] = (UDS_P2_STAR_MS / 10) >> 8;
+  server->response[5] = (UDS_P2_STAR_MS / 10) & 0xFF;
+  return 6;
+}
+
+static uint16_t UDS_tester_present(UDS_server_t *server) {
+  if (server->total != 2) {
+    server->nrc = UDS_NRC_INCORRECT_LENGTH;
+    return 0;
+  }
+  if (server->header[1] & ~UDS_SUPPRESS_RESPONSE) {
+    server->nrc = UDS_NRC_SUBFUNCTION_NOT_SUPPORTED;
+    return 0;
+  }
+  if (server->header[1] & UDS_SUPPRESS_RESPONSE) {
+    return 0;
+  }
+
+  server->response[1] = 0;
+  return 2;
+}
+
+static uint16_t UDS_read_did(UDS_server_t *server) {
+  const uint16_t did = ((uint16_t)server->header[1] << 8) | server->header[2];
+  const UDS_did_t *entry = UDS_find_did(server, did);
+
+  if (server->total != UDS_DID_HEADER) {
+    server->nrc = UDS_NRC_INCORRECT_LENGTH;  // One DID per request
+    return 0;
+  }
+  if (!entry) {
+    server->nrc = UDS_NRC_OUT_OF_RANGE;
+    return 0;
+  }
+
+  server->response[1] = server->header[1];
+  server->response[2] = server->header[2];
+  server->response_did = entry;
+  return UDS_DID_HEADER + entry->length;
+}
+
+static uint16_t UDS_write_did(UDS_server_t *server) {
+  if (server->total < UDS_DID_HEADER) {
+    server->nrc = UDS_NRC_INCORRECT_LENGTH;
+    return 0;
+  }
+  if (server->nrc) {
+    return 0;  // Found while receiving
+  }
+  if (!server->target) {
+    server->nrc = UDS_NRC_OUT_OF_RANGE;
+    return 0;
+  }
+  if (server->target->commit) {
+    server->nrc = server->target->commit(server->target->context);
+    if (server->nrc) {
+      return 0;
+    }
+  }
+
+  server->response[1] = server->header[1];
+  server->response[2] = server->header[2];
+  return UDS_DID_HEADER;
+}
+
+static uint16_t UDS_routine_control(UDS_server_t *server) {
+  const uint8_t control = server->header[1] & ~UDS_SUPPRESS_RESPONSE;
+  const uint16_t rid = ((uint16_t)server->header[2] << 8) | server->header[3];
+  uint8_t length = UDS_RESPONSE_MAX - UDS_ROUTINE_HEADER;
+
+  if (server->total < UDS_ROUTINE_HEADER) {
+    server->nrc = UDS_NRC_INCORRECT_LENGTH;
+    return 0;
+  }
+  if (server->session != UDS_SESSION_EXTENDED) {
+    server->nrc = UDS_NRC_NOT_IN_SESSION;
+    return 0;
+  }
+  if ((control < UDS_ROUTINE_START) || (control > UDS_ROUTINE_RESULTS)) {
+    server->nrc = UDS_NRC_SUBFUNCTION_NOT_SUPPORTED;
+    return 0;
+  }
+
+  const UDS_routine_t *routine = UDS_find_routine(server, rid);
+  if (!routine) {
+    server->nrc = UDS_NRC_OUT_OF_RANGE;
+    return 0;
+  }
+
+  server->nrc = routine->control(control, &server->response[UDS_ROUTINE_HEADER], &length, routine->context);
+  if (server->nrc) {
+    return 0;
+  }
+
+  server->response[1] = control;
+  server->response[2] = server->header[2];
+  server->response[3] = server->header[3];
+  return UDS_ROUTINE_HEADER + length;
+}
+
+uint16_t UDS_request_done(UDS_server_t *server, uint32_t now) {
+  const uint8_t sid = server->header[0];
+  uint16_t length;
+
+  server->requests++;
+  server->last_request = now;
+  server->response_did = nullptr;
+
+  switch (sid) {
+    case UDS_SID_SESSION_CONTROL:
+      length = UDS_session_control(server);
+      break;
+    case UDS_SID_TESTER_PRESENT:
+      length = UDS_tester_present(server);
+      break;
+    case UDS_SID_READ_DID:
+      length = UDS_read_did(server);
+      break;
+    case UDS_SID_WRITE_DID:
+      length = UDS_write_did(server);
+      break;
+    case UDS_SID_ROUTINE_CONTROL:
+      length = UDS_routine_control(server);
+      break;
+    default:
+      server->nrc = UDS_NRC_SERVICE_NOT_SUPPORTED;
+      length = 0;
+      break;
+  }
+
+  if (server->nrc) {
+    server->negative++;
+    server->response[0] = UDS_NEGATIVE_RESPONSE;
+    server->response[1] = sid;
+    server->response[2] = server->nrc;
+    server->response_header = 3;
+    server->response_did = nullptr;
+    server->responding = true;
+    return 3;
+  }
+  if (!length) {
+    return 0;  // Suppressed
+  }
+
+  server->response[0] = sid + UDS_POSITIVE_OFFSET;
+  server->response_header = server->response_did ? UDS_DID_HEADER : (uint8_t)length;
+  server->responding = true;
+  return length;
+}
+
+/*******************************************************************
+ * Response, the header from the server and the data from the DID
+ *******************************************************************/
+void UDS_response_data(uint16_t offset, uint8_t *data, uint8_t length, void *context) {
+  UDS_server_t *server = (UDS_server_t *)context;
+  uint8_t i = 0;
+
+  for (; (i < length) && (offset + i < server->response_header); i++) {
+    data[i] = server->response[offset + i];
+  }
+  if ((i < length) && server->response_did) {
+    server->response_did->read(offset + i - server->response_header, &data[i], length - i,
+                               server->response_did->context);
+  }
+}
+
+void UDS_response_done(UDS_server_t *server) {
+  server->responding = false;
+  server->response_did = nullptr;
+}
+
+void UDS_poll(UDS_server_t *server, uint32_t now) {
+  if ((server->session != UDS_SESSION_DEFAULT) && ((now - server->last_request) >= server->s3)) {
+    server->session = UDS_SESSION_DEFAULT;
+  }
+}
@@ -3,8 +3,10 @@
 
 #if defined(ARDUINO) && ARDUINO >= 100
 	#include "arduino.h"
-#else
+#elif defined(ARDUINO)
 	#include "WProgram.h"
+#else
+	#include <stdint.h>
 #endif
 
 class StateMachine
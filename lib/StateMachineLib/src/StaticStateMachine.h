@@ -0,0 +1,129 @@
+#ifndef _StaticStateMachine_h
+#define _StaticStateMachine_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Table driven variant of StateMachine.
+ *
+ * The transition table is compiled at build time: it is stable sorted on
+ * input state (declaration order stays the priority within a state) and a
+ * span per state is stored, so Update() only visits the transitions of the
+ * current state. No heap is used, the machine lives in static storage.
+ *
+ *   static constexpr StaticTransition transitions[] = {
+ *       {STATE_A, STATE_B, fnAToB},
+ *       ...
+ *   };
+ *   static constexpr auto table = StaticStateMachineCompile<NUM_STATES>(transitions);
+ *   static StaticStateMachine<NUM_STATES, table.numTransitions> machine(table);
+ */
+
+typedef bool(*StaticStateCondition)();
+typedef void(*StaticStateAction)();
+
+struct StaticTransition
+{
+	uint8_t InputState;
+	uint8_t OutputState;
+	StaticStateCondition Condition;
+};
+
+template <uint8_t NumStates, size_t NumTransitions>
+struct StaticStateMachineTable
+{
+	static constexpr size_t numTransitions = NumTransitions;
+
+	StaticTransition Transitions[NumTransitions];
+	uint8_t First[NumStates + 1];	// Transitions of state s: [First[s], First[s + 1])
+	bool Valid;						// All input and output states < NumStates
+};
+
+template <uint8_t NumStates, size_t NumTransitions>
+constexpr StaticStateMachineTable<NumStates, NumTransitions> StaticStateMachineCompile(const StaticTransition (&transitions)[NumTransitions])
+{
+	static_assert(NumTransitions < 256, "Transition index is 8 bit");
+
+	StaticStateMachineTable<NumStates, NumTransitions> table{};
+	table.Valid = true;
+
+	// Stable insertion sort on input state
+	for (size_t i = 0; i < NumTransitions; i++)
+	{
+		StaticTransition transition = transitions[i];
+		if (transition.InputState >= NumStates || transition.OutputState >= NumStates) table.Valid = false;
+
+		size_t j = i;
+		while (j > 0 && table.Transitions[j - 1].InputState > transition.InputState)
+		{
+			table.Transitions[j] = table.Transitions[j - 1];
+			j--;
+		}
+		table.Transitions[j] = transition;
+	}
+
+	// Span offsets per state
+	size_t index = 0;
+	for (size_t state = 0; state <= NumStates; state++)
+	{
+		while (index < NumTransitions && table.Transitions[index].InputState < state) index++;
+		table.First[state] = (uint8_t)index;
+	}
+
+	return table;
+}
+
+template <uint8_t NumStates, size_t NumTransitions>
+class StaticStateMachine
+{
+public:
+	typedef StaticStateMachineTable<NumStates, NumTransitions> Table;
+
+	constexpr StaticStateMachine(const Table &table) : _table(table), _states{}, _currentStateIndex(0) {}
+
+	void SetOnEntering(uint8_t state, StaticStateAction action) { _states[state].OnEntering = action; }
+	void SetOnLeaving(uint8_t state, StaticStateAction action) { _states[state].OnLeaving = action; }
+
+	void ClearOnEntering(uint8_t state) { _states[state].OnEntering = nullptr; }
+	void ClearOnLeaving(uint8_t state) { _states[state].OnLeaving = nullptr; }
+
+	void SetState(uint8_t state, bool launchLeaving, bool launchEntering)
+	{
+		if (launchLeaving && _states[_currentStateIndex].OnLeaving != nullptr) _states[_currentStateIndex].OnLeaving();
+		if (launchEntering && _states[state].OnEntering != nullptr) _states[state].OnEntering();
+
+		_currentStateIndex = state;
+	}
+
+	uint8_t GetState() const { return _currentStateIndex; }
+
+	bool Update()
+	{
+		const uint8_t last = _table.First[_currentStateIndex + 1];
+
+		for (uint8_t transitionIndex = _table.First[_currentStateIndex]; transitionIndex < last; transitionIndex++)
+		{
+			const StaticTransition &transition = _table.Transitions[transitionIndex];
+
+			if (transition.Condition != nullptr && transition.Condition())
+			{
+				SetState(transition.OutputState, true, true);
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	struct State
+	{
+		StaticStateAction OnEntering;
+		StaticStateAction OnLeaving;
+	};
+
+	const Table &_table;
+	State _states[NumStates];
+	uint8_t _currentStateIndex;
+};
+#endif
@@ -0,0 +1,47 @@
+# gzip_web.py
+#
+# PlatformIO pre script: gzips the text assets of data/web next to
+# their source before the LittleFS image is built, the webserver
+# prefers the .gz variant. Only stale files are compressed again.
+#
+import gzip
+import os
+
+Import("env")  # noqa: F821
+
+WEB_FOLDER = "web"
+EXTENSIONS = (".html", ".htm", ".css", ".js", ".json", ".svg", ".txt", ".xml")
+SKIP = ("_old.html",)
+TEMPLATES = (os.path.join(WEB_FOLDER, "index.html"),)  # Rendered by the webserver
+FS_TARGETS = ("buildfs", "uploadfs", "uploadfsota")
+
+
+def gzip_file(path):
+    target = path + ".gz"
+    if os.path.exists(target) and os.path.getmtime(target) >= os.path.getmtime(path):
+        return False
+
+    with open(path, "rb") as source:
+        data = source.read()
+    with open(target, "wb") as output:
+        # No name or time in the header, same input same image
+        with gzip.GzipFile(filename="", mode="wb", fileobj=output, compresslevel=9, mtime=0) as compressed:
+            compressed.write(data)
+    print("gzip_web: %s %d -> %d bytes" % (os.path.relpath(path), len(data), os.path.getsize(target)))
+    return True
+
+
+def gzip_web(data_dir):
+    for root, _, files in os.walk(os.path.join(data_dir, WEB_FOLDER)):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            if name.endswith(".gz"):
+                if not os.path.exists(path[:-3]):
+                    os.remove(path)  # Source removed
+            elif name.endswith(EXTENSIONS) and not name.endswith(SKIP):
+                if os.path.relpath(path, data_dir) not in TEMPLATES:
+                    gzip_file(path)
+
+
+if any(target in FS_TARGETS for target in COMMAND_LINE_TARGETS):  # noqa: F821
+    gzip_web(env.subst("$PROJECT_DATA_DIR"))  # noqa: F821
@@ -0,0 +1,364 @@
+/*******************************************************************
+ * Analog.cpp
+ *
+ * EBC analog inputs, continuous (DMA) ADC acquisition.
+ *
+ * The ADC1 digital controller converts the steering wheel and the
+ * throttle channel in turn at ANALOG_SAMPLE_FREQ_HZ. The driver DMA
+ * fills its ring buffer without CPU load; the analog task wakes
+ * once per DMA frame, oversamples (ANALOG_OVERSAMPLE conversions
+ * per channel are summed) and publishes the decimated value in
+ * counts and eFuse calibrated millivolts.
+ *
+ *******************************************************************/
+#include "Analog.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <esp_err.h>
+
+#include "CLI.h"
+#include "Config.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#undef DEBUG_ANALOG
+
+#define ANALOG_SAMPLE_FREQ_HZ 20000  // All channels, ESP32 minimum is 20kHz
+#define ANALOG_OVERSAMPLE 32         // Conversions per decimated value (per channel)
+#define ANALOG_FRAME_BYTES 256       // DMA frame, 128 conversions
+#define ANALOG_BUFFER_BYTES 1024     // Driver ring buffer
+#define ANALOG_VREF_DEFAULT 1100     // mV, only used without eFuse calibration
+
+#define ANALOG_ATTEN ADC_ATTEN_DB_11
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+typedef struct {
+  uint32_t frames;      // DMA frames read
+  uint32_t conversions; // Conversions of the analog inputs
+  uint32_t overflows;   // Ring buffer full, data lost
+  uint32_t invalid;     // Conversions of an unknown channel
+} analog_stats_t;
+
+typedef struct {
+  int pin;
+  adc1_channel_t channel;
+  uint32_t sum;  // Oversampling accumulator
+  int count;
+  volatile int raw;
+  volatile int mv;
+  volatile uint32_t sequence;
+} analog_channel_t;
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static analog_channel_t analog_channels[ANALOG_NUM_INPUTS] = {
+    /* ANALOG_STEERWHEEL */ {STEER_WHEEL_ANALOG_CHANNEL},
+    /* ANALOG_THROTTLE */ {THOTTLE_ANALOG_CHANNEL},
+};
+
+static const char *analog_names[ANALOG_NUM_INPUTS] = {"steering wheel", "throttle"};
+
+static esp_adc_cal_characteristics_t analog_chars;
+static esp_adc_cal_value_t analog_cal_type;
+
+static analog_stats_t analog_stats;
+static bool analog_started = false;  // DMA acquisition started, no single reads anymore
+static volatile bool analog_running = false;  // All inputs have decimated values
+
+/*******************************************************************
+ * Read
+ *******************************************************************/
+int ANALOG_get_raw(analog_input_t input) {
+  if (!analog_started) {
+    return analogRead(analog_channels[input].pin);
+  }
+  return analog_channels[input].raw;
+}
+
+int ANALOG_get_mv(analog_input_t input) {
+  if (!analog_started) {
+    return esp_adc_cal_raw_to_voltage(ANALOG_get_raw(input), &analog_chars);
+  }
+  return analog_channels[input].mv;
+}
+
+bool ANALOG_continuous(void) {
+  return analog_running;
+}
+
+bool ANALOG_ready(analog_input_t input) {
+  return !analog_started || (analog_channels[input].sequence != 0);
+}
+
+uint32_t ANALOG_get_sequence(analog_input_t input) {
+  return analog_channels[input].sequence;
+}
+
+/*******************************************************************
+ * Oversampling and decimation
+ *******************************************************************/
+static void ANALOG_sample(int channel, int value) {
+  for (int input = 0; input < ANALOG_NUM_INPUTS; input++) {
+    analog_channel_t *ch = &analog_channels[input];
+
+    if (ch->channel != channel) {
+      continue;
+    }
+
+    analog_stats.conversions++;
+
+    ch->sum += value;
+    if (++ch->count >= ANALOG_OVERSAMPLE) {
+      int raw = (ch->sum + ANALOG_OVERSAMPLE / 2) / ANALOG_OVERSAMPLE;
+
+      ch->raw = raw;
+      ch->mv = esp_adc_cal_raw_to_voltage(raw, &analog_chars);
+      ch->sequence++;
+
+      ch->sum = 0;
+      ch->count = 0;
+    }
+    return;
+  }
+
+  analog_stats.invalid++;
+}
+
+/*******************************************************************
+ * Analog task, wakes when the DMA completed a frame
+ *******************************************************************/
+static void ANALOG_task(void *parameter) {
+  (void)parameter;
+  static uint8_t frame[ANALOG_FRAME_BYTES];
+  uint32_t length;
+
+  while (true) {
+    esp_err_t err = adc_digi_read_bytes(frame, sizeof(frame), &length, ADC_MAX_DELAY);
+
+    if (err == ESP_ERR_INVALID_STATE) {
+      analog_stats.overflows++;  // Data is still valid, older frames were dropped
+    } else if (err != ESP_OK) {
+      continue;
+    }
+
+    analog_stats.frames++;
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      adc_digi_output_data_t *p = (adc_digi_output_data_t *)&frame[i];
+      ANALOG_sample(p->type1.channel, p->type1.data);
+    }
+
+    if (!analog_running) {
+      bool ready = true;
+      for (int input = 0; input < ANALOG_NUM_INPUTS; input++) {
+        ready = ready && analog_channels[input].sequence;
+      }
+      analog_running = ready;  // Late first values after a start timeout
+    }
+  }
+}
+
+/********************************************************************
+ * Create JSON data
+ *******************************************************************/
+static JsonDocument ANALOG_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  doc[JSON_ANALOG_STEERWHEEL_COUNTS] = ANALOG_get_raw(ANALOG_STEERWHEEL);
+  doc[JSON_ANALOG_STEERWHEEL_MV] = ANALOG_get_mv(ANALOG_STEERWHEEL);
+  doc[JSON_ANALOG_THROTTLE_COUNTS] = ANALOG_get_raw(ANALOG_THROTTLE);
+  doc[JSON_ANALOG_THROTTLE_MV] = ANALOG_get_mv(ANALOG_THROTTLE);
+
+  doc["continuous"] = analog_running;
+  doc["sample_rate_hz"] = ANALOG_SAMPLE_FREQ_HZ;
+  doc["oversample"] = ANALOG_OVERSAMPLE;
+  doc["output_rate_hz"] = ANALOG_SAMPLE_FREQ_HZ / ANALOG_NUM_INPUTS / ANALOG_OVERSAMPLE;
+  doc["frames"] = analog_stats.frames;
+  doc["conversions"] = analog_stats.conversions;
+  doc["overflows"] = analog_stats.overflows;
+  doc["invalid"] = analog_stats.invalid;
+
+  return doc;
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String ANALOG_info_str(void) {
+  static const char *cal_names[] = {"eFuse Vref", "eFuse two point", "default Vref"};
+
+  String text = "--- Analog inputs ---";
+
+  for (int input = 0; input < ANALOG_NUM_INPUTS; input++) {
+    text.concat("\r\n");
+    text.concat(analog_names[input]);
+    text.concat(": ");
+    text.concat(ANALOG_get_raw((analog_input_t)input));
+    text.concat(" counts, ");
+    text.concat(ANALOG_get_mv((analog_input_t)input));
+    text.concat("mV");
+  }
+
+  text.concat("\r\nMode: ");
+  text.concat(analog_running ? "continuous (DMA)" : analog_started ? "continuous (DMA), no data" : "single read");
+  text.concat(", calibration: ");
+  text.concat(cal_names[analog_cal_type]);
+
+  text.concat("\r\nSample rate: ");
+  text.concat(ANALOG_SAMPLE_FREQ_HZ);
+  text.concat("Hz, oversample: ");
+  text.concat(ANALOG_OVERSAMPLE);
+  text.concat(", output rate: ");
+  text.concat(ANALOG_SAMPLE_FREQ_HZ / ANALOG_NUM_INPUTS / ANALOG_OVERSAMPLE);
+  text.concat("Hz per input");
+
+  text.concat("\r\nFrames: ");
+  text.concat(analog_stats.frames);
+  text.concat(", conversions: ");
+  text.concat(analog_stats.conversions);
+  text.concat(", overflows: ");
+  text.concat(analog_stats.overflows);
+  text.concat(", invalid: ");
+  text.concat(analog_stats.invalid);
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void ANALOG_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, ANALOG_json);
+}
+
+static rest_api_t ANALOG_api_handlers = {
+    /* uri */ "/api/v1/analog",
+    /* comment */ "Analog inputs",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ ANALOG_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(ANALOG_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    memset(&analog_stats, 0, sizeof(analog_stats));
+    CLI_println("Analog statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: ANALOG (reset).");
+}
+
+/*******************************************************************
+ * Continuous mode setup
+ *******************************************************************/
+static bool ANALOG_setup_continuous(void) {
+  adc_digi_pattern_config_t pattern[ANALOG_NUM_INPUTS] = {};
+  uint32_t mask = 0;
+
+  for (int input = 0; input < ANALOG_NUM_INPUTS; input++) {
+    int channel = digitalPinToAnalogChannel(analog_channels[input].pin);
+
+    if ((channel < 0) || (channel >= ADC1_CHANNEL_MAX)) {
+      Serial.printf("Analog input %s is not on ADC1.\n", analog_names[input]);
+      return false;
+    }
+
+    analog_channels[input].channel = (adc1_channel_t)channel;
+    mask |= BIT(channel);
+
+    pattern[input].atten = ANALOG_ATTEN;
+    pattern[input].channel = channel;
+    pattern[input].unit = 0;  // ADC1
+    pattern[input].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+  adc_digi_init_config_t init_config = {};
+  init_config.max_store_buf_size = ANALOG_BUFFER_BYTES;
+  init_config.conv_num_each_intr = ANALOG_FRAME_BYTES;
+  init_config.adc1_chan_mask = mask;
+  init_config.adc2_chan_mask = 0;
+
+  if (adc_digi_initialize(&init_config) != ESP_OK) {
+    return false;
+  }
+
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = true;  // Required on the ESP32
+  config.conv_limit_num = 250;
+  config.pattern_num = ANALOG_NUM_INPUTS;
+  config.adc_pattern = pattern;
+  config.sample_freq_hz = ANALOG_SAMPLE_FREQ_HZ;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+  if (adc_digi_controller_configure(&config) != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  return true;
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void ANALOG_setup(void) {
+  analogReadResolution(12);
+
+  analog_cal_type = esp_adc_cal_characterize(ADC_UNIT_1, ANALOG_ATTEN, ADC_WIDTH_BIT_12, ANALOG_VREF_DEFAULT, &analog_chars);
+
+  Serial.println(F("Analog setup completed..."));
+}
+
+/*******************************************************************
+ * Start, the steering loop reads the decimated values from here on
+ *******************************************************************/
+int ANALOG_start(void) {
+  int result = ESP_OK;
+
+  if (ANALOG_setup_continuous()) {
+    xTaskCreatePinnedToCore(ANALOG_task, "Analog", 3072, NULL, 19, NULL, APP_CPU_NUM);
+    adc_digi_start();
+    analog_started = true;
+
+    /* Wait for the first decimated values of all inputs */
+    for (int retry = 0; retry < 10 && !analog_running; retry++) {
+      vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+    if (!analog_running) {
+      Serial.println(F("ERROR: Analog continuous mode has no data after 100ms."));
+      result = ESP_FAIL;
+    }
+  } else {
+    Serial.println(F("Analog continuous mode failed, using single reads."));
+  }
+
+  cli.addBoundlessCmd("analog", clicb_handler);
+  setup_uri(&ANALOG_api_handlers);
+
+  Serial.println(F("Analog started..."));
+  return result;
+}
@@ -10,6 +10,7 @@
 #include <ArduinoJson.h>
 
 #include "CLI.h"
+#include "Calibration.h"
 #include "Config.h"
 #include "EBC_IOLib.h"
 #include "EBC_Utils.h"
@@ -30,8 +31,6 @@
 #define JSON_STEERWHEEL_LEFT_DEFAULT 0.0
 #define JSON_STEERWHEEL_RIGHT_DEFAULT 5.0
 
-#define DELAY_TO_MIDDLE_DEFAULT 5
-
 #define AZIMUTH_CALIBRATION_STEP 5
 
 /*******************************************************************
@@ -50,6 +49,8 @@ enum AzmuthCalibrateStates {
  *******************************************************************/
 static JsonDocument AZIMUTH_data;
 
+static volatile int AZIMUTH_actual = 0;  // Written by the steering loop
+
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
@@ -196,53 +197,41 @@ void AZIMUTH_analog_disable() {
  * Get/Set steering
  *******************************************************************/
 int AZIMUTH_get_low(void) {
-  int value;
-  STORAGE_get_int(JSON_AZIMUTH_LOW, value);
-  return value;
+  return CALIBRATION_get(CAL_AZIMUTH_LOW);
 }
 
 void AZIMUTH_set_low(int value) {
-  if ((value >= DAC_MIN) && (value <= DAC_MAX)) {
-    AZIMUTH_data[JSON_AZIMUTH_LOW] = value;
-    STORAGE_set_int(JSON_AZIMUTH_LOW, value);
+  if (CALIBRATION_set(CAL_AZIMUTH_LOW, value) == ESP_OK) {
     AZIMUTH_set_steering(AZIMUTH_get_manual());  // Recalculate
   }
 }
 
 int AZIMUTH_get_high(void) {
-  int value;
-  STORAGE_get_int(JSON_AZIMUTH_HIGH, value);
-  return value;
+  return CALIBRATION_get(CAL_AZIMUTH_HIGH);
 }
 
 void AZIMUTH_set_high(int value) {
-  if ((value >= DAC_MIN) && (value <= DAC_MAX)) {
-    AZIMUTH_data[JSON_AZIMUTH_HIGH] = value;
-    STORAGE_set_int(JSON_AZIMUTH_HIGH, value);
+  if (CALIBRATION_set(CAL_AZIMUTH_HIGH, value) == ESP_OK) {
     AZIMUTH_set_steering(AZIMUTH_get_manual());  // Recalculate
   }
 }
 
 int AZIMUTH_get_middle(void) {
-  int value;
-  STORAGE_get_int(JSON_AZIMUTH_MIDDLE, value);
-  return value;
+  return CALIBRATION_get(CAL_AZIMUTH_MIDDLE);
 }
 
 void AZIMUTH_set_middle(int value) {
-  if ((value >= DAC_MIN) && (value <= DAC_MAX)) {
-    AZIMUTH_data[JSON_AZIMUTH_MIDDLE] = value;
-    STORAGE_set_int(JSON_AZIMUTH_MIDDLE, value);
+  if (CALIBRATION_set(CAL_AZIMUTH_MIDDLE, value) == ESP_OK) {
     AZIMUTH_set_steering(value);  // Recalculate
   }
 }
 
 int AZIMUTH_get_actual(void) {
-  return AZIMUTH_data[JSON_AZIMUTH_ACTUAL].as<int>();
+  return AZIMUTH_actual;
 }
 
 void AZIMUTH_set_actual(int value) {
-  AZIMUTH_data[JSON_AZIMUTH_ACTUAL] = value;
+  AZIMUTH_actual = value;
   AZIMUTH_set_steering(value);  // Recalculate
 }
 
@@ -258,16 +247,11 @@ int AZIMUTH_get_manual(void) {
 }
 
 int AZIMUTH_get_timeout(void) {
-  int value;
-  STORAGE_get_int(JSON_AZIMUTH_TIMEOUT_TO_MIDDLE, value);
-  return value;
+  return CALIBRATION_get(CAL_AZIMUTH_TIMEOUT);
 }
 
 void AZIMUTH_set_timeout(int value) {
-  if ((value >= 0) && (value <= 120)) {
-    AZIMUTH_data[JSON_AZIMUTH_TIMEOUT_TO_MIDDLE] = value;
-    STORAGE_set_int(JSON_AZIMUTH_TIMEOUT_TO_MIDDLE, value);
-  }
+  CALIBRATION_set(CAL_AZIMUTH_TIMEOUT, value);
 }
 
 /********************************************************************
@@ -284,20 +268,24 @@ void AZIMUTH_set_timeout(int value) {
  * @param value The input value representing the desired steering position.
  *******************************************************************/
 void AZIMUTH_set_steering(int value) {
-  long left = AZIMUTH_get_low();
-  long middle = AZIMUTH_get_middle();
-  long right = AZIMUTH_get_high();
-
-  if (((left < middle) && (middle < right)) ||
-      ((left > middle) && (middle > right))) {
-    if (value < LINEAR_MIDDLE) {
-      value = map(value, LINEAR_MIN, LINEAR_MIDDLE, left, middle);
-    } else {
-      value = map(value, LINEAR_MIDDLE, LINEAR_MAX, middle, right);
-    }
-  }
+  STEERING_azimuth_cal_t cal = {AZIMUTH_get_low(), AZIMUTH_get_middle(), AZIMUTH_get_high()};
 
-  value = constrain(value, DAC_MIN, DAC_MAX);  // range from 0...4095
+  value = (int)STEERING_azimuth_output(&cal, value);  // range from 0...4095
+  AZIMUTH_set_right_output(value);
+
+#ifdef ENABLE_LEFT_OUTPUT
+  AZIMUTH_set_left_output(value);
+#endif
+}
+
+/********************************************************************
+ * Sets a precalculated azimuth output (steering lookup table).
+ *
+ * @param value The output value, DAC_MIN ... DAC_MAX.
+ * @param linear The linear steering value the output belongs to.
+ *******************************************************************/
+void AZIMUTH_set_output(int value, int linear) {
+  AZIMUTH_actual = linear;
   AZIMUTH_set_right_output(value);
 
 #ifdef ENABLE_LEFT_OUTPUT
@@ -325,7 +313,7 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 0 ... 4096 counts.");
       return;
     }
-    STORAGE_set_int(JSON_AZIMUTH_LOW, val);
+    CALIBRATION_set(CAL_AZIMUTH_LOW, val);
     CLI_println("Azimuth low limit has been set to " + String(val) + " counts.");
   }
 
@@ -335,7 +323,7 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 0 ... 4096 counts.");
       return;
     }
-    STORAGE_set_int(JSON_AZIMUTH_HIGH, val);
+    CALIBRATION_set(CAL_AZIMUTH_HIGH, val);
     CLI_println("Azimuth high limit has been set to " + String(val) + " counts.");
   }
 
@@ -345,7 +333,7 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 0 ... 4096 counts.");
       return;
     }
-    STORAGE_set_int(JSON_AZIMUTH_MIDDLE, val);
+    CALIBRATION_set(CAL_AZIMUTH_MIDDLE, val);
     CLI_println("Azimuth middle has been set to " + String(val) + " counts.");
   }
 
@@ -412,46 +400,16 @@ static void AZIMUTH_setup_gpio(void) {
   pinMode(LED_TWAI_PIN, OUTPUT);  // Used for AZIMUTH home signal
 }
 
-/*******************************************************************
- * Setup variables
- *******************************************************************/
-static void AZIMUTH_setup_variables(void) {
-  int value;
-
-  if (STORAGE_get_int(JSON_AZIMUTH_LOW, value)) {
-    value = DAC_MIN;
-    STORAGE_set_int(JSON_AZIMUTH_LOW, value);
-  }
-  AZIMUTH_data[JSON_AZIMUTH_LOW] = value;
-
-  if (STORAGE_get_int(JSON_AZIMUTH_MIDDLE, value)) {
-    value = (DAC_MIN + DAC_MAX) / 2;
-    STORAGE_set_int(JSON_AZIMUTH_MIDDLE, value);
-  }
-  AZIMUTH_data[JSON_AZIMUTH_MIDDLE] = value;
-
-
-  if (STORAGE_get_int(JSON_AZIMUTH_HIGH, value)) {
-    value = DAC_MAX;
-    STORAGE_set_int(JSON_AZIMUTH_HIGH, value);
-  }
-  AZIMUTH_data[JSON_AZIMUTH_HIGH] = value;
-
-  if (STORAGE_get_int(JSON_AZIMUTH_TIMEOUT_TO_MIDDLE, value)) {
-    value = DELAY_TO_MIDDLE_DEFAULT;
-    STORAGE_set_int(JSON_AZIMUTH_TIMEOUT_TO_MIDDLE, value);
-  }
-  AZIMUTH_data[JSON_AZIMUTH_TIMEOUT_TO_MIDDLE] = value;
-}
-
 /*******************************************************************
  * Stops the azimuth movement.
  *
  * This function disables the azimuth control and analog output.
  *******************************************************************/
 void AZIMUTH_stop() {
+  PCF8574_begin(PCF8574_address);
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
+  PCF8574_commit();
 
   Serial.println(F("Azimuth stopped..."));
 }
@@ -464,7 +422,6 @@ void AZIMUTH_stop() {
  * other functions related to the Azimuth module.
  *******************************************************************/
 void AZIMUTH_setup() {
-  AZIMUTH_setup_variables();
   AZIMUTH_setup_gpio();
   AZIMUTH_disable();
 
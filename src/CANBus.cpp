@@ -0,0 +1,345 @@
+/*******************************************************************
+ * CANBus.cpp
+ *
+ * CAN frame pool and dispatch to subscribed modules.
+ *
+ * The receive tasks of the TWAI and MCP channel fill frames taken
+ * from a shared pool and post them to the dispatch task, the queues
+ * only carry frame pointers. The dispatch task looks up the
+ * subscriptions of a frame in the dispatch table (EBC_Utils) and
+ * calls their handlers with the pooled frame, then returns the
+ * frame to the pool.
+ *
+ *******************************************************************/
+#include "CANBus.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "CANCapture.h"
+#include "CLI.h"
+#include "Config.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define CANBUS_POOL_SIZE 64           // Frames shared by all channels
+#define CANBUS_HANDLER_BUDGET_US 500  // Handler time, longer is counted as over budget
+#define CANBUS_MAX_CALLBACKS 4
+#define CANBUS_IDLE_MS 100            // Dispatch task wakeup without frames, applies a statistics reset
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static CAN_frame_t canbus_pool[CANBUS_POOL_SIZE];
+static QueueHandle_t canbus_free = nullptr;   // Free frames
+static QueueHandle_t canbus_ready = nullptr;  // Received frames, to dispatch
+
+static DISPATCH_table_t canbus_table;
+static SemaphoreHandle_t canbus_lock = nullptr;  // Dispatch table, innermost lock: nothing is called while held
+static volatile bool canbus_reset = false;       // Statistics reset, applied by the dispatch task
+
+static uint32_t canbus_pool_low = CANBUS_POOL_SIZE;
+static uint32_t canbus_pool_empty = 0;
+static uint32_t canbus_rejected[CAN_NUM_CHANNELS];
+
+static canbus_change_fn canbus_callbacks[CANBUS_MAX_CALLBACKS];
+static int canbus_num_callbacks = 0;
+
+/*******************************************************************
+ * Handler clock, microseconds
+ *******************************************************************/
+static uint32_t CANBUS_clock(void) {
+  return (uint32_t)micros();
+}
+
+/*******************************************************************
+ * Subscribe
+ *******************************************************************/
+int CANBUS_subscribe(const char *name, uint32_t id, uint32_t mask, DISPATCH_handler_fn handler, void *context) {
+  int index;
+
+  CANBUS_setup();
+
+  xSemaphoreTake(canbus_lock, portMAX_DELAY);
+  index = DISPATCH_subscribe(&canbus_table, name, id, mask, handler, context, CANBUS_HANDLER_BUDGET_US);
+  xSemaphoreGive(canbus_lock);
+
+  if (index < 0) {
+    Serial.printf("CAN subscription %s failed, table full.\n", name);
+    return index;
+  }
+
+  for (int i = 0; i < canbus_num_callbacks; i++) {
+    canbus_callbacks[i]();
+  }
+  return index;
+}
+
+int CANBUS_enable(int index, bool enable) {
+  int result;
+
+  xSemaphoreTake(canbus_lock, portMAX_DELAY);
+  const bool changed = (index >= 0) && (index < canbus_table.num_subs) && (canbus_table.sub[index].enabled != enable);
+  result = DISPATCH_enable(&canbus_table, index, enable);
+  xSemaphoreGive(canbus_lock);
+
+  if (result < 0) {
+    return ESP_FAIL;
+  }
+
+  for (int i = 0; changed && (i < canbus_num_callbacks); i++) {
+    canbus_callbacks[i]();
+  }
+  return ESP_OK;
+}
+
+/*******************************************************************
+ * Hardware filter support
+ *******************************************************************/
+int CANBUS_rules(CANFILTER_rule_t *rules, int max_rules) {
+  int count = 0;
+
+  xSemaphoreTake(canbus_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < canbus_table.num_subs && count < max_rules; i++) {
+    if (!canbus_table.sub[i].enabled) {
+      continue;
+    }
+    rules[count].id = canbus_table.sub[i].id;
+    rules[count].mask = canbus_table.sub[i].mask & DISPATCH_MASK_EXT;
+    count++;
+  }
+  xSemaphoreGive(canbus_lock);
+
+  return count;
+}
+
+int CANBUS_on_change(canbus_change_fn callback) {
+  if (canbus_num_callbacks >= CANBUS_MAX_CALLBACKS) {
+    return ESP_FAIL;
+  }
+  canbus_callbacks[canbus_num_callbacks++] = callback;
+  return ESP_OK;
+}
+
+uint32_t CANBUS_rejected(can_channel_t channel) {
+  return (channel < CAN_NUM_CHANNELS) ? canbus_rejected[channel] : 0;
+}
+
+/*******************************************************************
+ * Frame pool
+ *******************************************************************/
+CAN_frame_t *CANBUS_frame_alloc(void) {
+  CAN_frame_t *frame;
+
+  if (xQueueReceive(canbus_free, &frame, 0) != pdPASS) {
+    canbus_pool_empty++;
+    return nullptr;
+  }
+
+  uint32_t available = uxQueueMessagesWaiting(canbus_free);
+  if (available < canbus_pool_low) {
+    canbus_pool_low = available;
+  }
+  return frame;
+}
+
+void CANBUS_frame_post(CAN_frame_t *frame) {
+  CANCAP_frame(frame, false);
+  xQueueSend(canbus_ready, &frame, 0);  // Never full, same size as the pool
+}
+
+/*******************************************************************
+ * Dispatch task, handles all posted frames in one wakeup
+ *
+ * The matching handlers are collected with canbus_lock held, they
+ * run after it is released. Handlers may subscribe or send, which
+ * takes the channel locks (MCP1_lock before canbus_lock through
+ * CANBUS_rules()).
+ *
+ * The dispatch statistics are only written by this task, a reset is
+ * requested with canbus_reset. Readers (CLI, REST) take them as is.
+ *******************************************************************/
+static void CANBUS_task(void *parameter) {
+  DISPATCH_call_t calls[DISPATCH_MAX_SUBSCRIPTIONS];
+  CAN_frame_t *frame;
+  int num_calls;
+  (void)parameter;
+
+  while (true) {
+    const bool received = (xQueueReceive(canbus_ready, &frame, pdMS_TO_TICKS(CANBUS_IDLE_MS)) == pdPASS);
+
+    if (canbus_reset) {
+      xSemaphoreTake(canbus_lock, portMAX_DELAY);  // Subscriptions may be added
+      DISPATCH_reset_stats(&canbus_table);
+      xSemaphoreGive(canbus_lock);
+      canbus_reset = false;
+    }
+    if (!received)
+      continue;
+
+    do {
+      xSemaphoreTake(canbus_lock, portMAX_DELAY);
+      num_calls = DISPATCH_match(&canbus_table, frame, calls);
+      xSemaphoreGive(canbus_lock);
+
+      if (!num_calls && (frame->channel < CAN_NUM_CHANNELS)) {
+        canbus_rejected[frame->channel]++;  // Passed the hardware filter
+      }
+      DISPATCH_deliver(&canbus_table, calls, num_calls, frame);
+      xQueueSend(canbus_free, &frame, 0);
+    } while (xQueueReceive(canbus_ready, &frame, 0) == pdPASS);
+  }
+}
+
+/********************************************************************
+ * Create JSON data
+ *******************************************************************/
+static JsonDocument CANBUS_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  doc[JSON_CANBUS_FRAMES] = canbus_table.frames;
+  doc[JSON_CANBUS_UNMATCHED] = canbus_table.unmatched;
+  doc[JSON_CANBUS_POOL_FREE] = uxQueueMessagesWaiting(canbus_free);
+  doc[JSON_CANBUS_POOL_LOW] = canbus_pool_low;
+  doc[JSON_CANBUS_POOL_EMPTY] = canbus_pool_empty;
+
+  JsonArray subs = doc[JSON_CANBUS_SUBSCRIPTIONS].to<JsonArray>();
+  for (uint8_t i = 0; i < canbus_table.num_subs; i++) {
+    const DISPATCH_subscription_t *sub = &canbus_table.sub[i];
+    JsonObject obj = subs.add<JsonObject>();
+
+    obj["name"] = sub->name;
+    obj["id"] = sub->id & DISPATCH_MASK_EXT;
+    obj["mask"] = sub->mask & DISPATCH_MASK_EXT;
+    obj["ext"] = (sub->id & DISPATCH_ID_EXT) ? true : false;
+    obj["frames"] = sub->frames;
+    obj["time-last-us"] = sub->cost_last;
+    obj["time-max-us"] = sub->cost_max;
+    obj["time-avg-us"] = sub->frames ? (uint32_t)(sub->cost_total / sub->frames) : 0;
+    obj["over-budget"] = sub->over_budget;
+
+    JsonObject interval = obj["interval-us"].to<JsonObject>();
+    interval["min"] = sub->interval.min;
+    interval["p50"] = DISPATCH_interval_percentile(&sub->interval, 50);
+    interval["p99"] = DISPATCH_interval_percentile(&sub->interval, 99);
+    interval["max"] = sub->interval.max;
+    JsonArray histogram = interval["histogram"].to<JsonArray>();
+    for (int b = 0; b < DISPATCH_INTERVAL_BUCKETS; b++) {
+      histogram.add(sub->interval.bucket[b]);
+    }
+  }
+
+  return doc;
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String CANBUS_info_str(void) {
+  char line[120];
+
+  String text = "--- CAN dispatch ---";
+
+  text.concat("\r\nFrames: ");
+  text.concat(canbus_table.frames);
+  text.concat(", unmatched: ");
+  text.concat(canbus_table.unmatched);
+
+  text.concat("\r\nPool free: ");
+  text.concat(uxQueueMessagesWaiting(canbus_free));
+  text.concat("/");
+  text.concat(CANBUS_POOL_SIZE);
+  text.concat(", low-water: ");
+  text.concat(canbus_pool_low);
+  text.concat(", empty: ");
+  text.concat(canbus_pool_empty);
+
+  for (uint8_t i = 0; i < canbus_table.num_subs; i++) {
+    const DISPATCH_subscription_t *sub = &canbus_table.sub[i];
+
+    snprintf(line, sizeof(line), "\r\n%-12s id 0x%08X mask 0x%08X: %u frames, %u/%u/%uus (last/avg/max), over budget %u",
+             sub->name, (unsigned)(sub->id & DISPATCH_MASK_EXT), (unsigned)(sub->mask & DISPATCH_MASK_EXT),
+             (unsigned)sub->frames, (unsigned)sub->cost_last,
+             (unsigned)(sub->frames ? sub->cost_total / sub->frames : 0), (unsigned)sub->cost_max,
+             (unsigned)sub->over_budget);
+    text.concat(line);
+
+    if (sub->frames > 1) {
+      snprintf(line, sizeof(line), "\r\n%-12s interval %u/%u/%u/%uus (min/p50/p99/max)", "",
+               (unsigned)sub->interval.min, (unsigned)DISPATCH_interval_percentile(&sub->interval, 50),
+               (unsigned)DISPATCH_interval_percentile(&sub->interval, 99), (unsigned)sub->interval.max);
+      text.concat(line);
+    }
+  }
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void CANBUS_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, CANBUS_json);
+}
+
+static rest_api_t CANBUS_api_handlers = {
+    /* uri */ "/api/v1/canbus",
+    /* comment */ "CAN dispatch",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ CANBUS_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(CANBUS_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    canbus_reset = true;
+    canbus_pool_low = uxQueueMessagesWaiting(canbus_free);
+    canbus_pool_empty = 0;
+    CLI_println("CAN dispatch statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: CANBUS (reset).");
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void CANBUS_setup(void) {
+  if (canbus_lock) {
+    return;  // Already done by another channel
+  }
+
+  canbus_lock = xSemaphoreCreateMutex();
+  DISPATCH_init(&canbus_table, CANBUS_clock);
+
+  canbus_free = xQueueCreate(CANBUS_POOL_SIZE, sizeof(CAN_frame_t *));
+  canbus_ready = xQueueCreate(CANBUS_POOL_SIZE, sizeof(CAN_frame_t *));
+  for (int i = 0; i < CANBUS_POOL_SIZE; i++) {
+    CAN_frame_t *frame = &canbus_pool[i];
+    xQueueSend(canbus_free, &frame, 0);
+  }
+
+  xTaskCreate(CANBUS_task, "CAN dispatch", 4096, NULL, 4, NULL);
+
+  cli.addBoundlessCmd("canbus", clicb_handler);
+  setup_uri(&CANBUS_api_handlers);
+
+  Serial.println(F("CAN dispatch setup completed..."));
+}
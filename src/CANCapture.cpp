@@ -0,0 +1,667 @@
+/*******************************************************************
+ * CANCapture.cpp
+ *
+ * Binary capture of the CAN traffic to flash, and replay.
+ *
+ * The channels record every received and transmitted frame into a
+ * double buffer in RAM (EBC_Utils), the hot path only encodes a
+ * 20 byte record under a spinlock. A full half wakes the writer
+ * task, which appends it to the current capture file while the
+ * channels fill the other half. Both halves full drops records and
+ * counts them, the bus is never held up by the flash.
+ *
+ * Capture files are a ring of CANCAP_FILES files in LittleFS, each
+ * a header followed by fixed size records. A new file is started
+ * for every capture, when the current file is full and after a long
+ * quiet gap, the oldest file is overwritten.
+ *
+ * A capture is started from the CLI or REST API, or by the first
+ * bus error while armed. A file is downloaded as candump text, or
+ * replayed into the CAN dispatch as if the frames were received.
+ *
+ *******************************************************************/
+#include "CANCapture.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <esp_timer.h>
+#include <memory>
+
+#include "CLI.h"
+#include "Config.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define CANCAP_DIR "/capture"
+#define CANCAP_LAST_FILE CANCAP_DIR "/last"  // Number of the newest file
+#define CANCAP_FILES 8
+#define CANCAP_FILE_SIZE (64 * 1024)
+#define CANCAP_FLUSH_MS 1000                            // Partly filled half to flash
+#define CANCAP_GAP_US (30ULL * 60ULL * 1000000ULL)      // New file, well within the record clock
+#define CANCAP_TRIGGER_MS 60000                         // Capture after a bus error
+#define CANCAP_REPLAY_CHUNK 32                          // Records read at once
+
+typedef enum {
+  CANCAP_IDLE,
+  CANCAP_CAPTURING,
+  CANCAP_REPLAYING
+} cancap_state_t;
+
+static const char *CANCAP_STATE_NAMES[] = {"idle", "capturing", "replaying"};
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static CAPTURE_buffer_t cancap_buffer;
+static portMUX_TYPE cancap_mux = portMUX_INITIALIZER_UNLOCKED;  // Buffer
+static SemaphoreHandle_t cancap_lock = nullptr;                 // Files
+static TaskHandle_t cancap_writer_handle = nullptr;
+
+static volatile cancap_state_t cancap_state = CANCAP_IDLE;
+static volatile bool cancap_armed = false;
+static volatile bool cancap_flush = false;     // Write the partly filled half now
+static volatile bool cancap_new_file = false;  // Capture started
+static const char *cancap_reason = "";
+static uint32_t cancap_start_ms = 0;
+static uint32_t cancap_duration_ms = 0;
+static uint32_t cancap_triggers = 0;
+
+static File cancap_file;
+static int cancap_index = CANCAP_FILES - 1;  // Newest file
+static uint32_t cancap_file_bytes = 0;
+static uint64_t cancap_last_us = 0;          // Clock of the last record written
+static uint32_t cancap_write_errors = 0;
+
+static int cancap_replay_file = -1;
+static uint16_t cancap_replay_speed = 100;
+static uint32_t cancap_replayed = 0;
+static uint32_t cancap_replay_dropped = 0;
+
+/*******************************************************************
+ * Capture clock, microseconds
+ *******************************************************************/
+static uint64_t CANCAP_clock(void) {
+  return (uint64_t)esp_timer_get_time();
+}
+
+static String CANCAP_path(int file) {
+  return String(CANCAP_DIR "/cap") + file + ".bin";
+}
+
+/*******************************************************************
+ * Record frames, from the channel tasks
+ *******************************************************************/
+void CANCAP_frame(const CAN_frame_t *frame, bool tx) {
+  CAPTURE_record_t record;
+  bool handed;
+
+  if (cancap_state != CANCAP_CAPTURING) {
+    return;
+  }
+
+  CAPTURE_encode(frame, tx, CANCAP_clock(), &record);
+
+  portENTER_CRITICAL(&cancap_mux);
+  const int full = cancap_buffer.full[0] + cancap_buffer.full[1];
+  CAPTURE_buffer_put(&cancap_buffer, &record);
+  handed = (cancap_buffer.full[0] + cancap_buffer.full[1]) > full;
+  portEXIT_CRITICAL(&cancap_mux);
+
+  if (handed) {
+    xTaskNotifyGive(cancap_writer_handle);
+  }
+}
+
+void CANCAP_tx(can_channel_t channel, uint32_t id, bool ext, bool rtr, uint8_t length, const uint8_t *data) {
+  CAN_frame_t frame = {};
+
+  if (cancap_state != CANCAP_CAPTURING) {
+    return;
+  }
+
+  frame.id = id;
+  frame.ext = ext ? 1 : 0;
+  frame.rtr = rtr ? 1 : 0;
+  frame.channel = channel;
+  frame.length = (length > sizeof(frame.data)) ? sizeof(frame.data) : length;
+  if (data && !rtr) {
+    memcpy(frame.data, data, frame.length);
+  }
+  CANCAP_frame(&frame, true);
+}
+
+/*******************************************************************
+ * Capture files, called with cancap_lock
+ *******************************************************************/
+static bool CANCAP_open(uint64_t base_us) {
+  CAPTURE_header_t header;
+
+  cancap_index = (cancap_index + 1) % CANCAP_FILES;
+  cancap_file = LittleFS.open(CANCAP_path(cancap_index), "w");
+  if (!cancap_file) {
+    return false;
+  }
+
+  CAPTURE_header_init(&header, base_us);  // Rebased on the first record
+  cancap_file.write((const uint8_t *)&header, sizeof(header));
+  cancap_file_bytes = sizeof(header);
+  cancap_last_us = header.base_us;
+
+  File last = LittleFS.open(CANCAP_LAST_FILE, "w");
+  if (last) {
+    last.print(cancap_index);
+    last.close();
+  }
+  return true;
+}
+
+static void CANCAP_close(void) {
+  if (cancap_file) {
+    cancap_file.close();
+  }
+}
+
+static void CANCAP_write(const CAPTURE_record_t *records, uint16_t count) {
+  const uint64_t now_us = CANCAP_clock();
+
+  for (uint16_t i = 0; i < count; i++) {
+    // Records are at most a few flush periods old, unwrapping against the clock is exact at any gap
+    const uint64_t time_us = CAPTURE_time(now_us, &records[i]);
+
+    if (cancap_file && ((cancap_file_bytes + sizeof(CAPTURE_record_t) > CANCAP_FILE_SIZE) ||
+                        ((int64_t)(time_us - cancap_last_us) > (int64_t)CANCAP_GAP_US))) {
+      CANCAP_close();  // Full, or quiet for long
+    }
+    if (!cancap_file && !CANCAP_open(time_us)) {
+      cancap_write_errors++;
+      continue;
+    }
+
+    if (cancap_file.write((const uint8_t *)&records[i], sizeof(CAPTURE_record_t)) != sizeof(CAPTURE_record_t)) {
+      cancap_write_errors++;
+    }
+    cancap_file_bytes += sizeof(CAPTURE_record_t);
+    cancap_last_us = time_us;
+  }
+}
+
+/*******************************************************************
+ * Writer task, appends full halves, partly filled ones every second
+ *******************************************************************/
+static void CANCAP_writer_task(void *parameter) {
+  uint16_t count;
+  int half;
+  (void)parameter;
+
+  while (true) {
+    const bool timeout = (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CANCAP_FLUSH_MS)) == 0);
+
+    if ((cancap_state == CANCAP_CAPTURING) && cancap_duration_ms &&
+        ((millis() - cancap_start_ms) >= cancap_duration_ms)) {
+      CANCAP_stop();
+    }
+
+    if (timeout || cancap_flush) {
+      cancap_flush = false;
+      portENTER_CRITICAL(&cancap_mux);
+      CAPTURE_buffer_flush(&cancap_buffer);
+      portEXIT_CRITICAL(&cancap_mux);
+    }
+
+    xSemaphoreTake(cancap_lock, portMAX_DELAY);
+    if (cancap_new_file) {
+      cancap_new_file = false;
+      CANCAP_close();
+    }
+    while (true) {
+      portENTER_CRITICAL(&cancap_mux);
+      half = CAPTURE_buffer_take(&cancap_buffer, &count);
+      portEXIT_CRITICAL(&cancap_mux);
+      if (half < 0) {
+        break;
+      }
+
+      CANCAP_write(cancap_buffer.record[half], count);  // Channels fill the other half
+
+      portENTER_CRITICAL(&cancap_mux);
+      CAPTURE_buffer_release(&cancap_buffer, half);
+      portEXIT_CRITICAL(&cancap_mux);
+    }
+
+    if (cancap_state != CANCAP_CAPTURING) {
+      CANCAP_close();  // Complete for download and replay
+    }
+    if (cancap_file) {
+      cancap_file.flush();
+    }
+    xSemaphoreGive(cancap_lock);
+  }
+}
+
+/*******************************************************************
+ * Start, stop, trigger
+ *******************************************************************/
+int CANCAP_start(const char *reason, uint32_t duration_ms) {
+  if (!cancap_lock || (cancap_state == CANCAP_REPLAYING)) {
+    return ESP_FAIL;
+  }
+
+  cancap_new_file = true;  // Every capture gets its own file
+  cancap_reason = reason;
+  cancap_start_ms = millis();
+  cancap_duration_ms = duration_ms;
+  cancap_state = CANCAP_CAPTURING;
+
+  Serial.printf("CAN capture started (%s).\n", reason);
+  return ESP_OK;
+}
+
+void CANCAP_stop(void) {
+  if (cancap_state == CANCAP_REPLAYING) {
+    cancap_state = CANCAP_IDLE;  // Replay task ends by itself
+    return;
+  }
+  if (cancap_state != CANCAP_CAPTURING) {
+    return;
+  }
+
+  cancap_state = CANCAP_IDLE;
+  cancap_flush = true;
+  xTaskNotifyGive(cancap_writer_handle);
+}
+
+void CANCAP_trigger(const char *reason) {
+  if (!cancap_armed || (cancap_state != CANCAP_IDLE)) {
+    return;
+  }
+
+  cancap_armed = false;
+  cancap_triggers++;
+  CANCAP_start(reason, CANCAP_TRIGGER_MS);
+}
+
+/*******************************************************************
+ * Replay task, injects the received frames of a file into the
+ * dispatch, paced by the recorded clock
+ *******************************************************************/
+static void CANCAP_replay_task(void *parameter) {
+  CAPTURE_record_t records[CANCAP_REPLAY_CHUNK];
+  CAPTURE_header_t header;
+  uint64_t time_us;
+  uint64_t first_us = 0;
+  bool first = true;
+  size_t bytes;
+  (void)parameter;
+
+  File file = LittleFS.open(CANCAP_path(cancap_replay_file), "r");
+  if (!file || (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header)) || !CAPTURE_header_valid(&header)) {
+    Serial.printf("CAN replay of file %d failed, no capture.\n", cancap_replay_file);
+    cancap_state = CANCAP_IDLE;
+    vTaskDelete(NULL);
+    return;
+  }
+
+  const uint64_t start_us = CANCAP_clock();
+  time_us = header.base_us;
+
+  while ((cancap_state == CANCAP_REPLAYING) &&
+         ((bytes = file.read((uint8_t *)records, sizeof(records))) >= sizeof(CAPTURE_record_t))) {
+    for (size_t i = 0; (i < bytes / sizeof(CAPTURE_record_t)) && (cancap_state == CANCAP_REPLAYING); i++) {
+      CAN_frame_t *frame;
+      bool tx;
+
+      time_us = CAPTURE_time(time_us, &records[i]);
+      if (records[i].id & CAPTURE_ID_TX) {
+        continue;  // Our own frames, the modules send them again
+      }
+      if (first) {
+        first_us = time_us;
+        first = false;
+      }
+
+      const uint64_t due_us = start_us + CAPTURE_replay_offset(first_us, time_us, cancap_replay_speed);
+      const int64_t wait_us = (int64_t)(due_us - CANCAP_clock());
+      if (wait_us >= 1000) {
+        vTaskDelay(pdMS_TO_TICKS(wait_us / 1000) ? pdMS_TO_TICKS(wait_us / 1000) : 1);
+      }
+
+      frame = CANBUS_frame_alloc();
+      if (!frame) {
+        cancap_replay_dropped++;
+        continue;
+      }
+      CAPTURE_decode(&records[i], frame, &tx);
+      CANBUS_frame_post(frame);
+      cancap_replayed++;
+    }
+  }
+
+  file.close();
+  Serial.printf("CAN replay of file %d done, %u frames.\n", cancap_replay_file, (unsigned)cancap_replayed);
+  if (cancap_state == CANCAP_REPLAYING) {
+    cancap_state = CANCAP_IDLE;
+  }
+  vTaskDelete(NULL);
+}
+
+int CANCAP_replay(int file, uint16_t speed_pct) {
+  if (!cancap_lock || (cancap_state != CANCAP_IDLE) || (file < 0) || (file >= CANCAP_FILES) || !speed_pct ||
+      !LittleFS.exists(CANCAP_path(file))) {
+    return ESP_FAIL;
+  }
+
+  cancap_replay_file = file;
+  cancap_replay_speed = speed_pct;
+  cancap_replayed = 0;
+  cancap_replay_dropped = 0;
+  cancap_state = CANCAP_REPLAYING;
+
+  xTaskCreate(CANCAP_replay_task, "CAN replay", 4096, NULL, 3, NULL);
+  return ESP_OK;
+}
+
+/*******************************************************************
+ * Create JSON document
+ *******************************************************************/
+static JsonDocument CANCAP_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  doc[JSON_CANCAP_STATE] = CANCAP_STATE_NAMES[cancap_state];
+  doc[JSON_CANCAP_ARMED] = (bool)cancap_armed;
+  doc[JSON_CANCAP_REASON] = cancap_reason;
+  doc[JSON_CANCAP_RECORDS] = cancap_buffer.records;
+  doc[JSON_CANCAP_DROPPED] = cancap_buffer.dropped;
+  doc[JSON_CANCAP_WRITE_ERRORS] = cancap_write_errors;
+  doc[JSON_CANCAP_TRIGGERS] = cancap_triggers;
+  doc[JSON_CANCAP_FILE] = cancap_index;
+  doc[JSON_CANCAP_REPLAYED] = cancap_replayed;
+  doc[JSON_CANCAP_REPLAY_DROPPED] = cancap_replay_dropped;
+
+  JsonArray files = doc[JSON_CANCAP_FILES].to<JsonArray>();
+  xSemaphoreTake(cancap_lock, portMAX_DELAY);
+  for (int i = 0; i < CANCAP_FILES; i++) {
+    File file = LittleFS.open(CANCAP_path(i), "r");
+    if (!file) {
+      continue;
+    }
+
+    JsonObject obj = files.add<JsonObject>();
+    obj["file"] = i;
+    obj["records"] = (file.size() > sizeof(CAPTURE_header_t))
+                         ? (file.size() - sizeof(CAPTURE_header_t)) / sizeof(CAPTURE_record_t)
+                         : 0;
+    obj["written"] = file.getLastWrite();
+    file.close();
+  }
+  xSemaphoreGive(cancap_lock);
+
+  return doc;
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String CANCAP_info_str(void) {
+  JsonDocument doc = CANCAP_json();
+  char line[80];
+
+  String text = "--- CAN capture ---";
+
+  text.concat("\r\nState: ");
+  text.concat(doc[JSON_CANCAP_STATE].as<const char *>());
+  text.concat(doc[JSON_CANCAP_ARMED].as<bool>() ? ", armed" : ", not armed");
+  text.concat("\r\nReason: ");
+  text.concat(doc[JSON_CANCAP_REASON].as<const char *>());
+
+  text.concat("\r\nRecords: ");
+  text.concat(doc[JSON_CANCAP_RECORDS].as<unsigned>());
+  text.concat(", dropped: ");
+  text.concat(doc[JSON_CANCAP_DROPPED].as<unsigned>());
+  text.concat(", write errors: ");
+  text.concat(doc[JSON_CANCAP_WRITE_ERRORS].as<unsigned>());
+  text.concat(", triggers: ");
+  text.concat(doc[JSON_CANCAP_TRIGGERS].as<unsigned>());
+
+  text.concat("\r\nReplayed: ");
+  text.concat(doc[JSON_CANCAP_REPLAYED].as<unsigned>());
+  text.concat(", dropped: ");
+  text.concat(doc[JSON_CANCAP_REPLAY_DROPPED].as<unsigned>());
+
+  for (JsonObject obj : doc[JSON_CANCAP_FILES].as<JsonArray>()) {
+    snprintf(line, sizeof(line), "\r\n%s file %d: %u records", (obj["file"] == cancap_index) ? "*" : " ",
+             obj["file"].as<int>(), obj["records"].as<unsigned>());
+    text.concat(line);
+  }
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * candump download, one record per line, streamed from the file
+ *******************************************************************/
+typedef struct {
+  File file;
+  uint32_t records;  // Flushed when the download started
+  uint64_t time_us;
+  char line[CAPTURE_CANDUMP_MAX];
+  int pending;  // Bytes of line not sent yet
+  int sent;
+} cancap_download_t;
+
+static void CANCAP_download(AsyncWebServerRequest *request, int number) {
+  std::shared_ptr<cancap_download_t> download = std::make_shared<cancap_download_t>();
+  CAPTURE_header_t header;
+
+  /* The writer flushes with the lock held, the size is the flushed part of an open capture */
+  xSemaphoreTake(cancap_lock, portMAX_DELAY);
+  download->file = LittleFS.open(CANCAP_path(number), "r");
+  const bool valid = download->file &&
+                     (download->file.read((uint8_t *)&header, sizeof(header)) == sizeof(header)) &&
+                     CAPTURE_header_valid(&header);
+  if (valid) {
+    download->records = (download->file.size() - sizeof(header)) / sizeof(CAPTURE_record_t);
+  }
+  xSemaphoreGive(cancap_lock);
+
+  if (!valid) {
+    request->send(404, "text/plain", "404, No capture");
+    return;
+  }
+  download->time_us = header.base_us;
+  download->pending = 0;
+  download->sent = 0;
+
+  AsyncWebServerResponse *response = request->beginChunkedResponse(
+      "text/plain", [download](uint8_t *buffer, size_t max_len, size_t index) -> size_t {
+        size_t len = 0;
+        (void)index;
+
+        while (len < max_len) {
+          if (!download->pending) {
+            CAPTURE_record_t record;
+            if (!download->records || (download->file.read((uint8_t *)&record, sizeof(record)) != sizeof(record))) {
+              break;
+            }
+            download->records--;
+            download->time_us = CAPTURE_time(download->time_us, &record);
+            download->pending = CAPTURE_candump(&record, download->time_us, download->line, sizeof(download->line));
+            download->sent = 0;
+          }
+
+          const size_t n = min((size_t)download->pending, max_len - len);
+          memcpy(buffer + len, download->line + download->sent, n);
+          len += n;
+          download->sent += n;
+          download->pending -= n;
+        }
+        return len;  // 0 ends the response
+      });
+  response->addHeader("Content-Disposition", String("attachment; filename=\"cap") + number + ".log\"");
+  request->send(response);
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void CANCAP_rest_read(AsyncWebServerRequest *request) {
+  if (request->hasParam(JSON_CANCAP_FILE)) {
+    CANCAP_download(request, request->getParam(JSON_CANCAP_FILE)->value().toInt());
+    return;
+  }
+
+  WEBSERVER_send_json(request, CANCAP_json);
+}
+
+static void CANCAP_rest_update(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  (void)index;
+  (void)total;
+
+  JsonDocument doc;
+  if (deserializeJson(doc, (const char *)data, len)) {
+    request->send(400, "text/plain", "400, Invalid JSON");
+    return;
+  }
+
+  if (doc["arm"].is<bool>()) {
+    cancap_armed = doc["arm"].as<bool>();
+  }
+
+  if (doc["capture"].is<bool>()) {
+    if (!doc["capture"].as<bool>()) {
+      CANCAP_stop();
+    } else if (CANCAP_start("rest", doc["duration-ms"] | 0) != ESP_OK) {
+      request->send(409, "text/plain", "409, Replay running");
+      return;
+    }
+  }
+
+  if (doc["replay"].is<int>() && (CANCAP_replay(doc["replay"].as<int>(), doc["speed"] | 100) != ESP_OK)) {
+    request->send(409, "text/plain", "409, Replay not possible");
+    return;
+  }
+
+  request->send(200, "text/plain", "200, OK");
+}
+
+static rest_api_t CANCAP_api_handlers = {
+    /* uri */ "/api/v1/cancap",
+    /* comment */ "CAN capture, ?file=n downloads candump text",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ CANCAP_rest_read,
+    /* fn_update */ CANCAP_rest_update,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(CANCAP_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("start")) {
+    int duration = cmd.getArg(1).getValue().toInt();
+    if (CANCAP_start("cli", duration * 1000) == ESP_OK) {
+      CLI_println("CAN capture started.");
+    } else {
+      CLI_println("CAN capture not possible, replay running.");
+    }
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("stop")) {
+    CANCAP_stop();
+    CLI_println("CAN capture or replay stopped.");
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("arm")) {
+    cancap_armed = true;
+    CLI_println("CAN capture armed, the next bus error starts a capture.");
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("disarm")) {
+    cancap_armed = false;
+    CLI_println("CAN capture disarmed.");
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("replay")) {
+    int file = cmd.getArg(1).getValue().toInt();
+    int speed = cmd.getArg(2).getValue().toInt();
+    if (CANCAP_replay(file, speed ? speed : 100) == ESP_OK) {
+      CLI_println("CAN replay started.");
+    } else {
+      CLI_println("CAN replay not possible.");
+    }
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("erase")) {
+    if (cancap_state != CANCAP_IDLE) {
+      CLI_println("CAN capture busy.");
+      return;
+    }
+    xSemaphoreTake(cancap_lock, portMAX_DELAY);
+    for (int i = 0; i < CANCAP_FILES; i++) {
+      LittleFS.remove(CANCAP_path(i));
+    }
+    LittleFS.remove(CANCAP_LAST_FILE);
+    cancap_index = CANCAP_FILES - 1;
+    xSemaphoreGive(cancap_lock);
+    CLI_println("CAN capture files erased.");
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    portENTER_CRITICAL(&cancap_mux);
+    cancap_buffer.records = 0;
+    cancap_buffer.dropped = 0;
+    portEXIT_CRITICAL(&cancap_mux);
+    cancap_write_errors = 0;
+    cancap_triggers = 0;
+    CLI_println("CAN capture statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: CANCAP (start [s], stop, arm, disarm, replay <file> [speed%], erase, reset).");
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void CANCAP_setup(void) {
+  if (cancap_lock) {
+    return;  // Already done
+  }
+
+  cancap_lock = xSemaphoreCreateMutex();
+  CAPTURE_buffer_init(&cancap_buffer);
+
+  if (!LittleFS.exists(CANCAP_DIR)) {
+    LittleFS.mkdir(CANCAP_DIR);
+  }
+  File last = LittleFS.open(CANCAP_LAST_FILE, "r");
+  if (last) {
+    cancap_index = last.parseInt() % CANCAP_FILES;  // Continue the ring
+    last.close();
+  }
+
+  xTaskCreate(CANCAP_writer_task, "CAN capture", 4096, NULL, 2, &cancap_writer_handle);
+
+  cli.addBoundlessCmd("cancap", clicb_handler);
+  setup_uri(&CANCAP_api_handlers);
+
+  Serial.println(F("CAN capture setup completed..."));
+}
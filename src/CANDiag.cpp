@@ -0,0 +1,510 @@
+/*******************************************************************
+ * CANDiag.cpp
+ *
+ * Diagnostic server on the TWAI channel.
+ *
+ * A tester on 0x7E0 talks UDS (EBC_Utils) over ISO-TP and gets the
+ * responses on 0x7E8. The dispatch handler only copies the request
+ * frames to the diagnostic task, which runs the transport, calls the
+ * services and paces the consecutive frames with the separation
+ * time. Payloads are never buffered as a whole: the data of a DID is
+ * read and written in frame sized chunks, a calibration value is
+ * checked and stored when the request is complete.
+ *
+ * Writing DIDs and running routines needs the extended session,
+ * homing also needs maintenance mode. The session falls back to the
+ * default session 5 s after the last request (tester present).
+ *
+ *******************************************************************/
+#include "CANDiag.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "Azimuth.h"
+#include "CANBus.h"
+#include "CLI.h"
+#include "Calibration.h"
+#include "Config.h"
+#include "GPIO.h"
+#include "Lift.h"
+#include "Maintenance.h"
+#include "SteeringWheel.h"
+#include "Storage.h"
+#include "TWAICom.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define CANDIAG_QUEUE_LEN 16          // Request frames to the task
+#define CANDIAG_TIMEOUT_US 1000000    // N_Bs, N_Cr
+#define CANDIAG_S3_US 5000000         // Session timeout
+#define CANDIAG_POLL_MS 100           // Session timeout check
+#define CANDIAG_BLOCK_SIZE 8          // Default flow control
+#define CANDIAG_ST_MIN 0
+#define CANDIAG_PADDING 0xCC
+#define CANDIAG_NUM_DIDS (CAL_NUM_FIELDS + 5)
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static ISOTP_link_t candiag_link;
+static UDS_server_t candiag_server;
+static QueueHandle_t candiag_rx = nullptr;
+static TaskHandle_t candiag_task_handle = nullptr;
+static uint32_t candiag_dropped = 0;  // Request frames, queue full
+
+static UDS_did_t candiag_dids[CANDIAG_NUM_DIDS];
+static int32_t candiag_staged;       // Calibration value being written
+static calibration_t candiag_snapshot;  // All calibration values being read
+static uint8_t candiag_self_test = 0;
+
+/*******************************************************************
+ * Diagnostic clock, microseconds
+ *******************************************************************/
+static uint32_t CANDIAG_clock(void) {
+  return (uint32_t)micros();
+}
+
+/*******************************************************************
+ * Big endian fields, a chunk of a DID is any part of it
+ *******************************************************************/
+static void CANDIAG_put(uint8_t *field, int32_t value) {
+  field[0] = (uint8_t)(value >> 24);
+  field[1] = (uint8_t)(value >> 16);
+  field[2] = (uint8_t)(value >> 8);
+  field[3] = (uint8_t)value;
+}
+
+static void CANDIAG_copy(const uint8_t *source, uint16_t offset, uint8_t *data, uint16_t length) {
+  memcpy(data, &source[offset], length);
+}
+
+/*******************************************************************
+ * Calibration values, one DID per field and all at once
+ *******************************************************************/
+static void CANDIAG_calibration_read(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  uint8_t field[4];
+
+  CANDIAG_put(field, CALIBRATION_get((calibration_field_t)(intptr_t)context));
+  CANDIAG_copy(field, offset, data, length);
+}
+
+static void CANDIAG_calibration_write(uint16_t offset, const uint8_t *data, uint16_t length, void *context) {
+  uint8_t field[4];
+  (void)context;
+
+  CANDIAG_put(field, candiag_staged);
+  memcpy(&field[offset], data, length);
+  candiag_staged = (int32_t)(((uint32_t)field[0] << 24) | ((uint32_t)field[1] << 16) | ((uint32_t)field[2] << 8) | field[3]);
+}
+
+static uint8_t CANDIAG_calibration_commit(void *context) {
+  const calibration_field_t field = (calibration_field_t)(intptr_t)context;
+
+  if (CALIBRATION_set(field, candiag_staged) != ESP_OK) {
+    return UDS_NRC_OUT_OF_RANGE;
+  }
+  Serial.printf("CAN diagnostic set %s to %d.\n", CALIBRATION_key(field), (int)candiag_staged);
+  return 0;
+}
+
+static void CANDIAG_calibration_all(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  uint8_t field[4];
+  (void)context;
+
+  if (offset == 0) {
+    CALIBRATION_snapshot(&candiag_snapshot);  // One consistent set
+  }
+  for (uint16_t i = 0; i < length; i++) {
+    const uint16_t position = offset + i;
+    CANDIAG_put(field, candiag_snapshot.value[position / 4]);
+    data[i] = field[position % 4];
+  }
+}
+
+/*******************************************************************
+ * Counters: retracted, extended, requests, negative responses and
+ * transport errors, uint32 each
+ *******************************************************************/
+static void CANDIAG_counters(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  uint8_t counters[20];
+  int retracted = 0;
+  int extended = 0;
+  (void)context;
+
+  STORAGE_get_int(JSON_RETRACTED_COUNT, retracted);
+  STORAGE_get_int(JSON_EXTENDED_COUNT, extended);
+
+  CANDIAG_put(&counters[0], retracted);
+  CANDIAG_put(&counters[4], extended);
+  CANDIAG_put(&counters[8], (int32_t)candiag_server.requests);
+  CANDIAG_put(&counters[12], (int32_t)candiag_server.negative);
+  CANDIAG_put(&counters[16], (int32_t)candiag_link.errors);
+  CANDIAG_copy(counters, offset, data, length);
+}
+
+/*******************************************************************
+ * State: maintenance, emergency stop, latched, lift up, down and
+ * home sensor (one byte each), azimuth and steering wheel actual
+ * (int32 each)
+ *******************************************************************/
+static void CANDIAG_state(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  uint8_t state[14];
+  (void)context;
+
+  state[0] = MAINTENANCE_enabled();
+  state[1] = EMERGENCY_STOP_active();
+  state[2] = EMERGENCY_STOP_latched();
+  state[3] = LIFT_UP_sensor();
+  state[4] = LIFT_DOWN_sensor();
+  state[5] = LIFT_HOME_sensor();
+  CANDIAG_put(&state[6], AZIMUTH_get_actual());
+  CANDIAG_put(&state[10], STEERWHEEL_get_actual());
+  CANDIAG_copy(state, offset, data, length);
+}
+
+static void CANDIAG_text(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  CANDIAG_copy((const uint8_t *)context, offset, data, length);
+}
+
+/*******************************************************************
+ * Routines, homing through the maintenance mode
+ *******************************************************************/
+static uint8_t CANDIAG_homing(uint8_t control, uint8_t *result, uint8_t *length, void *context) {
+  const bool lift = (context != nullptr);
+
+  switch (control) {
+    case UDS_ROUTINE_START:
+      if (!MAINTENANCE_enabled() || (lift && !LIFT_enabled())) {
+        return UDS_NRC_CONDITIONS_NOT_CORRECT;
+      }
+      MAINTENANCE_command_handler(lift ? "{\"" JSON_LIFT_HOMING "\":true}" : "{\"" JSON_AZIMUTH_HOMING "\":true}");
+      *length = 0;
+      return 0;
+
+    case UDS_ROUTINE_RESULTS:
+      result[0] = lift ? LIFT_HOME_sensor() : AZIMUTH_home();  // Home reached
+      *length = 1;
+      return 0;
+
+    default:
+      return UDS_NRC_CONDITIONS_NOT_CORRECT;  // Homing ends by itself
+  }
+}
+
+static uint8_t CANDIAG_test(void) {
+  HEALTH_status_t status;
+  uint8_t failed = 0;
+
+  if (EMERGENCY_STOP_active()) {
+    failed |= CANDIAG_TEST_EMERGENCY_STOP;
+  }
+  if (LIFT_UP_sensor() && LIFT_DOWN_sensor()) {
+    failed |= CANDIAG_TEST_LIFT_SENSORS;
+  }
+
+  const int wheel = STEERWHEEL_get_actual();
+  const int left = CALIBRATION_get(CAL_STEERWHEEL_LEFT);
+  const int right = CALIBRATION_get(CAL_STEERWHEEL_RIGHT);
+  if ((wheel < min(left, right)) || (wheel > max(left, right))) {
+    failed |= CANDIAG_TEST_STEERWHEEL;
+  }
+
+  const int azimuth = AZIMUTH_get_actual();
+  const int low = CALIBRATION_get(CAL_AZIMUTH_LOW);
+  const int high = CALIBRATION_get(CAL_AZIMUTH_HIGH);
+  if ((azimuth < min(low, high)) || (azimuth > max(low, high))) {
+    failed |= CANDIAG_TEST_AZIMUTH;
+  }
+
+  if ((TWAI_bus_status(&status) == ESP_OK) && (status.state == HEALTH_BUS_OFF)) {
+    failed |= CANDIAG_TEST_CAN;
+  }
+  return failed;
+}
+
+static uint8_t CANDIAG_self_test(uint8_t control, uint8_t *result, uint8_t *length, void *context) {
+  (void)context;
+
+  switch (control) {
+    case UDS_ROUTINE_START:
+      candiag_self_test = CANDIAG_test();
+      // fall through
+    case UDS_ROUTINE_RESULTS:
+      result[0] = candiag_self_test;
+      *length = 1;
+      return 0;
+
+    default:
+      return UDS_NRC_CONDITIONS_NOT_CORRECT;
+  }
+}
+
+static const UDS_routine_t candiag_routines[] = {
+    {CANDIAG_RID_LIFT_HOMING, "lift-homing", CANDIAG_homing, (void *)1},
+    {CANDIAG_RID_AZIMUTH_HOMING, "azimuth-homing", CANDIAG_homing, nullptr},
+    {CANDIAG_RID_SELF_TEST, "self-test", CANDIAG_self_test, nullptr},
+};
+
+/*******************************************************************
+ * Transport
+ *******************************************************************/
+static bool CANDIAG_send(const CAN_frame_t *frame, void *context) {
+  (void)context;
+  return TWAI_send(frame->id, frame->data, frame->length, false, frame->ext) == ESP_OK;
+}
+
+static void CANDIAG_done(bool tx, ISOTP_result_t result, void *context) {
+  (void)context;
+
+  if (tx) {
+    UDS_response_done(&candiag_server);  // Also after a failed response
+    return;
+  }
+  if (result != ISOTP_OK) {
+    return;
+  }
+
+  const uint16_t length = UDS_request_done(&candiag_server, CANDIAG_clock());
+  if (length && (ISOTP_send(&candiag_link, length, CANDIAG_clock()) != 0)) {
+    UDS_response_done(&candiag_server);
+  }
+}
+
+static void CANDIAG_handler(const CAN_frame_t *frame, void *context) {
+  (void)context;
+
+  if ((frame->channel != CAN_CHANNEL_TWAI) || (xQueueSend(candiag_rx, frame, 0) != pdPASS)) {
+    candiag_dropped++;
+    return;
+  }
+  xTaskNotifyGive(candiag_task_handle);
+}
+
+/*******************************************************************
+ * Diagnostic task, sleeps until a frame arrives or the transport
+ * has a frame or timeout due
+ *******************************************************************/
+static void CANDIAG_task(void *parameter) {
+  CAN_frame_t frame;
+  (void)parameter;
+
+  while (true) {
+    const uint32_t wait = ISOTP_wait(&candiag_link, CANDIAG_clock());
+    TickType_t ticks = CANDIAG_POLL_MS / portTICK_PERIOD_MS;
+
+    if (wait < (uint32_t)CANDIAG_POLL_MS * 1000) {
+      ticks = (wait + 999) / 1000 / portTICK_PERIOD_MS;  // Sub tick separation times wait one tick
+      if (wait && !ticks) {
+        ticks = 1;
+      }
+    }
+    if (ticks) {
+      ulTaskNotifyTake(pdTRUE, ticks);
+    }
+
+    while (xQueueReceive(candiag_rx, &frame, 0) == pdPASS) {
+      ISOTP_receive(&candiag_link, &frame, CANDIAG_clock());
+    }
+    ISOTP_poll(&candiag_link, CANDIAG_clock());
+    UDS_poll(&candiag_server, CANDIAG_clock());
+  }
+}
+
+/********************************************************************
+ * Create JSON data
+ *******************************************************************/
+static JsonDocument CANDIAG_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  doc[JSON_CANDIAG_BLOCK_SIZE] = candiag_link.config.block_size;
+  doc[JSON_CANDIAG_ST_MIN] = candiag_link.config.st_min;
+  doc[JSON_CANDIAG_SESSION] = candiag_server.session;
+  doc[JSON_CANDIAG_REQUESTS] = candiag_server.requests;
+  doc[JSON_CANDIAG_NEGATIVE] = candiag_server.negative;
+  doc[JSON_CANDIAG_BUSY] = candiag_server.busy;
+  doc[JSON_CANDIAG_RX_MESSAGES] = candiag_link.rx_messages;
+  doc[JSON_CANDIAG_TX_MESSAGES] = candiag_link.tx_messages;
+  doc[JSON_CANDIAG_RX_FRAMES] = candiag_link.rx_frames;
+  doc[JSON_CANDIAG_TX_FRAMES] = candiag_link.tx_frames;
+  doc[JSON_CANDIAG_ERRORS] = candiag_link.errors;
+  doc[JSON_CANDIAG_DROPPED] = candiag_dropped;
+
+  return doc;
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String CANDIAG_info_str(void) {
+  char line[120];
+
+  String text = "--- CAN diagnostic ---";
+
+  snprintf(line, sizeof(line), "\r\nRequest 0x%03X, response 0x%03X, block size %u, STmin 0x%02X, session 0x%02X",
+           CANDIAG_REQUEST_ID, CANDIAG_RESPONSE_ID, candiag_link.config.block_size, candiag_link.config.st_min,
+           candiag_server.session);
+  text.concat(line);
+
+  snprintf(line, sizeof(line), "\r\nRequests: %u, negative: %u, busy: %u",
+           (unsigned)candiag_server.requests, (unsigned)candiag_server.negative, (unsigned)candiag_server.busy);
+  text.concat(line);
+
+  snprintf(line, sizeof(line), "\r\nMessages rx/tx: %u/%u, frames rx/tx: %u/%u, errors: %u, dropped: %u",
+           (unsigned)candiag_link.rx_messages, (unsigned)candiag_link.tx_messages, (unsigned)candiag_link.rx_frames,
+           (unsigned)candiag_link.tx_frames, (unsigned)candiag_link.errors, (unsigned)candiag_dropped);
+  text.concat(line);
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * Flow control of the requests, used by the next first frame
+ *******************************************************************/
+static int CANDIAG_flow_control(int block_size, int st_min) {
+  if ((block_size < 0) || (block_size > 0xFF) || (st_min < 0) || (st_min > 0xFF)) {
+    return ESP_FAIL;
+  }
+  candiag_link.config.block_size = (uint8_t)block_size;
+  candiag_link.config.st_min = (uint8_t)st_min;
+  return ESP_OK;
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void CANDIAG_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, CANDIAG_json);
+}
+
+static void CANDIAG_rest_update(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  (void)index;
+  (void)total;
+
+  JsonDocument doc;
+  if (deserializeJson(doc, (const char *)data, len)) {
+    request->send(400, "text/plain", "400, Invalid JSON");
+    return;
+  }
+
+  if (CANDIAG_flow_control(doc[JSON_CANDIAG_BLOCK_SIZE] | candiag_link.config.block_size,
+                           doc[JSON_CANDIAG_ST_MIN] | candiag_link.config.st_min) != ESP_OK) {
+    request->send(400, "text/plain", "400, Invalid value");
+    return;
+  }
+
+  request->send(200, "text/plain", "200, OK");
+}
+
+static rest_api_t CANDIAG_api_handlers = {
+    /* uri */ "/api/v1/candiag",
+    /* comment */ "CAN diagnostic (UDS on ISO-TP)",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ CANDIAG_rest_read,
+    /* fn_update */ CANDIAG_rest_update,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(CANDIAG_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("bs")) {
+    if (CANDIAG_flow_control(cmd.getArg(1).getValue().toInt(), candiag_link.config.st_min) == ESP_OK) {
+      CLI_println("CAN diagnostic block size set.");
+    } else {
+      CLI_println("Invalid block size (0..255).");
+    }
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("stmin")) {
+    if (CANDIAG_flow_control(candiag_link.config.block_size, cmd.getArg(1).getValue().toInt()) == ESP_OK) {
+      CLI_println("CAN diagnostic separation time set.");
+    } else {
+      CLI_println("Invalid separation time (0..255).");
+    }
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    candiag_server.requests = 0;
+    candiag_server.negative = 0;
+    candiag_server.busy = 0;
+    candiag_link.rx_messages = 0;
+    candiag_link.tx_messages = 0;
+    candiag_link.rx_frames = 0;
+    candiag_link.tx_frames = 0;
+    candiag_link.errors = 0;
+    candiag_dropped = 0;
+    CLI_println("CAN diagnostic statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: CANDIAG (bs n, stmin n, reset).");
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void CANDIAG_setup(void) {
+  ISOTP_config_t config = {};
+  int n = 0;
+
+  if (candiag_task_handle) {
+    return;  // Already done
+  }
+
+  for (int i = 0; i < CAL_NUM_FIELDS; i++) {
+    candiag_dids[n++] = {(uint16_t)(CANDIAG_DID_CALIBRATION + i), CALIBRATION_key((calibration_field_t)i), 4,
+                         CANDIAG_calibration_read, CANDIAG_calibration_write, CANDIAG_calibration_commit,
+                         (void *)(intptr_t)i};
+  }
+  candiag_dids[n++] = {CANDIAG_DID_CALIBRATION_ALL, "calibration", CAL_NUM_FIELDS * 4, CANDIAG_calibration_all,
+                       nullptr, nullptr, nullptr};
+  candiag_dids[n++] = {CANDIAG_DID_COUNTERS, "counters", 20, CANDIAG_counters, nullptr, nullptr, nullptr};
+  candiag_dids[n++] = {CANDIAG_DID_STATE, "state", 14, CANDIAG_state, nullptr, nullptr, nullptr};
+  candiag_dids[n++] = {CANDIAG_DID_SOFTWARE_VERSION, "version", sizeof(ProgramVersion) - 1, CANDIAG_text, nullptr,
+                       nullptr, (void *)ProgramVersion};
+  candiag_dids[n++] = {CANDIAG_DID_SYSTEM_NAME, "name", sizeof(ProgramName) - 1, CANDIAG_text, nullptr, nullptr,
+                       (void *)ProgramName};
+
+  UDS_init(&candiag_server, candiag_dids, n, candiag_routines,
+           sizeof(candiag_routines) / sizeof(candiag_routines[0]), CANDIAG_S3_US);
+
+  config.tx_id = CANDIAG_RESPONSE_ID;
+  config.rx_id = CANDIAG_REQUEST_ID;
+  config.ext = false;
+  config.block_size = CANDIAG_BLOCK_SIZE;
+  config.st_min = CANDIAG_ST_MIN;
+  config.padding = CANDIAG_PADDING;
+  config.timeout = CANDIAG_TIMEOUT_US;
+  config.send = CANDIAG_send;
+  config.source = UDS_response_data;
+  config.sink = UDS_request_data;
+  config.done = CANDIAG_done;
+  config.context = &candiag_server;
+  ISOTP_init(&candiag_link, &config);
+
+  candiag_rx = xQueueCreate(CANDIAG_QUEUE_LEN, sizeof(CAN_frame_t));
+  xTaskCreate(CANDIAG_task, "CAN diagnostic", 4096, NULL, 3, &candiag_task_handle);
+
+  CANBUS_subscribe("diag", CANDIAG_REQUEST_ID, DISPATCH_MASK_STD, CANDIAG_handler);
+
+  cli.addBoundlessCmd("candiag", clicb_handler);
+  setup_uri(&CANDIAG_api_handlers);
+
+  Serial.println(F("CAN diagnostic setup completed..."));
+}
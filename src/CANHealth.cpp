@@ -0,0 +1,367 @@
+/*******************************************************************
+ * CANHealth.cpp
+ *
+ * CAN bus health monitor, tells a congested bus from a faulty node.
+ *
+ * The channels count every frame they receive or transmit with its
+ * bit time on the wire (EBC_Utils), the load of a channel is the
+ * share of the bit rate used per one second window. Frames dropped
+ * by the hardware acceptance filter are not seen, the load is the
+ * load of the accepted traffic.
+ *
+ * The monitor task samples the error state of the channels, keeps
+ * a trend of the error counters and recovers a bus-off controller
+ * after an exponential backoff: a node that keeps going bus-off is
+ * kept off the bus longer every time, and gets the short delay back
+ * after a minute on the bus. The state is published on the REST API
+ * and the websocket, the inter-arrival times of the subscriptions
+ * are in the CAN dispatch statistics.
+ *
+ *******************************************************************/
+#include "CANHealth.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "CLI.h"
+#include "Config.h"
+#include "MCPCom.h"
+#include "TWAICom.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define CANHEALTH_PERIOD_MS 100         // Error state, bus-off handling
+#define CANHEALTH_SAMPLE_PERIODS 10     // Trend sample and publish every second
+#define CANHEALTH_WINDOW_US 1000000     // Bus load window
+#define CANHEALTH_BACKOFF_MS 100        // First bus-off recovery
+#define CANHEALTH_BACKOFF_MAX_MS 10000  // Repeated bus-off
+#define CANHEALTH_STABLE_MS 60000       // On the bus, backoff starts over
+
+typedef struct {
+  const char *name;
+  bool active;  // Channel set up
+  HEALTH_status_t status;
+  HEALTH_load_t load;
+  HEALTH_errors_t errors;
+  HEALTH_backoff_t backoff;
+  HEALTH_verdict_t verdict;
+} canhealth_channel_t;
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static canhealth_channel_t canhealth_channels[CAN_NUM_CHANNELS] = {
+    {"twai"},
+    {"mcp"},
+};
+static portMUX_TYPE canhealth_mux = portMUX_INITIALIZER_UNLOCKED;  // Bus load
+static TaskHandle_t canhealth_task_handle = nullptr;
+
+/*******************************************************************
+ * Bus load clock, microseconds
+ *******************************************************************/
+static uint32_t CANHEALTH_clock(void) {
+  return (uint32_t)micros();
+}
+
+/*******************************************************************
+ * Frames on the bus, from the channel tasks
+ *******************************************************************/
+void CANHEALTH_observe(can_channel_t channel, uint32_t id, bool ext, bool rtr, uint8_t length, const uint8_t *data) {
+  CAN_frame_t frame;
+
+  if (channel >= CAN_NUM_CHANNELS) {
+    return;
+  }
+
+  frame.id = id;
+  frame.ext = ext ? 1 : 0;
+  frame.rtr = rtr ? 1 : 0;
+  frame.length = (length > sizeof(frame.data)) ? sizeof(frame.data) : length;
+  if (data && !rtr) {
+    memcpy(frame.data, data, frame.length);
+  }
+
+  const uint16_t bits = HEALTH_frame_bits(&frame);
+
+  portENTER_CRITICAL(&canhealth_mux);
+  HEALTH_load_add(&canhealth_channels[channel].load, bits, CANHEALTH_clock());
+  portEXIT_CRITICAL(&canhealth_mux);
+}
+
+/*******************************************************************
+ * Channel access
+ *******************************************************************/
+static int CANHEALTH_status(can_channel_t channel, HEALTH_status_t *status) {
+  return (channel == CAN_CHANNEL_TWAI) ? TWAI_bus_status(status) : MCP1_bus_status(status);
+}
+
+static uint32_t CANHEALTH_bitrate(can_channel_t channel) {
+  return (channel == CAN_CHANNEL_TWAI) ? TWAI_baudrate() : MCP1_baudrate();
+}
+
+/*******************************************************************
+ * Bus-off handling. The TWAI controller stays bus-off until the
+ * recovery is started, then stops and is started again. The MCP2515
+ * recovers by itself and is held in configuration mode instead.
+ *******************************************************************/
+static void CANHEALTH_recovery(can_channel_t channel, uint32_t now) {
+  canhealth_channel_t *ch = &canhealth_channels[channel];
+
+  switch (ch->status.state) {
+    case HEALTH_BUS_OFF:
+      if (!ch->backoff.pending) {
+        Serial.printf("CAN %s bus-off, recovery in %u ms.\n", ch->name, (unsigned)ch->backoff.delay);
+      }
+      HEALTH_backoff_bus_off(&ch->backoff, now);
+      if (channel == CAN_CHANNEL_MCP1) {
+        MCP1_bus_hold();
+      }
+      break;
+
+    case HEALTH_RECOVERING:
+      if ((channel == CAN_CHANNEL_TWAI) && !ch->backoff.pending) {
+        TWAI_bus_recover();  // Starts a stopped controller
+      }
+      break;
+
+    default:
+      HEALTH_backoff_ok(&ch->backoff, now);
+      break;
+  }
+
+  if (HEALTH_backoff_due(&ch->backoff, now)) {
+    const int result = (channel == CAN_CHANNEL_TWAI) ? TWAI_bus_recover() : MCP1_bus_recover();
+    Serial.printf("CAN %s bus-off recovery %s.\n", ch->name, (result == ESP_OK) ? "started" : "failed");
+  }
+}
+
+/********************************************************************
+ * Create JSON data
+ *******************************************************************/
+static JsonDocument CANHEALTH_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  JsonArray channels = doc[JSON_CANHEALTH_CHANNELS].to<JsonArray>();
+  for (int i = 0; i < CAN_NUM_CHANNELS; i++) {
+    const canhealth_channel_t *ch = &canhealth_channels[i];
+    JsonObject obj = channels.add<JsonObject>();
+
+    obj[JSON_CANHEALTH_CHANNEL] = ch->name;
+    obj[JSON_CANHEALTH_ACTIVE] = ch->active;
+    if (!ch->active) {
+      continue;
+    }
+
+    obj[JSON_CANHEALTH_BITRATE] = ch->load.bitrate;
+    obj[JSON_CANHEALTH_LOAD] = ch->load.load / 10.0;
+    obj[JSON_CANHEALTH_LOAD_MAX] = ch->load.load_max / 10.0;
+    obj[JSON_CANHEALTH_FRAME_RATE] = ch->load.frame_rate;
+    obj[JSON_CANHEALTH_STATE] = HEALTH_state_name(ch->status.state);
+    obj[JSON_CANHEALTH_VERDICT] = HEALTH_verdict_name(ch->verdict);
+
+    if (ch->status.tec != HEALTH_COUNTER_UNKNOWN) {
+      obj[JSON_CANHEALTH_TEC] = ch->status.tec;
+      obj[JSON_CANHEALTH_REC] = ch->status.rec;
+      obj[JSON_CANHEALTH_TEC_TREND] = HEALTH_errors_trend(&ch->errors, true);
+      obj[JSON_CANHEALTH_REC_TREND] = HEALTH_errors_trend(&ch->errors, false);
+      obj[JSON_CANHEALTH_TEC_MAX] = ch->errors.tec_max;
+      obj[JSON_CANHEALTH_REC_MAX] = ch->errors.rec_max;
+    }
+    obj[JSON_CANHEALTH_BUS_ERRORS] = ch->errors.bus_errors;
+
+    JsonObject entered = obj[JSON_CANHEALTH_ENTERED].to<JsonObject>();
+    for (int s = 0; s < HEALTH_NUM_STATES; s++) {
+      entered[HEALTH_state_name((HEALTH_state_t)s)] = ch->errors.entered[s];
+    }
+
+    obj[JSON_CANHEALTH_BUS_OFFS] = ch->backoff.bus_offs;
+    obj[JSON_CANHEALTH_RECOVERIES] = ch->backoff.recoveries;
+    obj[JSON_CANHEALTH_BACKOFF] = ch->backoff.delay;
+  }
+
+  return doc;
+}
+
+/********************************************************************
+ * Websocket, flat values that change
+ *******************************************************************/
+static void CANHEALTH_publish(void) {
+  JsonDocument doc;
+
+  for (int i = 0; i < CAN_NUM_CHANNELS; i++) {
+    const canhealth_channel_t *ch = &canhealth_channels[i];
+    const String key = String("can_") + ch->name + "_";
+
+    if (!ch->active) {
+      continue;
+    }
+
+    doc[key + "load"] = ch->load.load / 10.0;
+    doc[key + "state"] = HEALTH_state_name(ch->status.state);
+    doc[key + "verdict"] = HEALTH_verdict_name(ch->verdict);
+    doc[key + "bus_offs"] = ch->backoff.bus_offs;
+  }
+
+  WEBSOCKET_update_doc(doc);
+}
+
+/*******************************************************************
+ * Monitor task
+ *******************************************************************/
+static void CANHEALTH_task(void *parameter) {
+  uint32_t periods = 0;
+  (void)parameter;
+
+  while (true) {
+    vTaskDelay(CANHEALTH_PERIOD_MS / portTICK_PERIOD_MS);
+
+    const bool sample = (++periods % CANHEALTH_SAMPLE_PERIODS) == 0;
+    const uint32_t now = millis();
+
+    for (int i = 0; i < CAN_NUM_CHANNELS; i++) {
+      const can_channel_t channel = (can_channel_t)i;
+      canhealth_channel_t *ch = &canhealth_channels[i];
+      const uint32_t bitrate = CANHEALTH_bitrate(channel);
+
+      portENTER_CRITICAL(&canhealth_mux);
+      if (ch->load.bitrate != bitrate) {
+        HEALTH_load_init(&ch->load, bitrate, CANHEALTH_WINDOW_US, CANHEALTH_clock());
+      }
+      HEALTH_load_update(&ch->load, CANHEALTH_clock());  // Closes quiet windows
+      portEXIT_CRITICAL(&canhealth_mux);
+
+      ch->active = (CANHEALTH_status(channel, &ch->status) == ESP_OK);
+      if (!ch->active) {
+        continue;
+      }
+
+      CANHEALTH_recovery(channel, now);
+
+      if (sample) {
+        HEALTH_errors_add(&ch->errors, &ch->status);
+        ch->verdict = HEALTH_diagnose(&ch->load, &ch->errors);
+      }
+    }
+
+    if (sample) {
+      CANHEALTH_publish();
+    }
+  }
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String CANHEALTH_info_str(void) {
+  char line[120];
+
+  String text = "--- CAN health ---";
+
+  for (int i = 0; i < CAN_NUM_CHANNELS; i++) {
+    const canhealth_channel_t *ch = &canhealth_channels[i];
+
+    if (!ch->active) {
+      snprintf(line, sizeof(line), "\r\n%s: not active", ch->name);
+      text.concat(line);
+      continue;
+    }
+
+    snprintf(line, sizeof(line), "\r\n%s: %u kbit/s, load %u.%u%% (max %u.%u%%), %u frames/s",
+             ch->name, (unsigned)(ch->load.bitrate / 1000), ch->load.load / 10, ch->load.load % 10,
+             ch->load.load_max / 10, ch->load.load_max % 10, (unsigned)ch->load.frame_rate);
+    text.concat(line);
+
+    snprintf(line, sizeof(line), "\r\n  State: %s, verdict: %s, bus errors: %u",
+             HEALTH_state_name(ch->status.state), HEALTH_verdict_name(ch->verdict), (unsigned)ch->errors.bus_errors);
+    text.concat(line);
+
+    if (ch->status.tec != HEALTH_COUNTER_UNKNOWN) {
+      snprintf(line, sizeof(line), "\r\n  TEC: %u (trend %+d, max %u), REC: %u (trend %+d, max %u)",
+               ch->status.tec, HEALTH_errors_trend(&ch->errors, true), ch->errors.tec_max,
+               ch->status.rec, HEALTH_errors_trend(&ch->errors, false), ch->errors.rec_max);
+      text.concat(line);
+    }
+
+    snprintf(line, sizeof(line), "\r\n  Warning: %u, passive: %u, bus-off: %u, recoveries: %u, backoff: %u ms",
+             (unsigned)ch->errors.entered[HEALTH_ERROR_WARNING], (unsigned)ch->errors.entered[HEALTH_ERROR_PASSIVE],
+             (unsigned)ch->backoff.bus_offs, (unsigned)ch->backoff.recoveries, (unsigned)ch->backoff.delay);
+    text.concat(line);
+  }
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void CANHEALTH_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, CANHEALTH_json);
+}
+
+static rest_api_t CANHEALTH_api_handlers = {
+    /* uri */ "/api/v1/canhealth",
+    /* comment */ "CAN bus health",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ CANHEALTH_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(CANHEALTH_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    for (int i = 0; i < CAN_NUM_CHANNELS; i++) {
+      canhealth_channel_t *ch = &canhealth_channels[i];
+
+      portENTER_CRITICAL(&canhealth_mux);
+      ch->load.load_max = 0;
+      portEXIT_CRITICAL(&canhealth_mux);
+      HEALTH_errors_init(&ch->errors);
+      ch->backoff.bus_offs = 0;
+      ch->backoff.recoveries = 0;
+    }
+    CLI_println("CAN health statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: CANHEALTH (reset).");
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void CANHEALTH_setup(void) {
+  if (canhealth_task_handle) {
+    return;  // Already done
+  }
+
+  for (int i = 0; i < CAN_NUM_CHANNELS; i++) {
+    canhealth_channel_t *ch = &canhealth_channels[i];
+
+    HEALTH_load_init(&ch->load, 0, CANHEALTH_WINDOW_US, CANHEALTH_clock());
+    HEALTH_errors_init(&ch->errors);
+    HEALTH_backoff_init(&ch->backoff, CANHEALTH_BACKOFF_MS, CANHEALTH_BACKOFF_MAX_MS, CANHEALTH_STABLE_MS);
+  }
+
+  xTaskCreate(CANHEALTH_task, "CAN health", 4096, NULL, 3, &canhealth_task_handle);
+
+  cli.addBoundlessCmd("canhealth", clicb_handler);
+  setup_uri(&CANHEALTH_api_handlers);
+
+  Serial.println(F("CAN health setup completed..."));
+}
@@ -0,0 +1,331 @@
+/*******************************************************************
+ * CANSchedule.cpp
+ *
+ * Cyclic and one-shot CAN transmit schedule.
+ *
+ * One task owns the schedule (EBC_Utils) and sleeps until the next
+ * release, or until a one-shot frame is added. Due frames are
+ * handed to the transmit queue of their channel, most urgent first.
+ * A frame the channel can not queue is counted as failed, the task
+ * never blocks on a full queue so the other frames keep their
+ * timing. Jitter, deadline misses and the queue occupancy are
+ * reported per entry.
+ *
+ *******************************************************************/
+#include "CANSchedule.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <string.h>
+
+#include "CLI.h"
+#include "Config.h"
+#include "MCPCom.h"
+#include "TWAICom.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define US_PER_MS 1000
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static SCHED_table_t cansched_table;
+static SemaphoreHandle_t cansched_lock = nullptr;  // Schedule
+static TaskHandle_t cansched_task_handle = nullptr;
+
+static uint32_t cansched_failed[SCHED_MAX_ENTRIES];  // Channel queue full, cyclic entries
+static uint32_t cansched_once_sent = 0;
+static uint32_t cansched_once_failed = 0;
+static uint32_t cansched_once_missed = 0;
+static int cansched_pending_max[CAN_NUM_CHANNELS];
+
+/*******************************************************************
+ * Schedule clock, microseconds
+ *******************************************************************/
+static uint32_t CANSCHED_clock(void) {
+  return (uint32_t)micros();
+}
+
+static CAN_frame_t CANSCHED_frame(can_channel_t channel, uint32_t id, bool ext, uint8_t length, const uint8_t *data) {
+  CAN_frame_t frame = {};
+
+  frame.id = id;
+  frame.ext = ext ? 1 : 0;
+  frame.channel = channel;
+  frame.length = (length > sizeof(frame.data)) ? sizeof(frame.data) : length;
+  if (data && frame.length) {
+    memcpy(frame.data, data, frame.length);
+  }
+  return frame;
+}
+
+/*******************************************************************
+ * Add frames
+ *******************************************************************/
+int CANSCHED_add(const char *name, can_channel_t channel, uint32_t id, bool ext, uint8_t length,
+                 const uint8_t *data, uint32_t period_ms, uint32_t phase_ms, uint8_t priority,
+                 SCHED_produce_fn produce, void *context) {
+  CAN_frame_t frame = CANSCHED_frame(channel, id, ext, length, data);
+  int index;
+
+  CANSCHED_setup();
+
+  xSemaphoreTake(cansched_lock, portMAX_DELAY);
+  index = SCHED_add(&cansched_table, name, &frame, period_ms * US_PER_MS, phase_ms * US_PER_MS, priority,
+                    produce, context, CANSCHED_clock());
+  if (index >= 0) {
+    cansched_failed[index] = 0;
+  }
+  xSemaphoreGive(cansched_lock);
+
+  if (index < 0) {
+    Serial.printf("CAN schedule %s failed, table full.\n", name);
+    return index;
+  }
+
+  xTaskNotifyGive(cansched_task_handle);  // Recalculate the wait
+  return index;
+}
+
+int CANSCHED_send(can_channel_t channel, uint32_t id, bool ext, uint8_t length, const uint8_t *data,
+                  uint8_t priority, uint32_t deadline_ms) {
+  CAN_frame_t frame = CANSCHED_frame(channel, id, ext, length, data);
+  int index;
+
+  CANSCHED_setup();
+
+  xSemaphoreTake(cansched_lock, portMAX_DELAY);
+  index = SCHED_once(&cansched_table, &frame, priority, deadline_ms * US_PER_MS, CANSCHED_clock());
+  xSemaphoreGive(cansched_lock);
+
+  if (index < 0) {
+    return ESP_FAIL;
+  }
+
+  xTaskNotifyGive(cansched_task_handle);
+  return ESP_OK;
+}
+
+/*******************************************************************
+ * Channel transmit queue
+ *******************************************************************/
+static int CANSCHED_transmit(const CAN_frame_t *frame) {
+  int result;
+  int pending;
+
+  switch (frame->channel) {
+    case CAN_CHANNEL_TWAI:
+      result = TWAI_send(frame->id, frame->data, frame->length, frame->rtr, frame->ext);
+      pending = TWAI_tx_pending();
+      break;
+
+    case CAN_CHANNEL_MCP1:
+      result = MCP1_send(frame->id, frame->data, frame->length, frame->rtr, frame->ext);
+      pending = MCP1_tx_pending();
+      break;
+
+    default:
+      return ESP_FAIL;
+  }
+
+  if (pending > cansched_pending_max[frame->channel]) {
+    cansched_pending_max[frame->channel] = pending;
+  }
+  return result;
+}
+
+/*******************************************************************
+ * Scheduler task, sends all due frames, then sleeps until the next
+ * release or a notification
+ *******************************************************************/
+static void CANSCHED_task(void *parameter) {
+  CAN_frame_t frame;
+  uint32_t wait;
+  (void)parameter;
+
+  while (true) {
+    xSemaphoreTake(cansched_lock, portMAX_DELAY);
+
+    int index;
+    while ((index = SCHED_next(&cansched_table, CANSCHED_clock(), &frame)) >= 0) {
+      const SCHED_entry_t *entry = &cansched_table.entry[index];
+      const bool failed = CANSCHED_transmit(&frame) != ESP_OK;
+
+      if (entry->period) {
+        cansched_failed[index] += failed ? 1 : 0;
+      } else {
+        cansched_once_sent++;
+        cansched_once_failed += failed ? 1 : 0;
+        cansched_once_missed += entry->missed;  // Freed, statistics are still in the slot
+      }
+    }
+
+    wait = SCHED_wait(&cansched_table, CANSCHED_clock());
+    xSemaphoreGive(cansched_lock);
+
+    if (wait == SCHED_IDLE) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    } else if (wait) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((wait + US_PER_MS - 1) / US_PER_MS));
+    }
+  }
+}
+
+/********************************************************************
+ * Create JSON data
+ *******************************************************************/
+static JsonDocument CANSCHED_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  xSemaphoreTake(cansched_lock, portMAX_DELAY);
+  doc[JSON_CANSCHED_BACKLOG_MAX] = cansched_table.backlog_max;
+  doc[JSON_CANSCHED_ONCE_SENT] = cansched_once_sent;
+  doc[JSON_CANSCHED_ONCE_FAILED] = cansched_once_failed;
+  doc[JSON_CANSCHED_ONCE_MISSED] = cansched_once_missed;
+
+  JsonObject pending = doc[JSON_CANSCHED_TX_PENDING].to<JsonObject>();
+  pending["twai"] = TWAI_tx_pending();
+  pending["mcp"] = MCP1_tx_pending();
+
+  JsonObject pending_max = doc[JSON_CANSCHED_TX_PENDING_MAX].to<JsonObject>();
+  pending_max["twai"] = cansched_pending_max[CAN_CHANNEL_TWAI];
+  pending_max["mcp"] = cansched_pending_max[CAN_CHANNEL_MCP1];
+
+  JsonArray entries = doc[JSON_CANSCHED_ENTRIES].to<JsonArray>();
+  for (uint8_t i = 0; i < cansched_table.num_entries; i++) {
+    const SCHED_entry_t *entry = &cansched_table.entry[i];
+    JsonObject obj;
+
+    if (!entry->active || !entry->period) {
+      continue;
+    }
+
+    obj = entries.add<JsonObject>();
+    obj["name"] = entry->name;
+    obj["id"] = entry->frame.id;
+    obj["channel"] = (entry->frame.channel == CAN_CHANNEL_MCP1) ? "mcp" : "twai";
+    obj["period-ms"] = entry->period / US_PER_MS;
+    obj["priority"] = entry->priority;
+    obj["sent"] = entry->sent;
+    obj["missed"] = entry->missed;
+    obj["skipped"] = entry->skipped;
+    obj["failed"] = cansched_failed[i];
+    obj["jitter-last-us"] = entry->jitter_last;
+    obj["jitter-max-us"] = entry->jitter_max;
+    obj["jitter-avg-us"] = (entry->sent > 1) ? (uint32_t)(entry->jitter_total / (entry->sent - 1)) : 0;
+  }
+  xSemaphoreGive(cansched_lock);
+
+  return doc;
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String CANSCHED_info_str(void) {
+  JsonDocument doc = CANSCHED_json();
+  char line[140];
+
+  String text = "--- CAN schedule ---";
+
+  text.concat("\r\nBacklog max: ");
+  text.concat(doc[JSON_CANSCHED_BACKLOG_MAX].as<int>());
+
+  text.concat("\r\nOne-shot sent: ");
+  text.concat(doc[JSON_CANSCHED_ONCE_SENT].as<int>());
+  text.concat(", failed: ");
+  text.concat(doc[JSON_CANSCHED_ONCE_FAILED].as<int>());
+  text.concat(", missed: ");
+  text.concat(doc[JSON_CANSCHED_ONCE_MISSED].as<int>());
+
+  text.concat("\r\nTX pending TWAI: ");
+  text.concat(doc[JSON_CANSCHED_TX_PENDING]["twai"].as<int>());
+  text.concat(" (max ");
+  text.concat(doc[JSON_CANSCHED_TX_PENDING_MAX]["twai"].as<int>());
+  text.concat("), MCP: ");
+  text.concat(doc[JSON_CANSCHED_TX_PENDING]["mcp"].as<int>());
+  text.concat(" (max ");
+  text.concat(doc[JSON_CANSCHED_TX_PENDING_MAX]["mcp"].as<int>());
+  text.concat(")");
+
+  for (JsonObject obj : doc[JSON_CANSCHED_ENTRIES].as<JsonArray>()) {
+    snprintf(line, sizeof(line),
+             "\r\n%-12s %-4s id 0x%08X %ums prio %u: %u sent, %u missed, %u skipped, %u failed, jitter %u/%u/%uus (last/avg/max)",
+             obj["name"].as<const char *>(), obj["channel"].as<const char *>(), obj["id"].as<unsigned>(),
+             obj["period-ms"].as<unsigned>(), obj["priority"].as<unsigned>(), obj["sent"].as<unsigned>(),
+             obj["missed"].as<unsigned>(), obj["skipped"].as<unsigned>(), obj["failed"].as<unsigned>(),
+             obj["jitter-last-us"].as<unsigned>(), obj["jitter-avg-us"].as<unsigned>(),
+             obj["jitter-max-us"].as<unsigned>());
+    text.concat(line);
+  }
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void CANSCHED_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, CANSCHED_json);
+}
+
+static rest_api_t CANSCHED_api_handlers = {
+    /* uri */ "/api/v1/cansched",
+    /* comment */ "CAN transmit schedule",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ CANSCHED_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(CANSCHED_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    xSemaphoreTake(cansched_lock, portMAX_DELAY);
+    SCHED_reset_stats(&cansched_table);
+    memset(cansched_failed, 0, sizeof(cansched_failed));
+    memset(cansched_pending_max, 0, sizeof(cansched_pending_max));
+    cansched_once_sent = 0;
+    cansched_once_failed = 0;
+    cansched_once_missed = 0;
+    xSemaphoreGive(cansched_lock);
+    CLI_println("CAN schedule statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: CANSCHED (reset).");
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void CANSCHED_setup(void) {
+  if (cansched_lock) {
+    return;  // Already done
+  }
+
+  cansched_lock = xSemaphoreCreateMutex();
+  SCHED_init(&cansched_table);
+
+  xTaskCreate(CANSCHED_task, "CAN schedule", 3072, NULL, 5, &cansched_task_handle);
+
+  cli.addBoundlessCmd("cansched", clicb_handler);
+  setup_uri(&CANSCHED_api_handlers);
+
+  Serial.println(F("CAN schedule setup completed..."));
+}
@@ -31,6 +31,16 @@ void cli_set_output(cli_output_t value)
   cli_output = value;
 }
 
+/*******************************************************************
+ * Serial console, released while a gateway owns UART0
+ *******************************************************************/
+static volatile bool cli_serial = true;
+
+void CLI_serial_enable(bool enable)
+{
+  cli_serial = enable;
+}
+
 /*******************************************************************
  * Calibration commandline handler
  *******************************************************************/
@@ -63,7 +73,8 @@ void CLI_print(String txt)
   }
 
   // Default output channel (CLI_SERIAL)
-  Serial.print(txt);
+  if (cli_serial)
+    Serial.print(txt);
 }
 
 void CLI_println(String txt)
@@ -152,7 +163,7 @@ static void CLI_serial_task(void *parameter)
   {
     vTaskDelay(200 / portTICK_PERIOD_MS);
 
-    while (Serial.available())
+    while (cli_serial && Serial.available())
     {
       inChar = Serial.read();
       switch (inChar)
@@ -0,0 +1,215 @@
+/*******************************************************************
+ * Calibration.cpp
+ *
+ * Typed in-RAM calibration and configuration registry.
+ *
+ * Values are loaded once from storage, control loops read them
+ * from RAM without JSON lookups. JSON is only used for persistence
+ * (Storage) and by the REST/websocket/CLI boundary of the modules.
+ *
+ *******************************************************************/
+#include "Calibration.h"
+
+#include <Arduino.h>
+#include <esp_err.h>
+
+#include "Azimuth.h"
+#include "Controller.h"
+#include "EBC_IOLib.h"
+#include "EBC_Utils.h"
+#include "Lift.h"
+#include "SteeringWheel.h"
+#include "Storage.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#undef DEBUG_CALIBRATION
+
+#define CALIBRATION_MAX_CALLBACKS 4
+
+/*******************************************************************
+ * Type definitions
+ *******************************************************************/
+typedef struct {
+  const char *key;  // Storage key
+  int preset;       // Default
+  int min;
+  int max;
+} calibration_info_t;
+
+/*******************************************************************
+ * Field table, same order as calibration_field_t
+ *******************************************************************/
+static const calibration_info_t calibration_info[CAL_NUM_FIELDS] = {
+    /* CAL_STEERWHEEL_LEFT */ {JSON_STEERWHEEL_LEFT, ADC_MAX, ADC_MIN, ADC_MAX},
+    /* CAL_STEERWHEEL_MIDDLE */ {JSON_STEERWHEEL_MIDDLE, (ADC_MIN + ADC_MAX) / 2, ADC_MIN, ADC_MAX},
+    /* CAL_STEERWHEEL_RIGHT */ {JSON_STEERWHEEL_RIGHT, ADC_MIN, ADC_MIN, ADC_MAX},
+    /* CAL_STEERWHEEL_DEADBAND */ {JSON_STEERWHEEL_DEADBAND, 2, ADC_MIN, ADC_MAX},
+    /* CAL_STEERWHEEL_HYSTERESIS */ {JSON_STEERWHEEL_HYSTERESIS, 2, ADC_MIN, ADC_MAX},
+    /* CAL_STEERWHEEL_MEDIAN */ {JSON_STEERWHEEL_MEDIAN, 3, 0, FILTER_MEDIAN_MAX},
+    /* CAL_STEERWHEEL_IIR */ {JSON_STEERWHEEL_IIR, 500, 1, 1000},
+    /* CAL_STEERWHEEL_RATE_LIMIT */ {JSON_STEERWHEEL_RATE_LIMIT, 0, 0, ADC_MAX},
+    /* CAL_AZIMUTH_LOW */ {JSON_AZIMUTH_LOW, DAC_MIN, DAC_MIN, DAC_MAX},
+    /* CAL_AZIMUTH_MIDDLE */ {JSON_AZIMUTH_MIDDLE, (DAC_MIN + DAC_MAX) / 2, DAC_MIN, DAC_MAX},
+    /* CAL_AZIMUTH_HIGH */ {JSON_AZIMUTH_HIGH, DAC_MAX, DAC_MIN, DAC_MAX},
+    /* CAL_AZIMUTH_TIMEOUT */ {JSON_AZIMUTH_TIMEOUT_TO_MIDDLE, 5, 0, 120},
+    /* CAL_LIFT_MOVE_TIMEOUT */ {JSON_LIFT_MOVE_TIMEOUT, DELFAULT_LIFT_MOVE_TIMEOUT, 3, 120},
+    /* CAL_STEERING_RATE */ {JSON_STEERING_RATE, STEERING_RATE_DEFAULT, STEERING_RATE_MIN, STEERING_RATE_MAX},
+};
+
+/*******************************************************************
+ * Globals
+ *******************************************************************/
+static calibration_t calibration;
+static portMUX_TYPE calibration_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static calibration_change_fn calibration_callbacks[CALIBRATION_MAX_CALLBACKS];
+static int calibration_num_callbacks = 0;
+
+/*******************************************************************
+ * Field information
+ *******************************************************************/
+const char *CALIBRATION_key(calibration_field_t field) {
+  return calibration_info[field].key;
+}
+
+int CALIBRATION_min(calibration_field_t field) {
+  return calibration_info[field].min;
+}
+
+int CALIBRATION_max(calibration_field_t field) {
+  return calibration_info[field].max;
+}
+
+/*******************************************************************
+ * Read
+ *******************************************************************/
+int CALIBRATION_get(calibration_field_t field) {
+  return calibration.value[field];  // Aligned int, single read
+}
+
+void CALIBRATION_snapshot(calibration_t *snapshot) {
+  portENTER_CRITICAL(&calibration_mux);
+  *snapshot = calibration;
+  portEXIT_CRITICAL(&calibration_mux);
+}
+
+/*******************************************************************
+ * Write
+ *******************************************************************/
+static void CALIBRATION_notify(uint32_t changed, const calibration_t *values) {
+  for (int i = 0; i < calibration_num_callbacks; i++) {
+    calibration_callbacks[i](changed, values);
+  }
+}
+
+int CALIBRATION_update(const calibration_t *values, uint32_t mask, bool persist) {
+  const char *keys[CAL_NUM_FIELDS];
+  int stored[CAL_NUM_FIELDS];
+  int num_stored = 0;
+  uint32_t changed = 0;
+  calibration_t current;
+
+  // Validate all fields before applying any
+  for (int field = 0; field < CAL_NUM_FIELDS; field++) {
+    const calibration_info_t *info = &calibration_info[field];
+
+    if ((mask & CALIBRATION_MASK(field)) &&
+        ((values->value[field] < info->min) || (values->value[field] > info->max))) {
+      return ESP_FAIL;
+    }
+  }
+
+  portENTER_CRITICAL(&calibration_mux);
+  for (int field = 0; field < CAL_NUM_FIELDS; field++) {
+    if ((mask & CALIBRATION_MASK(field)) && (calibration.value[field] != values->value[field])) {
+      calibration.value[field] = values->value[field];
+      changed |= CALIBRATION_MASK(field);
+    }
+  }
+  current = calibration;
+  portEXIT_CRITICAL(&calibration_mux);
+
+  if (persist) {
+    for (int field = 0; field < CAL_NUM_FIELDS; field++) {
+      if (mask & CALIBRATION_MASK(field)) {
+        keys[num_stored] = calibration_info[field].key;
+        stored[num_stored++] = values->value[field];
+      }
+    }
+    STORAGE_set_ints(keys, stored, num_stored);
+  }
+
+#ifdef DEBUG_CALIBRATION
+  Serial.printf("Calibration mask %08x changed %08x%s.\n", (unsigned)mask, (unsigned)changed,
+                persist ? " (stored)" : "");
+#endif
+
+  if (changed) {
+    CALIBRATION_notify(changed, &current);
+  }
+  return ESP_OK;
+}
+
+int CALIBRATION_set(calibration_field_t field, int value, bool persist) {
+  calibration_t values;
+
+  values.value[field] = value;
+  return CALIBRATION_update(&values, CALIBRATION_MASK(field), persist);
+}
+
+void CALIBRATION_restore(uint32_t mask) {
+  calibration_t values;
+  uint32_t restore = 0;
+
+  for (int field = 0; field < CAL_NUM_FIELDS; field++) {
+    if ((mask & CALIBRATION_MASK(field)) && !STORAGE_get_int(calibration_info[field].key, values.value[field])) {
+      restore |= CALIBRATION_MASK(field);
+    }
+  }
+  if (restore) {
+    CALIBRATION_update(&values, restore, false);
+  }
+}
+
+int CALIBRATION_on_change(calibration_change_fn callback) {
+  if (calibration_num_callbacks >= CALIBRATION_MAX_CALLBACKS) {
+    return ESP_FAIL;
+  }
+  calibration_callbacks[calibration_num_callbacks++] = callback;
+  return ESP_OK;
+}
+
+/*******************************************************************
+ * Setup variables
+ *******************************************************************/
+static void CALIBRATION_setup_variables(void) {
+  const char *keys[CAL_NUM_FIELDS];
+  int presets[CAL_NUM_FIELDS];
+  int num_presets = 0;
+  int value;
+
+  for (int field = 0; field < CAL_NUM_FIELDS; field++) {
+    const calibration_info_t *info = &calibration_info[field];
+
+    if (STORAGE_get_int(info->key, value) || (value < info->min) || (value > info->max)) {
+      value = info->preset;
+      keys[num_presets] = info->key;
+      presets[num_presets++] = value;
+    }
+    calibration.value[field] = value;
+  }
+  if (num_presets) {
+    STORAGE_set_ints(keys, presets, num_presets);
+  }
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void CALIBRATION_setup(void) {
+  CALIBRATION_setup_variables();
+
+  Serial.println(F("Calibration setup completed..."));
+}
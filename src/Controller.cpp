@@ -8,20 +8,24 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <StateMachineLib.h>
+#include <StaticStateMachine.h>
 #include <endian.h>
 #include <esp_err.h>
+#include <esp_timer.h>
 
 #include "Azimuth.h"
 #include "CLI.h"
+#include "Calibration.h"
 #include "Config.h"
 #include "DMC.h"
 #include "EBC_IOLib.h"
+#include "EBC_Utils.h"
 #include "GPIO.h"
 #include "Lift.h"
 #include "Maintenance.h"
 #include "SteeringWheel.h"
 #include "Storage.h"
+#include "WebServer.h"
 
 /*******************************************************************
  * Constants
@@ -30,6 +34,10 @@
 
 #define SEC_TO_MS 1000
 
+/* Fallback tick, edges on sensors, buttons and e-stop wake the task directly */
+#define CONTROLLER_TICK_MS 200
+#define CONTROLLER_OUTPUT_REFRESH_MS 1000  // Re-assert the PCF8574 outputs
+
 /*******************************************************************
  * Storage keys and defaults
  *******************************************************************/
@@ -48,14 +56,14 @@ enum VEDOUTStateIds {
   CONTROLLER_extending,
   CONTROLLER_no_position,
   CONTROLLER_emergency_stop,
-  CONTROLLER_maintenance
+  CONTROLLER_maintenance,
+  CONTROLLER_NUM_STATES
 };
 
 /*******************************************************************
  * Global variables
  *******************************************************************/
 static JsonDocument controller_data;
-static StateMachine stateMachine(9, 26);
 
 /* timers */
 static unsigned long Homing_timer = 0;
@@ -66,6 +74,43 @@ static unsigned long calibrating_timer = 0;
 
 static bool request_maintenance_enable = false;
 
+/* Event wakeup */
+static TaskHandle_t controller_task_handle = NULL;
+static portMUX_TYPE controller_edge_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile int64_t controller_edge_us = 0;  // Oldest unhandled edge
+static int64_t controller_handled_edge_us = 0;   // Edge of the current Update()
+
+/* Steering control loop */
+static TaskHandle_t steering_task_handle = NULL;
+static esp_timer_handle_t steering_timer = NULL;
+static int steering_period_us = 1000000 / STEERING_RATE_DEFAULT;
+
+static STEERING_lut_t steering_lut;           // Wheel ADC to azimuth DAC
+static volatile bool steering_lut_dirty = true;
+
+typedef struct {
+  uint32_t cycles;
+  uint32_t jitter_last_us;
+  uint32_t jitter_max_us;
+  uint32_t exec_last_us;
+  uint32_t exec_max_us;
+  uint32_t overruns;  // Execution longer than the period
+  uint32_t missed;    // Timer ticks not served
+  uint32_t lut_builds;
+  uint32_t lut_build_us;
+} steering_stats_t;
+
+static steering_stats_t steering_stats;
+
+/* Reaction time statistics (edge to SetState) */
+static volatile uint32_t controller_wakeups = 0;
+static int64_t controller_reaction_last_us = 0;
+static int64_t controller_reaction_max_us = 0;
+
+static const char *controller_state_names[] = {
+    "INIT", "RETRACTED", "RETRACTING", "HOMING", "EXTENDED",
+    "EXTENDING", "NO-POSITION", "EMERGENCY-STOP", "MAINTENANCE"};
+
 /*******************************************************************
  * Timers
  *******************************************************************/
@@ -100,6 +145,46 @@ static bool CONTROLLER_maintenance_requested(void) {
   return false;
 }
 
+/*******************************************************************
+ * Event wakeup
+ *
+ * Keeps the timestamp of the first edge since the last statemachine
+ * update, the reaction time is measured from that edge until
+ * SetState() is called (the OnLeaving action of every state).
+ *******************************************************************/
+void ARDUINO_ISR_ATTR CONTROLLER_wakeup_from_isr(void) {
+  BaseType_t woken = pdFALSE;
+
+  portENTER_CRITICAL_ISR(&controller_edge_mux);
+  if (controller_edge_us == 0)
+    controller_edge_us = esp_timer_get_time();
+  portEXIT_CRITICAL_ISR(&controller_edge_mux);
+
+  controller_wakeups++;
+
+  if (controller_task_handle) {
+    vTaskNotifyGiveFromISR(controller_task_handle, &woken);
+    if (woken)
+      portYIELD_FROM_ISR();
+  }
+}
+
+static void CONTROLLER_take_edge(void) {
+  portENTER_CRITICAL(&controller_edge_mux);
+  controller_handled_edge_us = controller_edge_us;
+  controller_edge_us = 0;
+  portEXIT_CRITICAL(&controller_edge_mux);
+}
+
+static void fnStateLeaving() {
+  if (controller_handled_edge_us) {
+    controller_reaction_last_us = esp_timer_get_time() - controller_handled_edge_us;
+    if (controller_reaction_last_us > controller_reaction_max_us)
+      controller_reaction_max_us = controller_reaction_last_us;
+    controller_handled_edge_us = 0;
+  }
+}
+
 /*******************************************************************
  * Controller Initializiation State
  *******************************************************************/
@@ -107,6 +192,7 @@ static void fnStateInit() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: INIT.");
 #endif
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
@@ -114,6 +200,7 @@ static void fnStateInit() {
   LIFT_disable();
   LIFT_UP_off();
   LIFT_DOWN_off();
+  PCF8574_commit();
 }
 
 static bool fnInitToNoPosition() {
@@ -127,9 +214,12 @@ static void fnStateHoming() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: HOMING");
 #endif
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
+  PCF8574_commit();
+
   TIMER_start(Homing_timer, AZIMUTH_get_timeout());
 }
 
@@ -159,6 +249,7 @@ static void fnStateRetracting() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: RETRACTING");
 #endif
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
@@ -166,6 +257,7 @@ static void fnStateRetracting() {
   LIFT_enable();
   LIFT_UP_on();
   LIFT_DOWN_off();
+  PCF8574_commit();
 
   TIMER_start(retracting_timer, LIFT_move_timeout());
 }
@@ -195,10 +287,12 @@ static void fnStateRetracted() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: RETRACTED");
 #endif
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   LIFT_disable();
   LIFT_UP_off();
   LIFT_DOWN_off();
+  PCF8574_commit();
 
   LIFT_retected_increment();
 }
@@ -224,6 +318,7 @@ static void fnStateExtending() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: EXTENDING");
 #endif
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
@@ -231,6 +326,7 @@ static void fnStateExtending() {
   LIFT_enable();
   LIFT_UP_off();
   LIFT_DOWN_on();
+  PCF8574_commit();
 
   TIMER_start(extending_timer, LIFT_move_timeout());
 }
@@ -260,10 +356,12 @@ static void fnStateExtended() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: EXTENDED");
 #endif
+  PCF8574_begin(PCF8574_address);
   LIFT_UP_off();
   LIFT_DOWN_off();
 
   DMC_enable();
+  PCF8574_commit();
 
   AZIMUTH_analog_enable();
   vTaskDelay(500 / portTICK_PERIOD_MS);
@@ -293,6 +391,7 @@ static void fnStateNoPosition() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: NO-POSITION");
 #endif
+  PCF8574_begin(PCF8574_address);
   LIFT_UP_off();
   LIFT_DOWN_off();
 
@@ -302,6 +401,7 @@ static void fnStateNoPosition() {
     AZIMUTH_disable();
     AZIMUTH_analog_disable();
   }
+  PCF8574_commit();
 }
 
 static bool fnNoPositionToExtended() {
@@ -339,6 +439,7 @@ static void fnStateEmergencyStop() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: EMERGENCY-STOP");
 #endif
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
@@ -346,17 +447,19 @@ static void fnStateEmergencyStop() {
   LIFT_disable();
   LIFT_UP_off();
   LIFT_DOWN_off();
+  PCF8574_commit();
 
   // TODO: Set error emergency stop
 }
 
 static bool fnAnyToEmergencyStop() {
-  return EMERGENCY_STOP_active();
+  return EMERGENCY_STOP_active() || EMERGENCY_STOP_latched();
 }
 
 static bool fnEmergencyStopToNoPosition() {
   if (!EMERGENCY_STOP_active()) {
     // TODO: Clear error not calibrated
+    EMERGENCY_STOP_clear();
     return true;
   }
   return false;
@@ -369,6 +472,7 @@ static void fnStateMaintenace() {
 #ifdef DEBUG_CONTROLLER
   Serial.println("Enter state: MAINTENANCE-MODE");
 #endif
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
@@ -378,6 +482,7 @@ static void fnStateMaintenace() {
   LIFT_DOWN_off();
 
   MAINTENANCE_enable();  // Start maintenance mode
+  PCF8574_commit();
 }
 
 static bool fnMaintenanceToNoPosition() {
@@ -401,31 +506,213 @@ static bool fnAnyToMantenance() {
  * linearisation (left > ADC_MIDDLE-1 and  ADC_MIDDLE > right).
  *******************************************************************/
 static void CONTROLLER_update_steering() {
+  if (!STEERWHEEL_ready()) {
+    return;  // No steering wheel data, don't drive
+  }
+
   if (LIFT_DOWN_sensor()) {
     if (AZIMUTH_enabled() && AZIMUTH_analog_enabled()) {
 
-      long value = STEERWHEEL_get_linear();
-      AZIMUTH_set_steering(value);
-      AZIMUTH_set_actual(value);
+      int adc = STEERWHEEL_get_actual();
+      AZIMUTH_set_output(steering_lut.dac[adc], steering_lut.linear[adc]);
     }
   }
 }
 
+/*******************************************************************
+ * Steering lookup table
+ *
+ * Rebuilt by the steering loop after a calibration change.
+ *******************************************************************/
+static void CONTROLLER_steering_invalidate(void) {
+  steering_lut_dirty = true;
+}
+
+static void CONTROLLER_steering_build_lut(void) {
+  int64_t start_us = esp_timer_get_time();
+
+  steering_lut_dirty = false;  // Before reading, a change during the build rebuilds again
+
+  calibration_t cal;
+  CALIBRATION_snapshot(&cal);  // One consistent set of values
+
+  STEERING_wheel_cal_t wheel = {cal.value[CAL_STEERWHEEL_LEFT], cal.value[CAL_STEERWHEEL_MIDDLE],
+                                cal.value[CAL_STEERWHEEL_RIGHT]};
+  STEERING_azimuth_cal_t azimuth = {cal.value[CAL_AZIMUTH_LOW], cal.value[CAL_AZIMUTH_MIDDLE],
+                                    cal.value[CAL_AZIMUTH_HIGH]};
+  STEERING_lut_build(&steering_lut, &wheel, &azimuth);
+
+  steering_stats.lut_builds++;
+  steering_stats.lut_build_us = (uint32_t)(esp_timer_get_time() - start_us);
+}
+
+/*******************************************************************
+ * Steering control loop
+ *
+ * Fixed rate task on the application core, released by a periodic
+ * esp_timer. Each cycle samples the steering wheel, linearises and
+ * writes the azimuth DAC.
+ *******************************************************************/
+static void CONTROLLER_steering_tick(void *arg) {
+  (void)arg;
+  xTaskNotifyGive(steering_task_handle);
+}
+
+static void CONTROLLER_steering_stats(int64_t wakeup_us, int64_t &previous_us, uint32_t pending) {
+  int64_t exec_us = esp_timer_get_time() - wakeup_us;
+
+  steering_stats.cycles++;
+  if (pending > 1)
+    steering_stats.missed += pending - 1;
+
+  if (previous_us) {
+    int64_t jitter = (wakeup_us - previous_us) - steering_period_us;
+    steering_stats.jitter_last_us = (uint32_t)(jitter < 0 ? -jitter : jitter);
+    if (steering_stats.jitter_last_us > steering_stats.jitter_max_us)
+      steering_stats.jitter_max_us = steering_stats.jitter_last_us;
+  }
+  previous_us = wakeup_us;
+
+  steering_stats.exec_last_us = (uint32_t)exec_us;
+  if (steering_stats.exec_last_us > steering_stats.exec_max_us)
+    steering_stats.exec_max_us = steering_stats.exec_last_us;
+  if (exec_us > steering_period_us)
+    steering_stats.overruns++;
+}
+
+static void CONTROLLER_steering_task(void *parameter) {
+  (void)parameter;
+  int64_t previous_us = 0;
+
+  while (true) {
+    uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t wakeup_us = esp_timer_get_time();
+
+    STEERWHEEL_update();
+
+    if (steering_lut_dirty) {
+      CONTROLLER_steering_build_lut();
+    }
+
+    if (!MAINTENANCE_enabled()) {
+      CONTROLLER_update_steering();
+    }
+
+    CONTROLLER_steering_stats(wakeup_us, previous_us, pending);
+  }
+}
+
+static void CONTROLLER_steering_set_rate(int rate) {
+  steering_period_us = 1000000 / rate;
+  memset(&steering_stats, 0, sizeof(steering_stats));
+
+  if (steering_timer) {
+    esp_timer_stop(steering_timer);
+    esp_timer_start_periodic(steering_timer, steering_period_us);
+  }
+}
+
+/*******************************************************************
+ * Calibration change, called by the calibration registry
+ *******************************************************************/
+static void CONTROLLER_calibration_changed(uint32_t changed, const calibration_t *values) {
+  const uint32_t steering = CALIBRATION_MASK(CAL_STEERWHEEL_LEFT) | CALIBRATION_MASK(CAL_STEERWHEEL_MIDDLE) |
+                            CALIBRATION_MASK(CAL_STEERWHEEL_RIGHT) | CALIBRATION_MASK(CAL_AZIMUTH_LOW) |
+                            CALIBRATION_MASK(CAL_AZIMUTH_MIDDLE) | CALIBRATION_MASK(CAL_AZIMUTH_HIGH);
+
+  if (changed & steering) {
+    CONTROLLER_steering_invalidate();
+  }
+  if (changed & CALIBRATION_MASK(CAL_STEERING_RATE)) {
+    CONTROLLER_steering_set_rate(values->value[CAL_STEERING_RATE]);
+  }
+}
+
+static void CONTROLLER_setup_steering() {
+  CONTROLLER_steering_set_rate(CALIBRATION_get(CAL_STEERING_RATE));
+  CALIBRATION_on_change(CONTROLLER_calibration_changed);
+
+  xTaskCreatePinnedToCore(CONTROLLER_steering_task, "Steering", 3072, NULL, 20, &steering_task_handle, APP_CPU_NUM);
+
+  esp_timer_create_args_t timer_args = {};
+  timer_args.callback = CONTROLLER_steering_tick;
+  timer_args.name = "steering";
+  esp_timer_create(&timer_args, &steering_timer);
+  esp_timer_start_periodic(steering_timer, steering_period_us);
+}
+
+/*******************************************************************
+ * Transition table, sorted on state at compile time.
+ * Order within a state is the priority of the transitions.
+ *******************************************************************/
+static constexpr StaticTransition controller_transitions[] = {
+    /* STATE(s) initial */
+    {CONTROLLER_init, CONTROLLER_no_position, fnInitToNoPosition},
+
+    /* STATE(s) No position */
+    {CONTROLLER_no_position, CONTROLLER_extended, fnNoPositionToExtended},
+    {CONTROLLER_no_position, CONTROLLER_extending, fnNoPositionToExtending},
+    {CONTROLLER_no_position, CONTROLLER_homing, fnNoPositionToHoming},
+    {CONTROLLER_no_position, CONTROLLER_retracted, fnNoPositionToRetracted},
+    {CONTROLLER_no_position, CONTROLLER_emergency_stop, fnAnyToEmergencyStop},
+    {CONTROLLER_no_position, CONTROLLER_maintenance, fnAnyToMantenance},
+
+    /* STATE(s) Homing, retracting and retracted */
+    {CONTROLLER_homing, CONTROLLER_retracting, fnHomingToRetracting},
+    {CONTROLLER_homing, CONTROLLER_no_position, fnHomingToNoPosition},
+    {CONTROLLER_homing, CONTROLLER_emergency_stop, fnAnyToEmergencyStop},
+
+    {CONTROLLER_retracting, CONTROLLER_retracted, fnRetractingToRetracted},
+    {CONTROLLER_retracting, CONTROLLER_no_position, fnRetractingToNoPosition},
+    {CONTROLLER_retracting, CONTROLLER_emergency_stop, fnAnyToEmergencyStop},
+
+    {CONTROLLER_retracted, CONTROLLER_extending, fnRetractedToExtending},
+    {CONTROLLER_retracted, CONTROLLER_no_position, fnRetractedToNoPosition},
+    {CONTROLLER_retracted, CONTROLLER_emergency_stop, fnAnyToEmergencyStop},
+    {CONTROLLER_retracted, CONTROLLER_maintenance, fnAnyToMantenance},
+
+    /* STATE(s) Extending and extended */
+    {CONTROLLER_extending, CONTROLLER_extended, fnExtendingToExtended},
+    {CONTROLLER_extending, CONTROLLER_no_position, fnExtendingToNoPosition},
+    {CONTROLLER_extending, CONTROLLER_emergency_stop, fnAnyToEmergencyStop},
+
+    {CONTROLLER_extended, CONTROLLER_homing, fnExtendedToRetracting},
+    {CONTROLLER_extended, CONTROLLER_no_position, fnExtendedToNoPosition},
+    {CONTROLLER_extended, CONTROLLER_emergency_stop, fnAnyToEmergencyStop},
+    {CONTROLLER_extended, CONTROLLER_maintenance, fnAnyToMantenance},
+
+    /* STATE(s) Emergency stop */
+    {CONTROLLER_emergency_stop, CONTROLLER_no_position, fnEmergencyStopToNoPosition},
+
+    /* STATE(s) Maintenance mode */
+    {CONTROLLER_maintenance, CONTROLLER_no_position, fnMaintenanceToNoPosition},
+};
+
+static constexpr auto controller_table = StaticStateMachineCompile<CONTROLLER_NUM_STATES>(controller_transitions);
+static_assert(controller_table.Valid, "Controller transition with invalid state");
+
+static StaticStateMachine<CONTROLLER_NUM_STATES, controller_table.numTransitions> stateMachine(controller_table);
+
 /*******************************************************************
  * Controller main task
  *******************************************************************/
 static void CONTROLLER_main_task(void *parameter) {
+  uint32_t refreshed = millis();
+
   (void)parameter;
 
   while (true) {
+    CONTROLLER_take_edge();
     stateMachine.Update();
 
-    if (!MAINTENANCE_enabled()) {
-      CONTROLLER_update_steering();
-      
+    /* The outputs revert to OFF after a PCF8574 reset */
+    if (millis() - refreshed >= CONTROLLER_OUTPUT_REFRESH_MS) {
+      refreshed = millis();
+      PCF8574_refresh(PCF8574_address);
     }
 
-    vTaskDelay(200 / portTICK_PERIOD_MS);
+    /* Sleep until an edge notification or the timer tick */
+    ulTaskNotifyTake(pdTRUE, CONTROLLER_TICK_MS / portTICK_PERIOD_MS);
   }
 }
 
@@ -433,74 +720,171 @@ static void CONTROLLER_main_task(void *parameter) {
  * Setup Controller task(s)
  *******************************************************************/
 static void CONTROLLER_setup_tasks() {
-  xTaskCreate(CONTROLLER_main_task, "Controller debug task", 4096, NULL, 15, NULL);
+  xTaskCreate(CONTROLLER_main_task, "Controller debug task", 4096, NULL, 15, &controller_task_handle);
+}
+
+/*******************************************************************
+ * Setup edge interrupts
+ *
+ * Note: GPIO36 and GPIO39 (lift sensors) can generate spurious
+ * interrupts on the ESP32 (errata 3.11), a spurious wakeup only
+ * results in an extra statemachine update. The emergency stop
+ * interrupt is owned by GPIO and wakes the controller as well.
+ *******************************************************************/
+static void CONTROLLER_setup_interrupts() {
+  attachInterrupt(digitalPinToInterrupt(LIFT_SENSOR_UP_PIN), CONTROLLER_wakeup_from_isr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(LIFT_SENSOR_DOWN_PIN), CONTROLLER_wakeup_from_isr, CHANGE);
+}
+
+/********************************************************************
+ * Create initial JSON data
+ *******************************************************************/
+static JsonDocument CONTROLLER_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  controller_data[JSON_CONTROLLER_STATE] = controller_state_names[stateMachine.GetState()];
+  controller_data[JSON_CONTROLLER_WAKEUPS] = controller_wakeups;
+  controller_data[JSON_CONTROLLER_REACTION_LAST] = controller_reaction_last_us;
+  controller_data[JSON_CONTROLLER_REACTION_MAX] = controller_reaction_max_us;
+
+  controller_data[JSON_STEERING_RATE] = 1000000 / steering_period_us;
+  controller_data[JSON_STEERING_CYCLES] = steering_stats.cycles;
+  controller_data[JSON_STEERING_JITTER_LAST] = steering_stats.jitter_last_us;
+  controller_data[JSON_STEERING_JITTER_MAX] = steering_stats.jitter_max_us;
+  controller_data[JSON_STEERING_EXEC_LAST] = steering_stats.exec_last_us;
+  controller_data[JSON_STEERING_EXEC_MAX] = steering_stats.exec_max_us;
+  controller_data[JSON_STEERING_OVERRUNS] = steering_stats.overruns;
+  controller_data[JSON_STEERING_MISSED] = steering_stats.missed;
+  controller_data[JSON_STEERING_LUT_BUILDS] = steering_stats.lut_builds;
+  controller_data[JSON_STEERING_LUT_BUILD_TIME] = steering_stats.lut_build_us;
+
+  JsonDocument doc(allocator);
+  doc.set(controller_data);
+  return doc;
+}
+
+/********************************************************************
+ * Create string
+ *******************************************************************/
+static String CONTROLLER_info_str(void) {
+  JsonDocument doc = CONTROLLER_json();  // Update
+
+  String text = "--- CONTROLLER ---";
+
+  text.concat("\r\nState: ");
+  text.concat(doc[JSON_CONTROLLER_STATE].as<const char *>());
+
+  text.concat("\r\nEdge wakeups: ");
+  text.concat(doc[JSON_CONTROLLER_WAKEUPS].as<unsigned long>());
+
+  text.concat("\r\nReaction time (edge to SetState) last: ");
+  text.concat(doc[JSON_CONTROLLER_REACTION_LAST].as<long>());
+  text.concat("us, max: ");
+  text.concat(doc[JSON_CONTROLLER_REACTION_MAX].as<long>());
+  text.concat("us");
+
+  text.concat("\r\nSteering loop rate: ");
+  text.concat(doc[JSON_STEERING_RATE].as<int>());
+  text.concat("Hz, cycles: ");
+  text.concat(doc[JSON_STEERING_CYCLES].as<unsigned long>());
+
+  text.concat("\r\nSteering jitter last: ");
+  text.concat(doc[JSON_STEERING_JITTER_LAST].as<unsigned long>());
+  text.concat("us, max: ");
+  text.concat(doc[JSON_STEERING_JITTER_MAX].as<unsigned long>());
+  text.concat("us");
+
+  text.concat("\r\nSteering execution last: ");
+  text.concat(doc[JSON_STEERING_EXEC_LAST].as<unsigned long>());
+  text.concat("us, max: ");
+  text.concat(doc[JSON_STEERING_EXEC_MAX].as<unsigned long>());
+  text.concat("us");
+
+  text.concat("\r\nSteering overruns: ");
+  text.concat(doc[JSON_STEERING_OVERRUNS].as<unsigned long>());
+  text.concat(", missed cycles: ");
+  text.concat(doc[JSON_STEERING_MISSED].as<unsigned long>());
+
+  text.concat("\r\nSteering table builds: ");
+  text.concat(doc[JSON_STEERING_LUT_BUILDS].as<unsigned long>());
+  text.concat(", last build: ");
+  text.concat(doc[JSON_STEERING_LUT_BUILD_TIME].as<unsigned long>());
+  text.concat("us");
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *********************************************************************/
+static void CONTROLLER_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, CONTROLLER_json);
+}
+
+static rest_api_t CONTROLLER_api_handlers = {
+    /* uri */ "/api/v1/controller",
+    /* comment */ "Controller statemachine",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ CONTROLLER_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(CONTROLLER_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    controller_reaction_last_us = controller_reaction_max_us = 0;
+    controller_wakeups = 0;
+    memset(&steering_stats, 0, sizeof(steering_stats));
+    CLI_println("Controller statistics cleared.");
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("rate")) {
+    int val = cmd.getArg(1).getValue().toInt();
+    if ((val < STEERING_RATE_MIN) || (val > STEERING_RATE_MAX)) {
+      CLI_println("Illegal value, range: " + String(STEERING_RATE_MIN) + " ... " + String(STEERING_RATE_MAX) + "Hz.");
+      return;
+    }
+    CALIBRATION_set(CAL_STEERING_RATE, val);
+    CLI_println("Steering loop rate has been set to " + String(val) + "Hz.");
+    return;
+  }
+
+  CLI_println("Invalid command: CONTROLLER (reset, rate <n>).");
+}
+
+static void CONTROLLER_setup_cli(void) {
+  cli.addBoundlessCmd("controller", clicb_handler);
 }
 
 /*******************************************************************
  * Setup Controller State Machine
  *******************************************************************/
 static void CONTROLLER_setup_statemachine() {
-  /* ---------------- */
-  /* STATE(s) initial */
-  /* ---------------- */
   stateMachine.SetOnEntering(CONTROLLER_init, fnStateInit);
-  stateMachine.AddTransition(CONTROLLER_init, CONTROLLER_no_position, fnInitToNoPosition);
-
-  /* -------------------- */
-  /* STATE(s) No position */
-  /* -------------------- */
   stateMachine.SetOnEntering(CONTROLLER_no_position, fnStateNoPosition);
-  stateMachine.AddTransition(CONTROLLER_no_position, CONTROLLER_extended, fnNoPositionToExtended);
-  stateMachine.AddTransition(CONTROLLER_no_position, CONTROLLER_extending, fnNoPositionToExtending);
-  stateMachine.AddTransition(CONTROLLER_no_position, CONTROLLER_homing, fnNoPositionToHoming);
-  stateMachine.AddTransition(CONTROLLER_no_position, CONTROLLER_retracted, fnNoPositionToRetracted);
-  stateMachine.AddTransition(CONTROLLER_no_position, CONTROLLER_emergency_stop, fnAnyToEmergencyStop);
-  stateMachine.AddTransition(CONTROLLER_no_position, CONTROLLER_maintenance, fnAnyToMantenance);
-
-  /* ----------------------------------------- */
-  /* STATE(s) Homing, retracting and retracted */
-  /* ----------------------------------------- */
   stateMachine.SetOnEntering(CONTROLLER_homing, fnStateHoming);
-  stateMachine.AddTransition(CONTROLLER_homing, CONTROLLER_retracting, fnHomingToRetracting);
-  stateMachine.AddTransition(CONTROLLER_homing, CONTROLLER_no_position, fnHomingToNoPosition);
-  stateMachine.AddTransition(CONTROLLER_homing, CONTROLLER_emergency_stop, fnAnyToEmergencyStop);
-
   stateMachine.SetOnEntering(CONTROLLER_retracting, fnStateRetracting);
-  stateMachine.AddTransition(CONTROLLER_retracting, CONTROLLER_retracted, fnRetractingToRetracted);
-  stateMachine.AddTransition(CONTROLLER_retracting, CONTROLLER_no_position, fnRetractingToNoPosition);
-  stateMachine.AddTransition(CONTROLLER_retracting, CONTROLLER_emergency_stop, fnAnyToEmergencyStop);
-
   stateMachine.SetOnEntering(CONTROLLER_retracted, fnStateRetracted);
-  stateMachine.AddTransition(CONTROLLER_retracted, CONTROLLER_extending, fnRetractedToExtending);
-  stateMachine.AddTransition(CONTROLLER_retracted, CONTROLLER_no_position, fnRetractedToNoPosition);
-  stateMachine.AddTransition(CONTROLLER_retracted, CONTROLLER_emergency_stop, fnAnyToEmergencyStop);
-  stateMachine.AddTransition(CONTROLLER_retracted, CONTROLLER_maintenance, fnAnyToMantenance);
-
-  /* ------------------------------- */
-  /* STATE(s) Extending and extended */
-  /* ------------------------------- */
   stateMachine.SetOnEntering(CONTROLLER_extending, fnStateExtending);
-  stateMachine.AddTransition(CONTROLLER_extending, CONTROLLER_extended, fnExtendingToExtended);
-  stateMachine.AddTransition(CONTROLLER_extending, CONTROLLER_no_position, fnExtendingToNoPosition);
-  stateMachine.AddTransition(CONTROLLER_extending, CONTROLLER_emergency_stop, fnAnyToEmergencyStop);
-
   stateMachine.SetOnEntering(CONTROLLER_extended, fnStateExtended);
-  stateMachine.AddTransition(CONTROLLER_extended, CONTROLLER_homing, fnExtendedToRetracting);
-  stateMachine.AddTransition(CONTROLLER_extended, CONTROLLER_no_position, fnExtendedToNoPosition);
-  stateMachine.AddTransition(CONTROLLER_extended, CONTROLLER_emergency_stop, fnAnyToEmergencyStop);
-  stateMachine.AddTransition(CONTROLLER_extended, CONTROLLER_maintenance, fnAnyToMantenance);
-
-  /* ----------------------- */
-  /* STATE(s) Emergency stop */
-  /* ----------------------- */
   stateMachine.SetOnEntering(CONTROLLER_emergency_stop, fnStateEmergencyStop);
-  stateMachine.AddTransition(CONTROLLER_emergency_stop, CONTROLLER_no_position, fnEmergencyStopToNoPosition);
-
-  /* ------------------------- */
-  /* STATE(s) Maintenance mode */
-  /* ------------------------- */
   stateMachine.SetOnEntering(CONTROLLER_maintenance, fnStateMaintenace);
-  stateMachine.AddTransition(CONTROLLER_maintenance, CONTROLLER_no_position, fnMaintenanceToNoPosition);
+
+  /* Reaction time is measured when leaving a state */
+  for (int state = CONTROLLER_init; state < CONTROLLER_NUM_STATES; state++)
+    stateMachine.SetOnLeaving(state, fnStateLeaving);
 
   // Initial state
   stateMachine.SetState(CONTROLLER_init, false, true);
@@ -517,6 +901,10 @@ void CONTROLLER_setup() {
 
 void CONTROLLER_start() {
   CONTROLLER_setup_tasks();
+  CONTROLLER_setup_steering();
+  CONTROLLER_setup_interrupts();
+  CONTROLLER_setup_cli();
+  setup_uri(&CONTROLLER_api_handlers);
 
   Serial.println(F("Controller started..."));
 }
\ No newline at end of file
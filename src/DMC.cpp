@@ -10,7 +10,6 @@
 #include <ArduinoJson.h>
 #include <WebSerial.h>
 #include <WebServer.h>
-#include <WebSocketsServer.h>
 
 #include "Config.h"
 #include "Storage.h"
@@ -38,11 +37,13 @@ static bool DMC_is_enabled = false;
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
-static JsonDocument DMC_json(void) {
+static JsonDocument DMC_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
 
   DMC_data[JSON_DMC_ENABLED] = DMC_enabled();
 
-  return DMC_data;
+  JsonDocument doc(allocator);
+  doc.set(DMC_data);
+  return doc;
 }
 
 /********************************************************************
@@ -86,9 +87,7 @@ bool DMC_enabled(void) {
  * REST API
  *********************************************************************/
 static void DMC_rest_read(AsyncWebServerRequest *request) {
-  String str;
-  serializeJson(DMC_json(), str);
-  request->send(200, "application/json", str.c_str());
+  WEBSERVER_send_json(request, DMC_json);
 }
 
 static rest_api_t DMC_api_handlers = {
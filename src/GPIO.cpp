@@ -3,9 +3,13 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <Wire.h>
+#include <esp_timer.h>
 
+#include "CLI.h"
 #include "Config.h"
-#include "EBC_IOLib.h" 
+#include "Controller.h"
+#include "EBC_IOLib.h"
+#include "WebServer.h"
 
 /*******************************************************************
   Definitions
@@ -36,6 +40,15 @@ uint8_t PCF8574_address  = 0;
 uint8_t MCP4725_R_address  = 0;
 uint8_t MCP4725_L_address  = 0;
 
+/* Emergency stop fast path */
+static TaskHandle_t estop_task_handle = NULL;
+static volatile bool estop_latched = false;
+static volatile int64_t estop_edge_us = 0;
+static volatile uint32_t estop_count = 0;
+static int64_t estop_shutdown_last_us = 0;
+static int64_t estop_shutdown_max_us = 0;
+static uint32_t estop_write_failed = 0;
+
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
@@ -63,6 +76,248 @@ bool EMERGENCY_STOP_active(void) {
   return digitalRead(EMERGNECY_STOP_PIN) == HIGH ? false : true;
 }
 
+bool EMERGENCY_STOP_latched(void) {
+  return estop_latched;
+}
+
+void EMERGENCY_STOP_clear(void) {
+  estop_latched = false;
+}
+
+/*******************************************************************
+ * Emergency stop interrupt (active low)
+ *
+ * Drops the azimuth analog enable directly, latches and timestamps
+ * the event and hands the I2C shutdown to the e-stop task. Both
+ * edges wake the controller.
+ *******************************************************************/
+static void ARDUINO_ISR_ATTR EMERGENCY_STOP_isr(void) {
+  BaseType_t woken = pdFALSE;
+
+  if (digitalRead(EMERGNECY_STOP_PIN) == LOW) {
+    digitalWrite(AZIMUTH_ANALOG_ENABLE_PIN, IO_OFF);
+
+    estop_edge_us = esp_timer_get_time();
+    estop_latched = true;
+    estop_count++;
+
+    if (estop_task_handle)
+      vTaskNotifyGiveFromISR(estop_task_handle, &woken);
+  }
+
+  CONTROLLER_wakeup_from_isr();
+
+  if (woken)
+    portYIELD_FROM_ISR();
+}
+
+/*******************************************************************
+ * Emergency stop task, highest priority
+ *
+ * Writes the all-off mask (PCF8574_RESET) in a single I2C
+ * transaction and records the shutdown time from the e-stop edge.
+ *******************************************************************/
+static void EMERGENCY_STOP_task(void *parameter) {
+  (void)parameter;
+
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    if (!PCF8574_write(PCF8574_address, 0, PCF8574_RESET))
+      estop_write_failed++;
+
+    estop_shutdown_last_us = esp_timer_get_time() - estop_edge_us;
+    if (estop_shutdown_last_us > estop_shutdown_max_us)
+      estop_shutdown_max_us = estop_shutdown_last_us;
+
+#ifdef DEBUG_GPIO
+    Serial.printf("Emergency stop, outputs off in %lldus.\n", estop_shutdown_last_us);
+#endif
+  }
+}
+
+/********************************************************************
+ * Emergency stop JSON data
+ *******************************************************************/
+static JsonDocument EMERGENCY_STOP_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  doc[JSON_EMERGENCY_STOP] = EMERGENCY_STOP_active();
+  doc[JSON_EMERGENCY_STOP_LATCHED] = EMERGENCY_STOP_latched();
+  doc[JSON_EMERGENCY_STOP_COUNT] = estop_count;
+  doc[JSON_EMERGENCY_STOP_SHUTDOWN_LAST] = estop_shutdown_last_us;
+  doc[JSON_EMERGENCY_STOP_SHUTDOWN_MAX] = estop_shutdown_max_us;
+  doc[JSON_EMERGENCY_STOP_WRITE_FAILED] = estop_write_failed;
+
+  return doc;
+}
+
+/********************************************************************
+ * Create string
+ *******************************************************************/
+static String EMERGENCY_STOP_info_str(void) {
+  JsonDocument doc = EMERGENCY_STOP_json();
+
+  String text = "--- EMERGENCY STOP ---";
+
+  text.concat("\r\nActive: ");
+  text.concat(doc[JSON_EMERGENCY_STOP].as<bool>() ? "yes" : "no");
+  text.concat(", latched: ");
+  text.concat(doc[JSON_EMERGENCY_STOP_LATCHED].as<bool>() ? "yes" : "no");
+
+  text.concat("\r\nEmergency stops: ");
+  text.concat(doc[JSON_EMERGENCY_STOP_COUNT].as<unsigned long>());
+
+  text.concat("\r\nShutdown time last: ");
+  text.concat(doc[JSON_EMERGENCY_STOP_SHUTDOWN_LAST].as<long>());
+  text.concat("us, max: ");
+  text.concat(doc[JSON_EMERGENCY_STOP_SHUTDOWN_MAX].as<long>());
+  text.concat("us");
+
+  text.concat("\r\nI2C write failures: ");
+  text.concat(doc[JSON_EMERGENCY_STOP_WRITE_FAILED].as<unsigned long>());
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *********************************************************************/
+static void EMERGENCY_STOP_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, EMERGENCY_STOP_json);
+}
+
+static rest_api_t EMERGENCY_STOP_api_handlers = {
+    /* uri */ "/api/v1/estop",
+    /* comment */ "Emergency stop",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ EMERGENCY_STOP_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_estop(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(EMERGENCY_STOP_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    estop_shutdown_last_us = estop_shutdown_max_us = 0;
+    estop_count = estop_write_failed = 0;
+    CLI_println("Emergency stop statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: ESTOP (reset).");
+}
+
+/********************************************************************
+ * I2C bus statistics
+ *******************************************************************/
+static const char *I2C_prio_names[I2C_PRIO_COUNT] = {"safety", "dac", "diagnostic"};
+
+static JsonDocument I2C_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+  I2C_stats_t stats;
+
+  for (int prio = 0; prio < I2C_PRIO_COUNT; prio++) {
+    I2C_statistics((I2C_prio_t)prio, &stats);
+
+    JsonObject obj = doc[I2C_prio_names[prio]].to<JsonObject>();
+    obj["count"] = stats.count;
+    obj["wait_last_us"] = stats.wait_last_us;
+    obj["wait_max_us"] = stats.wait_max_us;
+    obj["latency_last_us"] = stats.latency_last_us;
+    obj["latency_max_us"] = stats.latency_max_us;
+    obj["latency_avg_us"] = stats.count ? (uint32_t)(stats.latency_total_us / stats.count) : 0;
+  }
+
+  return doc;
+}
+
+static String I2C_info_str(void) {
+  JsonDocument doc = I2C_json();
+
+  String text = "--- I2C BUS ---";
+
+  for (int prio = 0; prio < I2C_PRIO_COUNT; prio++) {
+    JsonObject obj = doc[I2C_prio_names[prio]];
+
+    text.concat("\r\n");
+    text.concat(I2C_prio_names[prio]);
+    text.concat(": count: ");
+    text.concat(obj["count"].as<unsigned long>());
+    text.concat(", wait last/max: ");
+    text.concat(obj["wait_last_us"].as<unsigned long>());
+    text.concat("/");
+    text.concat(obj["wait_max_us"].as<unsigned long>());
+    text.concat("us, latency last/avg/max: ");
+    text.concat(obj["latency_last_us"].as<unsigned long>());
+    text.concat("/");
+    text.concat(obj["latency_avg_us"].as<unsigned long>());
+    text.concat("/");
+    text.concat(obj["latency_max_us"].as<unsigned long>());
+    text.concat("us");
+  }
+
+  text.concat("\r\n");
+  return text;
+}
+
+static void I2C_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, I2C_json);
+}
+
+static rest_api_t I2C_api_handlers = {
+    /* uri */ "/api/v1/i2c",
+    /* comment */ "I2C bus statistics",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ I2C_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+static void clicb_i2c(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(I2C_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    I2C_statistics_clear();
+    CLI_println("I2C statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: I2C (reset).");
+}
+
+/*******************************************************************
+ * Emergency stop setup
+ *******************************************************************/
+static void EMERGENCY_STOP_setup(void) {
+  pinMode(EMERGNECY_STOP_PIN, INPUT);
+
+  xTaskCreate(EMERGENCY_STOP_task, "Emergency stop", 2048, NULL, configMAX_PRIORITIES - 1, &estop_task_handle);
+  attachInterrupt(digitalPinToInterrupt(EMERGNECY_STOP_PIN), EMERGENCY_STOP_isr, CHANGE);
+
+  cli.addBoundlessCmd("estop", clicb_estop);
+  setup_uri(&EMERGENCY_STOP_api_handlers);
+}
+
 /*******************************************************************
  * LED
  *******************************************************************/
@@ -185,7 +440,12 @@ void GPIO_setup(void) {
   Start
  *******************************************************************/
 void GPIO_start(void) {
+  I2C_start();  // Bus owner, serialises all I2C transactions
   setup_tasks();
+  EMERGENCY_STOP_setup();
+
+  cli.addBoundlessCmd("i2c", clicb_i2c);
+  setup_uri(&I2C_api_handlers);
 
   Serial.println(F("GPIO setup completed..."));
 }
@@ -10,10 +10,11 @@
 #include <ArduinoJson.h>
 #include <WebSerial.h>
 #include <WebServer.h>
-#include <WebSocketsServer.h>
 
 #include "CLI.h"
+#include "Calibration.h"
 #include "Config.h"
+#include "Controller.h"
 #include "EBC_IOLib.h"
 #include "GPIO.h"
 #include "Storage.h"
@@ -24,6 +25,7 @@
 #define DEBUG_LIFT
 
 #define BUTTON_BOTH_DELAY 30;
+#define BUTTON_DEBOUNCE_MS 50
 
 /*******************************************************************
  * Storage keys and defaults
@@ -40,7 +42,7 @@ static int LIFT_error_mask = 0;
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
-static JsonDocument LIFT_json(void) {
+static JsonDocument LIFT_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
   int value;
 
   LIFT_data[JSON_LIFT_ENABLED] = LIFT_enabled();
@@ -51,13 +53,17 @@ static JsonDocument LIFT_json(void) {
   LIFT_data[JSON_LIFT_SENSOR_UP] = LIFT_UP_sensor();
   LIFT_data[JSON_LIFT_SENSOR_DOWN] = LIFT_DOWN_sensor();
 
+  LIFT_data[JSON_LIFT_MOVE_TIMEOUT] = LIFT_move_timeout();
+
   STORAGE_get_int(JSON_RETRACTED_COUNT, value);
   LIFT_data[JSON_RETRACTED_COUNT] = value;
 
   STORAGE_get_int(JSON_EXTENDED_COUNT, value);
   LIFT_data[JSON_EXTENDED_COUNT] = value;
 
-  return LIFT_data;
+  JsonDocument doc(allocator);
+  doc.set(LIFT_data);
+  return doc;
 }
 
 /********************************************************************
@@ -98,7 +104,7 @@ static String LIFT_info_str(void) {
  * LIFT getters
  *******************************************************************/
 int LIFT_move_timeout(void) {
-  return LIFT_data[JSON_LIFT_MOVE_TIMEOUT].as<int>();
+  return CALIBRATION_get(CAL_LIFT_MOVE_TIMEOUT);
 }
 
 bool LIFT_error(void) {
@@ -206,9 +212,9 @@ static void LIFT_position_check(void) {
 /*******************************************************************
  * Lift buttons
  *******************************************************************/
-static bool BUTTON_UP_pushed = false;
-static bool BUTTON_DOWN_pushed = false;
-static bool BUTTON_BOTH_pushed = false;
+static volatile bool BUTTON_UP_pushed = false;
+static volatile bool BUTTON_DOWN_pushed = false;
+static volatile bool BUTTON_BOTH_pushed = false;
 
 bool LIFT_UP_button(void) {
   if (BUTTON_UP_pushed) {
@@ -240,30 +246,49 @@ bool LIFT_BOTH_button(void) {
   return false;
 }
 
+/*******************************************************************
+ * Button edge interrupts, a push is flagged on the rising edge and
+ * wakes the controller. Ignored while the other button is held.
+ *******************************************************************/
 // * Edit this for active high/low
-static void LIFT_button_update(void) {
-  static bool BUTTON_UP_state, BUTTON_UP_memo = false;
-  static bool BUTTON_DOWN_state, BUTTON_DOWN_memo = false;
-  static int delay = BUTTON_BOTH_DELAY;
+static void ARDUINO_ISR_ATTR LIFT_button_up_isr(void) {
+  static unsigned long memo = 0;
+  unsigned long now = millis();
+
+  if (now - memo < BUTTON_DEBOUNCE_MS)
+    return;
+  memo = now;
 
-  // Button up flag
-  BUTTON_UP_state = digitalRead(LIFT_BUTTON_UP_PIN);
-  if (!BUTTON_UP_memo && BUTTON_UP_state && !BUTTON_DOWN_state)
+  if (!digitalRead(LIFT_BUTTON_DOWN_PIN)) {
     BUTTON_UP_pushed = true;
-  BUTTON_UP_memo = BUTTON_UP_state;
+    CONTROLLER_wakeup_from_isr();
+  }
+}
+
+static void ARDUINO_ISR_ATTR LIFT_button_down_isr(void) {
+  static unsigned long memo = 0;
+  unsigned long now = millis();
 
-  // Button down flag
-  BUTTON_DOWN_state = digitalRead(LIFT_BUTTON_DOWN_PIN);
-  if (!BUTTON_DOWN_memo && BUTTON_DOWN_state && !BUTTON_UP_state)
+  if (now - memo < BUTTON_DEBOUNCE_MS)
+    return;
+  memo = now;
+
+  if (!digitalRead(LIFT_BUTTON_UP_PIN)) {
     BUTTON_DOWN_pushed = true;
-  BUTTON_DOWN_memo = BUTTON_DOWN_state;
+    CONTROLLER_wakeup_from_isr();
+  }
+}
+
+/*******************************************************************
+ * Both buttons held, polled every 100ms
+ *******************************************************************/
+static void LIFT_button_update(void) {
+  static int delay = BUTTON_BOTH_DELAY;
 
-  // Both buttons pushed
-  if (BUTTON_UP_state && BUTTON_DOWN_state) {
+  if (digitalRead(LIFT_BUTTON_UP_PIN) && digitalRead(LIFT_BUTTON_DOWN_PIN)) {
     if (delay >= 0) {
       delay--;
       if (delay == 0) {
-        BUTTON_UP_memo = BUTTON_DOWN_memo = false;
         BUTTON_UP_pushed = BUTTON_DOWN_pushed = false;
         BUTTON_BOTH_pushed = true;
       }
@@ -357,9 +382,7 @@ static void LIFT_main_task(void *parameter) {
  * REST API
  *********************************************************************/
 static void LIFT_rest_read(AsyncWebServerRequest *request) {
-  String str;
-  serializeJson(LIFT_json(), str);
-  request->send(200, "application/json", str.c_str());
+  WEBSERVER_send_json(request, LIFT_json);
 }
 
 static rest_api_t LIFT_api_handlers = {
@@ -395,7 +418,7 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 3 ... 120s.");
       return;
     }
-    STORAGE_set_int(JSON_LIFT_MOVE_TIMEOUT, val);
+    CALIBRATION_set(CAL_LIFT_MOVE_TIMEOUT, val);
     CLI_println("Retractable timeout has been set to: " + String(val) + "sec.");
   }
 
@@ -428,6 +451,14 @@ static void LIFT_setup_gpio(void) {
   digitalWrite(LIFT_LED_DOWN_PIN, HIGH);  // Inverted
 }
 
+/*******************************************************************
+ * Button interrupts
+ *******************************************************************/
+static void LIFT_setup_interrupts(void) {
+  attachInterrupt(digitalPinToInterrupt(LIFT_BUTTON_UP_PIN), LIFT_button_up_isr, RISING);
+  attachInterrupt(digitalPinToInterrupt(LIFT_BUTTON_DOWN_PIN), LIFT_button_down_isr, RISING);
+}
+
 /*******************************************************************
   Setup tasks
  *******************************************************************/
@@ -441,13 +472,6 @@ static void LIFT_setup_tasks(void) {
 static void LIFT_setup_variables(void) {
   int value;
 
-  // Maximum lift move up/down time in seconds
-  if (STORAGE_get_int(JSON_LIFT_MOVE_TIMEOUT, value)) {
-    value = DELFAULT_LIFT_MOVE_TIMEOUT;
-    STORAGE_set_int(JSON_LIFT_MOVE_TIMEOUT, value);
-  }
-  LIFT_data[JSON_LIFT_MOVE_TIMEOUT] = value;
-
   /* Initialize if not exist */
   if (STORAGE_get_int(JSON_RETRACTED_COUNT, value)) {
     STORAGE_set_int(JSON_RETRACTED_COUNT, 0);
@@ -465,9 +489,11 @@ static void LIFT_setup_variables(void) {
  * Prints a message to the serial monitor indicating that the lift has stopped.
  *******************************************************************/
 void LIFT_stop(void) {
+  PCF8574_begin(PCF8574_address);
   LIFT_disable();
   LIFT_UP_off();
   LIFT_DOWN_off();
+  PCF8574_commit();
 
   Serial.println(F("Lift stopped."));
 }
@@ -480,9 +506,11 @@ void LIFT_setup(void) {
   LIFT_setup_variables();
   LIFT_setup_gpio();
 
+  PCF8574_begin(PCF8574_address);
   LIFT_disable();
   LIFT_UP_off();
   LIFT_DOWN_off();
+  PCF8574_commit();
 
   Serial.println(F("Lift setup completed..."));
 }
@@ -498,6 +526,7 @@ void LIFT_setup(void) {
  *******************************************************************/
 void LIFT_start(void) {
   LIFT_setup_tasks();
+  LIFT_setup_interrupts();
   LIFT_setup_cli();
   setup_uri(&LIFT_api_handlers);
 
@@ -8,6 +8,9 @@
 #include <ArduinoJson.h>
 #include <mcp2515_can.h>
 
+#include "CANBus.h"
+#include "CANCapture.h"
+#include "CANHealth.h"
 #include "Config.h"
 #include "Debug.h"
 #include "WebServer.h"
@@ -22,6 +25,11 @@
 #undef DEBUG_TASKS
 #undef DEBUG_FRAMES
 
+#define MCP1_QUEUE_LEN 32        // Frames in the transmit queue
+#define MCP1_RX_TIMEOUT_MS 100   // Receive task wakes without /INT edge (missed edge)
+#define MCP1_DRAIN_PASSES 8      // Drains per wakeup while /INT stays low
+#define MCP1_MAX_RULES 16        // Subscriptions compiled into the masks and filters
+
 /*******************************************************************
  * Type definitions
  *******************************************************************/
@@ -37,27 +45,63 @@ typedef struct mcp_frame_t {
  *  Variables
  *******************************************************************/
 static QueueHandle_t MCP1_TX_QUEUE;
-static QueueHandle_t MCP1_RX_QUEUE;
 
 static uint32_t _mcp1_baudrate = 500000;
 
 static uint32_t _mcp1_transmited = 0;
 static uint32_t _mcp1_transmited_error = 0;
+static uint32_t _mcp1_tx_dropped = 0;     // Transmit queue full
 static uint32_t _mcp1_received = 0;
 static uint32_t _mcp1_received_error = 0;
+static uint32_t _mcp1_rx_overflow = 0;    // RX0OVR/RX1OVR, frame lost in the MCP2515
+static uint32_t _mcp1_rx_dropped = 0;     // Frame pool empty
+static uint32_t _mcp1_rx_interrupts = 0;
+static uint32_t _mcp1_rx_burst_max = 0;
+static uint32_t _mcp1_rx_drain_capped = 0;  // /INT still low after MCP1_DRAIN_PASSES
+static uint32_t _mcp1_filter_errors = 0;    // Masks and filters not written, mode switch failed
+
+static TaskHandle_t MCP1_receive_task_handle = nullptr;
+static SemaphoreHandle_t MCP1_lock = nullptr;  // CAN1 SPI access, receive and transmit task
 
-static CANReceiveHandler MCP1_receive_handler = nullptr;
+static CANFILTER_mcp_t MCP1_filter;
+static volatile bool MCP1_filter_dirty = false;
+static volatile bool MCP1_held = false;  // Configuration mode, bus-off backoff
+static bool MCP1_bus_off = false;        // TXBO seen on ERRIF, until MCP1_bus_status(), MCP1_lock
+
+static int MCP1_apply_filters(void);
 
 /*******************************************************************
  *  Globals
  *******************************************************************/
 mcp2515_can CAN1(SPI0_CS);  // Set CAN-1 CS to pin 15
 
+/********************************************************************
+ * Software rejected frames per second since the previous call
+ *******************************************************************/
+static uint32_t MCP1_rejected_rate(void) {
+  static uint32_t memo_ms = 0, memo_rejected = 0, last_rate = 0;
+
+  uint32_t now = millis();
+  uint32_t elapsed = now - memo_ms;
+  uint32_t rejected = CANBUS_rejected(CAN_CHANNEL_MCP1);
+
+  if (elapsed >= 1000) {
+    last_rate = (uint32_t)(((uint64_t)(rejected - memo_rejected) * 1000) / elapsed);
+    memo_ms = now;
+    memo_rejected = rejected;
+  }
+  return last_rate;
+}
+
+static String MCP1_hex(uint32_t value) {
+  return String("0x") + String(value, HEX);
+}
+
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
-static JsonDocument MCP1_json(void) {
-  JsonDocument doc;
+static JsonDocument MCP1_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
 
   doc[JSON_MCP_DEVICE] = "mcp2515";
 
@@ -65,9 +109,31 @@ static JsonDocument MCP1_json(void) {
 
   doc[JSON_MCP_RX_FRAMES] = _mcp1_received;
   doc[JSON_MCP_RX_ERRORS] = _mcp1_received_error;
+  doc[JSON_MCP_RX_OVERRUN] = _mcp1_rx_overflow;
+  doc[JSON_MCP_RX_DROPPED] = _mcp1_rx_dropped;
+  doc[JSON_MCP_RX_INTERRUPTS] = _mcp1_rx_interrupts;
+  doc[JSON_MCP_RX_BURST_MAX] = _mcp1_rx_burst_max;
+  doc[JSON_MCP_RX_DRAIN_CAPPED] = _mcp1_rx_drain_capped;
+  doc[JSON_MCP_RX_REJECTED] = CANBUS_rejected(CAN_CHANNEL_MCP1);
+  doc[JSON_MCP_RX_REJECTED_RATE] = MCP1_rejected_rate();
+
+  JsonArray masks = doc[JSON_MCP_FILTER_MASKS].to<JsonArray>();
+  for (int i = 0; i < CANFILTER_MCP_MASKS; i++) {
+    masks.add(MCP1_hex(MCP1_filter.mask[i]));
+  }
+  JsonArray filters = doc[JSON_MCP_FILTERS].to<JsonArray>();
+  for (int i = 0; i < CANFILTER_MCP_FILTERS; i++) {
+    JsonObject filter = filters.add<JsonObject>();
+    filter["id"] = MCP1_hex(MCP1_filter.filter[i]);
+    filter["ext"] = MCP1_filter.ext[i] ? true : false;
+  }
+  doc[JSON_MCP_FILTER_ACCEPT] = MCP1_filter.accept_ppm / 10000.0;
+  doc[JSON_MCP_FILTER_ERRORS] = _mcp1_filter_errors;
 
   doc[JSON_MCP_TX_FRAMES] = _mcp1_transmited;
   doc[JSON_MCP_TX_ERRORS] = _mcp1_transmited_error;
+  doc[JSON_MCP_TX_DROPPED] = _mcp1_tx_dropped;
+  doc[JSON_MCP_TX_QUEUED] = MCP1_tx_pending();
 
   return doc;
 }
@@ -86,11 +152,47 @@ String MCP1_string(void) {
   text.concat(doc[JSON_MCP_RX_FRAMES].as<int>());
   text.concat(", errors: ");
   text.concat(doc[JSON_MCP_RX_ERRORS].as<int>());
-  
+  text.concat(", overflow: ");
+  text.concat(doc[JSON_MCP_RX_OVERRUN].as<int>());
+  text.concat(", dropped: ");
+  text.concat(doc[JSON_MCP_RX_DROPPED].as<int>());
+
+  text.concat("\r\nInterrupts: ");
+  text.concat(doc[JSON_MCP_RX_INTERRUPTS].as<int>());
+  text.concat(", burst max: ");
+  text.concat(doc[JSON_MCP_RX_BURST_MAX].as<int>());
+  text.concat(", drain capped: ");
+  text.concat(doc[JSON_MCP_RX_DRAIN_CAPPED].as<int>());
+
+  text.concat("\r\nRejected (software): ");
+  text.concat(doc[JSON_MCP_RX_REJECTED].as<int>());
+  text.concat(", rate: ");
+  text.concat(doc[JSON_MCP_RX_REJECTED_RATE].as<int>());
+  text.concat(" frames/s");
+
+  text.concat("\r\nFilter masks: ");
+  text.concat(doc[JSON_MCP_FILTER_MASKS][0].as<const char *>());
+  text.concat(", ");
+  text.concat(doc[JSON_MCP_FILTER_MASKS][1].as<const char *>());
+  text.concat(", accepts ");
+  text.concat(doc[JSON_MCP_FILTER_ACCEPT].as<float>(), 3);
+  text.concat("% of identifiers, write errors: ");
+  text.concat(doc[JSON_MCP_FILTER_ERRORS].as<int>());
+  text.concat("\r\nFilters:");
+  for (JsonObject filter : doc[JSON_MCP_FILTERS].as<JsonArray>()) {
+    text.concat(" ");
+    text.concat(filter["id"].as<const char *>());
+    text.concat(filter["ext"].as<bool>() ? "(ext)" : "(std)");
+  }
+
   text.concat("\r\nTransmitted: ");
   text.concat(doc[JSON_MCP_TX_FRAMES].as<int>());
   text.concat(", errors: ");
   text.concat(doc[JSON_MCP_TX_ERRORS].as<int>());
+  text.concat(", dropped: ");
+  text.concat(doc[JSON_MCP_TX_DROPPED].as<int>());
+  text.concat(", queued: ");
+  text.concat(doc[JSON_MCP_TX_QUEUED].as<int>());
 
   text.concat("\r\n");
   return text;  
@@ -193,17 +295,10 @@ static void MCP1_check_errors(void) {
   }
 }
 
-/*******************************************************************
- * Set receive handler
- *******************************************************************/
-void MCP1_rx_handler(CANReceiveHandler handler) {
-  MCP1_receive_handler = handler;
-}
-
 /*******************************************************************
  *  Send a frame through MCP CAN channel
  *******************************************************************/
-int MCP1_send(uint32_t id, uint8_t* buffer, uint8_t length, bool rtr, bool ext) {
+int MCP1_send(uint32_t id, const uint8_t* buffer, uint8_t length, bool rtr, bool ext) {
   mcp_frame_t frame;
 
   frame.id = id & 0x0FFFFFFF;
@@ -220,12 +315,113 @@ int MCP1_send(uint32_t id, uint8_t* buffer, uint8_t length, bool rtr, bool ext)
 #endif
 
   if (xQueueSend(MCP1_TX_QUEUE, &frame, 0) != pdPASS) {
-    Serial.println(F("MCP error queueing frame..."));
-    vTaskDelay(500 / portTICK_PERIOD_MS);
+    _mcp1_tx_dropped++;  // Never block the caller, the scheduler counts it as failed
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+/*******************************************************************
+ *  Frames waiting in the transmit queue
+ *******************************************************************/
+int MCP1_tx_pending(void) {
+  return MCP1_TX_QUEUE ? (int)uxQueueMessagesWaiting(MCP1_TX_QUEUE) : 0;
+}
+
+/*******************************************************************
+ *  MCP bus bit rate in bits/s
+ *******************************************************************/
+uint32_t MCP1_baudrate(void) {
+  return _mcp1_baudrate;
+}
+
+/*******************************************************************
+ *  Error state from EFLG, the error counters are not readable
+ *  through the driver. Reading EFLG clears the overflow flags, they
+ *  are counted here as in MCP1_drain().
+ *
+ *  The MCP2515 leaves bus-off by itself within a few milliseconds,
+ *  a poll of EFLG misses it. The receive task latches TXBO from the
+ *  error interrupt, the latch is reported (and cleared) here.
+ *******************************************************************/
+int MCP1_bus_status(HEALTH_status_t* status) {
+  uint8_t eflg;
+
+  if (!MCP1_lock) {
+    return ESP_FAIL;
+  }
+
+  xSemaphoreTake(MCP1_lock, portMAX_DELAY);
+  CAN1.checkError(&eflg);
+  if (MCP1_bus_off) {
+    eflg |= CAN_TXBO;
+    MCP1_bus_off = false;
+  }
+  xSemaphoreGive(MCP1_lock);
+
+  _mcp1_rx_overflow += ((eflg & CAN_RX0OVR) ? 1 : 0) + ((eflg & CAN_RX1OVR) ? 1 : 0);
+
+  status->tec = HEALTH_COUNTER_UNKNOWN;
+  status->rec = HEALTH_COUNTER_UNKNOWN;
+  status->bus_errors = _mcp1_received_error;  // Error-passive or bus-off seen while receiving
+
+  if (MCP1_held) {
+    status->state = HEALTH_RECOVERING;
+  } else if (eflg & CAN_TXBO) {
+    status->state = HEALTH_BUS_OFF;
+  } else if (eflg & (CAN_TXEP | CAN_RXEP)) {
+    status->state = HEALTH_ERROR_PASSIVE;
+  } else if (eflg & CAN_EWARN) {
+    status->state = HEALTH_ERROR_WARNING;
+  } else {
+    status->state = HEALTH_ERROR_ACTIVE;
   }
   return ESP_OK;
 }
 
+/*******************************************************************
+ *  Bus-off backoff. The MCP2515 leaves bus-off by itself after 128
+ *  occurrences of 11 recessive bits, holding it in configuration
+ *  mode keeps it off the bus until the backoff expires.
+ *******************************************************************/
+void MCP1_bus_hold(void) {
+  if (!MCP1_lock || MCP1_held) {
+    return;
+  }
+
+  xSemaphoreTake(MCP1_lock, portMAX_DELAY);
+  CAN1.setMode(MODE_CONFIG);
+  MCP1_held = true;
+  xSemaphoreGive(MCP1_lock);
+}
+
+/*******************************************************************
+ *  Reset and reinitialise the MCP2515 after a bus-off, clears the
+ *  error counters
+ *******************************************************************/
+int MCP1_bus_recover(void) {
+  int result;
+
+  if (!MCP1_lock) {
+    return ESP_FAIL;
+  }
+
+  xSemaphoreTake(MCP1_lock, portMAX_DELAY);
+  result = CAN1.begin((_mcp1_baudrate == 500000) ? CAN_500KBPS : CAN_250KBPS, MCP_16MHz);
+  if (result == CAN_OK) {
+    CAN1.setMode(MODE_NORMAL);
+    CAN1.enableErrorInterrupt();  // Reset by begin()
+    if (MCP1_apply_filters() != ESP_OK) {  // Restores normal mode
+      result = CAN_FAIL;
+    }
+    MCP1_held = false;
+    MCP1_bus_off = false;
+  }
+  xSemaphoreGive(MCP1_lock);
+
+  return (result == CAN_OK) ? ESP_OK : ESP_FAIL;
+}
+
 /*******************************************************************
  *  Setup Serial Paralel interface (SPI)
  *
@@ -263,6 +459,10 @@ static esp_err_t MCP1_setup_driver(int mode) {
 
   if (result == CAN_OK) {
     CAN1.setMode(MODE_NORMAL);  // Set operation mode to normal so the MCP2515 sends acks to received data.
+    CAN1.enableErrorInterrupt();  // Bus-off latch, see MCP1_bus_status()
+    if (MCP1_apply_filters() != ESP_OK) {  // Restores normal mode
+      Serial.println(F("MCP2515 acceptance filters not written, retried on the next receive."));
+    }
     pinMode(SPI0_INT, INPUT);   // Configuring pin for /INT input
     Serial.println(F("SUCCESS initialisation MCP2515 driver."));
     return ESP_OK;  // Success
@@ -272,6 +472,42 @@ static esp_err_t MCP1_setup_driver(int mode) {
   return ESP_FAIL;  // Failed
 }
 
+/*******************************************************************
+ *  Masks and filters, compiled from the CAN subscriptions. Written
+ *  in one configuration mode pass, call with MCP1_lock held. Stays
+ *  dirty when the mode switch fails, the next pass retries.
+ *******************************************************************/
+static int MCP1_apply_filters(void) {
+  CANFILTER_rule_t rules[MCP1_MAX_RULES];
+  int count = CANBUS_rules(rules, MCP1_MAX_RULES);
+  const byte mask_ext[CANFILTER_MCP_MASKS] = {1, 1};
+  unsigned long masks[CANFILTER_MCP_MASKS];
+  byte filt_ext[CANFILTER_MCP_FILTERS];
+  unsigned long filters[CANFILTER_MCP_FILTERS];
+
+  MCP1_filter_dirty = false;
+  CANFILTER_mcp2515(rules, count, &MCP1_filter);
+
+  for (int i = 0; i < CANFILTER_MCP_MASKS; i++) {
+    masks[i] = MCP1_filter.mask[i];
+  }
+  for (int i = 0; i < CANFILTER_MCP_FILTERS; i++) {
+    filt_ext[i] = MCP1_filter.ext[i];
+    filters[i] = MCP1_filter.ext[i] ? MCP1_filter.filter[i] : (MCP1_filter.filter[i] >> 18);  // SID
+  }
+
+  if (CAN1.init_MaskFilt(mask_ext, masks, filt_ext, filters) != MCP2515_OK) {
+    MCP1_filter_dirty = true;
+    _mcp1_filter_errors++;
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+static void MCP1_filter_changed(void) {
+  MCP1_filter_dirty = true;
+}
+
 /*******************************************************************
  *  Setup the MCP transmitting frame
  *
@@ -281,77 +517,179 @@ void MCP1_transmit_task(void* parameter) {
   (void)parameter;
 
   while (true) {
-    if (xQueueReceive(MCP1_TX_QUEUE, &frame, 0) == pdPASS) {
+    if (xQueueReceive(MCP1_TX_QUEUE, &frame, portMAX_DELAY) != pdPASS)
+      continue;
+
+    do {
 #ifdef DEBUG_FRAMES
       Serial.printf("MCP-TX: Send frame with id=0x%08X, length:%d, ext=%d, rtr=%d.\n\r", (int)frame.id, (int)frame.length, (int)frame.ext, (int)frame.rtr);
 #endif
       DEBUG_can("MCP-TX: ", frame.length, frame.id, frame.rtr ? 1 : 0, frame.buffer);
 
+      xSemaphoreTake(MCP1_lock, portMAX_DELAY);
       if (CAN1.sendMsgBuf((unsigned long)frame.id, frame.ext ? 1 : 0, frame.rtr ? 1 : 0, frame.length, frame.buffer) != CAN_OK) {
+        _mcp1_transmited_error++;
         MCP1_check_errors();
+        CANCAP_trigger("mcp1 transmit failed");
       }
       else {
         _mcp1_transmited++;
+        CANHEALTH_observe(CAN_CHANNEL_MCP1, frame.id, frame.ext, frame.rtr, frame.length, frame.buffer);
+        CANCAP_tx(CAN_CHANNEL_MCP1, frame.id, frame.ext, frame.rtr, frame.length, frame.buffer);
       }
+      xSemaphoreGive(MCP1_lock);
 
 #ifdef DEBUG_TASKS
       Serial.println(F("Success sending MCP CAN frame..."));
 #endif
-    }
-    vTaskDelay(50 / portTICK_PERIOD_MS);
+    } while (xQueueReceive(MCP1_TX_QUEUE, &frame, 0) == pdPASS);
   }
 }
 
 /*******************************************************************
- *  Setup the MCP receiving frame
- *
+ *  MCP2515 /INT, active low while RXB0 or RXB1 holds a frame
  *******************************************************************/
-void MCP1_receive_task(void* parameter) {
-  mcp_frame_t frame;
-  (void)parameter;
+static void ARDUINO_ISR_ATTR MCP1_isr(void) {
+  BaseType_t woken = pdFALSE;
 
-  while (true) {
-    if (CAN1.readMsgBuf(&frame.length, frame.buffer) == CAN_OK) {
-      _mcp1_received++;
+  _mcp1_rx_interrupts++;
+
+  if (MCP1_receive_task_handle) {
+    vTaskNotifyGiveFromISR(MCP1_receive_task_handle, &woken);
+    if (woken)
+      portYIELD_FROM_ISR();
+  }
+}
+
+/*******************************************************************
+ *  Read one receive buffer (READ RX BUFFER instruction, clears
+ *  the RXnIF flag when done) straight into a pooled frame
+ *******************************************************************/
+static void MCP1_read_buffer(uint8_t rxif) {
+  CAN_frame_t *frame = CANBUS_frame_alloc();
+  CAN_frame_t discard;
+  unsigned long id;
+  byte ext, rtr, length;
+
+  _mcp1_received++;
+
+  if (!frame) {
+    _mcp1_rx_dropped++;
+    frame = &discard;  // The buffer must be read to release it
+  }
+
+  CAN1.readMsgBufID(rxif, &id, &ext, &rtr, &length, frame->data);
+  CANHEALTH_observe(CAN_CHANNEL_MCP1, id, ext, rtr, length, frame->data);
 
-      frame.id = CAN1.getCanId();
-      frame.ext = CAN1.isExtendedFrame() ? 1 : 0;
-      frame.rtr = CAN1.isRemoteRequest() ? 1 : 0;
+  frame->id = id;
+  frame->ext = ext;
+  frame->rtr = rtr;
+  frame->length = length;
+  frame->channel = CAN_CHANNEL_MCP1;
 
 #ifdef DEBUG_FRAMES
-      Serial.printf("MCP-RX: Recieve frame with id=0x%08X, length:%d, ext=%d, rtr=%d.\n\r", (int)frame.id, (int)frame.length, (int)frame.ext, (int)frame.rtr);
+  Serial.printf("MCP-RX: Recieve frame with id=0x%08X, length:%d, ext=%d, rtr=%d.\n\r", (int)frame->id, (int)frame->length, (int)frame->ext, (int)frame->rtr);
 #endif
 
-      if (xQueueSend(MCP1_RX_QUEUE, &frame, 0) != pdPASS) {
-        Serial.println(F("MCP error queueing received frame..."));
-        vTaskDelay(500 / portTICK_PERIOD_MS);
-        continue;
-      }
+  if (frame != &discard) {
+    CANBUS_frame_post(frame);
+  }
+}
+
+/*******************************************************************
+ *  Read and clear EFLG and the ERRIF/MERRF interrupt flags, latch
+ *  a bus-off, call with MCP1_lock held
+ *******************************************************************/
+static uint8_t MCP1_clear_errors(void) {
+  uint8_t eflg;
+
+  CAN1.checkError(&eflg);  // Clears EFLG
+  CAN1.clearErrorIfFlags();
+
+  _mcp1_rx_overflow += ((eflg & CAN_RX0OVR) ? 1 : 0) + ((eflg & CAN_RX1OVR) ? 1 : 0);
+  if (eflg & CAN_TXBO) {
+    MCP1_bus_off = true;
+  }
+  if (eflg & (CAN_RXEP | CAN_TXBO)) {
+    _mcp1_received_error++;
+    CANCAP_trigger("mcp1 error passive or bus-off");
+  }
+  return eflg;
+}
+
+/*******************************************************************
+ *  Drain RXB0 and RXB1
+ *
+ *  One READ STATUS per pass gives both RXnIF flags, every frame is
+ *  read with a single READ RX BUFFER transaction. Passes repeat
+ *  until both buffers are empty, the overflow flags are read and
+ *  cleared once per burst. /INT still low without a frame is the
+ *  error interrupt (ERRIF), the error flags are read as well.
+ *******************************************************************/
+static uint32_t MCP1_drain(void) {
+  uint32_t burst = 0;
+  uint8_t status;
+
+  xSemaphoreTake(MCP1_lock, portMAX_DELAY);
+
+  while ((status = CAN1.readRxTxStatus() & (MCP_RX0IF | MCP_RX1IF)) != 0) {
+    if (status & MCP_RX0IF) {
+      MCP1_read_buffer(MCP_RX0IF);
+      burst++;
+    }
+    if (status & MCP_RX1IF) {
+      MCP1_read_buffer(MCP_RX1IF);
+      burst++;
     }
-    vTaskDelay(50 / portTICK_PERIOD_MS);
   }
+
+  if (burst || (digitalRead(SPI0_INT) == LOW)) {
+    MCP1_clear_errors();
+  }
+
+  xSemaphoreGive(MCP1_lock);
+  return burst;
 }
 
 /*******************************************************************
- *  MCP main task
+ *  MCP receive task, woken by the /INT interrupt
+ *
  *******************************************************************/
-void MCP1_main_task(void* parameter) {
-  mcp_frame_t frame;
+void MCP1_receive_task(void* parameter) {
+  uint32_t burst;
+  int passes;
+  int result;
   (void)parameter;
 
   while (true) {
-    if (xQueueReceive(MCP1_RX_QUEUE, &frame, 0) == pdPASS) {
-      _mcp1_received++;
-
-    #ifdef DEBUG_FRAMES
-      Serial.printf("MCP-RX: Process frame with id=0x%08X, length:%d, ext=%d, rtr=%d.\n\r", (int)frame.id, (int)frame.length, (int)frame.ext, (int)frame.rtr);
-    #endif
-
-      if (MCP1_receive_handler)
-        MCP1_receive_handler(frame.id, frame.buffer, frame.length, frame.rtr ? true : false, frame.ext ? true : false);
+    ulTaskNotifyTake(pdTRUE, MCP1_RX_TIMEOUT_MS / portTICK_PERIOD_MS);
+
+    /* /INT is level triggered, a frame that arrived during the drain gives no new edge */
+    passes = 0;
+    do {
+      burst = MCP1_drain();
+      if (burst > _mcp1_rx_burst_max)
+        _mcp1_rx_burst_max = burst;
+    } while ((digitalRead(SPI0_INT) == LOW) && (++passes < MCP1_DRAIN_PASSES));
+
+    /* Still low: clear the error flags, let other tasks run and drain again */
+    if (digitalRead(SPI0_INT) == LOW) {
+      _mcp1_rx_drain_capped++;
+
+      xSemaphoreTake(MCP1_lock, portMAX_DELAY);
+      MCP1_clear_errors();
+      xSemaphoreGive(MCP1_lock);
+
+      xTaskNotifyGive(MCP1_receive_task_handle);
+      vTaskDelay(1);
     }
 
-    vTaskDelay(100 / portTICK_PERIOD_MS);
+    if (MCP1_filter_dirty) {
+      xSemaphoreTake(MCP1_lock, portMAX_DELAY);
+      result = MCP1_apply_filters();
+      xSemaphoreGive(MCP1_lock);
+      CLI_println((result == ESP_OK) ? "MCP acceptance filters updated." : "MCP acceptance filters not written.");
+    }
   }
 }
 
@@ -359,9 +697,7 @@ void MCP1_main_task(void* parameter) {
  * REST API: read handler
  *********************************************************************/
 void MCP1_rest_read(AsyncWebServerRequest* request) {
-  String str;
-  serializeJson(MCP1_json(), str);
-  request->send(200, "application/json", str.c_str());
+  WEBSERVER_send_json(request, MCP1_json);
 }
 
 static rest_api_t MCP1_api_handlers = {
@@ -394,8 +730,8 @@ void MCP1_cli_handlers(void) {
  *
  *******************************************************************/
 void MCP1_setup_queues() {
-  MCP1_TX_QUEUE = xQueueCreate(10, sizeof(mcp_frame_t)); // Transmit queue
-  MCP1_RX_QUEUE = xQueueCreate(10, sizeof(mcp_frame_t)); // Receive queue
+  MCP1_TX_QUEUE = xQueueCreate(MCP1_QUEUE_LEN, sizeof(mcp_frame_t)); // Transmit queue
+  MCP1_lock = xSemaphoreCreateMutex();
 }
 
 /*******************************************************************
@@ -403,8 +739,8 @@ void MCP1_setup_queues() {
  *
  *******************************************************************/
 void MCP1_setup_tasks() {
-  xTaskCreate(MCP1_main_task, "MCP main task", 4096, NULL, 3, NULL);
-  xTaskCreate(MCP1_receive_task, "MCP receive task", 4096, NULL, 5, NULL);
+  xTaskCreate(MCP1_receive_task, "MCP receive task", 4096, NULL, 6, &MCP1_receive_task_handle);
+  attachInterrupt(digitalPinToInterrupt(SPI0_INT), MCP1_isr, FALLING);
   xTaskCreate(MCP1_transmit_task, "MCP transmit task", 2048, NULL, 5, NULL);
 }
 
@@ -413,6 +749,7 @@ void MCP1_setup_tasks() {
  *
  *******************************************************************/
 void MCP1_setup(int mode) {
+  CANBUS_setup();
   MCP1_setup_queues();
   MCP1_setup_SPI();
 
@@ -421,6 +758,7 @@ void MCP1_setup(int mode) {
     return;
   }
 
+  CANBUS_on_change(MCP1_filter_changed);
   MCP1_setup_tasks();
 
   MCP1_cli_handlers();
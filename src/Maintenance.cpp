@@ -11,7 +11,6 @@
 #include <Endian.h>
 #include <Math.h>
 #include <WebServer.h>
-#include <WebSocketsServer.h>
 
 #include "Azimuth.h"
 #include "CLI.h"
@@ -32,11 +31,13 @@
  *******************************************************************/
 #define DEBUG_MAINTENANCE
 
+#define MAINTENANCE_TICK_MS 500       // Homing countdown and values to the websocket
+#define MAINTENANCE_COMMAND_MAX 256   // Websocket command, including the terminator
+#define MAINTENANCE_COMMAND_QUEUE 4
+
 /*******************************************************************
  * JSON and Websocket keys
  *******************************************************************/
-#define JSON_MAINTENANCE_ENABLED "maintenance_enabled"
-
 #define JSON_STEERWHEEL_CALIBRATION_SAVE "save_steeringwheel_calibration"
 #define JSON_STEERWHEEL_CALIBRATION_RESTORE "restore_steeringwheel_calibration"
 
@@ -48,6 +49,12 @@ static JsonDocument maintenance_data;
 static int azimuth_homing_timer = 0;
 static int lift_homing_timer = 0;
 
+typedef struct {
+  char data[MAINTENANCE_COMMAND_MAX];
+} maintenance_command_t;
+
+static QueueHandle_t maintenance_commands = nullptr;  // Websocket commands to the worker task
+
 /*******************************************************************
  * Forwards
  *******************************************************************/
@@ -90,7 +97,7 @@ static void MAINTENANCE_json_init(void) {
   WEBSOCKET_send_doc(maintenance_data);
 }
 
-static JsonDocument MAINTENANCE_json(void) {
+static JsonDocument MAINTENANCE_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
   maintenance_data[JSON_EMERGENCY_STOP] = EMERGENCY_STOP_active();
 
   // Lift
@@ -123,7 +130,9 @@ static JsonDocument MAINTENANCE_json(void) {
   maintenance_data[JSON_STEERWHEEL_MIDDLE] = STEERWHEEL_get_middle();
   maintenance_data[JSON_STEERWHEEL_ACTUAL] = STEERWHEEL_get_actual();
 
-  return maintenance_data;
+  JsonDocument doc(allocator);
+  doc.set(maintenance_data);
+  return doc;
 }
 
 /********************************************************************
@@ -200,10 +209,12 @@ void MAINTENANCE_enable(void) {
   if (!EMERGENCY_STOP_active()) {
     maintenance_data[JSON_MAINTENANCE_ENABLED] = true;
 
+    PCF8574_begin(PCF8574_address);
     DMC_disable();
     LIFT_disable();
     AZIMUTH_disable();
     AZIMUTH_analog_disable();
+    PCF8574_commit();
 
 #ifdef DEBUG_MAINTENANCE
     Serial.println(F("MAINTENACE mode enabled."));
@@ -220,10 +231,12 @@ void MAINTENANCE_enable(void) {
 void MAINTENANCE_disable(void) {
   maintenance_data[JSON_MAINTENANCE_ENABLED] = false;
 
+  PCF8574_begin(PCF8574_address);
   DMC_disable();
   LIFT_disable();
   AZIMUTH_disable();
   AZIMUTH_analog_disable();
+  PCF8574_commit();
 
 #ifdef DEBUG_MAINTENANCE
   Serial.println(F("MAINTENACE mode disabled."));
@@ -327,8 +340,10 @@ static void MAINTENANCE_lift_motor_down(void) {
 }
 
 static void MAINTENANCE_lift_motor_off(void) {
+  PCF8574_begin(PCF8574_address);
   LIFT_DOWN_off();
   LIFT_UP_off();
+  PCF8574_commit();
 }
 
 static void MAINTENANCE_lift_homing(void) {
@@ -589,9 +604,7 @@ int MAINTENANCE_command_handler(const char *data) {
  * REST API: read handler
  *********************************************************************/
 void MAINTENANCE_rest_read(AsyncWebServerRequest *request) {
-  String str;
-  serializeJson(MAINTENANCE_json(), str);
-  request->send(200, "application/json", str.c_str());
+  WEBSERVER_send_json(request, MAINTENANCE_json);
 }
 
 void MAINTENANCE_rest_update(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
@@ -619,15 +632,45 @@ static rest_api_t MAINTENANCE_api_handlers = {
 };
 
 /********************************************************************
- * WebSocketsServer task
+ * Queues a websocket command for the worker task, the websocket
+ * events run in the AsyncTCP task and must not wait for the motors.
+ *********************************************************************/
+int MAINTENANCE_queue_command(const char *data, size_t len) {
+  maintenance_command_t command;
+
+  if (!maintenance_commands || (len >= sizeof(command.data))) {
+    return ESP_FAIL;
+  }
+  memcpy(command.data, data, len);
+  command.data[len] = '\0';
+
+  return (xQueueSend(maintenance_commands, &command, 0) == pdTRUE) ? ESP_OK : ESP_FAIL;
+}
+
+/********************************************************************
+ * Worker task, runs the queued websocket commands and every tick
+ * the homing countdown and the values to the websocket.
  *********************************************************************/
-static void MAINTENACE_websocket_task(void *parameter) {
+static void MAINTENANCE_worker_task(void *parameter) {
+  maintenance_command_t command;
+  TickType_t tick = xTaskGetTickCount() + pdMS_TO_TICKS(MAINTENANCE_TICK_MS);
   (void)parameter;
 
   // One time push of all maintenance data
   WEBSOCKET_send_doc(MAINTENANCE_json());
 
   while (true) {
+    const TickType_t now = xTaskGetTickCount();
+    const TickType_t wait = ((int32_t)(tick - now) > 0) ? (tick - now) : 0;
+
+    if (xQueueReceive(maintenance_commands, &command, wait) == pdTRUE) {
+      if (MAINTENANCE_command_handler(command.data) < 0) {
+        Serial.println(F("MAINTENANCE command handler failed!"));
+      }
+      continue;
+    }
+    tick += pdMS_TO_TICKS(MAINTENANCE_TICK_MS);
+
     /* After countdown lift disable status homing */
     if (lift_homing_timer >= 0) {
       if (--lift_homing_timer == 0) {
@@ -646,7 +689,6 @@ static void MAINTENACE_websocket_task(void *parameter) {
     }
 
     WEBSOCKET_update_doc(MAINTENANCE_json());
-    vTaskDelay(500 / portTICK_PERIOD_MS);
   }
 }
 
@@ -687,7 +729,7 @@ void MAINTENANCE_main_task(void *parameter) {
  *
  *********************************************************************/
 static void MAINTENANCE_setup_tasks(void) {
-  xTaskCreate(MAINTENACE_websocket_task, "WebSocketServer task", 8192, NULL, 15, NULL);
+  xTaskCreate(MAINTENANCE_worker_task, "Maintenance worker", 8192, NULL, 15, NULL);
   xTaskCreate(MAINTENANCE_main_task, "Maintenance main", 16000, NULL, 15, NULL);
 }
 
@@ -703,6 +745,7 @@ static void MAINTENANCE_cli_handlers(void) {
  *******************************************************************/
 void MAINTENANCE_setup(void) {
   MAINTENANCE_json_init();
+  maintenance_commands = xQueueCreate(MAINTENANCE_COMMAND_QUEUE, sizeof(maintenance_command_t));
   MAINTENANCE_cli_handlers();
   setup_uri(&MAINTENANCE_api_handlers);
 
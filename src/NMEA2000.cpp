@@ -0,0 +1,504 @@
+/*******************************************************************
+ * NMEA2000.cpp
+ *
+ * NMEA2000 on the TWAI channel.
+ *
+ * The protocol logic (identifiers, address claim, fast-packet and
+ * the PGN codec) is in EBC_Utils, this module connects it to the
+ * CAN dispatch table and the transmit schedule. Received frames are
+ * handled in the CAN dispatch task, fast-packet messages are
+ * reassembled in a fixed slot pool without allocation. The azimuth
+ * (rudder) and thruster status are broadcast by the CAN schedule
+ * once the address claim has settled.
+ *
+ *******************************************************************/
+#include "NMEA2000.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <math.h>
+
+#include "Azimuth.h"
+#include "CANBus.h"
+#include "CANSchedule.h"
+#include "CLI.h"
+#include "Config.h"
+#include "DMC.h"
+#include "Lift.h"
+#include "TWAICom.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define NMEA2000_PREFERRED_ADDRESS 35
+#define NMEA2000_MANUFACTURER 2046     // Not assigned
+#define NMEA2000_DEVICE_FUNCTION 180   // Actuator
+#define NMEA2000_DEVICE_CLASS 40       // Propulsion
+#define NMEA2000_INDUSTRY_MARINE 4
+#define NMEA2000_CLAIM_SETTLE_MS 250   // Address usable after the claim
+#define NMEA2000_AZIMUTH_FULL_DEG 45   // Azimuth angle at LINEAR_MIN/LINEAR_MAX
+
+#define NMEA2000_RUDDER_PERIOD_MS 100
+#define NMEA2000_THRUSTER_PERIOD_MS 1000
+
+#define NMEA2000_MASK_PDU1 0x03FF0000UL  // Data page and PDU format
+#define NMEA2000_MASK_PDU2 0x03FFFF00UL  // Data page, PDU format and specific
+
+typedef struct {
+  uint32_t pgn;
+  uint8_t source;
+  uint32_t received;
+  uint32_t last_ms;
+  double values[N2K_ENGINE_FIELDS];  // Largest PGN in the codec table
+} nmea2000_rx_t;
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static N2K_claim_t nmea2000_claim;
+static uint32_t nmea2000_claim_ms = 0;
+static N2K_fp_pool_t nmea2000_pool;  // CAN dispatch task only
+static SemaphoreHandle_t nmea2000_lock = nullptr;  // Received values, fast-packet sequence
+static uint8_t nmea2000_sequence = 0;
+
+static nmea2000_rx_t nmea2000_rx[] = {
+    {N2K_PGN_RUDDER},
+    {N2K_PGN_ENGINE_RAPID},
+    {N2K_PGN_ENGINE_DYNAMIC},
+    {N2K_PGN_THRUSTER_STATUS},
+};
+
+#define NMEA2000_NUM_RX (sizeof(nmea2000_rx) / sizeof(nmea2000_rx[0]))
+
+static uint32_t nmea2000_frames = 0;
+static uint32_t nmea2000_requests = 0;
+static uint32_t nmea2000_naks = 0;
+
+/*******************************************************************
+ * Address claim
+ *******************************************************************/
+static bool NMEA2000_claimed(void) {
+  return (nmea2000_claim.address != N2K_ADDRESS_NULL) &&
+         ((millis() - nmea2000_claim_ms) >= NMEA2000_CLAIM_SETTLE_MS);
+}
+
+static void NMEA2000_send_claim(void) {
+  N2K_header_t header = {6, N2K_PGN_ADDRESS_CLAIM, nmea2000_claim.address, N2K_ADDRESS_GLOBAL};
+  uint8_t data[8];
+
+  N2K_name_encode(nmea2000_claim.name, data);
+  TWAI_send(N2K_id_encode(&header), data, sizeof(data), false, true);
+  nmea2000_claim_ms = millis();
+}
+
+/*******************************************************************
+ * Send
+ *******************************************************************/
+int NMEA2000_send(const N2K_pgn_t *pgn, const double *values, uint8_t destination) {
+  N2K_header_t header = {pgn->priority, pgn->pgn, nmea2000_claim.address, destination};
+  uint8_t payload[N2K_FAST_PACKET_MAX];
+  uint8_t frame[8];
+  int result = ESP_OK;
+
+  if (!NMEA2000_claimed()) {
+    return ESP_FAIL;
+  }
+
+  const uint8_t length = N2K_encode(pgn, values, payload);
+  const uint32_t id = N2K_id_encode(&header);
+
+  if (!pgn->fast) {
+    return TWAI_send(id, payload, length, false, true);
+  }
+
+  xSemaphoreTake(nmea2000_lock, portMAX_DELAY);  // Frames of one message stay together
+  const uint8_t sequence = nmea2000_sequence;
+  nmea2000_sequence = (nmea2000_sequence + 1) & 0x07;
+
+  for (uint8_t index = 0; (index < N2K_fp_frames(length)) && (result == ESP_OK); index++) {
+    N2K_fp_frame(sequence, payload, length, index, frame);
+    result = TWAI_send(id, frame, sizeof(frame), false, true);
+  }
+  xSemaphoreGive(nmea2000_lock);
+
+  return result;
+}
+
+/*******************************************************************
+ * Azimuth angle in radians, from the linear steering value
+ *******************************************************************/
+static double NMEA2000_azimuth_rad(void) {
+  const double linear = AZIMUTH_get_actual() - LINEAR_MIDDLE;
+  return linear / (LINEAR_MAX - LINEAR_MIDDLE) * NMEA2000_AZIMUTH_FULL_DEG * M_PI / 180.0;
+}
+
+/*******************************************************************
+ * Scheduled broadcasts, payload built just before the release
+ *******************************************************************/
+static bool NMEA2000_rudder(CAN_frame_t *frame, void *context) {
+  const N2K_pgn_t *pgn = (const N2K_pgn_t *)context;
+  N2K_header_t header = {pgn->priority, pgn->pgn, nmea2000_claim.address, N2K_ADDRESS_GLOBAL};
+  double values[N2K_RUDDER_FIELDS];
+
+  if (!NMEA2000_claimed()) {
+    return false;
+  }
+
+  values[N2K_RUDDER_INSTANCE] = 0;
+  values[N2K_RUDDER_DIRECTION] = NAN;
+  values[N2K_RUDDER_ANGLE_ORDER] = NMEA2000_azimuth_rad();
+  values[N2K_RUDDER_POSITION] = NAN;  // No position feedback
+
+  frame->id = N2K_id_encode(&header);
+  frame->length = N2K_encode(pgn, values, frame->data);
+  return true;
+}
+
+static bool NMEA2000_thruster(CAN_frame_t *frame, void *context) {
+  const N2K_pgn_t *pgn = (const N2K_pgn_t *)context;
+  N2K_header_t header = {pgn->priority, pgn->pgn, nmea2000_claim.address, N2K_ADDRESS_GLOBAL};
+  double values[N2K_THRUSTER_FIELDS];
+  static uint8_t sid = 0;
+
+  if (!NMEA2000_claimed()) {
+    return false;
+  }
+
+  double azimuth = NMEA2000_azimuth_rad();
+  if (azimuth < 0) {
+    azimuth += 2 * M_PI;  // Unsigned field, 0 ... 2 pi
+  }
+
+  values[N2K_THRUSTER_SID] = sid++;
+  values[N2K_THRUSTER_IDENTIFIER] = 0;
+  values[N2K_THRUSTER_DIRECTION] = NAN;
+  values[N2K_THRUSTER_POWER] = DMC_enabled() ? 1 : 0;
+  values[N2K_THRUSTER_RETRACT] = LIFT_UP_moving() ? 2 : (LIFT_DOWN_moving() ? 1 : 0);
+  values[N2K_THRUSTER_SPEED] = NAN;
+  values[N2K_THRUSTER_EVENTS] = 0;
+  values[N2K_THRUSTER_TIMEOUT] = NAN;
+  values[N2K_THRUSTER_AZIMUTH] = azimuth;
+
+  frame->id = N2K_id_encode(&header);
+  frame->length = N2K_encode(pgn, values, frame->data);
+  return true;
+}
+
+/*******************************************************************
+ * Received messages
+ *******************************************************************/
+static void NMEA2000_request(const N2K_header_t *header, const uint8_t *data, uint8_t length) {
+  const N2K_pgn_t *pgn;
+  uint32_t requested;
+  CAN_frame_t frame;
+
+  if ((header->destination != N2K_ADDRESS_GLOBAL) && (header->destination != nmea2000_claim.address)) {
+    return;
+  }
+  if (!N2K_request_decode(data, length, &requested)) {
+    return;
+  }
+
+  nmea2000_requests++;
+
+  if (requested == N2K_PGN_ADDRESS_CLAIM) {
+    NMEA2000_send_claim();
+    return;
+  }
+
+  pgn = N2K_pgn_find(requested);
+  if (pgn && (requested == N2K_PGN_RUDDER) && NMEA2000_rudder(&frame, (void *)pgn)) {
+    TWAI_send(frame.id, frame.data, frame.length, false, true);
+    return;
+  }
+  if (pgn && (requested == N2K_PGN_THRUSTER_STATUS) && NMEA2000_thruster(&frame, (void *)pgn)) {
+    TWAI_send(frame.id, frame.data, frame.length, false, true);
+    return;
+  }
+
+  if ((header->destination != N2K_ADDRESS_GLOBAL) && NMEA2000_claimed()) {
+    N2K_header_t nak = {6, N2K_PGN_ISO_ACK, nmea2000_claim.address, header->source};
+    uint8_t payload[8];
+
+    N2K_nak_encode(requested, payload);
+    TWAI_send(N2K_id_encode(&nak), payload, sizeof(payload), false, true);
+    nmea2000_naks++;
+  }
+}
+
+static void NMEA2000_store(const N2K_header_t *header, const uint8_t *data, uint8_t length) {
+  const N2K_pgn_t *pgn = N2K_pgn_find(header->pgn);
+
+  if (!pgn) {
+    return;
+  }
+
+  for (unsigned i = 0; i < NMEA2000_NUM_RX; i++) {
+    nmea2000_rx_t *rx = &nmea2000_rx[i];
+
+    if (rx->pgn != header->pgn) {
+      continue;
+    }
+
+    xSemaphoreTake(nmea2000_lock, portMAX_DELAY);
+    N2K_decode(pgn, data, length, rx->values);
+    rx->source = header->source;
+    rx->last_ms = millis();
+    rx->received++;
+    xSemaphoreGive(nmea2000_lock);
+    return;
+  }
+}
+
+/*******************************************************************
+ * CAN dispatch handler, all subscribed PGNs
+ *******************************************************************/
+static void NMEA2000_handler(const CAN_frame_t *frame, void *context) {
+  N2K_header_t header;
+  N2K_message_t message;
+  const N2K_pgn_t *pgn;
+  (void)context;
+
+  if ((frame->channel != CAN_CHANNEL_TWAI) || !frame->ext) {
+    return;
+  }
+
+  nmea2000_frames++;
+  N2K_id_decode(frame->id, &header);
+
+  switch (header.pgn) {
+    case N2K_PGN_ADDRESS_CLAIM:
+      if (N2K_claim_received(&nmea2000_claim, header.source, N2K_name_decode(frame->data, frame->length))) {
+        NMEA2000_send_claim();
+      }
+      return;
+
+    case N2K_PGN_ISO_REQUEST:
+      NMEA2000_request(&header, frame->data, frame->length);
+      return;
+  }
+
+  if (header.source == nmea2000_claim.address) {
+    return;  // Own broadcast
+  }
+
+  pgn = N2K_pgn_find(header.pgn);
+  if (pgn && pgn->fast) {
+    if (N2K_fp_receive(&nmea2000_pool, &header, frame->data, frame->length, millis(), &message)) {
+      NMEA2000_store(&message.header, message.data, message.length);
+    }
+    return;
+  }
+
+  NMEA2000_store(&header, frame->data, frame->length);
+}
+
+/*******************************************************************
+ * Last received values
+ *******************************************************************/
+int32_t NMEA2000_received(uint32_t pgn, double *values) {
+  const N2K_pgn_t *desc = N2K_pgn_find(pgn);
+
+  for (unsigned i = 0; desc && (i < NMEA2000_NUM_RX); i++) {
+    const nmea2000_rx_t *rx = &nmea2000_rx[i];
+    int32_t age;
+
+    if ((rx->pgn != pgn) || !rx->received) {
+      continue;
+    }
+
+    xSemaphoreTake(nmea2000_lock, portMAX_DELAY);
+    memcpy(values, rx->values, desc->num_fields * sizeof(double));
+    age = (int32_t)(millis() - rx->last_ms);
+    xSemaphoreGive(nmea2000_lock);
+    return age;
+  }
+
+  return -1;
+}
+
+/********************************************************************
+ * Create JSON data
+ *******************************************************************/
+static JsonDocument NMEA2000_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+  char name[20];
+
+  snprintf(name, sizeof(name), "%08X%08X", (unsigned)(nmea2000_claim.name >> 32), (unsigned)nmea2000_claim.name);
+
+  doc[JSON_NMEA2000_ADDRESS] = nmea2000_claim.address;
+  doc[JSON_NMEA2000_NAME] = name;
+  doc[JSON_NMEA2000_CONFLICTS] = nmea2000_claim.conflicts;
+  doc[JSON_NMEA2000_FRAMES] = nmea2000_frames;
+  doc[JSON_NMEA2000_REQUESTS] = nmea2000_requests;
+  doc[JSON_NMEA2000_NAKS] = nmea2000_naks;
+  doc[JSON_NMEA2000_FP_COMPLETED] = nmea2000_pool.completed;
+  doc[JSON_NMEA2000_FP_LOST] = nmea2000_pool.lost;
+  doc[JSON_NMEA2000_FP_DROPPED] = nmea2000_pool.dropped;
+  doc[JSON_NMEA2000_FP_TIMEOUTS] = nmea2000_pool.timeouts;
+
+  JsonArray pgns = doc[JSON_NMEA2000_PGNS].to<JsonArray>();
+  for (unsigned i = 0; i < NMEA2000_NUM_RX; i++) {
+    const nmea2000_rx_t *rx = &nmea2000_rx[i];
+    const N2K_pgn_t *pgn = N2K_pgn_find(rx->pgn);
+    double values[N2K_ENGINE_FIELDS];
+    int32_t age = NMEA2000_received(rx->pgn, values);
+    JsonObject obj = pgns.add<JsonObject>();
+
+    obj["pgn"] = rx->pgn;
+    obj["name"] = pgn->name;
+    obj["received"] = rx->received;
+    if (age < 0) {
+      continue;
+    }
+
+    obj["source"] = rx->source;
+    obj["age-ms"] = age;
+    JsonObject fields = obj["fields"].to<JsonObject>();
+    for (int f = 0; f < pgn->num_fields; f++) {
+      if (isnan(values[f])) {
+        fields[pgn->field[f].name] = nullptr;
+      } else {
+        fields[pgn->field[f].name] = values[f];
+      }
+    }
+  }
+
+  return doc;
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String NMEA2000_info_str(void) {
+  JsonDocument doc = NMEA2000_json();
+
+  String text = "--- NMEA2000 ---";
+
+  text.concat("\r\nAddress: ");
+  text.concat(doc[JSON_NMEA2000_ADDRESS].as<int>());
+  text.concat(", NAME: ");
+  text.concat(doc[JSON_NMEA2000_NAME].as<const char *>());
+  text.concat(", conflicts: ");
+  text.concat(doc[JSON_NMEA2000_CONFLICTS].as<int>());
+
+  text.concat("\r\nReceived frames: ");
+  text.concat(doc[JSON_NMEA2000_FRAMES].as<int>());
+  text.concat(", requests: ");
+  text.concat(doc[JSON_NMEA2000_REQUESTS].as<int>());
+  text.concat(" (NAK ");
+  text.concat(doc[JSON_NMEA2000_NAKS].as<int>());
+  text.concat(")");
+
+  text.concat("\r\nFast-packet completed: ");
+  text.concat(doc[JSON_NMEA2000_FP_COMPLETED].as<int>());
+  text.concat(", lost: ");
+  text.concat(doc[JSON_NMEA2000_FP_LOST].as<int>());
+  text.concat(", dropped: ");
+  text.concat(doc[JSON_NMEA2000_FP_DROPPED].as<int>());
+  text.concat(", timeouts: ");
+  text.concat(doc[JSON_NMEA2000_FP_TIMEOUTS].as<int>());
+
+  for (JsonObject obj : doc[JSON_NMEA2000_PGNS].as<JsonArray>()) {
+    text.concat("\r\n");
+    text.concat(obj["pgn"].as<int>());
+    text.concat(" ");
+    text.concat(obj["name"].as<const char *>());
+    text.concat(": ");
+    text.concat(obj["received"].as<int>());
+    text.concat(" received");
+
+    if (!obj["age-ms"].isNull()) {
+      text.concat(", source ");
+      text.concat(obj["source"].as<int>());
+      text.concat(", ");
+      text.concat(obj["age-ms"].as<int>());
+      text.concat("ms ago");
+    }
+  }
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void NMEA2000_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, NMEA2000_json);
+}
+
+static rest_api_t NMEA2000_api_handlers = {
+    /* uri */ "/api/v1/nmea2000",
+    /* comment */ "NMEA2000",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ NMEA2000_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(NMEA2000_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("claim")) {
+    N2K_claim_init(&nmea2000_claim, nmea2000_claim.name, NMEA2000_PREFERRED_ADDRESS);
+    NMEA2000_send_claim();
+    CLI_println("NMEA2000 address claim sent.");
+    return;
+  }
+
+  CLI_println("Invalid command: NMEA2000 (claim).");
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void NMEA2000_setup(int mode) {
+  N2K_name_fields_t fields = {};
+  const N2K_pgn_t *pgn;
+
+  TWAI_setup(mode);
+
+  nmea2000_lock = xSemaphoreCreateMutex();
+  N2K_fp_init(&nmea2000_pool);
+
+  fields.identity = (uint32_t)ESP.getEfuseMac();  // Lower 21 bits are used
+  fields.manufacturer = NMEA2000_MANUFACTURER;
+  fields.device_function = NMEA2000_DEVICE_FUNCTION;
+  fields.device_class = NMEA2000_DEVICE_CLASS;
+  fields.industry_group = NMEA2000_INDUSTRY_MARINE;
+  fields.arbitrary_address = true;
+  N2K_claim_init(&nmea2000_claim, N2K_name(&fields), NMEA2000_PREFERRED_ADDRESS);
+
+  CANBUS_subscribe("n2k-request", DISPATCH_ID_EXT | (N2K_PGN_ISO_REQUEST << 8), NMEA2000_MASK_PDU1, NMEA2000_handler);
+  CANBUS_subscribe("n2k-claim", DISPATCH_ID_EXT | (N2K_PGN_ADDRESS_CLAIM << 8), NMEA2000_MASK_PDU1, NMEA2000_handler);
+  for (unsigned i = 0; i < NMEA2000_NUM_RX; i++) {
+    CANBUS_subscribe(N2K_pgn_find(nmea2000_rx[i].pgn)->name, DISPATCH_ID_EXT | (nmea2000_rx[i].pgn << 8),
+                     NMEA2000_MASK_PDU2, NMEA2000_handler);
+  }
+
+  NMEA2000_send_claim();
+
+  pgn = N2K_pgn_find(N2K_PGN_RUDDER);
+  CANSCHED_add("n2k-rudder", CAN_CHANNEL_TWAI, 0, true, 8, nullptr, NMEA2000_RUDDER_PERIOD_MS,
+               NMEA2000_CLAIM_SETTLE_MS, pgn->priority, NMEA2000_rudder, (void *)pgn);
+  pgn = N2K_pgn_find(N2K_PGN_THRUSTER_STATUS);
+  CANSCHED_add("n2k-thruster", CAN_CHANNEL_TWAI, 0, true, 8, nullptr, NMEA2000_THRUSTER_PERIOD_MS,
+               NMEA2000_CLAIM_SETTLE_MS + NMEA2000_RUDDER_PERIOD_MS / 2, pgn->priority, NMEA2000_thruster, (void *)pgn);
+
+  cli.addBoundlessCmd("nmea2000", clicb_handler);
+  setup_uri(&NMEA2000_api_handlers);
+
+  Serial.println(F("NMEA2000 setup completed..."));
+}
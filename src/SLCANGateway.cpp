@@ -0,0 +1,530 @@
+/*******************************************************************
+ * SLCANGateway.cpp
+ *
+ * SLCAN (LAWICEL) gateway.
+ *
+ * The RCU behaves like a CANUSB/CAN232 adapter on one CAN channel,
+ * over UART0 or a TCP socket. On the PC:
+ *
+ *   slcand -o -s6 -S2000000 /dev/ttyUSB0 can0      (UART0, S6 = 500k)
+ *   socat pty,link=/dev/ttyRCU,raw tcp:<ip>:3333   (TCP, then slcand
+ *                                                   on /dev/ttyRCU)
+ *
+ * SavvyCAN connects with its LAWICEL/SLCAN driver to the same tty.
+ *
+ * Received frames of the channel are copied by a catch-all CAN
+ * subscription into the gateway queue. The gateway task wakes every
+ * tick, handles the commands of the PC, formats all queued frames
+ * into one output buffer and writes it with a single write. Parsing
+ * and formatting (EBC_Utils) work on fixed buffers, nothing is
+ * allocated per frame.
+ *
+ *******************************************************************/
+#include "SLCANGateway.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+
+#include "CLI.h"
+#include "Config.h"
+#include "MCPCom.h"
+#include "TWAICom.h"
+#include "WebServer.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define SLCANGW_TICK_MS 5          // One write per tick
+#define SLCANGW_RX_QUEUE_SIZE 256  // Frames, 50 ms of a fully loaded 1 Mbit/s bus
+#define SLCANGW_OUT_SIZE 4096      // Output buffer, written once per tick
+#define SLCANGW_VERSION "V1013"    // Same as the LAWICEL code in lib/CAN_BUS_Shield
+
+typedef struct {
+  CAN_frame_t frame;
+  uint32_t time_ms;
+} slcangw_rx_t;
+
+static const char *SLCANGW_PORT_NAMES[] = {"none", "uart", "tcp"};
+
+/*******************************************************************
+ * Global variables
+ *******************************************************************/
+static QueueHandle_t slcangw_rx_queue = nullptr;
+static TaskHandle_t slcangw_task_handle = nullptr;
+static WiFiServer slcangw_server(SLCANGW_TCP_PORT);
+static WiFiClient slcangw_client;
+
+static volatile slcangw_port_t slcangw_port = SLCANGW_PORT_NONE;
+static volatile can_channel_t slcangw_channel = CAN_CHANNEL_TWAI;
+static volatile bool slcangw_open = false;  // CAN channel opened by the PC
+static int slcangw_subs[2] = {-1, -1};  // Catch-all standard and extended, enabled while open
+static bool slcangw_listen = false;
+static bool slcangw_timestamp = false;
+static bool slcangw_autopoll = true;
+static uint8_t slcangw_flags = 0;  // SLCAN_FLAG_, cleared by F
+
+static SLCAN_reader_t slcangw_reader;
+static char slcangw_out[SLCANGW_OUT_SIZE];
+static size_t slcangw_out_len = 0;
+static Stream *slcangw_stream = nullptr;  // Port of this tick
+
+static uint32_t slcangw_rx_frames = 0;
+static uint32_t slcangw_rx_overflow = 0;
+static uint32_t slcangw_tx_frames = 0;
+static uint32_t slcangw_tx_failed = 0;
+static uint32_t slcangw_errors = 0;
+static uint32_t slcangw_writes = 0;
+static uint32_t slcangw_write_max = 0;
+
+/*******************************************************************
+ * Catch-all subscription, in the CAN dispatch task
+ *******************************************************************/
+static void SLCANGW_handler(const CAN_frame_t *frame, void *context) {
+  slcangw_rx_t rx;
+  (void)context;
+
+  if (!slcangw_open || (frame->channel != slcangw_channel)) {
+    return;
+  }
+
+  rx.frame = *frame;
+  rx.time_ms = millis();
+  if (xQueueSend(slcangw_rx_queue, &rx, 0) != pdPASS) {
+    slcangw_rx_overflow++;
+    slcangw_flags |= SLCAN_FLAG_RX_FULL | SLCAN_FLAG_OVERRUN;
+  }
+}
+
+/*******************************************************************
+ * Open and close the channel, the catch-all subscriptions open the
+ * hardware filters for all frames only while the channel is open
+ *******************************************************************/
+static void SLCANGW_set_open(bool open) {
+  slcangw_open = open;
+
+  if (open && (slcangw_subs[0] < 0)) {
+    slcangw_subs[0] = CANBUS_subscribe("slcan-std", 0, 0, SLCANGW_handler);
+    slcangw_subs[1] = CANBUS_subscribe("slcan-ext", DISPATCH_ID_EXT, 0, SLCANGW_handler);
+    return;
+  }
+  for (int sub : slcangw_subs) {
+    if (sub >= 0) {
+      CANBUS_enable(sub, open);
+    }
+  }
+}
+
+/*******************************************************************
+ * Output buffer, one write per tick
+ *******************************************************************/
+static void SLCANGW_flush(void) {
+  if (!slcangw_out_len) {
+    return;
+  }
+
+  if (slcangw_stream) {
+    slcangw_stream->write((const uint8_t *)slcangw_out, slcangw_out_len);
+    slcangw_writes++;
+    if (slcangw_out_len > slcangw_write_max) {
+      slcangw_write_max = slcangw_out_len;
+    }
+  }
+  slcangw_out_len = 0;
+}
+
+static void SLCANGW_out(const char *text, size_t len) {
+  if (slcangw_out_len + len > sizeof(slcangw_out)) {
+    SLCANGW_flush();  // More than a tick worth of frames
+  }
+  memcpy(&slcangw_out[slcangw_out_len], text, len);
+  slcangw_out_len += len;
+}
+
+static void SLCANGW_reply(char reply) {
+  SLCANGW_out(&reply, 1);
+}
+
+/*******************************************************************
+ * Queued frames to the output buffer
+ *
+ * @param max Frames to send, -1 is all.
+ *******************************************************************/
+static int SLCANGW_frames(int max) {
+  char line[SLCAN_LINE_MAX];
+  slcangw_rx_t rx;
+  int count = 0;
+
+  while (((max < 0) || (count < max)) && (xQueueReceive(slcangw_rx_queue, &rx, 0) == pdPASS)) {
+    SLCANGW_out(line, SLCAN_format(&rx.frame, slcangw_timestamp, rx.time_ms, line, sizeof(line)));
+    slcangw_rx_frames++;
+    count++;
+  }
+  return count;
+}
+
+/*******************************************************************
+ * Commands of the PC
+ *******************************************************************/
+static uint32_t SLCANGW_baudrate(void) {
+  return (slcangw_channel == CAN_CHANNEL_MCP1) ? MCP1_baudrate() : TWAI_baudrate();
+}
+
+static bool SLCANGW_send(const CAN_frame_t *frame) {
+  const int result = (frame->channel == CAN_CHANNEL_MCP1)
+                         ? MCP1_send(frame->id, frame->data, frame->length, frame->rtr, frame->ext)
+                         : TWAI_send(frame->id, frame->data, frame->length, frame->rtr, frame->ext);
+  return result == ESP_OK;
+}
+
+static void SLCANGW_execute(const char *line) {
+  CAN_frame_t frame;
+  uint32_t argument;
+  char text[8];
+
+  switch (SLCAN_parse(line, &frame, &argument)) {
+    case SLCAN_CMD_SETUP:
+      /* The bit rate belongs to the RCU, the PC has to ask for the same one */
+      SLCANGW_reply((!slcangw_open && (argument == SLCANGW_baudrate())) ? SLCAN_OK : SLCAN_ERROR);
+      return;
+
+    case SLCAN_CMD_OPEN:
+    case SLCAN_CMD_LISTEN:
+      if (slcangw_open) {
+        break;
+      }
+      xQueueReset(slcangw_rx_queue);
+      slcangw_listen = (line[0] == 'L');
+      slcangw_flags = 0;
+      SLCANGW_set_open(true);
+      SLCANGW_reply(SLCAN_OK);
+      return;
+
+    case SLCAN_CMD_CLOSE:
+      if (!slcangw_open) {
+        break;
+      }
+      SLCANGW_set_open(false);
+      SLCANGW_reply(SLCAN_OK);
+      return;
+
+    case SLCAN_CMD_TRANSMIT:
+      if (!slcangw_open || slcangw_listen) {
+        break;
+      }
+      frame.channel = slcangw_channel;
+      if (!SLCANGW_send(&frame)) {
+        slcangw_tx_failed++;
+        slcangw_flags |= SLCAN_FLAG_TX_FULL;
+        break;
+      }
+      slcangw_tx_frames++;
+      SLCANGW_reply(frame.ext ? 'Z' : 'z');
+      SLCANGW_reply(SLCAN_OK);
+      return;
+
+    case SLCAN_CMD_FLAGS:
+      if (!slcangw_open) {
+        break;
+      }
+      snprintf(text, sizeof(text), "F%02X\r", slcangw_flags);
+      SLCANGW_out(text, strlen(text));
+      slcangw_flags = 0;
+      return;
+
+    case SLCAN_CMD_TIMESTAMP:
+      if (slcangw_open) {
+        break;
+      }
+      slcangw_timestamp = (argument != 0);
+      SLCANGW_reply(SLCAN_OK);
+      return;
+
+    case SLCAN_CMD_AUTOPOLL:
+      if (slcangw_open) {
+        break;
+      }
+      slcangw_autopoll = (argument != 0);
+      SLCANGW_reply(SLCAN_OK);
+      return;
+
+    case SLCAN_CMD_POLL:
+      if (!slcangw_open || slcangw_autopoll) {
+        break;
+      }
+      if (line[0] == 'A') {
+        SLCANGW_frames(-1);
+        SLCANGW_out("A\r", 2);
+      } else if (!SLCANGW_frames(1)) {
+        SLCANGW_reply(SLCAN_OK);
+      }
+      return;
+
+    case SLCAN_CMD_VERSION:
+      SLCANGW_out(SLCANGW_VERSION "\r", sizeof(SLCANGW_VERSION));
+      return;
+
+    case SLCAN_CMD_SERIAL:
+      snprintf(text, sizeof(text), "N%04X\r", (unsigned)(ESP.getEfuseMac() & 0xFFFF));
+      SLCANGW_out(text, strlen(text));
+      return;
+
+    case SLCAN_CMD_IGNORED:
+      SLCANGW_reply(SLCAN_OK);
+      return;
+
+    case SLCAN_CMD_INVALID:
+    default:
+      break;
+  }
+
+  slcangw_errors++;
+  SLCANGW_reply(SLCAN_ERROR);
+}
+
+/*******************************************************************
+ * Port of this tick, accepts a new TCP client
+ *******************************************************************/
+static Stream *SLCANGW_port(void) {
+  switch (slcangw_port) {
+    case SLCANGW_PORT_UART:
+      return &Serial;
+
+    case SLCANGW_PORT_TCP:
+      if (!slcangw_client.connected()) {
+        if (slcangw_open) {
+          SLCANGW_set_open(false);  // PC gone, close like slcand does
+        }
+        slcangw_client = slcangw_server.available();
+        if (!slcangw_client) {
+          return nullptr;
+        }
+        slcangw_client.setNoDelay(true);
+        SLCAN_reader_init(&slcangw_reader);
+      }
+      return &slcangw_client;
+
+    default:
+      return nullptr;
+  }
+}
+
+/*******************************************************************
+ * Gateway task
+ *******************************************************************/
+static void SLCANGW_task(void *parameter) {
+  TickType_t wake = xTaskGetTickCount();
+  (void)parameter;
+
+  while (true) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(SLCANGW_TICK_MS));
+
+    slcangw_stream = SLCANGW_port();
+    if (!slcangw_stream) {
+      continue;
+    }
+
+    while (slcangw_stream->available() > 0) {
+      if (SLCAN_reader_put(&slcangw_reader, (char)slcangw_stream->read())) {
+        SLCANGW_execute(slcangw_reader.line);
+      }
+    }
+
+    if (slcangw_open && slcangw_autopoll) {
+      SLCANGW_frames(-1);
+    }
+    SLCANGW_flush();
+  }
+}
+
+/*******************************************************************
+ * Start and stop
+ *******************************************************************/
+void SLCANGW_stop(void) {
+  const slcangw_port_t port = slcangw_port;
+
+  if (slcangw_open) {
+    SLCANGW_set_open(false);
+  }
+  slcangw_port = SLCANGW_PORT_NONE;
+  vTaskDelay(pdMS_TO_TICKS(2 * SLCANGW_TICK_MS));  // Task off the port
+
+  if (port == SLCANGW_PORT_TCP) {
+    slcangw_client.stop();
+    slcangw_server.end();
+  }
+  if (port == SLCANGW_PORT_UART) {
+    Serial.updateBaudRate(115200);
+    CLI_serial_enable(true);
+  }
+}
+
+int SLCANGW_start(slcangw_port_t port, can_channel_t channel, uint32_t baud) {
+  if ((port != SLCANGW_PORT_UART) && (port != SLCANGW_PORT_TCP)) {
+    return ESP_FAIL;
+  }
+
+  SLCANGW_stop();
+
+  slcangw_channel = channel;
+  slcangw_timestamp = false;
+  slcangw_autopoll = true;
+  SLCAN_reader_init(&slcangw_reader);
+
+  if (port == SLCANGW_PORT_UART) {
+    Serial.printf("SLCAN gateway on UART0 at %u baud, serial console off.\n", (unsigned)baud);
+    Serial.flush();
+    CLI_serial_enable(false);
+    Serial.updateBaudRate(baud);
+  } else {
+    slcangw_server.begin();
+    slcangw_server.setNoDelay(true);
+  }
+
+  slcangw_port = port;
+  return ESP_OK;
+}
+
+/*******************************************************************
+ * Create JSON document
+ *******************************************************************/
+static JsonDocument SLCANGW_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  doc[JSON_SLCANGW_PORT] = SLCANGW_PORT_NAMES[slcangw_port];
+  doc[JSON_SLCANGW_CHANNEL] = (slcangw_channel == CAN_CHANNEL_MCP1) ? "mcp" : "twai";
+  doc[JSON_SLCANGW_STATE] = slcangw_open ? (slcangw_listen ? "listen" : "open") : "closed";
+  doc[JSON_SLCANGW_CLIENT] = (slcangw_port == SLCANGW_PORT_TCP) && slcangw_client.connected();
+  doc[JSON_SLCANGW_RX_FRAMES] = slcangw_rx_frames;
+  doc[JSON_SLCANGW_RX_OVERFLOW] = slcangw_rx_overflow;
+  doc[JSON_SLCANGW_TX_FRAMES] = slcangw_tx_frames;
+  doc[JSON_SLCANGW_TX_FAILED] = slcangw_tx_failed;
+  doc[JSON_SLCANGW_ERRORS] = slcangw_errors;
+  doc[JSON_SLCANGW_WRITES] = slcangw_writes;
+  doc[JSON_SLCANGW_WRITE_MAX] = slcangw_write_max;
+
+  return doc;
+}
+
+/********************************************************************
+ * Create info string
+ *******************************************************************/
+static String SLCANGW_info_str(void) {
+  JsonDocument doc = SLCANGW_json();
+
+  String text = "--- SLCAN gateway ---";
+
+  text.concat("\r\nPort: ");
+  text.concat(doc[JSON_SLCANGW_PORT].as<const char *>());
+  if (slcangw_port == SLCANGW_PORT_TCP) {
+    text.concat(" ");
+    text.concat(SLCANGW_TCP_PORT);
+    text.concat(doc[JSON_SLCANGW_CLIENT].as<bool>() ? ", connected" : ", waiting");
+  }
+  text.concat("\r\nChannel: ");
+  text.concat(doc[JSON_SLCANGW_CHANNEL].as<const char *>());
+  text.concat(", ");
+  text.concat(doc[JSON_SLCANGW_STATE].as<const char *>());
+
+  text.concat("\r\nRX frames: ");
+  text.concat(doc[JSON_SLCANGW_RX_FRAMES].as<unsigned>());
+  text.concat(", overflow: ");
+  text.concat(doc[JSON_SLCANGW_RX_OVERFLOW].as<unsigned>());
+  text.concat("\r\nTX frames: ");
+  text.concat(doc[JSON_SLCANGW_TX_FRAMES].as<unsigned>());
+  text.concat(", failed: ");
+  text.concat(doc[JSON_SLCANGW_TX_FAILED].as<unsigned>());
+  text.concat("\r\nCommand errors: ");
+  text.concat(doc[JSON_SLCANGW_ERRORS].as<unsigned>());
+  text.concat("\r\nWrites: ");
+  text.concat(doc[JSON_SLCANGW_WRITES].as<unsigned>());
+  text.concat(", largest: ");
+  text.concat(doc[JSON_SLCANGW_WRITE_MAX].as<unsigned>());
+  text.concat(" bytes");
+
+  text.concat("\r\n");
+  return text;
+}
+
+/********************************************************************
+ * REST API
+ *******************************************************************/
+static void SLCANGW_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, SLCANGW_json);
+}
+
+static rest_api_t SLCANGW_api_handlers = {
+    /* uri */ "/api/v1/slcan",
+    /* comment */ "SLCAN gateway",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ SLCANGW_rest_read,
+    /* fn_update */ nullptr,
+    /* fn_delete */ nullptr,
+};
+
+/********************************************************************
+ * CLI handler
+ *******************************************************************/
+static void clicb_handler(cmd *c) {
+  Command cmd(c);
+  String strArg = cmd.getArg(0).getValue();
+
+  if (strArg.isEmpty()) {
+    CLI_println(SLCANGW_info_str());
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("uart") || strArg.equalsIgnoreCase("tcp")) {
+    const slcangw_port_t port = strArg.equalsIgnoreCase("uart") ? SLCANGW_PORT_UART : SLCANGW_PORT_TCP;
+    const can_channel_t channel =
+        cmd.getArg(1).getValue().equalsIgnoreCase("mcp") ? CAN_CHANNEL_MCP1 : CAN_CHANNEL_TWAI;
+    const int baud = cmd.getArg(2).getValue().toInt();
+
+    if (port == SLCANGW_PORT_UART) {
+      CLI_println("SLCAN gateway takes over UART0, stop it from WebSerial or restart.");
+    }
+    SLCANGW_start(port, channel, (baud > 0) ? baud : SLCANGW_UART_BAUD);
+    if (port == SLCANGW_PORT_TCP) {
+      CLI_println(String("SLCAN gateway listening on port ") + SLCANGW_TCP_PORT + ".");
+    }
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("stop")) {
+    SLCANGW_stop();
+    CLI_println("SLCAN gateway stopped.");
+    return;
+  }
+
+  if (strArg.equalsIgnoreCase("reset")) {
+    slcangw_rx_frames = 0;
+    slcangw_rx_overflow = 0;
+    slcangw_tx_frames = 0;
+    slcangw_tx_failed = 0;
+    slcangw_errors = 0;
+    slcangw_writes = 0;
+    slcangw_write_max = 0;
+    CLI_println("SLCAN gateway statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: SLCAN (uart|tcp [twai|mcp] [baud], stop, reset).");
+}
+
+/*******************************************************************
+ * Setup
+ *******************************************************************/
+void SLCANGW_setup(void) {
+  if (slcangw_rx_queue) {
+    return;  // Already done
+  }
+
+  slcangw_rx_queue = xQueueCreate(SLCANGW_RX_QUEUE_SIZE, sizeof(slcangw_rx_t));
+  xTaskCreate(SLCANGW_task, "SLCAN gateway", 4096, NULL, 3, &slcangw_task_handle);
+
+  cli.addBoundlessCmd("slcan", clicb_handler);
+  setup_uri(&SLCANGW_api_handlers);
+
+  Serial.println(F("SLCAN gateway setup completed..."));
+}
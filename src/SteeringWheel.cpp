@@ -9,13 +9,17 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include "Analog.h"
 #include "Azimuth.h"
 #include "CLI.h"
+#include "Calibration.h"
 #include "Config.h"
 #include "EBC_IOLib.h"
+#include "EBC_Utils.h"
 #include "GPIO.h"
 #include "Maintenance.h"
 #include "Storage.h"
+#include "WebServer.h"
 
 /*******************************************************************
  * Definitions
@@ -31,13 +35,27 @@
  *******************************************************************/
 #define JSON_STEERWHEEL_LEFT_DEFAULT 0.0
 #define JSON_STEERWHEEL_RIGHT_DEFAULT 5.0
-#define DELAY_TO_MIDDLE_DEFAULT 5
+
+/*******************************************************************
+ * Filter cost budget per stage in CPU cycles (240MHz)
+ *******************************************************************/
+#define STEERWHEEL_BUDGET_MEDIAN 800
+#define STEERWHEEL_BUDGET_IIR 200
+#define STEERWHEEL_BUDGET_RATE_LIMIT 120
+#define STEERWHEEL_BUDGET_DEADBAND 120
 
 /*******************************************************************
  * Global variables
  *******************************************************************/
 static JsonDocument STEERWHEEL_data;
 
+static volatile int STEERWHEEL_actual = 0;  // Written by the steering loop
+
+static FILTER_chain_t STEERWHEEL_filter;         // Owned by the steering loop
+static volatile bool STEERWHEEL_filter_dirty = true;
+static volatile bool STEERWHEEL_sampled = false;  // Filter chain has seen a real sample
+static uint32_t STEERWHEEL_sequence = 0;         // Last analog sample filtered
+
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
@@ -47,6 +65,13 @@ static JsonDocument STEERINGWHEEL_json(void) {
   STEERWHEEL_data[JSON_STEERWHEEL_MIDDLE] = STEERWHEEL_get_middle();
 
   STEERWHEEL_data[JSON_STEERWHEEL_DEADBAND] = STEERWHEEL_get_deadband();
+  STEERWHEEL_data[JSON_STEERWHEEL_HYSTERESIS] = CALIBRATION_get(CAL_STEERWHEEL_HYSTERESIS);
+
+  STEERWHEEL_data[JSON_STEERWHEEL_MEDIAN] = CALIBRATION_get(CAL_STEERWHEEL_MEDIAN);
+  STEERWHEEL_data[JSON_STEERWHEEL_IIR] = CALIBRATION_get(CAL_STEERWHEEL_IIR);
+  STEERWHEEL_data[JSON_STEERWHEEL_RATE_LIMIT] = CALIBRATION_get(CAL_STEERWHEEL_RATE_LIMIT);
+
+  STEERWHEEL_data[JSON_STEERWHEEL_ACTUAL] = STEERWHEEL_get_actual();
 
   return STEERWHEEL_data;
 }
@@ -55,7 +80,7 @@ static JsonDocument STEERINGWHEEL_json(void) {
  * Create azimuth string
  *******************************************************************/
 String STEERINGWHEEL_info(void) {
-  static JsonDocument doc = STEERINGWHEEL_json();
+  JsonDocument doc = STEERINGWHEEL_json();  // Update
 
   String text = "--- Steering wheel ---";
 
@@ -73,28 +98,125 @@ String STEERINGWHEEL_info(void) {
 
   text.concat("\r\nMiddle deadband: ");
   text.concat(doc[JSON_STEERWHEEL_DEADBAND].as<int>());
+  text.concat(", hysteresis: ");
+  text.concat(doc[JSON_STEERWHEEL_HYSTERESIS].as<int>());
+
+  text.concat("\r\nFilter median: ");
+  text.concat(doc[JSON_STEERWHEEL_MEDIAN].as<int>());
+  text.concat(", iir: ");
+  text.concat(doc[JSON_STEERWHEEL_IIR].as<int>());
+  text.concat("/1000, rate limit: ");
+  text.concat(doc[JSON_STEERWHEEL_RATE_LIMIT].as<int>());
+  text.concat(" counts/sample");
+
+  for (int i = 0; i < STEERWHEEL_filter.num_stages; i++) {
+    const FILTER_stage_t *stage = &STEERWHEEL_filter.stage[i];
+
+    text.concat("\r\nStage ");
+    text.concat(i);
+    text.concat(" ");
+    text.concat(FILTER_type_name(stage->cfg.type));
+    text.concat(": cycles last/max: ");
+    text.concat(stage->cost_last);
+    text.concat("/");
+    text.concat(stage->cost_max);
+    text.concat(", budget: ");
+    text.concat(stage->cfg.budget);
+    text.concat(", over budget: ");
+    text.concat(stage->over_budget);
+  }
 
   text.concat("\r\n");
   return text;
 }
 
 /*******************************************************************
- * Steering wheel read analog input
+ * Steering wheel filter chain
+ *
+ * median -> IIR -> rate limit -> centre deadband, a stage is left
+ * out when it is switched off. Rebuilt by the steering loop after a
+ * calibration change.
  *******************************************************************/
-#define MAX_AVERAGE 10
-static void STEERWHEEL_update(void) {
-  static int ndx = 0, value;
-  static int array[MAX_AVERAGE] = {0};
-  static long sum = 0;
+static uint32_t STEERWHEEL_clock(void) {
+  return ESP.getCycleCount();
+}
+
+static void STEERWHEEL_filter_build(void) {
+  FILTER_stage_cfg_t cfg[FILTER_MAX_STAGES] = {};
+  calibration_t cal;
+  int n = 0;
+
+  STEERWHEEL_filter_dirty = false;  // Before reading, a change during the build rebuilds again
+  CALIBRATION_snapshot(&cal);
+
+  if (cal.value[CAL_STEERWHEEL_MEDIAN] >= 3) {
+    cfg[n].type = FILTER_MEDIAN;
+    cfg[n].window = cal.value[CAL_STEERWHEEL_MEDIAN];
+    cfg[n++].budget = STEERWHEEL_BUDGET_MEDIAN;
+  }
+
+  if (cal.value[CAL_STEERWHEEL_IIR] < 1000) {
+    cfg[n].type = FILTER_IIR;
+    cfg[n].alpha = (cal.value[CAL_STEERWHEEL_IIR] * FILTER_IIR_ONE) / 1000;
+    cfg[n++].budget = STEERWHEEL_BUDGET_IIR;
+  }
 
-  ndx = (ndx + 1) % MAX_AVERAGE;
+  if (cal.value[CAL_STEERWHEEL_RATE_LIMIT] > 0) {
+    cfg[n].type = FILTER_RATE_LIMIT;
+    cfg[n].step = cal.value[CAL_STEERWHEEL_RATE_LIMIT];
+    cfg[n++].budget = STEERWHEEL_BUDGET_RATE_LIMIT;
+  }
 
-  sum -= array[ndx];
-  array[ndx] = analogRead(STEER_WHEEL_ANALOG_CHANNEL);
-  sum += array[ndx];
+  cfg[n].type = FILTER_DEADBAND;
+  cfg[n].centre = cal.value[CAL_STEERWHEEL_MIDDLE];
+  cfg[n].width = cal.value[CAL_STEERWHEEL_DEADBAND];
+  cfg[n].hysteresis = cal.value[CAL_STEERWHEEL_HYSTERESIS];
+  cfg[n++].budget = STEERWHEEL_BUDGET_DEADBAND;
 
-  value = constrain(sum / MAX_AVERAGE, ADC_MIN, ADC_MAX);
-  STEERWHEEL_data[JSON_STEERWHEEL_ACTUAL] = value;
+  FILTER_chain_init(&STEERWHEEL_filter, cfg, n, STEERWHEEL_clock);
+}
+
+static void STEERWHEEL_calibration_changed(uint32_t changed, const calibration_t *values) {
+  (void)values;
+
+  if (changed & (CALIBRATION_MASK(CAL_STEERWHEEL_MIDDLE) | CALIBRATION_MASK(CAL_STEERWHEEL_DEADBAND) |
+                 CALIBRATION_MASK(CAL_STEERWHEEL_HYSTERESIS) | CALIBRATION_MASK(CAL_STEERWHEEL_MEDIAN) |
+                 CALIBRATION_MASK(CAL_STEERWHEEL_IIR) | CALIBRATION_MASK(CAL_STEERWHEEL_RATE_LIMIT))) {
+    STEERWHEEL_filter_dirty = true;
+  }
+}
+
+/*******************************************************************
+ * Steering wheel read analog input, called by the steering loop.
+ * Each new oversampled value of the continuous ADC is run through
+ * the filter chain once.
+ *******************************************************************/
+void STEERWHEEL_update(void) {
+  uint32_t sequence = ANALOG_get_sequence(ANALOG_STEERWHEEL);
+
+  if (STEERWHEEL_filter_dirty) {
+    STEERWHEEL_filter_build();
+  }
+
+  if (!ANALOG_ready(ANALOG_STEERWHEEL)) {
+    return;  // No analog data yet
+  }
+
+  if (ANALOG_continuous() && (sequence == STEERWHEEL_sequence)) {
+    return;  // No new sample
+  }
+  STEERWHEEL_sequence = sequence;
+
+  int value = FILTER_chain_run(&STEERWHEEL_filter, ANALOG_get_raw(ANALOG_STEERWHEEL));
+  STEERWHEEL_actual = constrain(value, ADC_MIN, ADC_MAX);
+  STEERWHEEL_sampled = true;
+}
+
+/********************************************************************
+ * True once the steering wheel position comes from a real sample.
+ *******************************************************************/
+bool STEERWHEEL_ready(void) {
+  return STEERWHEEL_sampled;
 }
 
 /********************************************************************
@@ -105,7 +227,7 @@ static void STEERWHEEL_update(void) {
  * @return The actual steering wheel position.
  *******************************************************************/
 int STEERWHEEL_get_actual(void) {
-  return STEERWHEEL_data[JSON_STEERWHEEL_ACTUAL].as<int>();
+  return STEERWHEEL_actual;
 }
 
 /********************************************************************
@@ -114,86 +236,56 @@ int STEERWHEEL_get_actual(void) {
  * @return The linear value of the steering wheel position.
  *******************************************************************/
 int STEERWHEEL_get_linear(void) {
-  long value = STEERWHEEL_get_actual();
-  long left = STEERWHEEL_get_left();
-  long middle = STEERWHEEL_get_middle();
-  long right = STEERWHEEL_get_right();
-
-  if (((left < middle) && (middle < right)) ||
-      ((left > middle) && (middle > right))) {
-    if (value < middle) {
-      value = (int)map(value, left, middle, LINEAR_MIN, LINEAR_MIDDLE - 1);
-    } else {
-      value = (int)map(value, middle, right, LINEAR_MIDDLE, LINEAR_MAX);
-    }
-  }
+  STEERING_wheel_cal_t cal = {STEERWHEEL_get_left(), STEERWHEEL_get_middle(), STEERWHEEL_get_right()};
 
-  value = constrain(value, LINEAR_MIN, LINEAR_MAX);
-  return value;
+  return (int)STEERING_wheel_linear(&cal, STEERWHEEL_get_actual());
 }
 
 /*******************************************************************
  * Steering wheel get calibration values
  *******************************************************************/
 int STEERWHEEL_get_left(void) {
-  return STEERWHEEL_data[JSON_STEERWHEEL_LEFT].as<int>();
+  return CALIBRATION_get(CAL_STEERWHEEL_LEFT);
 }
 
 void STEERWHEEL_set_left(int value) {
-  if ((value >= ADC_MIN) && (value <= ADC_MAX)) {
-    STEERWHEEL_data[JSON_STEERWHEEL_LEFT] = value;
-  }
+  CALIBRATION_set(CAL_STEERWHEEL_LEFT, value, false);
 }
 
 void STEERWHEEL_store_left(int value) {
-  if ((value >= ADC_MIN) && (value <= ADC_MAX)) {
-    STORAGE_set_int(JSON_STEERWHEEL_LEFT, value);
-  }
+  CALIBRATION_set(CAL_STEERWHEEL_LEFT, value);
 }
 
 int STEERWHEEL_get_right(void) {
-  return STEERWHEEL_data[JSON_STEERWHEEL_RIGHT].as<int>();
+  return CALIBRATION_get(CAL_STEERWHEEL_RIGHT);
 }
 
 void STEERWHEEL_set_right(int value) {
-  if ((value >= ADC_MIN) && (value <= ADC_MAX)) {
-    STEERWHEEL_data[JSON_STEERWHEEL_RIGHT] = value;
-  }
+  CALIBRATION_set(CAL_STEERWHEEL_RIGHT, value, false);
 }
 
 void STEERWHEEL_store_right(int value) {
-  if ((value >= ADC_MIN) && (value <= ADC_MAX)) {
-    STORAGE_set_int(JSON_STEERWHEEL_RIGHT, value);
-  }
+  CALIBRATION_set(CAL_STEERWHEEL_RIGHT, value);
 }
 
 int STEERWHEEL_get_middle(void) {
-  return STEERWHEEL_data[JSON_STEERWHEEL_MIDDLE].as<int>();
+  return CALIBRATION_get(CAL_STEERWHEEL_MIDDLE);
 }
 
 void STEERWHEEL_set_middle(int value) {
-  if ((value >= ADC_MIN) && (value <= ADC_MAX)) {
-    STEERWHEEL_data[JSON_STEERWHEEL_MIDDLE] = value;
-  }
+  CALIBRATION_set(CAL_STEERWHEEL_MIDDLE, value, false);
 }
 
 void STEERWHEEL_store_middle(int value) {
-  if ((value >= ADC_MIN) && (value <= ADC_MAX)) {
-    STORAGE_set_int(JSON_STEERWHEEL_MIDDLE, value);
-  }
+  CALIBRATION_set(CAL_STEERWHEEL_MIDDLE, value);
 }
 
 int STEERWHEEL_get_deadband(void) {
-  int value;
-  STORAGE_get_int(JSON_STEERWHEEL_DEADBAND, value);
-  return value;
+  return CALIBRATION_get(CAL_STEERWHEEL_DEADBAND);
 }
 
 void STEERWHEEL_set_deadband(int value) {
-  if ((value >= ADC_MIN) && (value <= ADC_MAX)) {
-    STEERWHEEL_data[JSON_STEERWHEEL_DEADBAND] = value;
-    STORAGE_set_int(JSON_STEERWHEEL_DEADBAND, value);
-  }
+  CALIBRATION_set(CAL_STEERWHEEL_DEADBAND, value);
 }
 
 /********************************************************************
@@ -226,21 +318,107 @@ void STEERWHEEL_calibration_save(void) {
  * @see STEERWHEEL_set_middle
  *******************************************************************/
 void STEERWHEEL_calibration_restore(void) {
-  int value;
+  CALIBRATION_restore(CALIBRATION_MASK(CAL_STEERWHEEL_LEFT) | CALIBRATION_MASK(CAL_STEERWHEEL_RIGHT) |
+                      CALIBRATION_MASK(CAL_STEERWHEEL_MIDDLE));
+}
+
+/********************************************************************
+ * REST API, filter settings
+ *******************************************************************/
+static const struct {
+  const char *key;
+  calibration_field_t field;
+} STEERWHEEL_filter_keys[] = {
+    {JSON_STEERWHEEL_DEADBAND, CAL_STEERWHEEL_DEADBAND},
+    {JSON_STEERWHEEL_HYSTERESIS, CAL_STEERWHEEL_HYSTERESIS},
+    {JSON_STEERWHEEL_MEDIAN, CAL_STEERWHEEL_MEDIAN},
+    {JSON_STEERWHEEL_IIR, CAL_STEERWHEEL_IIR},
+    {JSON_STEERWHEEL_RATE_LIMIT, CAL_STEERWHEEL_RATE_LIMIT},
+};
+
+static JsonDocument STEERWHEEL_filter_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
+
+  for (auto &key : STEERWHEEL_filter_keys) {
+    doc[key.key] = CALIBRATION_get(key.field);
+  }
 
-  STORAGE_get_int(JSON_STEERWHEEL_LEFT, value);
-  STEERWHEEL_set_left(value);
+  JsonArray stages = doc["stages"].to<JsonArray>();
+  for (int i = 0; i < STEERWHEEL_filter.num_stages; i++) {
+    const FILTER_stage_t *stage = &STEERWHEEL_filter.stage[i];
+    JsonObject obj = stages.add<JsonObject>();
 
-  STORAGE_get_int(JSON_STEERWHEEL_RIGHT, value);
-  STEERWHEEL_set_right(value);
+    obj["type"] = FILTER_type_name(stage->cfg.type);
+    obj["cycles_last"] = stage->cost_last;
+    obj["cycles_max"] = stage->cost_max;
+    obj["budget"] = stage->cfg.budget;
+    obj["over_budget"] = stage->over_budget;
+  }
 
-  STORAGE_get_int(JSON_STEERWHEEL_MIDDLE, value);
-  STEERWHEEL_set_middle(value);
+  return doc;
 }
 
+static void STEERWHEEL_rest_read(AsyncWebServerRequest *request) {
+  WEBSERVER_send_json(request, STEERWHEEL_filter_json);
+}
+
+static void STEERWHEEL_rest_update(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  (void)index;
+  (void)total;
+
+  JsonDocument doc;
+  if (deserializeJson(doc, (const char *)data, len)) {
+    request->send(400, "text/plain", "400, Invalid JSON");
+    return;
+  }
+
+  calibration_t values;
+  uint32_t mask = 0;
+
+  /* Validate all keys first, nothing is applied on an error */
+  for (auto &key : STEERWHEEL_filter_keys) {
+    if (doc[key.key].isNull()) {
+      continue;
+    }
+
+    int value = doc[key.key].as<int>();
+    if (!doc[key.key].is<int>() || (value < CALIBRATION_min(key.field)) || (value > CALIBRATION_max(key.field))) {
+      request->send(400, "text/plain", String("400, Illegal value: ") + key.key);
+      return;
+    }
+    values.value[key.field] = value;
+    mask |= CALIBRATION_MASK(key.field);
+  }
+
+  if (mask && (CALIBRATION_update(&values, mask) != ESP_OK)) {
+    request->send(400, "text/plain", "400, Illegal value");
+    return;
+  }
+
+  request->send(200, "text/plain", "200, OK");
+}
+
+static rest_api_t STEERWHEEL_api_handlers = {
+    /* uri */ "/api/v1/steer/filter",
+    /* comment */ "Steering wheel filter",
+    /* instances */ 1,
+    /* fn_create */ nullptr,
+    /* fn_read */ STEERWHEEL_rest_read,
+    /* fn_update */ STEERWHEEL_rest_update,
+    /* fn_delete */ nullptr,
+};
+
 /********************************************************************
  * CLI handler
  *******************************************************************/
+static void clicb_filter_set(calibration_field_t field, const char *name, int val) {
+  if (CALIBRATION_set(field, val) != ESP_OK) {
+    CLI_println("Illegal value, range: " + String(CALIBRATION_min(field)) + " ... " + String(CALIBRATION_max(field)) + ".");
+    return;
+  }
+  CLI_println(String("Steering wheel ") + name + " has been set to " + String(val) + ".");
+}
+
 static void clicb_handler(cmd *c) {
   Command cmd(c);
   Argument arg = cmd.getArg(0);
@@ -258,7 +436,7 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 0 ... 4095 counts");
       return;
     }
-    STORAGE_set_int(JSON_STEERWHEEL_LEFT, val);
+    CALIBRATION_set(CAL_STEERWHEEL_LEFT, val);
     CLI_println("Steering wheel left limit has been set to " + String(val) + " counts.");
   }
 
@@ -268,7 +446,7 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 0 ... 4095 counts");
       return;
     }
-    STORAGE_set_int(JSON_STEERWHEEL_RIGHT, val);
+    CALIBRATION_set(CAL_STEERWHEEL_RIGHT, val);
     CLI_println("Steering wheel right limit has been set to " + String(val) + " counts.");
   }
 
@@ -278,7 +456,7 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 0 ... 4095 counts");
       return;
     }
-    STORAGE_set_int(JSON_STEERWHEEL_MIDDLE, val);
+    CALIBRATION_set(CAL_STEERWHEEL_MIDDLE, val);
     CLI_println("Steering wheel middle has been set to " + String(val) + " counts.");
   }
 
@@ -288,72 +466,35 @@ static void clicb_handler(cmd *c) {
       CLI_println("Illegal value, range: 0 ... 4095 counts");
       return;
     }
-    STORAGE_set_int(JSON_STEERWHEEL_DEADBAND, val);
+    CALIBRATION_set(CAL_STEERWHEEL_DEADBAND, val);
     CLI_println("Steering wheel middle has been set to " + String(val) + " counts.");
   }
 
-  CLI_println("Invalid command: STEER (left <n>, right <n>, middle <n>, deadband <n>).");
-}
-
-static void cli_setup(void) {
-  cli.addBoundlessCmd("steer", clicb_handler);
-}
-
-/********************************************************************
- * Main task
- *********************************************************************/
-static void STEERINGWHEEL_main_task(void *parameter) {
-  (void)parameter;
-
-  while (true) {
-    STEERWHEEL_update();
-    vTaskDelay(100 / portTICK_PERIOD_MS);
+  if (strArg.equalsIgnoreCase("hysteresis")) {
+    clicb_filter_set(CAL_STEERWHEEL_HYSTERESIS, "deadband hysteresis", cmd.getArg(1).getValue().toInt());
+    return;
   }
-}
 
-/********************************************************************
- *  Initialize tasks
- *********************************************************************/
-static void STEERINGWHEEL_setup_tasks(void) {
-  xTaskCreate(STEERINGWHEEL_main_task, "Steer wheel main", 2048, NULL, 10, NULL);
-}
-
-/*******************************************************************
- * GPIO setup
- *******************************************************************/
-static void STEERINGWHEEL_setup_gpio(void) {
-  analogReadResolution(12);
-}
-
-/*******************************************************************
- * Setup variables
- *******************************************************************/
-static void STEERINGWHEEL_setup_variables(void) {
-  int value;
-
-  if (STORAGE_get_int(JSON_STEERWHEEL_LEFT, value)) {
-    value = ADC_MAX;
-    STORAGE_set_int(JSON_STEERWHEEL_LEFT, value);
+  if (strArg.equalsIgnoreCase("median")) {
+    clicb_filter_set(CAL_STEERWHEEL_MEDIAN, "median window", cmd.getArg(1).getValue().toInt());
+    return;
   }
-  STEERWHEEL_data[JSON_STEERWHEEL_LEFT] = value;
 
-  if (STORAGE_get_int(JSON_STEERWHEEL_MIDDLE, value)) {
-    value = (ADC_MIN + ADC_MAX) / 2;
-    STORAGE_set_int(JSON_STEERWHEEL_MIDDLE, value);
+  if (strArg.equalsIgnoreCase("iir")) {
+    clicb_filter_set(CAL_STEERWHEEL_IIR, "iir alpha (1/1000)", cmd.getArg(1).getValue().toInt());
+    return;
   }
-  STEERWHEEL_data[JSON_STEERWHEEL_MIDDLE] = value;
 
-  if (STORAGE_get_int(JSON_STEERWHEEL_RIGHT, value)) {
-    value = ADC_MIN;
-    STORAGE_set_int(JSON_STEERWHEEL_RIGHT, value);
+  if (strArg.equalsIgnoreCase("rate")) {
+    clicb_filter_set(CAL_STEERWHEEL_RATE_LIMIT, "rate limit (counts/sample)", cmd.getArg(1).getValue().toInt());
+    return;
   }
-  STEERWHEEL_data[JSON_STEERWHEEL_RIGHT] = value;
 
-  if (STORAGE_get_int(JSON_STEERWHEEL_DEADBAND, value)) {
-    value = 2;
-    STORAGE_set_int(JSON_STEERWHEEL_DEADBAND, value);
-  }
-  STEERWHEEL_data[JSON_STEERWHEEL_DEADBAND] = value;
+  CLI_println("Invalid command: STEER (left <n>, right <n>, middle <n>, deadband <n>, hysteresis <n>, median <n>, iir <n>, rate <n>).");
+}
+
+static void cli_setup(void) {
+  cli.addBoundlessCmd("steer", clicb_handler);
 }
 
 /********************************************************************
@@ -371,8 +512,7 @@ void STEERINGWHEEL_stop() {
  * during the setup phase of the program.
  *******************************************************************/
 void STEERINGWHEEL_setup() {
-  STEERINGWHEEL_setup_variables();
-  STEERINGWHEEL_setup_gpio();
+  CALIBRATION_on_change(STEERWHEEL_calibration_changed);
 
   Serial.println(F("Steering wheel setup completed..."));
 }
@@ -385,8 +525,8 @@ void STEERINGWHEEL_setup() {
  * steering wheel related functions.
  *******************************************************************/
 void STEERINGWHEEL_start() {
-  STEERINGWHEEL_setup_tasks();
   cli_setup();
+  setup_uri(&STEERWHEEL_api_handlers);
 
   Serial.println(F("Steering wheel started..."));
 }
@@ -182,6 +182,33 @@ int STORAGE_set_int(const char *key, int value) {
   return ESP_OK;  // Ok
 }
 
+/********************************************************************
+ * Set integer fields, written with one file write
+ *******************************************************************/
+int STORAGE_set_ints(const char *const keys[], const int values[], int count) {
+  bool changed = false;
+
+  for (int i = 0; i < count; i++) {
+#ifdef DEBUG_STORAGE
+    Serial.printf("STORAGE-set-int: %s = %d.\r\n", keys[i], values[i]);
+#endif
+    if (_dta_stor.containsKey(keys[i]) && (_dta_stor[keys[i]] == values[i])) {
+      continue;  // Don't write if the same
+    }
+    _dta_stor[keys[i]] = values[i];
+    changed = true;
+  }
+
+  if (!changed) {
+    return ESP_FAIL;  // Ok
+  }
+  if (STORAGE_write(LittleFS, APP_CONFIG_FILE)) {
+    CLI_println("ERROR storing settings...");
+    return ESP_FAIL;  // Ok
+  }
+  return ESP_OK;  // Ok
+}
+
 /********************************************************************
  * Get string field
  *******************************************************************/
@@ -395,9 +422,7 @@ void STORAGE_cli_handlers(void) {
  * REST API: read handler
  *********************************************************************/
 void STORAGE_api_read(AsyncWebServerRequest *request) {
-  String str;
-  serializeJson(_dta_stor, str);
-  request->send(200, "application/json", str.c_str());
+  WEBSERVER_send_json(request, _dta_stor);  // The stored document, not copied
 }
 
 static rest_api_t STORAGE_api_handlers = {
@@ -8,6 +8,9 @@
 #include <ArduinoJson.h>
 #include <esp_err.h>
 
+#include "CANBus.h"
+#include "CANCapture.h"
+#include "CANHealth.h"
 #include "Config.h"
 #include "Debug.h"
 #include "WebServer.h"
@@ -18,6 +21,11 @@
 /*******************************************************************
  * Constants
  *******************************************************************/
+#define TWAI_QUEUE_LEN 32        // Frames in the transmit queue
+#define TWAI_DRIVER_TX_LEN 16    // Frames in the driver transmit queue
+#define TWAI_RX_TIMEOUT_MS 1000  // Receive wait, loops to stay responsive
+#define TWAI_TX_TIMEOUT_MS 100   // Driver transmit queue full
+#define TWAI_MAX_RULES 16        // Subscriptions compiled into the acceptance filter
 
 /*******************************************************************
  * Type definitions
@@ -27,15 +35,25 @@
  *  Variables
  *******************************************************************/
 static QueueHandle_t TWAI_TX_QUEUE;
-static QueueHandle_t TWAI_RX_QUEUE;
+static SemaphoreHandle_t TWAI_lock = nullptr;  // Driver, transmit and filter reinstall
+
+static twai_general_config_t TWAI_general_config;
+static twai_timing_config_t TWAI_timing_config;
+static CANFILTER_twai_t TWAI_filter;
+static twai_filter_config_t TWAI_filter_config;  // Installed acceptance filter
+static volatile bool TWAI_filter_dirty = false;
+static volatile bool TWAI_installed = false;     // Driver installed and started, the bus is down otherwise
 
 static uint32_t _twai_baudrate = 500000;
 
 static uint32_t _twai_received = 0;
-static uint32_t _twai_transmitted = 0;
-static uint32_t _twai_error = 0;
+static uint32_t _twai_rx_dropped = 0;
+static uint32_t _twai_rx_burst_max = 0;
 
-static CANReceiveHandler TWAI_receive_handler = nullptr;
+static uint32_t _twai_transmitted = 0;
+static uint32_t _twai_tx_dropped = 0;
+static uint32_t _twai_tx_timeout = 0;
+static uint32_t _twai_tx_queue_hwm = 0;
 
 /********************************************************************
  * TWAI state to string
@@ -57,18 +75,50 @@ static String twai_state_to_str(twai_state_t state)
     }
 }
 
+/********************************************************************
+ * Frames per second since the previous call
+ *******************************************************************/
+static void TWAI_throughput(uint32_t &rx_rate, uint32_t &tx_rate, uint32_t &rejected_rate)
+{
+    static uint32_t memo_ms = 0, memo_rx = 0, memo_tx = 0, memo_rejected = 0;
+    static uint32_t last_rx_rate = 0, last_tx_rate = 0, last_rejected_rate = 0;
+
+    uint32_t now = millis();
+    uint32_t elapsed = now - memo_ms;
+    uint32_t rejected = CANBUS_rejected(CAN_CHANNEL_TWAI);
+
+    if (elapsed >= 1000)
+    {
+        last_rx_rate = (uint32_t)(((uint64_t)(_twai_received - memo_rx) * 1000) / elapsed);
+        last_tx_rate = (uint32_t)(((uint64_t)(_twai_transmitted - memo_tx) * 1000) / elapsed);
+        last_rejected_rate = (uint32_t)(((uint64_t)(rejected - memo_rejected) * 1000) / elapsed);
+
+        memo_ms = now;
+        memo_rx = _twai_received;
+        memo_tx = _twai_transmitted;
+        memo_rejected = rejected;
+    }
+
+    rx_rate = last_rx_rate;
+    tx_rate = last_tx_rate;
+    rejected_rate = last_rejected_rate;
+}
+
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
-static JsonDocument TWAI_json(void)
+static JsonDocument TWAI_json(ArduinoJson::Allocator *allocator = JSON_HEAP)
 {
-    JsonDocument doc;
+    JsonDocument doc(allocator);
+    uint32_t rx_rate, tx_rate, rejected_rate;
 
-    twai_status_info_t info;
-    twai_get_status_info(&info);
+    TWAI_throughput(rx_rate, tx_rate, rejected_rate);
+
+    twai_status_info_t info = {};
+    bool status = (twai_get_status_info(&info) == ESP_OK);
 
     doc[JSON_TWAI_DEVICE] = "TWAI";
-    doc[JSON_TWAI_STATE] = twai_state_to_str(info.state);
+    doc[JSON_TWAI_STATE] = status ? twai_state_to_str(info.state) : String("NOT INSTALLED");
 
     doc[JSON_TWAI_BAUDRATE] = _twai_baudrate / 1000;
 
@@ -77,11 +127,25 @@ static JsonDocument TWAI_json(void)
     doc[JSON_TWAI_RX_MISSED] = info.rx_missed_count;
     doc[JSON_TWAI_RX_OVERRUN] = info.rx_overrun_count;
     doc[JSON_TWAI_RX_QUEUED] = info.msgs_to_rx;
+    doc[JSON_TWAI_RX_DROPPED] = _twai_rx_dropped;
+    doc[JSON_TWAI_RX_RATE] = rx_rate;
+    doc[JSON_TWAI_RX_BURST_MAX] = _twai_rx_burst_max;
+    doc[JSON_TWAI_RX_REJECTED] = CANBUS_rejected(CAN_CHANNEL_TWAI);
+    doc[JSON_TWAI_RX_REJECTED_RATE] = rejected_rate;
+
+    doc[JSON_TWAI_FILTER_MODE] = (TWAI_filter.mode == CANFILTER_TWAI_SINGLE) ? "single" : "dual";
+    doc[JSON_TWAI_FILTER_CODE] = String("0x") + String(TWAI_filter.code, HEX);
+    doc[JSON_TWAI_FILTER_MASK] = String("0x") + String(TWAI_filter.mask, HEX);
+    doc[JSON_TWAI_FILTER_ACCEPT] = TWAI_filter.accept_ppm / 10000.0;
 
     doc[JSON_TWAI_TX_FRAMES] = _twai_transmitted;
     doc[JSON_TWAI_TX_ERRORS] = info.tx_error_counter;
     doc[JSON_TWAI_TX_FAILED] = info.tx_failed_count;
     doc[JSON_TWAI_TX_QUEUED] = info.msgs_to_tx;
+    doc[JSON_TWAI_TX_DROPPED] = _twai_tx_dropped;
+    doc[JSON_TWAI_TX_TIMEOUT] = _twai_tx_timeout;
+    doc[JSON_TWAI_TX_RATE] = tx_rate;
+    doc[JSON_TWAI_TX_QUEUE_HWM] = _twai_tx_queue_hwm;
 
     doc[JSON_TWAI_ARB_LOST] = info.arb_lost_count;
     doc[JSON_TWAI_BUS_ERROR] = info.bus_error_count;
@@ -113,6 +177,27 @@ String TWAI_string(void)
     text.concat(doc[JSON_TWAI_RX_OVERRUN].as<int>());
     text.concat(", queued: ");
     text.concat(doc[JSON_TWAI_RX_QUEUED].as<int>());
+    text.concat(", dropped: ");
+    text.concat(doc[JSON_TWAI_RX_DROPPED].as<int>());
+    text.concat("\r\nReceive rate: ");
+    text.concat(doc[JSON_TWAI_RX_RATE].as<int>());
+    text.concat(" frames/s, burst max: ");
+    text.concat(doc[JSON_TWAI_RX_BURST_MAX].as<int>());
+    text.concat("\r\nRejected (software): ");
+    text.concat(doc[JSON_TWAI_RX_REJECTED].as<int>());
+    text.concat(", rate: ");
+    text.concat(doc[JSON_TWAI_RX_REJECTED_RATE].as<int>());
+    text.concat(" frames/s");
+
+    text.concat("\r\nFilter: ");
+    text.concat(doc[JSON_TWAI_FILTER_MODE].as<const char *>());
+    text.concat(", code: ");
+    text.concat(doc[JSON_TWAI_FILTER_CODE].as<const char *>());
+    text.concat(", mask: ");
+    text.concat(doc[JSON_TWAI_FILTER_MASK].as<const char *>());
+    text.concat(", accepts ");
+    text.concat(doc[JSON_TWAI_FILTER_ACCEPT].as<float>(), 3);
+    text.concat("% of identifiers");
 
     text.concat("\r\nTransmitted: ");
     text.concat(doc[JSON_TWAI_TX_FRAMES].as<int>());
@@ -122,6 +207,16 @@ String TWAI_string(void)
     text.concat(doc[JSON_TWAI_TX_FAILED].as<int>());
     text.concat(", queued: ");
     text.concat(doc[JSON_TWAI_TX_QUEUED].as<int>());
+    text.concat(", dropped: ");
+    text.concat(doc[JSON_TWAI_TX_DROPPED].as<int>());
+    text.concat(", timeout: ");
+    text.concat(doc[JSON_TWAI_TX_TIMEOUT].as<int>());
+    text.concat("\r\nTransmit rate: ");
+    text.concat(doc[JSON_TWAI_TX_RATE].as<int>());
+    text.concat(" frames/s, queue high-water: ");
+    text.concat(doc[JSON_TWAI_TX_QUEUE_HWM].as<int>());
+    text.concat("/");
+    text.concat(TWAI_QUEUE_LEN);
 
     text.concat("\r\nArbitrage lost: ");
     text.concat(doc[JSON_TWAI_ARB_LOST].as<int>());
@@ -162,21 +257,28 @@ bool TWAI_rx_frames(void)
 }
 
 /*******************************************************************
- * Set receive handler
+ * Queue high-water mark
  *******************************************************************/
-void TWAI_rx_handler(CANReceiveHandler handler)
+static void TWAI_queue_hwm(QueueHandle_t queue, uint32_t &hwm)
 {
-    TWAI_receive_handler = handler;
+    uint32_t waiting = uxQueueMessagesWaiting(queue);
+    if (waiting > hwm)
+        hwm = waiting;
 }
 
 /*******************************************************************
  *  Send a frame through CAN channel
  *
  *******************************************************************/
-int TWAI_send(uint32_t id, uint8_t *buffer, uint8_t length, bool rtr, bool extd)
+int TWAI_send(uint32_t id, const uint8_t *buffer, uint8_t length, bool rtr, bool extd)
 {
     twai_message_t frame;
 
+    if (!TWAI_TX_QUEUE)
+    {
+        return ESP_FAIL;  // Channel not set up
+    }
+
     frame.identifier = id;
     frame.extd = extd ? 1 : 0;
     frame.rtr = rtr ? 1 : 0;
@@ -185,83 +287,305 @@ int TWAI_send(uint32_t id, uint8_t *buffer, uint8_t length, bool rtr, bool extd)
 
     if (xQueueSend(TWAI_TX_QUEUE, &frame, 0) != pdPASS)
     {
-        // Serial.println(F("TWAI transmit error queueing frame..."));
+        _twai_tx_dropped++;
         return ESP_FAIL;
     }
+    TWAI_queue_hwm(TWAI_TX_QUEUE, _twai_tx_queue_hwm);
+    return ESP_OK;
+}
+
+/*******************************************************************
+ *  Frames waiting in the transmit queue (not yet in the driver)
+ *
+ *******************************************************************/
+int TWAI_tx_pending(void)
+{
+    return TWAI_TX_QUEUE ? (int)uxQueueMessagesWaiting(TWAI_TX_QUEUE) : 0;
+}
+
+/*******************************************************************
+ *  Bus bit rate in bits/s
+ *
+ *******************************************************************/
+uint32_t TWAI_baudrate(void)
+{
+    return _twai_baudrate;
+}
+
+/*******************************************************************
+ *  Error counters and state for the CAN health monitor
+ *
+ *******************************************************************/
+int TWAI_bus_status(HEALTH_status_t *status)
+{
+    twai_status_info_t info;
+
+    if (!TWAI_lock || (twai_get_status_info(&info) != ESP_OK))
+        return ESP_FAIL;  // Driver not installed
+
+    status->tec = (uint16_t)info.tx_error_counter;
+    status->rec = (uint16_t)info.rx_error_counter;
+    status->bus_errors = info.bus_error_count;
+
+    switch (info.state)
+    {
+    case TWAI_STATE_BUS_OFF:
+        status->state = HEALTH_BUS_OFF;
+        break;
+    case TWAI_STATE_RECOVERING:
+    case TWAI_STATE_STOPPED:
+        status->state = HEALTH_RECOVERING;
+        break;
+    default:
+        status->state = HEALTH_state(status->tec, status->rec);
+        break;
+    }
     return ESP_OK;
 }
 
 /*******************************************************************
- *  Setup the TWAI transmitting frame
+ *  Bus-off recovery, the driver waits for 128 occurrences of 11
+ *  recessive bits and stops, a second call starts it again
  *
  *******************************************************************/
+int TWAI_bus_recover(void)
+{
+    twai_status_info_t info;
+    esp_err_t error = ESP_OK;
+
+    if (!TWAI_lock)
+        return ESP_FAIL;
+
+    xSemaphoreTake(TWAI_lock, portMAX_DELAY);
+    if (twai_get_status_info(&info) != ESP_OK)
+        error = ESP_FAIL;
+    else if (info.state == TWAI_STATE_BUS_OFF)
+        error = twai_initiate_recovery();
+    else if (info.state == TWAI_STATE_STOPPED)
+        error = twai_start();
+    xSemaphoreGive(TWAI_lock);
+
+    return (error == ESP_OK) ? ESP_OK : ESP_FAIL;
+}
+
+/*******************************************************************
+ *  TWAI transmit task, blocks on the transmit queue and hands all
+ *  queued frames to the driver in one wakeup
+ *
+ *******************************************************************/
+static void TWAI_transmit(twai_message_t *frame)
+{
+    DEBUG_can("TWAI-tx: ", frame->data_length_code, frame->identifier, 0, frame->data);
+
+    xSemaphoreTake(TWAI_lock, portMAX_DELAY);
+    if (twai_transmit(frame, TWAI_TX_TIMEOUT_MS / portTICK_PERIOD_MS) == ESP_OK)
+    {
+        _twai_transmitted++;
+        CANHEALTH_observe(CAN_CHANNEL_TWAI, frame->identifier, frame->extd, frame->rtr, frame->data_length_code, frame->data);
+        CANCAP_tx(CAN_CHANNEL_TWAI, frame->identifier, frame->extd, frame->rtr, frame->data_length_code, frame->data);
+    }
+    else
+    {
+        _twai_tx_timeout++;
+        CANCAP_trigger("twai transmit timeout");
+    }
+    xSemaphoreGive(TWAI_lock);
+}
+
 void TWAI_transmit_task(void *parameter)
 {
     twai_message_t frame;
-    int error;
     (void)parameter;
 
     while (true)
     {
-        if (xQueueReceive(TWAI_TX_QUEUE, &frame, 0) == pdPASS)
+        if (xQueueReceive(TWAI_TX_QUEUE, &frame, portMAX_DELAY) != pdPASS)
+            continue;
+
+        do
         {
-            DEBUG_can("TWAI-tx: ", frame.data_length_code, frame.identifier, 0, frame.data);
-            _twai_transmitted++;
+            TWAI_transmit(&frame);
+        } while (xQueueReceive(TWAI_TX_QUEUE, &frame, 0) == pdPASS);
+    }
+}
 
-            _twai_error = twai_transmit(&frame, portMAX_DELAY);
-        }
-        vTaskDelay(50 / portTICK_PERIOD_MS);
+/*******************************************************************
+ *  Copy a received message into a pooled frame for dispatch
+ *******************************************************************/
+static void TWAI_post(const twai_message_t *message)
+{
+    CANHEALTH_observe(CAN_CHANNEL_TWAI, message->identifier, message->extd, message->rtr, message->data_length_code, message->data);
+
+    CAN_frame_t *frame = CANBUS_frame_alloc();
+
+    if (!frame)
+    {
+        _twai_rx_dropped++;
+        return;
     }
+
+    frame->id = message->identifier;
+    frame->ext = message->extd;
+    frame->rtr = message->rtr;
+    frame->length = message->data_length_code;
+    frame->channel = CAN_CHANNEL_TWAI;
+    memcpy(frame->data, message->data, sizeof(frame->data));
+
+#ifdef DEBUG_FRAMES
+    Serial.printf("TWAI frame received with id 0x%04x.\n\r", (int)frame->id);
+#endif
+
+    CANBUS_frame_post(frame);
 }
 
 /*******************************************************************
- *  Setup the TWAI receiving frame
- *
+ *  Acceptance filter, compiled from the CAN subscriptions
  *******************************************************************/
-void TWAI_receive_task(void *parameter)
+static twai_filter_config_t TWAI_filter_compile(void)
 {
-    twai_message_t frame;
-    (void)parameter;
+    CANFILTER_rule_t rules[TWAI_MAX_RULES];
+    int count = CANBUS_rules(rules, TWAI_MAX_RULES);
 
-    while (true)
+    CANFILTER_twai(rules, count, &TWAI_filter);
+
+    twai_filter_config_t filter_config = {
+        .acceptance_code = TWAI_filter.code,
+        .acceptance_mask = TWAI_filter.mask,
+        .single_filter = (TWAI_filter.mode == CANFILTER_TWAI_SINGLE),
+    };
+    return filter_config;
+}
+
+static esp_err_t TWAI_install(const twai_filter_config_t *filter_config)
+{
+    esp_err_t error = twai_driver_install(&TWAI_general_config, &TWAI_timing_config, filter_config);
+    if (error != ESP_OK)
     {
-        if (twai_receive(&frame, 0) == ESP_OK)
-        {
-            _twai_received++;
+        Serial.printf("TWAI driver installation failed, (errno. %d).\n\r", (int)error);
+        return ESP_FAIL;
+    }
 
-            if (xQueueSend(TWAI_RX_QUEUE, &frame, 0) != pdPASS)
-            {
-                Serial.println(F("TWAI error queueing received frame..."));
-                vTaskDelay(500 / portTICK_PERIOD_MS);
-            }
+    // start TWAI driver
+    error = twai_start();
+    if (error != ESP_OK)
+    {
+        Serial.printf("TWAI driver start failed, (errno. %d).\n\r", (int)error);
+        twai_driver_uninstall();
+        return ESP_FAIL;
+    }
+
+    TWAI_filter_config = *filter_config;
+    TWAI_installed = true;
+    return ESP_OK;
+}
+
+static void TWAI_filter_changed(void)
+{
+    TWAI_filter_dirty = true;
+}
+
+/*******************************************************************
+ *  Subscriptions changed, the filter can only be set when the
+ *  driver is installed (called from the receive task)
+ *******************************************************************/
+static void TWAI_reconfigure(void)
+{
+    esp_err_t error;
+
+    TWAI_filter_dirty = false;
+    twai_filter_config_t filter_config = TWAI_filter_compile();
+
+    xSemaphoreTake(TWAI_lock, portMAX_DELAY);
+    if (TWAI_installed)
+    {
+        error = twai_stop();
+        if (error != ESP_OK)
+            Serial.printf("TWAI driver stop failed, (errno. %d).\n\r", (int)error);
+
+        // Bus-off also allows the uninstall, a failure keeps the old filter and retries
+        error = twai_driver_uninstall();
+        if (error != ESP_OK)
+        {
+            Serial.printf("TWAI driver uninstall failed, (errno. %d).\n\r", (int)error);
+            twai_start();
+            TWAI_filter_dirty = true;
+            xSemaphoreGive(TWAI_lock);
+            return;
         }
-        vTaskDelay(50 / portTICK_PERIOD_MS);
+        TWAI_installed = false;
     }
+
+    if (TWAI_install(&filter_config) == ESP_OK)
+    {
+        xSemaphoreGive(TWAI_lock);
+        CLI_println(F("TWAI acceptance filter updated."));
+        return;
+    }
+
+    // Previous filter, the bus stays down (receive task retries) when that fails too
+    if (TWAI_install(&TWAI_filter_config) != ESP_OK)
+        TWAI_filter_dirty = true;
+    xSemaphoreGive(TWAI_lock);
+
+    CLI_println(TWAI_installed ? F("TWAI acceptance filter update failed, previous filter restored.")
+                               : F("TWAI driver down, reinstall failed."));
 }
 
 /*******************************************************************
- *  TWAI main task
+ *  Bus errors or bus-off start an armed CAN capture
+ *
  *******************************************************************/
-void TWAI_main_task(void *parameter)
+static void TWAI_check_bus(void)
 {
-    twai_message_t frame;
+    static uint32_t memo_bus_errors = 0;
+    twai_status_info_t info;
+
+    if (twai_get_status_info(&info) != ESP_OK)
+        return;
+
+    if ((info.bus_error_count != memo_bus_errors) || (info.state == TWAI_STATE_BUS_OFF))
+        CANCAP_trigger("twai bus error");
+    memo_bus_errors = info.bus_error_count;
+}
+
+/*******************************************************************
+ *  TWAI receive task, blocks on the driver and posts a complete
+ *  burst to the CAN dispatch task in one wakeup
+ *
+ *******************************************************************/
+void TWAI_receive_task(void *parameter)
+{
+    twai_message_t message;
+    uint32_t burst;
     (void)parameter;
 
     while (true)
     {
-        if (xQueueReceive(TWAI_RX_QUEUE, &frame, 0) == pdPASS)
+        if (TWAI_filter_dirty)
+            TWAI_reconfigure();
+
+        if (!TWAI_installed)
         {
-            _twai_received++;
+            vTaskDelay(TWAI_RX_TIMEOUT_MS / portTICK_PERIOD_MS);  // Bus down, no driver to block on
+            continue;
+        }
 
-#ifdef DEBUG_FRAMES
-            Serial.printf("TWAI frame received with id 0x%04x.\n\r", (int)frame.identifier);
-#endif
+        TWAI_check_bus();
 
-            if (TWAI_receive_handler)
-                TWAI_receive_handler(frame.identifier, frame.data, frame.data_length_code, frame.rtr ? true : false, frame.extd ? true : false);
-        }
+        if (twai_receive(&message, TWAI_RX_TIMEOUT_MS / portTICK_PERIOD_MS) != ESP_OK)
+            continue;
+
+        burst = 0;
+        do
+        {
+            _twai_received++;
+            burst++;
+
+            TWAI_post(&message);
+        } while (twai_receive(&message, 0) == ESP_OK);
 
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        if (burst > _twai_rx_burst_max)
+            _twai_rx_burst_max = burst;
     }
 }
 
@@ -280,47 +604,34 @@ static esp_err_t TWAI_setup_driver(int mode)
         .rx_io = (gpio_num_t)GPIO_NUM_4,
         .clkout_io = (gpio_num_t)TWAI_IO_UNUSED,
         .bus_off_io = (gpio_num_t)TWAI_IO_UNUSED,
-        .tx_queue_len = 0, // NO QueQue
+        .tx_queue_len = TWAI_DRIVER_TX_LEN, // twai_transmit() blocks when full
         .rx_queue_len = 65,
         .alerts_enabled = TWAI_ALERT_NONE, // geen alert berichten
                                            //.alerts_enabled = TWAI_ALERT_AND_LOG, // Stuurt CANBUS Alert berichten via Debug poort
         .clkout_divider = 0,
         .intr_flags = 1,
     };
+    TWAI_general_config = general_config;
 
-    twai_timing_config_t timing_config;
     switch (mode)
     {
     case CAN_500KB:
         _twai_baudrate = 500000;
-        timing_config = TWAI_TIMING_CONFIG_500KBITS();
+        TWAI_timing_config = TWAI_TIMING_CONFIG_500KBITS();
         CLI_println(F("Setup TWAI with 500kbps."));
         break;
 
     case CAN_250KB:
     default:
         _twai_baudrate = 250000;
-        timing_config = TWAI_TIMING_CONFIG_250KBITS();
+        TWAI_timing_config = TWAI_TIMING_CONFIG_250KBITS();
         CLI_println(F("Setup TWAI with 250kbps."));
         break;
     }
 
-    twai_filter_config_t filter_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
-
-    esp_err_t error = twai_driver_install(&general_config, &timing_config, &filter_config);
-    if (error != ESP_OK)
-    {
-        Serial.printf("TWAI driver installation failed, (errno. %d).\n\r", (int)error);
-        return ESP_FAIL;
-    }
-
-    // start TWAI driver
-    error = twai_start();
-    if (error != ESP_OK)
-    {
-        Serial.printf("TWAI driver start failed, (errno. %d).\n\r", (int)error);
+    twai_filter_config_t filter_config = TWAI_filter_compile();
+    if (TWAI_install(&filter_config) != ESP_OK)
         return ESP_FAIL;
-    }
 
     CLI_println(F("TWAI setup completed..."));
     return ESP_OK;
@@ -331,9 +642,7 @@ static esp_err_t TWAI_setup_driver(int mode)
  *********************************************************************/
 void TWAI_rest_read(AsyncWebServerRequest *request)
 {
-    String str;
-    serializeJson(TWAI_json(), str);
-    request->send(200, "application/json", str.c_str());
+    WEBSERVER_send_json(request, TWAI_json);
 }
 
 static rest_api_t TWAI_api_handlers = {
@@ -368,8 +677,8 @@ static void TWAI_cli_handlers(void)
  *******************************************************************/
 void TWAI_setup_queues()
 {
-    TWAI_TX_QUEUE = xQueueCreate(10, sizeof(twai_message_t)); // Transmit queue
-    TWAI_RX_QUEUE = xQueueCreate(10, sizeof(twai_message_t)); // Receive queue
+    TWAI_TX_QUEUE = xQueueCreate(TWAI_QUEUE_LEN, sizeof(twai_message_t)); // Transmit queue
+    TWAI_lock = xSemaphoreCreateMutex();
 }
 
 /*******************************************************************
@@ -378,7 +687,6 @@ void TWAI_setup_queues()
  *******************************************************************/
 void TWAI_setup_tasks()
 {
-    xTaskCreate(TWAI_main_task, "TWAI main task", 4096, NULL, 3, NULL);
     xTaskCreate(TWAI_receive_task, "TWAI receive task", 2048, NULL, 5, NULL);
     xTaskCreate(TWAI_transmit_task, "TWAI transmit task", 2048, NULL, 5, NULL);
 }
@@ -389,6 +697,7 @@ void TWAI_setup_tasks()
  *******************************************************************/
 void TWAI_setup(int mode)
 {
+    CANBUS_setup();
     TWAI_setup_queues();
 
     if (TWAI_setup_driver(mode) != ESP_OK)
@@ -397,6 +706,7 @@ void TWAI_setup(int mode)
         return;
     }
 
+    CANBUS_on_change(TWAI_filter_changed);
     TWAI_setup_tasks();
 
     TWAI_cli_handlers();
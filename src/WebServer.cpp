@@ -4,19 +4,24 @@
  *******************************************************************/
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
 #include <ESPmDNS.h>
 #include <ElegantOTAPro.h>
 #include <FS.h>
 #include <LittleFS.h>
 #include <WebSerial.h>
 #include <WebServer.h>
-#include <WebSocketsServer.h>
 #include <WiFi.h>
 #include <esp_err.h>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "CLI.h"
 #include "Config.h"
 #include "Debug.h"
+#include "EBC_Utils.h"
 #include "Maintenance.h"
 #include "Storage.h"
 #include "WiFiCom.h"
@@ -27,40 +32,191 @@
 #define DEFAULT_HTML_PAGE "/web/index.html"
 
 #define WEBSERVER_PORT 80
-#define WEBSOCKET_PORT 81
+#define WEBSOCKET_URL "/ws"
+
+#define WEBSERVER_OTA_RESTART_MS 3000      // Delay after an OTA update
+#define WEBSOCKET_TICK_MS 100              // Websocket telemetry
+#define WEBSOCKET_FRAME_SIZE 1024          // Pairs per websocket message
+#define WEBSOCKET_STATS_WINDOW_US 1000000  // Byte rate
+#define WEBSOCKET_MAX_CLIENTS DEFAULT_MAX_WS_CLIENTS
+#define WEBSERVER_PAGE_CACHE "no-cache"    // Revalidate, the address is part of the page
+#define WEBSERVER_ASSET_ROOT "/web"
+#define WEBSERVER_ASSET_URL "/maintenance"
+#define WEBSERVER_ASSET_INDEX "index.html"
+#define WEBSERVER_ASSET_CACHE "max-age=300"  // Then revalidated by the entity tag
+#define WEBSERVER_ASSET_MAX 16             // Entity tags kept, files in the web folder
+#define WEBSERVER_ASSET_PATH_SIZE 64
+#define WEBSERVER_ASSET_CHUNK 512          // Hashing the file
+#define WEBSERVER_REST_ARENA_SIZE 8192     // JSON document of a REST read, the heap beyond
 
 #define DEBUG_WEBSOCKET
 
 /********************************************************************
  * Type definitions
  *********************************************************************/
+typedef struct {
+  char path[WEBSERVER_ASSET_PATH_SIZE];  // File served, .gz included
+  size_t size;                           // Of the file hashed
+  char etag[PAGE_ETAG_SIZE];
+} WEBSERVER_asset_t;
 
 /********************************************************************
  * Variables
  *********************************************************************/
 AsyncWebServer web_server(WEBSERVER_PORT);
-WebSocketsServer web_socket_server = WebSocketsServer(WEBSOCKET_PORT);
+AsyncWebSocket web_socket(WEBSOCKET_URL);
+
+static TELEM_cache_t websocket_cache;  // Last published values, zeroed is empty
+static TELEM_stats_t websocket_stats;
+static SemaphoreHandle_t websocket_lock = nullptr;  // Cache and statistics
+static TaskHandle_t websocket_task_handle = nullptr;
+
+static volatile bool websocket_resync = false;  // A client connected, send all values
+static uint32_t websocket_resyncs = 0;
+
+static std::shared_ptr<std::vector<char>> web_page;  // Rendered index page, kept by responses in flight
+static char web_page_etag[PAGE_ETAG_SIZE] = "";
+static String web_page_ip;  // Rendered address and network
+static String web_page_ssid;
+static uint32_t web_page_renders = 0;
+static uint32_t web_page_render_us = 0;
+static uint32_t web_page_requests = 0;
+static uint32_t web_page_not_modified = 0;
+static uint32_t web_page_response_us = 0;  // Handler time, last request
+static uint32_t web_page_response_max_us = 0;
+
+static uint8_t web_rest_buffer[WEBSERVER_REST_ARENA_SIZE];
+static ARENA_t web_rest_arena;
+static SemaphoreHandle_t web_rest_lock = nullptr;  // Arena, REST reads are answered one at a time
+static uint32_t web_rest_reads = 0;
+static uint32_t web_rest_bytes = 0;
+static uint32_t web_rest_allocations = 0;  // Last read, arena and heap
+static uint32_t web_rest_heap_allocations = 0;  // Last read, did not fit the arena
+static uint32_t web_rest_heap_peak = 0;  // Heap in use while sending, bytes
+static uint32_t web_rest_response_us = 0;
+static uint32_t web_rest_response_max_us = 0;
+
+static WEBSERVER_asset_t web_assets[WEBSERVER_ASSET_MAX];  // Entity tags, by file
+static int web_num_assets = 0;
+static uint32_t web_asset_requests = 0;
+static uint32_t web_asset_gzip = 0;
+static uint32_t web_asset_not_modified = 0;
+static uint32_t web_asset_not_found = 0;
 
-static JsonDocument WebSocket_JSON_data;
+/********************************************************************
+ * JSON allocators: the heap, and the arena of a REST read that falls
+ * back to the heap when a block does not fit
+ *******************************************************************/
+class WEBSERVER_heap_allocator : public ArduinoJson::Allocator {
+ public:
+  void *allocate(size_t size) override {
+    return malloc(size);
+  }
 
-static int ota_restart_countdown = 0;
+  void deallocate(void *pointer) override {
+    free(pointer);
+  }
 
-static int websocket_client_connected = 0;
+  void *reallocate(void *pointer, size_t new_size) override {
+    return realloc(pointer, new_size);
+  }
+};
+
+class WEBSERVER_arena_allocator : public ArduinoJson::Allocator {
+ public:
+  uint32_t heap_allocations = 0;
+
+  void *allocate(size_t size) override {
+    void *block = ARENA_alloc(&web_rest_arena, size);
+
+    if (!block) {
+      heap_allocations++;
+      block = malloc(size);
+    }
+    return block;
+  }
+
+  void deallocate(void *pointer) override {
+    if (ARENA_owns(&web_rest_arena, pointer)) {
+      ARENA_free(&web_rest_arena, pointer);
+    } else {
+      free(pointer);
+    }
+  }
+
+  void *reallocate(void *pointer, size_t new_size) override {
+    if (!pointer) {
+      return allocate(new_size);
+    }
+    if (!ARENA_owns(&web_rest_arena, pointer)) {
+      return realloc(pointer, new_size);
+    }
+
+    void *block = ARENA_realloc(&web_rest_arena, pointer, new_size);
+    if (!block) {
+      heap_allocations++;
+      block = malloc(new_size);
+      if (block) {
+        memcpy(block, pointer, std::min((size_t)ARENA_block_size(&web_rest_arena, pointer), new_size));
+      }
+    }
+    return block;
+  }
+};
+
+static WEBSERVER_heap_allocator web_json_heap;
+ArduinoJson::Allocator *const JSON_HEAP = &web_json_heap;
 
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
-static JsonDocument WEBSERVER_json(void) {
-  JsonDocument doc;
+static JsonDocument WEBSERVER_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
 
   doc[JSON_WEBS_FLASH_SIZE] = (uint32_t)(ESP.getFlashChipSize() / 1024);  // kByte
   doc[JSON_WEBS_FLASH_USED] = (uint32_t)(ESP.getSketchSize() / 1024);     // kByte
 
   doc[JSON_WEBS_HEAP_TOTAL] = (uint32_t)(ESP.getHeapSize() / 1024);  // kByte
   doc[JSON_WEBS_HEAP_FREE] = (uint32_t)(ESP.getFreeHeap() / 1024);   // kByte
+  doc[JSON_WEBS_HEAP_MIN] = (uint32_t)(ESP.getMinFreeHeap() / 1024);  // kByte, low water mark
 
   doc[JSON_WEBS_CHIP_ID] = ChipIds();
 
+  doc[JSON_WEBS_WS_KEYS] = websocket_cache.num_keys;
+  doc[JSON_WEBS_WS_CHANGED] = websocket_cache.changed;
+  doc[JSON_WEBS_WS_UNCHANGED] = websocket_cache.unchanged;
+  doc[JSON_WEBS_WS_REJECTED] = websocket_cache.rejected;
+  doc[JSON_WEBS_WS_FRAMES] = websocket_stats.frames;
+  doc[JSON_WEBS_WS_FRAMES_TICK] = websocket_stats.frames_last;
+  doc[JSON_WEBS_WS_PAIRS_TICK] = websocket_stats.pairs_last;
+  doc[JSON_WEBS_WS_BYTE_RATE] = websocket_stats.byte_rate;
+  doc[JSON_WEBS_WS_SERIALIZE] = websocket_stats.serialize_last;
+  doc[JSON_WEBS_WS_SERIALIZE_MAX] = websocket_stats.serialize_max;
+  doc[JSON_WEBS_WS_CLIENTS] = web_socket.count();
+  doc[JSON_WEBS_WS_RESYNCS] = websocket_resyncs;
+
+  doc[JSON_WEBS_PAGE_SIZE] = web_page ? (uint32_t)web_page->size() : 0;
+  doc[JSON_WEBS_PAGE_RENDERS] = web_page_renders;
+  doc[JSON_WEBS_PAGE_RENDER] = web_page_render_us;
+  doc[JSON_WEBS_PAGE_REQUESTS] = web_page_requests;
+  doc[JSON_WEBS_PAGE_NOT_MODIFIED] = web_page_not_modified;
+  doc[JSON_WEBS_PAGE_RESPONSE] = web_page_response_us;
+  doc[JSON_WEBS_PAGE_RESPONSE_MAX] = web_page_response_max_us;
+
+  doc[JSON_WEBS_ASSET_REQUESTS] = web_asset_requests;
+  doc[JSON_WEBS_ASSET_GZIP] = web_asset_gzip;
+  doc[JSON_WEBS_ASSET_NOT_MODIFIED] = web_asset_not_modified;
+  doc[JSON_WEBS_ASSET_NOT_FOUND] = web_asset_not_found;
+
+  doc[JSON_WEBS_REST_READS] = web_rest_reads;
+  doc[JSON_WEBS_REST_BYTES] = web_rest_bytes;
+  doc[JSON_WEBS_REST_ALLOCATIONS] = web_rest_allocations;
+  doc[JSON_WEBS_REST_HEAP_ALLOCATIONS] = web_rest_heap_allocations;
+  doc[JSON_WEBS_REST_ARENA_PEAK] = web_rest_arena.peak;
+  doc[JSON_WEBS_REST_HEAP_PEAK] = web_rest_heap_peak;
+  doc[JSON_WEBS_REST_RESPONSE] = web_rest_response_us;
+  doc[JSON_WEBS_REST_RESPONSE_MAX] = web_rest_response_max_us;
+
   return doc;
 }
 
@@ -81,11 +237,131 @@ String WEBSERVER_string(void) {
   text.concat(doc[JSON_WEBS_HEAP_TOTAL].as<int>());
   text.concat(", free(kb): ");
   text.concat(doc[JSON_WEBS_HEAP_FREE].as<int>());
+  text.concat(", min free(kb): ");
+  text.concat(doc[JSON_WEBS_HEAP_MIN].as<int>());
+
+  text.concat("\r\nWebsocket keys: ");
+  text.concat(websocket_cache.num_keys);
+  text.concat(", changed: ");
+  text.concat(websocket_cache.changed);
+  text.concat(", unchanged: ");
+  text.concat(websocket_cache.unchanged);
+  text.concat(", rejected: ");
+  text.concat(websocket_cache.rejected);
+
+  text.concat("\r\nWebsocket frames: ");
+  text.concat(websocket_stats.frames);
+  text.concat(", last tick: ");
+  text.concat(websocket_stats.frames_last);
+  text.concat(" (");
+  text.concat(websocket_stats.pairs_last);
+  text.concat(" values), bytes/s: ");
+  text.concat(websocket_stats.byte_rate);
+  text.concat(", serialize(us): ");
+  text.concat(websocket_stats.serialize_last);
+  text.concat(" (max ");
+  text.concat(websocket_stats.serialize_max);
+  text.concat(")");
+
+  text.concat("\r\nWebsocket clients: ");
+  text.concat(web_socket.count());
+  text.concat(", all values sent: ");
+  text.concat(websocket_resyncs);
+
+  text.concat("\r\nIndex page size: ");
+  text.concat(doc[JSON_WEBS_PAGE_SIZE].as<int>());
+  text.concat(", renders: ");
+  text.concat(web_page_renders);
+  text.concat(", render(us): ");
+  text.concat(web_page_render_us);
+  text.concat(", requests: ");
+  text.concat(web_page_requests);
+  text.concat(", not modified: ");
+  text.concat(web_page_not_modified);
+  text.concat(", response(us): ");
+  text.concat(web_page_response_us);
+  text.concat(" (max ");
+  text.concat(web_page_response_max_us);
+  text.concat(")");
+
+  text.concat("\r\nAssets requests: ");
+  text.concat(web_asset_requests);
+  text.concat(", gzip: ");
+  text.concat(web_asset_gzip);
+  text.concat(", not modified: ");
+  text.concat(web_asset_not_modified);
+  text.concat(", not found: ");
+  text.concat(web_asset_not_found);
+
+  text.concat("\r\nREST reads: ");
+  text.concat(web_rest_reads);
+  text.concat(", bytes: ");
+  text.concat(web_rest_bytes);
+  text.concat(", allocations: ");
+  text.concat(web_rest_allocations);
+  text.concat(" (heap ");
+  text.concat(web_rest_heap_allocations);
+  text.concat("), arena peak: ");
+  text.concat(web_rest_arena.peak);
+  text.concat("/");
+  text.concat(web_rest_arena.size);
+  text.concat(", heap peak: ");
+  text.concat(web_rest_heap_peak);
+  text.concat(", response(us): ");
+  text.concat(web_rest_response_us);
+  text.concat(" (max ");
+  text.concat(web_rest_response_max_us);
+  text.concat(")");
 
   text.concat("\r\n");
   return text;
 }
 
+/********************************************************************
+ * REST responses
+ *******************************************************************/
+void WEBSERVER_send_json(AsyncWebServerRequest *request, const JsonDocument &doc) {
+  const size_t length = measureJson(doc);
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json", length + 1);  // cbuf keeps one free
+  serializeJson(doc, *response);
+  request->send(response);
+
+  web_rest_bytes += length;
+}
+
+void WEBSERVER_send_json(AsyncWebServerRequest *request, JsonBuilder builder) {
+  const uint32_t start = micros();
+  const uint32_t heap = ESP.getFreeHeap();
+
+  web_rest_reads++;
+  if (!web_rest_lock || (xSemaphoreTake(web_rest_lock, 0) != pdTRUE)) {
+    WEBSERVER_send_json(request, builder(JSON_HEAP));  // Arena in use
+    return;
+  }
+
+  WEBSERVER_arena_allocator allocator;
+  const uint32_t allocations = web_rest_arena.allocations;
+  {
+    JsonDocument doc = builder(&allocator);
+
+    WEBSERVER_send_json(request, doc);
+    const uint32_t heap_used = heap - ESP.getFreeHeap();  // Document and response
+    if ((heap_used > web_rest_heap_peak) && (heap_used < heap)) {
+      web_rest_heap_peak = heap_used;
+    }
+  }
+  web_rest_allocations = web_rest_arena.allocations - allocations + allocator.heap_allocations;
+  web_rest_heap_allocations = allocator.heap_allocations;
+  ARENA_reset(&web_rest_arena);
+  xSemaphoreGive(web_rest_lock);
+
+  web_rest_response_us = micros() - start;
+  if (web_rest_response_us > web_rest_response_max_us) {
+    web_rest_response_max_us = web_rest_response_us;
+  }
+}
+
 /*******************************************************************
  * Get Web page title
  *******************************************************************/
@@ -140,6 +416,20 @@ void setup_uri(rest_api_t *uri_hdl) {
 /********************************************************************
  * ElegantOTA Profesional Routines
  *********************************************************************/
+extern void all_stop(void);
+
+static void WEBSERVER_restart_task(void *parameter) {
+  (void)parameter;
+
+  vTaskDelay(WEBSERVER_OTA_RESTART_MS / portTICK_PERIOD_MS);  // Short delay, OTA response
+
+  Serial.println("\nRestarting system after OTA update...\n");
+  all_stop();  // Stop al modules
+
+  vTaskDelay(1000 / portTICK_PERIOD_MS);
+  ESP.restart();
+}
+
 static void onOTAStart() {
   Serial.print("\nOTA update started...\n");
 }
@@ -158,85 +448,72 @@ static void onOTAEnd(bool success) {
   } else {
     Serial.println("\nOTA update failed...");
   }
-  ota_restart_countdown = 12;  // Short delay, in main-task-cycles
+  xTaskCreate(WEBSERVER_restart_task, "OTA restart", 4096, NULL, 10, NULL);
 }
 
 /********************************************************************
- * Main task
+ * WebSocket update
+ *
+ * The modules update values from their own tasks, the values are
+ * kept as JSON text in a fixed slot cache (EBC_Utils). The websocket
+ * task sends all values that changed during a tick in one message to
+ * all clients, they share its buffer. After a client connected the
+ * task sends all values instead. The serialisation runs under the
+ * lock, the sending does not. The client list belongs to AsyncTCP,
+ * the task only queues with textAll() and AsyncWebSocket closes a
+ * client whose queue overflows, it gets all values on reconnect.
  *********************************************************************/
-extern void all_stop(void);
-
-static void WEBSERVER_task(void *parameter) {
-  (void)parameter;
-
-  while (true) {
-    web_socket_server.loop();
-    
-    if (ota_restart_countdown > 0) {
-      ota_restart_countdown--;
-      if (ota_restart_countdown == 0) {
-        Serial.println("\nRestarting system after OTA update...\n");
-        all_stop();  // Stop al modules
-        
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-        ESP.restart();
-      }
-    }
-
-    vTaskDelay(250 / portTICK_PERIOD_MS);
+static void WEBSOCKET_lock(void) {
+  if (!websocket_lock) {
+    websocket_lock = xSemaphoreCreateMutex();  // First update, during setup
   }
+  xSemaphoreTake(websocket_lock, portMAX_DELAY);
+}
+
+static void WEBSOCKET_unlock(void) {
+  xSemaphoreGive(websocket_lock);
 }
 
 /********************************************************************
- * WebSocketsServer update
+ * Sends a pair directly, for values too long for the cache.
  *********************************************************************/
 static void WEBSOCKET_send_pair(JsonPair kv) {
-  String value;
-
-  if (kv.value().is<const char *>()) {
-    value = "\"" + String(kv.value().is<const char *>()) + "\"";
-  } else if (kv.value().is<int>()) {
-    value = String(kv.value().as<int>());
-  } else if (kv.value().is<float>()) {
-    value = String(kv.value().as<float>());
-  } else if (kv.value().is<bool>()) {
-    value = kv.value().as<bool>() ? String("true") : String("false");
-  } else {
-    value = "<invalid type>";
-  }
+  JsonDocument doc;
+  String msg;
 
-  String msg = "{\"" + String(kv.key().c_str()) + "\":" + value + "}";
-  web_socket_server.broadcastTXT(msg);
+  doc[kv.key()] = kv.value();
+  serializeJson(doc, msg);
+  web_socket.textAll(msg);
 }
 
 /********************************************************************
- * Stores a key-value pair in the WebSocket JSON data if
- * the value has changed.
+ * Stores a key-value pair in the cache, a changed or forced value
+ * is sent with the next tick. Call with the lock taken.
  *********************************************************************/
-static bool WEBSOCKET_store_pair(JsonPair kv) {
-  if (!WebSocket_JSON_data.containsKey(kv.key().c_str())) {
-    WebSocket_JSON_data[kv.key().c_str()] = NULL;
+static void WEBSOCKET_store_pair(JsonPair kv, bool force) {
+  char value[TELEM_VALUE_MAX];
+
+  if (measureJson(kv.value()) >= sizeof(value)) {
+    WEBSOCKET_send_pair(kv);
+    return;
   }
 
-  if (WebSocket_JSON_data[kv.key().c_str()] != kv.value()) {
-    WebSocket_JSON_data[kv.key().c_str()] = kv.value();
-    return true;
+  serializeJson(kv.value(), value, sizeof(value));
+  if (TELEM_set(&websocket_cache, kv.key().c_str(), value, force) < 0) {
+    WEBSOCKET_send_pair(kv);  // Cache full or key too long
   }
-  return false;
 }
 
 /********************************************************************
- * Updates the WebSocket JSON data with the given key-value pair.
- * If the key does not exist in the WebSocket JSON data, it is
- * added with a null value. * Then, the key-value pair is stored
- * and sent via WebSocket.
+ * Updates the WebSocket JSON data with the given key-value pair,
+ * a changed value is sent with the next tick.
  *
  * @param kv The key-value pair to update.
  *********************************************************************/
 void WEBSOCKET_update_pair(JsonPair kv) {
-  if (WEBSOCKET_store_pair(kv)) {
-    WEBSOCKET_send_pair(kv);
-  }
+  WEBSOCKET_lock();
+  WEBSOCKET_store_pair(kv, false);
+  WEBSOCKET_unlock();
 }
 
 /********************************************************************
@@ -245,52 +522,49 @@ void WEBSOCKET_update_pair(JsonPair kv) {
  * @param doc The JSON document containing the values to update.
  *********************************************************************/
 void WEBSOCKET_update_doc(JsonDocument doc) {
+  WEBSOCKET_lock();
   for (JsonPair kv : doc.as<JsonObject>()) {
-    WEBSOCKET_update_pair(kv);
+    WEBSOCKET_store_pair(kv, false);
   }
+  WEBSOCKET_unlock();
 }
 
 /********************************************************************
- * Sends a JSON document over a WebSocket connection.
+ * Sends a JSON document over a WebSocket connection, all values
+ * with the next tick.
  *
  * @param doc The JSON document to send.
  *********************************************************************/
 void WEBSOCKET_send_doc(JsonDocument doc) {
-  String msg;
-
-  // Store values
+  WEBSOCKET_lock();
   for (JsonPair kv : doc.as<JsonObject>()) {
-    WEBSOCKET_store_pair(kv);
+    WEBSOCKET_store_pair(kv, true);
   }
-
-  // Send complete doc
-  serializeJson(doc, msg);
-  web_socket_server.broadcastTXT(msg);
+  WEBSOCKET_unlock();
 }
 
 /********************************************************************
- * Sends a JSON key-value pair to the WebSocket connection.
+ * Sends a JSON key-value pair to the WebSocket connection, with the
+ * next tick even when the value did not change.
  *
  * @param key The key of the JSON pair to push.
  * @param doc The JSON document containing the key-value pairs.
  *********************************************************************/
 void WEBSOCKET_send(String key, JsonDocument doc) {
-  String msg;
-
-  // Store values
+  WEBSOCKET_lock();
   for (JsonPair kv : doc.as<JsonObject>()) {
-    if (String(kv.key().c_str()) == key) {
-      WEBSOCKET_send_pair(kv);
+    if (key == kv.key().c_str()) {
+      WEBSOCKET_store_pair(kv, true);
       break;
     }
   }
+  WEBSOCKET_unlock();
 }
 
 /********************************************************************
- * WebSockets on connect
+ * Values of a new client, queued for the next tick.
  *********************************************************************/
 static void WEBSOCKET_on_connect(void) {
-  WEBSOCKET_send_doc(WebSocket_JSON_data);
   JsonDocument doc;
 
   //  General program data
@@ -301,13 +575,69 @@ static void WEBSOCKET_on_connect(void) {
   WEBSOCKET_send_doc(doc);
 }
 
+/********************************************************************
+ * Sends the frames of the cache to all clients, the changed values
+ * or all values.
+ *********************************************************************/
+static void WEBSOCKET_send_frames(bool all, uint32_t *frames, uint32_t *bytes, uint32_t *pairs, uint32_t *serialize) {
+  static char frame[WEBSOCKET_FRAME_SIZE];
+  uint16_t cursor = 0;
+  int length;
+
+  do {
+    WEBSOCKET_lock();
+    const uint32_t start = micros();
+    const uint16_t dirty = websocket_cache.num_dirty;
+    length = TELEM_frame(&websocket_cache, frame, sizeof(frame), all, &cursor);
+    *pairs += dirty - websocket_cache.num_dirty;
+    *serialize += micros() - start;
+    WEBSOCKET_unlock();
+
+    if (length > 0) {
+      web_socket.textAll(std::make_shared<std::vector<uint8_t>>((uint8_t *)frame, (uint8_t *)frame + length));
+      (*frames)++;
+      *bytes += length;
+    }
+  } while (length > 0);
+}
+
+/********************************************************************
+ * Websocket task, sends the values changed during a tick, one
+ * message as long as they fit in a frame.
+ *********************************************************************/
+static void WEBSOCKET_task(void *parameter) {
+  TickType_t wake = xTaskGetTickCount();
+  (void)parameter;
+
+  while (true) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(WEBSOCKET_TICK_MS));
+
+    uint32_t frames = 0;
+    uint32_t bytes = 0;
+    uint32_t pairs = 0;
+    uint32_t serialize = 0;
+    bool all = false;
+
+    if (websocket_resync) {
+      websocket_resync = false;
+      WEBSOCKET_on_connect();
+      all = true;
+    }
+
+    WEBSOCKET_send_frames(all, &frames, &bytes, &pairs, &serialize);
+
+    WEBSOCKET_lock();
+    websocket_resyncs += all ? 1 : 0;
+    TELEM_stats_tick(&websocket_stats, frames, bytes, pairs, serialize, micros());
+    WEBSOCKET_unlock();
+  }
+}
+
 /********************************************************************
  * REST API: read handler
  *********************************************************************/
 void WEBSERVER_rest_read(AsyncWebServerRequest *request) {
-  String json;
-  serializeJson(WEBSERVER_json(), json);
-  request->send(200, "application/json", json.c_str());
+  WEBSERVER_send_json(request, WEBSERVER_json);
 }
 
 /********************************************************************
@@ -361,39 +691,65 @@ static rest_api_t WEBSERVER_api_handlers = {
 };
 
 /********************************************************************
- * WebSocketServer events
+ * Maintenance mode off on a websocket (dis)connect, queued like the
+ * commands since the disable waits for the motors
  *********************************************************************/
-void WebSocketsEvents(byte num, WStype_t type, uint8_t *payload, size_t length) {
-  switch (type) {              // switch on the type of information sent
-    case WStype_DISCONNECTED:  // if a client is disconnected, then type == WStype_DISCONNECTED
+static void WEBSOCKET_maintenance_disable(void) {
+  static const char command[] = "{\"" JSON_MAINTENANCE_ENABLED "\":false}";
+
+  if (MAINTENANCE_queue_command(command, sizeof(command) - 1) != ESP_OK) {
+    Serial.println(F("MAINTENANCE disable not queued, queue full."));
+  }
+}
+
+/********************************************************************
+ * WebSocket events, from the web server (AsyncTCP task)
+ *********************************************************************/
+static void WEBSOCKET_event(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg,
+                            uint8_t *data, size_t len) {
+  (void)client;
+
+  switch (type) {
+    case WS_EVT_DISCONNECT:
 #ifdef DEBUG_WEBSOCKET
       Serial.println("Websocket client disconnected.");
 #endif
-      MAINTENANCE_disable();
+      WEBSOCKET_maintenance_disable();
       break;
 
-    case WStype_CONNECTED:  // if a client is connected, then type == WStype_CONNECTED
+    case WS_EVT_CONNECT:
 #ifdef DEBUG_WEBSOCKET
       Serial.println("Websocket client connected.");
 #endif
-      MAINTENANCE_disable();
-      WEBSOCKET_on_connect();
+      WEBSOCKET_maintenance_disable();
+      server->cleanupClients(WEBSOCKET_MAX_CLIENTS);  // Clients that went away, in the AsyncTCP task
+      websocket_resync = true;
       break;
 
-    case WStype_TEXT:  // if a client has sent data, then type == WStype_TEXT
-      Serial.print("Cmd handler: ");
-#ifdef DEBUG_WEBSOCKET
-      for (int i = 0; i < length; i++) {
-        Serial.print((char)payload[i]);
+    case WS_EVT_DATA: {
+      const AwsFrameInfo *info = (const AwsFrameInfo *)arg;
+
+      /* Commands are short, one text frame */
+      if (!info->final || (info->index != 0) || (info->len != len) || (info->opcode != WS_TEXT)) {
+        Serial.println(F("Websocket command not in one text frame, ignored."));
+        return;
       }
-      Serial.println("");
+
+#ifdef DEBUG_WEBSOCKET
+      Serial.print("Cmd handler: ");
+      Serial.write(data, len);
+      Serial.println();
 #endif
 
-      if (MAINTENANCE_command_handler((const char *)payload) < 0) {
-        Serial.print(F("MAINTENANCE command handler failed!"));
+      if (MAINTENANCE_queue_command((const char *)data, len) != ESP_OK) {
+        Serial.println(F("MAINTENANCE command not queued, too long or queue full."));
         return;
       }
       break;
+    }
+
+    default:
+      break;
   }
 }
 
@@ -416,72 +772,168 @@ static String load_file(fs::FS &fs, const char *path) {
 }
 
 /*********************************************************************
- * @brief Initializes the index.html file for the web server.
+ * @brief Renders the index page into the page cache.
  *
- * This function reads the contents of the specified file path and modifies it
- * by replacing certain placeholders with actual values. The modified content
- * is then saved to the default HTML page file.
+ * The template is read once and its placeholders are filled in a single
+ * pass into a buffer of the exact size. Requests share that buffer until
+ * the address or network changes and the page is rendered again.
  *
  * @param fs The file system object to access the file.
- * @param path The path of the HTML file to read.
+ * @param path The path of the HTML template.
+ * @return ESP_OK, ESP_FAIL when the template can not be read.
  *********************************************************************/
-static String WEBSERVER_load_html(fs::FS &fs, const char *path) {
-  int start, end;
+static esp_err_t WEBSERVER_render_page(fs::FS &fs, const char *path) {
+  const uint32_t start = micros();
 
-  String content = load_file(fs, path);
-  if (content == "") {
+  String source = load_file(fs, path);
+  if (source == "") {
     Serial.println("- failed to read HTML page from file.");
-    return "";
+    return ESP_FAIL;
   }
 
-  // Program name
-  #define PROGRAM_NAME_PLACEHOLDER "<span id=\"program_name\">-</span>"
-  start = content.indexOf(PROGRAM_NAME_PLACEHOLDER);
-  if (start < 0)
-    return content;
-  end = start + sizeof(PROGRAM_NAME_PLACEHOLDER) - 1;
-  content = content.substring(0, start) + String(ProgramName) + content.substring(end);
-
-  // Program version
-  #define PROGRAM_VERSION_PLACEHOLDER "<span id=\"program_version\">-</span>"
-  start = content.indexOf(PROGRAM_VERSION_PLACEHOLDER);
-  if (start < 0)
-    return content;
-  end = start + sizeof(PROGRAM_VERSION_PLACEHOLDER) - 1;
-  content = content.substring(0, start) + String(ProgramVersion) + content.substring(end);
-
-  // Chip id
-  #define CHIP_ID_PLACEHOLDER "<span id=\"chip_id\">-</span>"
-  start = content.indexOf(CHIP_ID_PLACEHOLDER);
-  if (start < 0)
-    return content;
-  end = start + sizeof(CHIP_ID_PLACEHOLDER) - 1;
-  content = content.substring(0, start) +  ChipIds() + content.substring(end);
-
-  // WiFi id
-  #define WIFI_SSID_PLACEHOLDER "<span id=\"wifi_ssid\">-</span>"
-  start = content.indexOf(WIFI_SSID_PLACEHOLDER);
-  if (start < 0)
-    return content;
-  end = start + sizeof(WIFI_SSID_PLACEHOLDER) - 1;
-  content = content.substring(0, start) + WiFi_ssid() + content.substring(end);
-
-  // IP address
-  #define WIFI_IP_ADDRESS_PLACEHOLDER "<span id=\"ip_address\">-</span>"
-  start = content.indexOf(WIFI_IP_ADDRESS_PLACEHOLDER);
-  if (start < 0)
-    return content;
-  end = start + sizeof(WIFI_IP_ADDRESS_PLACEHOLDER) - 1;
-  content = content.substring(0, start) + WiFi_ip() + content.substring(end);
-
-  // Title
-  start = content.indexOf("<title>") + sizeof("<title>") - 1;
-  if (start < 0)
-    return content;
-  end = content.indexOf("</title>");
-  content = content.substring(0, start) + String(ProgramTitle) + content.substring(end);
+  const String chip_id = ChipIds();
+  web_page_ssid = WiFi_ssid();
+  web_page_ip = WiFi_ip();
+
+  const PAGE_field_t fields[] = {
+      {"<span id=\"program_name\">", "</span>", ProgramName},
+      {"<span id=\"program_version\">", "</span>", ProgramVersion},
+      {"<span id=\"chip_id\">", "</span>", chip_id.c_str()},
+      {"<span id=\"wifi_ssid\">", "</span>", web_page_ssid.c_str()},
+      {"<span id=\"ip_address\">", "</span>", web_page_ip.c_str()},
+      {"<title>", "</title>", ProgramTitle},
+  };
+  const int num_fields = sizeof(fields) / sizeof(fields[0]);
+
+  const int length = PAGE_render(source.c_str(), (int)source.length(), fields, num_fields, nullptr, 0);
+  auto page = std::make_shared<std::vector<char>>(length + 1);
+  PAGE_render(source.c_str(), (int)source.length(), fields, num_fields, page->data(), (int)page->size());
+  page->pop_back();  // Terminator
+
+  PAGE_etag(PAGE_hash(PAGE_HASH_INIT, page->data(), (int)page->size()), web_page_etag);
+  web_page = page;  // Responses in flight keep the previous page
+
+  web_page_renders++;
+  web_page_render_us = micros() - start;
+  return ESP_OK;
+}
 
-  return content;
+/********************************************************************
+ * GET index page: the cached page, 304 when the client has it
+ *********************************************************************/
+static void WEBSERVER_on_page(AsyncWebServerRequest *request) {
+  const uint32_t start = micros();
+
+  web_page_requests++;
+  if (!web_page || (WiFi_ip() != web_page_ip) || (WiFi_ssid() != web_page_ssid)) {
+    if (WEBSERVER_render_page(LittleFS, DEFAULT_HTML_PAGE) != ESP_OK) {
+      request->send(500, "text/plain", "500-Internal Server Error");
+      return;
+    }
+  }
+
+  AsyncWebServerResponse *response;
+  const AsyncWebHeader *header = request->getHeader("If-None-Match");
+  if (header && PAGE_etag_match(header->value().c_str(), web_page_etag)) {
+    web_page_not_modified++;
+    response = request->beginResponse(304);
+  } else {
+    std::shared_ptr<std::vector<char>> page = web_page;
+    response = request->beginResponse("text/html", page->size(),
+                                      [page](uint8_t *buffer, size_t max_len, size_t index) -> size_t {
+                                        const size_t length = std::min(max_len, page->size() - index);
+                                        memcpy(buffer, page->data() + index, length);
+                                        return length;
+                                      });
+  }
+  response->addHeader("ETag", web_page_etag);
+  response->addHeader("Cache-Control", WEBSERVER_PAGE_CACHE);
+  request->send(response);
+
+  web_page_response_us = micros() - start;
+  if (web_page_response_us > web_page_response_max_us) {
+    web_page_response_max_us = web_page_response_us;
+  }
+}
+
+/********************************************************************
+ * Entity tag of a static asset, hashed once per file and kept. The
+ * size is checked, the file system image is replaced as a whole.
+ *********************************************************************/
+static bool WEBSERVER_asset_etag(File &file, const String &path, char etag[PAGE_ETAG_SIZE]) {
+  for (int i = 0; i < web_num_assets; i++) {
+    if ((web_assets[i].size == file.size()) && (path == web_assets[i].path)) {
+      strcpy(etag, web_assets[i].etag);
+      return true;
+    }
+  }
+
+  uint8_t chunk[WEBSERVER_ASSET_CHUNK];
+  uint32_t hash = PAGE_HASH_INIT;
+  size_t length;
+  while ((length = file.read(chunk, sizeof(chunk))) > 0) {
+    hash = PAGE_hash(hash, chunk, (int)length);
+  }
+  if (!file.seek(0)) {
+    return false;
+  }
+  PAGE_etag(hash, etag);
+
+  if ((web_num_assets < WEBSERVER_ASSET_MAX) && (path.length() < WEBSERVER_ASSET_PATH_SIZE)) {
+    WEBSERVER_asset_t *asset = &web_assets[web_num_assets++];
+    strcpy(asset->path, path.c_str());
+    asset->size = file.size();
+    strcpy(asset->etag, etag);
+  }
+  return true;
+}
+
+/********************************************************************
+ * GET static asset from the web folder, streamed from LittleFS. The
+ * pre-compressed .gz variant of the build is preferred.
+ *********************************************************************/
+static void WEBSERVER_on_asset(AsyncWebServerRequest *request) {
+  String path = WEBSERVER_ASSET_ROOT + request->url();
+  char etag[PAGE_ETAG_SIZE];
+
+  web_asset_requests++;
+  if (path.indexOf("..") >= 0) {
+    web_asset_not_found++;
+    request->send(404, "text/plain", "404-Not Found");
+    return;
+  }
+  if (path.endsWith("/")) {
+    path += WEBSERVER_ASSET_INDEX;
+  } else if (path.lastIndexOf('.') < path.lastIndexOf('/')) {
+    path += "/" WEBSERVER_ASSET_INDEX;  // Folder
+  }
+
+  const String gzip_path = path + ".gz";
+  const AsyncWebHeader *encoding = request->getHeader("Accept-Encoding");
+  const bool accepts_gzip = encoding && (encoding->value().indexOf("gzip") >= 0);
+  bool gzip = LittleFS.exists(gzip_path) && (accepts_gzip || !LittleFS.exists(path));
+
+  File file = LittleFS.open(gzip ? gzip_path : path, "r");
+  if (!file || file.isDirectory() || !WEBSERVER_asset_etag(file, gzip ? gzip_path : path, etag)) {
+    web_asset_not_found++;
+    request->send(404, "text/plain", "404-Not Found");
+    return;
+  }
+
+  AsyncWebServerResponse *response;
+  const AsyncWebHeader *header = request->getHeader("If-None-Match");
+  if (header && PAGE_etag_match(header->value().c_str(), etag)) {
+    file.close();
+    web_asset_not_modified++;
+    response = request->beginResponse(304);
+  } else {
+    web_asset_gzip += gzip ? 1 : 0;
+    response = request->beginResponse(file, path, PAGE_content_type(path.c_str()));  // Content-Encoding by the .gz name
+  }
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", WEBSERVER_ASSET_CACHE);
+  response->addHeader("Vary", "Accept-Encoding");
+  request->send(response);
 }
 
 /********************************************************************
@@ -505,31 +957,15 @@ static void WEBSERVER_init(void) {
   WebSerial.begin(&web_server);
   WebSerial.msgCallback(CLI_webserial_task);
 
-  web_server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-    String html = WEBSERVER_load_html(LittleFS, DEFAULT_HTML_PAGE);
-    request->send(200, "text/html", html);
-  });
+  WEBSERVER_render_page(LittleFS, DEFAULT_HTML_PAGE);
+  web_server.on("/", HTTP_GET, WEBSERVER_on_page);
 
-  web_server.on("/maintenance", HTTP_GET, [](AsyncWebServerRequest *request) {
-    String html = "/web" + request->url();
+  web_server.on(WEBSERVER_ASSET_URL, HTTP_GET, WEBSERVER_on_asset);
 
-    String filetype;
-    if (html.endsWith(".css")) {
-      filetype = "text/css";
-    } else if (html.endsWith(".js")) {
-      filetype = "text/javascript";
-    } else {
-      filetype = "text/html";
-    }
-
-    File file = LittleFS.open(html);
-    request->send(200, filetype, file.readStringUntil(EOF));
-  });
+  web_socket.onEvent(WEBSOCKET_event);
+  web_server.addHandler(&web_socket);
 
   web_server.begin();  // Start WebServer
-
-  web_socket_server.begin();
-  web_socket_server.onEvent(WebSocketsEvents);
 }
 
 /********************************************************************
@@ -547,12 +983,41 @@ static void clicb_list_web(cmd *c) {
   }
 
   if (strArg.equalsIgnoreCase("data")) {
-    serializeJson(WebSocket_JSON_data, strArg);
-    CLI_println(strArg);
+    char frame[256];
+    uint16_t cursor = 0;
+
+    WEBSOCKET_lock();
+    while (TELEM_frame(&websocket_cache, frame, sizeof(frame), true, &cursor) > 0) {
+      CLI_println(frame);
+    }
+    WEBSOCKET_unlock();
     return;
   }
 
-  CLI_println("Invalid command: WEB <data>.");
+  if (strArg.equalsIgnoreCase("reset")) {
+    WEBSOCKET_lock();
+    websocket_cache.changed = 0;
+    websocket_cache.unchanged = 0;
+    websocket_cache.rejected = 0;
+    TELEM_stats_init(&websocket_stats, WEBSOCKET_STATS_WINDOW_US, micros());
+    WEBSOCKET_unlock();
+    web_page_requests = 0;
+    web_page_not_modified = 0;
+    web_page_response_max_us = 0;
+    web_asset_requests = 0;
+    web_asset_gzip = 0;
+    web_asset_not_modified = 0;
+    web_asset_not_found = 0;
+    web_rest_reads = 0;
+    web_rest_bytes = 0;
+    web_rest_heap_peak = 0;
+    web_rest_arena.peak = 0;
+    web_rest_response_max_us = 0;
+    CLI_println("Web statistics cleared.");
+    return;
+  }
+
+  CLI_println("Invalid command: WEB <data, reset>.");
 }
 
 /********************************************************************
@@ -566,13 +1031,18 @@ void WEBSERVER_cli_handlers(void) {
  *  Initialize tasks
  *********************************************************************/
 static void WEBSERVER_setup_tasks(void) {
-  xTaskCreate(WEBSERVER_task, "WebServer task", 8192, NULL, 10, NULL);  // 8Kb stack
+  xTaskCreate(WEBSOCKET_task, "Websocket", 4096, NULL, 2, &websocket_task_handle);
 }
 
 /********************************************************************
  *  Setup webserver
  *********************************************************************/
 void WEBSERVER_setup(void) {
+  TELEM_stats_init(&websocket_stats, WEBSOCKET_STATS_WINDOW_US, micros());
+  if (!web_rest_lock) {
+    ARENA_init(&web_rest_arena, web_rest_buffer, sizeof(web_rest_buffer));
+    web_rest_lock = xSemaphoreCreateMutex();
+  }
   WEBSERVER_init();
 
   WEBSERVER_setup_tasks();
@@ -77,8 +77,8 @@ String WiFi_ip(void) {
 /********************************************************************
  * Create initial JSON data
  *******************************************************************/
-static JsonDocument WiFi_json(void) {
-  JsonDocument doc;
+static JsonDocument WiFi_json(ArduinoJson::Allocator *allocator = JSON_HEAP) {
+  JsonDocument doc(allocator);
 
   doc[JSON_WIFI_SSID] = WiFi_ssid();
   doc[JSON_WIFI_MAC] = WiFi_mac();
@@ -240,9 +240,7 @@ static void WiFi_init(void) {
  *********************************************************************/
 void WIFI_rest_read(AsyncWebServerRequest* request) {
 
-  String json;
-  serializeJson(WiFi_json(), json);
-  request->send(200, "application/json", json.c_str());
+  WEBSERVER_send_json(request, WiFi_json);
 }
 
 static rest_api_t WIFI_api_handlers = {
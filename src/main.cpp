@@ -7,11 +7,17 @@
 #include "Config.h"
 #include "Debug.h"
 #include "MCPCom.h"
+#include "CANCapture.h"
+#include "CANDiag.h"
+#include "CANHealth.h"
+#include "SLCANGateway.h"
 #include "Storage.h"
+#include "Calibration.h"
 #include "Controller.h"
 #include "CLI.h"
 #include "GPIO.h"
 #include "DMC.h"
+#include "Analog.h"
 #include "Azimuth.h"
 #include "lift.h"
 #include "Maintenance.h"
@@ -34,7 +40,7 @@ static void clicb_help(cmd *c) {
   CLI_println(F("[dmc] ~ DMC information."));
   CLI_println(F("[lift] ~ Retractable information (timeout n)."));
   CLI_println(F("[azimuth] ~ Azimuth information (left <n>, right <n>, middle <n>, timeout <n>)."));
-  CLI_println(F("[steer] ~ Steering wheel information (left <n>, right <n>, middle <n>, deadband <n>)."));
+  CLI_println(F("[steer] ~ Steering wheel information (left <n>, right <n>, middle <n>, deadband <n>, hysteresis <n>, median <n>, iir <n>, rate <n>)."));
 }
 
 /*******************************************************************
@@ -113,16 +119,22 @@ void all_stop(void) {
  *******************************************************************/
 static void MAIN_setup(void) {
   STORAGE_setup();
+  CALIBRATION_setup();
   CLI_setup();
   WiFi_setup();
   WEBSERVER_setup();
   GPIO_setup();
+  ANALOG_setup();
   AZIMUTH_setup();
   LIFT_setup();
   DMC_setup();
   STEERINGWHEEL_setup();
   CONTROLLER_setup();
   MAINTENANCE_setup();
+  CANCAP_setup();
+  CANHEALTH_setup();
+  SLCANGW_setup();
+  CANDIAG_setup();
 
   Serial.println(F("Main setup completed."));
 }
@@ -132,6 +144,7 @@ static void MAIN_setup(void) {
  *******************************************************************/
 static void MAIN_start(void) {
   GPIO_start();
+  ANALOG_start();
   AZIMUTH_start();
   LIFT_start();
   DMC_start();
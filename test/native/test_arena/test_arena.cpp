@@ -0,0 +1,116 @@
+/*******************************************************************
+ * test_arena.cpp
+ *
+ * Bump allocator of the REST responses (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define ARENA_SIZE 256
+
+static uint8_t buffer[ARENA_SIZE + ARENA_ALIGN];
+static ARENA_t arena;
+
+void setUp(void) {
+  ARENA_init(&arena, &buffer[1], ARENA_SIZE);  // Unaligned on purpose
+}
+
+void tearDown(void) {}
+
+/*******************************************************************
+ * TC Aligned blocks until full, reset frees all
+ *******************************************************************/
+void test_alloc(void) {
+  uint8_t *a = (uint8_t *)ARENA_alloc(&arena, 10);
+  uint8_t *b = (uint8_t *)ARENA_alloc(&arena, 1);
+
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_NOT_NULL(b);
+  TEST_ASSERT_EQUAL(0, (uintptr_t)a % ARENA_ALIGN);
+  TEST_ASSERT_EQUAL(0, (uintptr_t)b % ARENA_ALIGN);
+  TEST_ASSERT_TRUE(b >= a + 10);
+  TEST_ASSERT_TRUE(ARENA_owns(&arena, a));
+  TEST_ASSERT_FALSE(ARENA_owns(&arena, &arena));
+  TEST_ASSERT_EQUAL(10, ARENA_block_size(&arena, a));
+  TEST_ASSERT_EQUAL(2, arena.allocations);
+
+  memset(a, 0xAA, 10);
+  TEST_ASSERT_EQUAL(1, b[-ARENA_ALIGN]);  // Header of b intact
+
+  TEST_ASSERT_NULL(ARENA_alloc(&arena, ARENA_SIZE));
+  TEST_ASSERT_EQUAL(1, arena.full);
+
+  const uint32_t peak = arena.peak;
+  ARENA_reset(&arena);
+  TEST_ASSERT_EQUAL(0, arena.used);
+  TEST_ASSERT_EQUAL(peak, arena.peak);
+  TEST_ASSERT_TRUE(ARENA_alloc(&arena, 10) == a);
+}
+
+/*******************************************************************
+ * TC The last block grows and frees in place, others move
+ *******************************************************************/
+void test_realloc(void) {
+  char *a = (char *)ARENA_alloc(&arena, 8);
+  strcpy(a, "abcdefg");
+
+  TEST_ASSERT_TRUE(ARENA_realloc(&arena, a, 64) == a);  // Last, in place
+  TEST_ASSERT_EQUAL(64, ARENA_block_size(&arena, a));
+  TEST_ASSERT_TRUE(ARENA_realloc(&arena, a, 16) == a);
+  const uint32_t used = arena.used;
+
+  char *b = (char *)ARENA_alloc(&arena, 8);
+  TEST_ASSERT_TRUE(ARENA_realloc(&arena, a, 8) == a);  // Shrinks in place
+  char *moved = (char *)ARENA_realloc(&arena, a, 32);
+  TEST_ASSERT_NOT_NULL(moved);
+  TEST_ASSERT_TRUE(moved > b);
+  TEST_ASSERT_EQUAL_STRING("abcdefg", moved);
+
+  /* Does not fit, left as it was */
+  TEST_ASSERT_NULL(ARENA_realloc(&arena, moved, ARENA_SIZE));
+  TEST_ASSERT_EQUAL(32, ARENA_block_size(&arena, moved));
+  TEST_ASSERT_NULL(ARENA_realloc(&arena, b, ARENA_SIZE));
+  TEST_ASSERT_EQUAL(2, arena.full);
+
+  /* Only the last block returns its space */
+  const uint32_t before = arena.used;
+  ARENA_free(&arena, b);
+  TEST_ASSERT_EQUAL(before, arena.used);
+  ARENA_free(&arena, moved);
+  TEST_ASSERT_TRUE(arena.used < before);
+  TEST_ASSERT_TRUE(arena.used > used);
+
+  TEST_ASSERT_NOT_NULL(ARENA_realloc(&arena, nullptr, 4));
+}
+
+/*******************************************************************
+ * TC Many small blocks, as a document pool and its strings
+ *******************************************************************/
+void test_fill(void) {
+  int blocks = 0;
+
+  while (ARENA_alloc(&arena, 12)) {
+    blocks++;
+  }
+  TEST_ASSERT_EQUAL(ARENA_SIZE / (ARENA_ALIGN + 16), blocks);
+  TEST_ASSERT_TRUE(arena.used <= ARENA_SIZE);
+  TEST_ASSERT_EQUAL(arena.used, arena.peak);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_alloc);
+  RUN_TEST(test_realloc);
+  RUN_TEST(test_fill);
+  return UNITY_END();
+}
@@ -0,0 +1,245 @@
+/*******************************************************************
+ * test_canfilter.cpp
+ *
+ * CAN acceptance filter compiler, checked against a model of the
+ * TWAI and MCP2515 acceptance logic (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define RANDOM_SETS 2000
+#define RANDOM_FRAMES 64
+
+typedef struct {
+  uint32_t id;
+  bool ext;
+  bool rtr;
+  uint8_t d0;
+  uint8_t d1;
+} frame_t;
+
+static uint32_t lcg_state;
+
+static uint32_t lcg_next(void) {
+  lcg_state = lcg_state * 1664525u + 1013904223u;
+  return lcg_state;
+}
+
+static CANFILTER_rule_t std_rule(uint32_t id, uint32_t mask = DISPATCH_MASK_STD) {
+  return {id, mask};
+}
+
+static CANFILTER_rule_t ext_rule(uint32_t id, uint32_t mask = DISPATCH_MASK_EXT) {
+  return {(uint32_t)DISPATCH_ID_EXT | id, mask};
+}
+
+static frame_t std_frame(uint32_t id, uint8_t d0 = 0x5A, uint8_t d1 = 0xA5) {
+  return {id, false, false, d0, d1};
+}
+
+static frame_t ext_frame(uint32_t id) {
+  return {id, true, false, 0, 0};
+}
+
+/*******************************************************************
+ * TWAI acceptance (ESP32 technical reference, acceptance filter)
+ *******************************************************************/
+static bool twai_accepts(const CANFILTER_twai_t *twai, const frame_t &f) {
+  const uint32_t care = ~twai->mask;
+
+  if (twai->mode == CANFILTER_TWAI_SINGLE) {
+    uint32_t image = f.ext ? ((f.id << 3) | (f.rtr << 2))
+                           : ((f.id << 21) | (f.rtr << 20) | (f.d0 << 8) | f.d1);
+    uint32_t bits = f.ext ? 0xFFFFFFFCUL : 0xFFF0FFFFUL;
+    return ((image ^ twai->code) & care & bits) == 0;
+  }
+
+  if (f.ext) {
+    uint32_t image = ((f.id >> 13) << 16) | (f.id >> 13);
+    return (((image ^ twai->code) & care & 0xFFFF0000UL) == 0) ||
+           (((image ^ twai->code) & care & 0x0000FFFFUL) == 0);
+  }
+
+  uint32_t image1 = (f.id << 21) | (f.rtr << 20) | ((f.d0 >> 4) << 16) | (f.d0 & 0x0F);
+  uint32_t image2 = (f.id << 5) | (f.rtr << 4);
+  return (((image1 ^ twai->code) & care & 0xFFFF000FUL) == 0) ||
+         (((image2 ^ twai->code) & care & 0x0000FFF0UL) == 0);
+}
+
+/*******************************************************************
+ * MCP2515 acceptance (datasheet, section 4.5)
+ *******************************************************************/
+static bool mcp_accepts(const CANFILTER_mcp_t *mcp, const frame_t &f) {
+  const uint32_t image = f.ext ? f.id : ((f.id << 18) | (f.d0 << 8) | f.d1);
+
+  for (int n = 0; n < CANFILTER_MCP_FILTERS; n++) {
+    const uint32_t mask = mcp->mask[(n < 2) ? 0 : 1];
+
+    if ((mcp->ext[n] != 0) != f.ext) {
+      continue;
+    }
+    if (((image ^ mcp->filter[n]) & mask) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC No rules, everything passes
+ *******************************************************************/
+void test_accept_all(void) {
+  CANFILTER_twai_t twai;
+  CANFILTER_mcp_t mcp;
+
+  CANFILTER_twai(nullptr, 0, &twai);
+  CANFILTER_mcp2515(nullptr, 0, &mcp);
+
+  TEST_ASSERT_EQUAL(CANFILTER_ACCEPT_ALL, twai.accept_ppm);
+  TEST_ASSERT_EQUAL(CANFILTER_ACCEPT_ALL, mcp.accept_ppm);
+  TEST_ASSERT_TRUE(twai_accepts(&twai, std_frame(0x123)));
+  TEST_ASSERT_TRUE(twai_accepts(&twai, ext_frame(0x18EF1234)));
+  TEST_ASSERT_TRUE(mcp_accepts(&mcp, std_frame(0x123)));
+  TEST_ASSERT_TRUE(mcp_accepts(&mcp, ext_frame(0x18EF1234)));
+}
+
+/*******************************************************************
+ * TC One or two standard identifiers are filtered exactly
+ *******************************************************************/
+void test_exact_std(void) {
+  CANFILTER_rule_t rules[] = {std_rule(0x123), std_rule(0x456)};
+  CANFILTER_twai_t twai;
+  CANFILTER_mcp_t mcp;
+
+  CANFILTER_twai(rules, 1, &twai);
+  TEST_ASSERT_TRUE(twai_accepts(&twai, std_frame(0x123)));
+  TEST_ASSERT_FALSE(twai_accepts(&twai, std_frame(0x124)));
+
+  CANFILTER_twai(rules, 2, &twai);
+  TEST_ASSERT_EQUAL(CANFILTER_TWAI_DUAL, twai.mode);
+  for (uint32_t id = 0; id <= DISPATCH_MASK_STD; id++) {
+    TEST_ASSERT_EQUAL((id == 0x123) || (id == 0x456), twai_accepts(&twai, std_frame(id, (uint8_t)id)));
+  }
+
+  CANFILTER_mcp2515(rules, 2, &mcp);
+  for (uint32_t id = 0; id <= DISPATCH_MASK_STD; id++) {
+    TEST_ASSERT_EQUAL((id == 0x123) || (id == 0x456), mcp_accepts(&mcp, std_frame(id, (uint8_t)id)));
+  }
+  TEST_ASSERT_FALSE(mcp_accepts(&mcp, ext_frame(0x123)));
+}
+
+/*******************************************************************
+ * TC Six identifiers fit the MCP2515 filters exactly
+ *******************************************************************/
+void test_mcp_six(void) {
+  CANFILTER_rule_t rules[] = {std_rule(0x100), std_rule(0x2F0), std_rule(0x301),
+                              std_rule(0x7FF), ext_rule(0x18EF1234), ext_rule(0x0CF00400)};
+  CANFILTER_mcp_t mcp;
+
+  CANFILTER_mcp2515(rules, 6, &mcp);
+
+  for (uint32_t id = 0; id <= DISPATCH_MASK_STD; id++) {
+    bool expected = (id == 0x100) || (id == 0x2F0) || (id == 0x301) || (id == 0x7FF);
+    TEST_ASSERT_EQUAL(expected, mcp_accepts(&mcp, std_frame(id)));
+  }
+  TEST_ASSERT_TRUE(mcp_accepts(&mcp, ext_frame(0x18EF1234)));
+  TEST_ASSERT_TRUE(mcp_accepts(&mcp, ext_frame(0x0CF00400)));
+  TEST_ASSERT_FALSE(mcp_accepts(&mcp, ext_frame(0x18EF1235)));
+}
+
+/*******************************************************************
+ * TC Ranges, a PGN mask narrows the extended identifiers
+ *******************************************************************/
+void test_ranges(void) {
+  CANFILTER_rule_t rules[] = {ext_rule(0x00EF0000, 0x00FF0000), std_rule(0x700, 0x700)};
+  CANFILTER_twai_t twai;
+  CANFILTER_mcp_t mcp;
+
+  CANFILTER_twai(rules, 2, &twai);
+  CANFILTER_mcp2515(rules, 2, &mcp);
+
+  TEST_ASSERT_TRUE(twai_accepts(&twai, ext_frame(0x18EF1234)));
+  TEST_ASSERT_TRUE(twai_accepts(&twai, std_frame(0x7AB)));
+  TEST_ASSERT_FALSE(twai_accepts(&twai, std_frame(0x3AB)));
+
+  TEST_ASSERT_TRUE(mcp_accepts(&mcp, ext_frame(0x18EF1234)));
+  TEST_ASSERT_FALSE(mcp_accepts(&mcp, ext_frame(0x18EE1234)));
+  TEST_ASSERT_TRUE(mcp_accepts(&mcp, std_frame(0x7AB)));
+  TEST_ASSERT_FALSE(mcp_accepts(&mcp, std_frame(0x3AB)));
+}
+
+/*******************************************************************
+ * TC Random rule sets, a matching frame is never rejected
+ *******************************************************************/
+void test_never_reject(void) {
+  CANFILTER_rule_t rules[DISPATCH_MAX_SUBSCRIPTIONS];
+  CANFILTER_twai_t twai;
+  CANFILTER_mcp_t mcp;
+  uint64_t twai_ppm = 0, mcp_ppm = 0;
+  char text[128];
+
+  lcg_state = 7;
+
+  for (int set = 0; set < RANDOM_SETS; set++) {
+    int num = 1 + (int)(lcg_next() % DISPATCH_MAX_SUBSCRIPTIONS);
+
+    for (int i = 0; i < num; i++) {
+      bool ext = (lcg_next() & 3) == 0;
+      uint32_t all = ext ? DISPATCH_MASK_EXT : DISPATCH_MASK_STD;
+      uint32_t mask = (lcg_next() & 1) ? all : (lcg_next() & all & ~(lcg_next() & lcg_next()));
+
+      rules[i].id = (lcg_next() & all) | (ext ? DISPATCH_ID_EXT : 0);
+      rules[i].mask = mask;
+    }
+
+    CANFILTER_twai(rules, num, &twai);
+    CANFILTER_mcp2515(rules, num, &mcp);
+    twai_ppm += twai.accept_ppm;
+    mcp_ppm += mcp.accept_ppm;
+
+    for (int n = 0; n < RANDOM_FRAMES; n++) {
+      const CANFILTER_rule_t &rule = rules[lcg_next() % num];
+      const bool ext = (rule.id & DISPATCH_ID_EXT) != 0;
+      const uint32_t all = ext ? DISPATCH_MASK_EXT : DISPATCH_MASK_STD;
+      frame_t f;
+
+      f.id = ((rule.id & rule.mask) | (lcg_next() & ~rule.mask)) & all;
+      f.ext = ext;
+      f.rtr = lcg_next() & 1;
+      f.d0 = (uint8_t)lcg_next();
+      f.d1 = (uint8_t)lcg_next();
+
+      TEST_ASSERT_TRUE(twai_accepts(&twai, f));
+      TEST_ASSERT_TRUE(mcp_accepts(&mcp, f));
+    }
+  }
+
+  snprintf(text, sizeof(text), "%d random sets, average acceptance TWAI %.2f%%, MCP2515 %.2f%%", RANDOM_SETS,
+           twai_ppm / (double)RANDOM_SETS / 10000.0, mcp_ppm / (double)RANDOM_SETS / 10000.0);
+  TEST_MESSAGE(text);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_accept_all);
+  RUN_TEST(test_exact_std);
+  RUN_TEST(test_mcp_six);
+  RUN_TEST(test_ranges);
+  RUN_TEST(test_never_reject);
+  return UNITY_END();
+}
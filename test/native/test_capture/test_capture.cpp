@@ -0,0 +1,232 @@
+/*******************************************************************
+ * test_capture.cpp
+ *
+ * CAN capture records, candump text, double buffer and replay
+ * pacing (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+static CAPTURE_buffer_t buffer;
+
+static CAN_frame_t frame(uint32_t id, bool ext, uint8_t length) {
+  CAN_frame_t f = {};
+  f.id = id;
+  f.ext = ext;
+  f.length = length;
+  f.channel = 1;
+  for (int i = 0; i < 8; i++)
+    f.data[i] = (uint8_t)(0x11 * (i + 1));
+  return f;
+}
+
+static CAPTURE_record_t record(uint32_t n) {
+  CAPTURE_record_t r = {};
+  r.time_us = n;
+  return r;
+}
+
+void setUp(void) {
+  CAPTURE_buffer_init(&buffer);
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Frame to record and back, flags
+ *******************************************************************/
+void test_record(void) {
+  CAN_frame_t in = frame(0x18EF1234, true, 5);
+  CAN_frame_t out;
+  CAPTURE_record_t r;
+  CAPTURE_header_t header;
+  bool tx;
+
+  TEST_ASSERT_EQUAL(20, sizeof(CAPTURE_record_t));
+  TEST_ASSERT_EQUAL(16, sizeof(CAPTURE_header_t));
+
+  CAPTURE_header_init(&header, 5000000);
+  TEST_ASSERT_TRUE(CAPTURE_header_valid(&header));
+  header.record_size = 16;
+  TEST_ASSERT_FALSE(CAPTURE_header_valid(&header));
+
+  CAPTURE_encode(&in, true, 0x100000005ULL, &r);
+  TEST_ASSERT_EQUAL_HEX32(0x18EF1234 | CAPTURE_ID_EXT | CAPTURE_ID_TX, r.id);
+  TEST_ASSERT_EQUAL(5, r.time_us);
+
+  CAPTURE_decode(&r, &out, &tx);
+  TEST_ASSERT_TRUE(tx);
+  TEST_ASSERT_EQUAL_HEX32(0x18EF1234, out.id);
+  TEST_ASSERT_EQUAL(1, out.ext);
+  TEST_ASSERT_EQUAL(0, out.rtr);
+  TEST_ASSERT_EQUAL(5, out.length);
+  TEST_ASSERT_EQUAL(1, out.channel);
+  TEST_ASSERT_EQUAL_MEMORY(in.data, out.data, 8);
+
+  in = frame(0x7FF, false, 0);
+  in.rtr = 1;
+  CAPTURE_encode(&in, false, 0, &r);
+  CAPTURE_decode(&r, &out, &tx);
+  TEST_ASSERT_FALSE(tx);
+  TEST_ASSERT_EQUAL_HEX32(0x7FF, out.id);
+  TEST_ASSERT_EQUAL(1, out.rtr);
+}
+
+/*******************************************************************
+ * TC Clock unwrap across the 32 bit boundary, small reorder
+ *******************************************************************/
+void test_time(void) {
+  CAPTURE_record_t r = record(0);
+  uint64_t t = 0xFFFFFF00ULL + (5ULL << 32);
+
+  r.time_us = 0x00000010;  // Wrapped
+  t = CAPTURE_time(t, &r);
+  TEST_ASSERT_TRUE(t == (6ULL << 32) + 0x10);
+
+  r.time_us = 0x00000008;  // Buffered before the header base
+  TEST_ASSERT_TRUE(CAPTURE_time(t, &r) == (6ULL << 32) + 0x08);
+
+  r.time_us = 0x7FFFFFFF;  // Longest forward gap
+  TEST_ASSERT_TRUE(CAPTURE_time(t, &r) == (6ULL << 32) + 0x7FFFFFFFULL);
+}
+
+/*******************************************************************
+ * TC candump log lines
+ *******************************************************************/
+void test_candump(void) {
+  CAN_frame_t f = frame(0x123, false, 3);
+  CAPTURE_record_t r;
+  char line[CAPTURE_CANDUMP_MAX];
+
+  f.channel = 0;
+  CAPTURE_encode(&f, false, 0, &r);
+  TEST_ASSERT_EQUAL(36, CAPTURE_candump(&r, 1718000000123456ULL, line, sizeof(line)));
+  TEST_ASSERT_EQUAL_STRING("(1718000000.123456) can0 123#112233\n", line);
+
+  f = frame(0x18EF1234, true, 8);
+  CAPTURE_encode(&f, true, 0, &r);
+  CAPTURE_candump(&r, 1000001, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("(1.000001) can1 18EF1234#1122334455667788\n", line);
+
+  f = frame(0x001, false, 0);
+  f.rtr = 1;
+  CAPTURE_encode(&f, false, 0, &r);
+  CAPTURE_candump(&r, 0, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("(0.000000) can1 001#R\n", line);
+
+  f = frame(0x1FFFFFFF, true, 8);
+  CAPTURE_encode(&f, false, 0, &r);
+  TEST_ASSERT_TRUE(CAPTURE_candump(&r, UINT64_MAX / 2, line, sizeof(line)) < CAPTURE_CANDUMP_MAX);
+}
+
+/*******************************************************************
+ * TC Double buffer, halves alternate, oldest first, drops counted
+ *******************************************************************/
+void test_double_buffer(void) {
+  CAPTURE_record_t r;
+  uint16_t count;
+  int half;
+
+  TEST_ASSERT_EQUAL(-1, CAPTURE_buffer_take(&buffer, &count));
+  TEST_ASSERT_FALSE(CAPTURE_buffer_flush(&buffer));
+
+  /* Fill both halves, the writer is slow */
+  for (uint32_t i = 0; i < 2 * CAPTURE_BUFFER_RECORDS; i++) {
+    r = record(i);
+    TEST_ASSERT_TRUE(CAPTURE_buffer_put(&buffer, &r));
+  }
+  r = record(9999);
+  TEST_ASSERT_FALSE(CAPTURE_buffer_put(&buffer, &r));
+  TEST_ASSERT_EQUAL(1, buffer.dropped);
+
+  half = CAPTURE_buffer_take(&buffer, &count);
+  TEST_ASSERT_EQUAL(CAPTURE_BUFFER_RECORDS, count);
+  TEST_ASSERT_EQUAL(0, buffer.record[half][0].time_us);
+  CAPTURE_buffer_release(&buffer, half);
+
+  /* Released half takes new records, the other one is older */
+  r = record(1000);
+  TEST_ASSERT_TRUE(CAPTURE_buffer_put(&buffer, &r));
+  half = CAPTURE_buffer_take(&buffer, &count);
+  TEST_ASSERT_EQUAL(CAPTURE_BUFFER_RECORDS, buffer.record[half][0].time_us);
+  CAPTURE_buffer_release(&buffer, half);
+  TEST_ASSERT_EQUAL(-1, CAPTURE_buffer_take(&buffer, &count));
+
+  /* Partly filled half on a flush */
+  TEST_ASSERT_TRUE(CAPTURE_buffer_flush(&buffer));
+  half = CAPTURE_buffer_take(&buffer, &count);
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_EQUAL(1000, buffer.record[half][0].time_us);
+  CAPTURE_buffer_release(&buffer, half);
+  TEST_ASSERT_FALSE(CAPTURE_buffer_flush(&buffer));
+
+  TEST_ASSERT_EQUAL(2 * CAPTURE_BUFFER_RECORDS + 1, buffer.records);
+}
+
+/*******************************************************************
+ * TC Interleaved writer keeps every record in order
+ *******************************************************************/
+void test_stream(void) {
+  uint32_t expected = 0;
+  uint16_t count;
+  int half;
+
+  for (uint32_t i = 0; i < 10000; i++) {
+    CAPTURE_record_t r = record(i);
+    TEST_ASSERT_TRUE(CAPTURE_buffer_put(&buffer, &r));
+
+    if ((i % 97) == 0)
+      CAPTURE_buffer_flush(&buffer);
+
+    if ((i % 61) == 0) {
+      while ((half = CAPTURE_buffer_take(&buffer, &count)) >= 0) {
+        for (uint16_t n = 0; n < count; n++)
+          TEST_ASSERT_EQUAL(expected++, buffer.record[half][n].time_us);
+        CAPTURE_buffer_release(&buffer, half);
+      }
+    }
+  }
+
+  CAPTURE_buffer_flush(&buffer);
+  while ((half = CAPTURE_buffer_take(&buffer, &count)) >= 0) {
+    for (uint16_t n = 0; n < count; n++)
+      TEST_ASSERT_EQUAL(expected++, buffer.record[half][n].time_us);
+    CAPTURE_buffer_release(&buffer, half);
+  }
+
+  TEST_ASSERT_EQUAL(10000, expected);
+  TEST_ASSERT_EQUAL(0, buffer.dropped);
+}
+
+/*******************************************************************
+ * TC Replay pacing
+ *******************************************************************/
+void test_replay(void) {
+  TEST_ASSERT_TRUE(CAPTURE_replay_offset(1000, 3000, 100) == 2000);
+  TEST_ASSERT_TRUE(CAPTURE_replay_offset(1000, 3000, 400) == 500);
+  TEST_ASSERT_TRUE(CAPTURE_replay_offset(1000, 3000, 50) == 4000);
+  TEST_ASSERT_TRUE(CAPTURE_replay_offset(1000, 3000, 0) == 0);
+  TEST_ASSERT_TRUE(CAPTURE_replay_offset(3000, 1000, 100) == 0);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_record);
+  RUN_TEST(test_time);
+  RUN_TEST(test_candump);
+  RUN_TEST(test_double_buffer);
+  RUN_TEST(test_stream);
+  RUN_TEST(test_replay);
+  return UNITY_END();
+}
@@ -0,0 +1,316 @@
+/*******************************************************************
+ * test_dispatch.cpp
+ *
+ * CAN frame dispatch, matching and delivery order of subscriptions,
+ * handler statistics and lookup cost (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+#include <vector>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define BENCHMARK_FRAMES 1000000
+#define BUDGET_FRAME_NS 200.0  // Host lookup cost, full table
+
+static DISPATCH_table_t table;
+static std::vector<int> calls;  // Subscription tags in call order
+
+static void record(const CAN_frame_t *frame, void *context) {
+  (void)frame;
+  calls.push_back((int)(intptr_t)context);
+}
+
+static void sink(const CAN_frame_t *frame, void *context) {
+  (void)frame;
+  (void)context;
+}
+
+static CAN_frame_t frame(uint32_t id, bool ext = false) {
+  CAN_frame_t f = {};
+  f.id = id;
+  f.ext = ext ? 1 : 0;
+  f.length = 8;
+  return f;
+}
+
+static int subscribe(uint32_t id, uint32_t mask, int tag) {
+  return DISPATCH_subscribe(&table, "test", id, mask, record, (void *)(intptr_t)tag, 0);
+}
+
+static int dispatch(uint32_t id, bool ext = false) {
+  CAN_frame_t f = frame(id, ext);
+  calls.clear();
+  return DISPATCH_frame(&table, &f);
+}
+
+/*******************************************************************
+ * Fake clock, every reading advances by the next step
+ *******************************************************************/
+static uint32_t clock_now;
+static uint32_t clock_step;
+
+static uint32_t fake_clock(void) {
+  clock_now += clock_step;
+  return clock_now;
+}
+
+void setUp(void) {
+  DISPATCH_init(&table, nullptr);
+  calls.clear();
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Exact identifiers, any subscription order
+ *******************************************************************/
+void test_exact_match(void) {
+  static const uint32_t ids[] = {0x300, 0x100, 0x7FF, 0x000, 0x200, 0x101};
+
+  for (int i = 0; i < 6; i++)
+    TEST_ASSERT_EQUAL(i, subscribe(ids[i], DISPATCH_MASK_STD, i));
+
+  for (int i = 0; i < 6; i++) {
+    TEST_ASSERT_EQUAL(1, dispatch(ids[i]));
+    TEST_ASSERT_EQUAL(i, calls[0]);
+  }
+
+  TEST_ASSERT_EQUAL(0, dispatch(0x102));
+  TEST_ASSERT_EQUAL(0, dispatch(0x0FF));
+  TEST_ASSERT_EQUAL(8, table.frames);
+  TEST_ASSERT_EQUAL(2, table.unmatched);
+}
+
+/*******************************************************************
+ * TC Masked ranges, and several subscribers to one frame
+ *******************************************************************/
+void test_mask_and_order(void) {
+  subscribe(0x100, 0x700, 1);               // 0x100 ... 0x1FF
+  subscribe(0x120, DISPATCH_MASK_STD, 2);
+  subscribe(0x000, 0x000, 3);               // Everything (standard)
+  subscribe(0x120, DISPATCH_MASK_STD, 4);
+
+  TEST_ASSERT_EQUAL(4, dispatch(0x120));
+  TEST_ASSERT_EQUAL(2, calls[0]);  // Exact first, in subscription order
+  TEST_ASSERT_EQUAL(4, calls[1]);
+  TEST_ASSERT_EQUAL(1, calls[2]);
+  TEST_ASSERT_EQUAL(3, calls[3]);
+
+  TEST_ASSERT_EQUAL(2, dispatch(0x1AB));
+  TEST_ASSERT_EQUAL(1, calls[0]);
+  TEST_ASSERT_EQUAL(3, calls[1]);
+
+  TEST_ASSERT_EQUAL(1, dispatch(0x2AB));
+  TEST_ASSERT_EQUAL(3, calls[0]);
+
+  TEST_ASSERT_EQUAL(2, table.sub[0].frames);
+  TEST_ASSERT_EQUAL(1, table.sub[1].frames);
+  TEST_ASSERT_EQUAL(3, table.sub[2].frames);
+}
+
+/*******************************************************************
+ * TC Match and deliver in two steps, as DISPATCH_frame
+ *******************************************************************/
+void test_match_deliver(void) {
+  DISPATCH_call_t collected[DISPATCH_MAX_SUBSCRIPTIONS];
+
+  subscribe(0x100, 0x700, 1);
+  subscribe(0x120, DISPATCH_MASK_STD, 2);
+
+  CAN_frame_t f = frame(0x120);
+  TEST_ASSERT_EQUAL(2, DISPATCH_match(&table, &f, collected));
+  TEST_ASSERT_EQUAL(1, collected[0].index);
+  TEST_ASSERT_EQUAL(2, (int)(intptr_t)collected[0].context);
+  TEST_ASSERT_EQUAL(0, collected[1].index);
+  TEST_ASSERT_EQUAL(0, table.sub[0].frames);  // Nothing called yet
+  TEST_ASSERT_EQUAL(0, (int)calls.size());
+
+  DISPATCH_deliver(&table, collected, 2, &f);
+  TEST_ASSERT_EQUAL(2, (int)calls.size());
+  TEST_ASSERT_EQUAL(2, calls[0]);
+  TEST_ASSERT_EQUAL(1, calls[1]);
+  TEST_ASSERT_EQUAL(1, table.sub[0].frames);
+  TEST_ASSERT_EQUAL(1, table.sub[1].frames);
+
+  f = frame(0x300);
+  TEST_ASSERT_EQUAL(0, DISPATCH_match(&table, &f, collected));
+  TEST_ASSERT_EQUAL(2, table.frames);
+  TEST_ASSERT_EQUAL(1, table.unmatched);
+}
+
+/*******************************************************************
+ * TC Disabled subscriptions match nothing
+ *******************************************************************/
+void test_enable(void) {
+  const int all = subscribe(0x000, 0x000, 1);
+  subscribe(0x120, DISPATCH_MASK_STD, 2);
+  const int exact = subscribe(0x120, DISPATCH_MASK_STD, 3);
+
+  TEST_ASSERT_EQUAL(0, DISPATCH_enable(&table, all, false));
+  TEST_ASSERT_EQUAL(0, DISPATCH_enable(&table, exact, false));
+  TEST_ASSERT_EQUAL(1, dispatch(0x120));
+  TEST_ASSERT_EQUAL(2, calls[0]);
+  TEST_ASSERT_EQUAL(0, dispatch(0x121));
+  TEST_ASSERT_EQUAL(1, table.unmatched);
+
+  TEST_ASSERT_EQUAL(0, DISPATCH_enable(&table, all, true));
+  TEST_ASSERT_EQUAL(2, dispatch(0x120));
+  TEST_ASSERT_EQUAL(2, calls[0]);
+  TEST_ASSERT_EQUAL(1, calls[1]);
+
+  TEST_ASSERT_EQUAL(-1, DISPATCH_enable(&table, 3, true));
+  TEST_ASSERT_EQUAL(-1, DISPATCH_enable(&table, -1, true));
+}
+
+/*******************************************************************
+ * TC Standard and extended identifiers never match each other
+ *******************************************************************/
+void test_extended(void) {
+  subscribe(0x123, DISPATCH_MASK_STD, 1);
+  subscribe(DISPATCH_ID_EXT | 0x123, DISPATCH_MASK_EXT, 2);
+  subscribe(DISPATCH_ID_EXT | 0x18EF0000, 0x1FFF0000, 3);  // PGN range
+  subscribe(0x000, 0x000, 4);                               // All standard
+
+  TEST_ASSERT_EQUAL(2, dispatch(0x123));
+  TEST_ASSERT_EQUAL(1, calls[0]);
+  TEST_ASSERT_EQUAL(4, calls[1]);
+
+  TEST_ASSERT_EQUAL(1, dispatch(0x123, true));
+  TEST_ASSERT_EQUAL(2, calls[0]);
+
+  TEST_ASSERT_EQUAL(1, dispatch(0x18EF1234, true));
+  TEST_ASSERT_EQUAL(3, calls[0]);
+
+  TEST_ASSERT_EQUAL(0, dispatch(0x18EE1234, true));
+}
+
+/*******************************************************************
+ * TC Table full and invalid subscriptions
+ *******************************************************************/
+void test_table_full(void) {
+  TEST_ASSERT_EQUAL(-1, DISPATCH_subscribe(&table, "none", 0x100, DISPATCH_MASK_STD, nullptr, nullptr, 0));
+
+  for (int i = 0; i < DISPATCH_MAX_SUBSCRIPTIONS; i++)
+    TEST_ASSERT_EQUAL(i, subscribe(DISPATCH_MAX_SUBSCRIPTIONS - i, DISPATCH_MASK_STD, i));
+
+  TEST_ASSERT_EQUAL(-1, subscribe(0x100, DISPATCH_MASK_STD, 99));
+
+  for (int i = 0; i < DISPATCH_MAX_SUBSCRIPTIONS; i++) {
+    TEST_ASSERT_EQUAL(1, dispatch(DISPATCH_MAX_SUBSCRIPTIONS - i));
+    TEST_ASSERT_EQUAL(i, calls[0]);
+  }
+}
+
+/*******************************************************************
+ * TC Handler time and budget with a clock
+ *******************************************************************/
+void test_handler_cost(void) {
+  DISPATCH_init(&table, fake_clock);
+  DISPATCH_subscribe(&table, "fast", 0x100, DISPATCH_MASK_STD, sink, nullptr, 20);
+  DISPATCH_subscribe(&table, "slow", 0x100, DISPATCH_MASK_STD, sink, nullptr, 5);
+
+  clock_now = 0;
+  clock_step = 10;
+  for (int i = 0; i < 4; i++)
+    dispatch(0x100);
+
+  TEST_ASSERT_EQUAL(4, table.sub[0].frames);
+  TEST_ASSERT_EQUAL(10, table.sub[0].cost_last);
+  TEST_ASSERT_EQUAL(10, table.sub[0].cost_max);
+  TEST_ASSERT_EQUAL(40, (int)table.sub[0].cost_total);
+  TEST_ASSERT_EQUAL(0, table.sub[0].over_budget);
+  TEST_ASSERT_EQUAL(4, table.sub[1].over_budget);
+
+  DISPATCH_reset_stats(&table);
+  TEST_ASSERT_EQUAL(0, table.frames);
+  TEST_ASSERT_EQUAL(0, table.sub[1].frames);
+  TEST_ASSERT_EQUAL(0, table.sub[1].cost_max);
+  TEST_ASSERT_EQUAL(0, table.sub[1].over_budget);
+
+  TEST_ASSERT_EQUAL(2, dispatch(0x100));  // Subscriptions are kept
+}
+
+/*******************************************************************
+ * TC Inter-arrival histogram with a clock
+ *******************************************************************/
+void test_interval(void) {
+  const DISPATCH_interval_t *interval = &table.sub[0].interval;
+
+  DISPATCH_init(&table, fake_clock);
+  DISPATCH_subscribe(&table, "cyclic", 0x100, DISPATCH_MASK_STD, sink, nullptr, 0);
+
+  clock_now = 0;
+  clock_step = 1000;  // Two readings per frame, frames 2000 apart
+  for (int i = 0; i < 10; i++)
+    dispatch(0x100);
+
+  clock_step = 300000;  // One late frame, 301000 after the last one
+  dispatch(0x100);
+
+  TEST_ASSERT_EQUAL(9, interval->bucket[1]);
+  TEST_ASSERT_EQUAL(1, interval->bucket[9]);
+  TEST_ASSERT_EQUAL(2000, interval->min);
+  TEST_ASSERT_EQUAL(301000, interval->max);
+  TEST_ASSERT_EQUAL(2048, DISPATCH_interval_percentile(interval, 90));
+  TEST_ASSERT_EQUAL(1UL << 19, DISPATCH_interval_percentile(interval, 100));
+
+  TEST_ASSERT_EQUAL(0, DISPATCH_interval_bucket(1023));
+  TEST_ASSERT_EQUAL(1, DISPATCH_interval_bucket(1024));
+  TEST_ASSERT_EQUAL(DISPATCH_INTERVAL_BUCKETS - 1, DISPATCH_interval_bucket(UINT32_MAX));
+  TEST_ASSERT_EQUAL(UINT32_MAX, DISPATCH_interval_bound(DISPATCH_INTERVAL_BUCKETS - 1));
+
+  DISPATCH_reset_stats(&table);
+  TEST_ASSERT_EQUAL(0, DISPATCH_interval_percentile(interval, 50));
+}
+
+/*******************************************************************
+ * TC Lookup cost per frame on the host, full table
+ *******************************************************************/
+void test_benchmark(void) {
+  char text[128];
+  volatile int total = 0;
+
+  for (int i = 0; i < DISPATCH_MAX_SUBSCRIPTIONS - 2; i++)
+    DISPATCH_subscribe(&table, "exact", 0x100 + 8 * i, DISPATCH_MASK_STD, sink, nullptr, 0);
+  DISPATCH_subscribe(&table, "range", 0x700, 0x700, sink, nullptr, 0);
+  DISPATCH_subscribe(&table, "pgn", DISPATCH_ID_EXT | 0x18EF0000, 0x1FFF0000, sink, nullptr, 0);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+    CAN_frame_t f = frame(0x100 + (i & 0x7F));
+    total += DISPATCH_frame(&table, &f);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double ns = std::chrono::duration<double, std::nano>(end - begin).count() / BENCHMARK_FRAMES;
+  snprintf(text, sizeof(text), "%d subscriptions: %5.1f ns/frame", (int)table.num_subs, ns);
+  TEST_MESSAGE(text);
+
+  TEST_ASSERT_TRUE(total > 0);
+  TEST_ASSERT_TRUE(ns < BUDGET_FRAME_NS);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_exact_match);
+  RUN_TEST(test_mask_and_order);
+  RUN_TEST(test_match_deliver);
+  RUN_TEST(test_enable);
+  RUN_TEST(test_extended);
+  RUN_TEST(test_table_full);
+  RUN_TEST(test_handler_cost);
+  RUN_TEST(test_interval);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
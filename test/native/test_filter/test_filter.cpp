@@ -0,0 +1,395 @@
+/*******************************************************************
+ * test_filter.cpp
+ *
+ * Steering wheel filter chain, behaviour of the stages and a trace
+ * harness reporting latency and noise figures per configuration
+ * (host, pio test -e native)
+ *
+ * A recorded trace (one ADC value per line, sampled at
+ * TRACE_RATE_HZ) is added to the report with:
+ *
+ *   FILTER_TRACE=wheel.csv pio test -e native -f native/test_filter
+ *
+ *******************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include <chrono>
+#include <vector>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define TRACE_RATE_HZ 312  // Analog output rate, 20kHz / 2 inputs / 32
+#define TRACE_CENTRE 2047
+#define BENCHMARK_SAMPLES 1000000
+
+/* Host cost budget per stage (ns/sample), the target budget is in cycles */
+#define BUDGET_MEDIAN_NS 500.0
+#define BUDGET_STAGE_NS 100.0
+
+typedef std::vector<int32_t> trace_t;
+
+/*******************************************************************
+ * Deterministic noise, approximately gaussian (sum of uniforms)
+ *******************************************************************/
+static uint32_t lcg_state;
+
+static uint32_t lcg_next(void) {
+  lcg_state = lcg_state * 1664525u + 1013904223u;
+  return lcg_state >> 8;
+}
+
+static int32_t noise(int32_t amplitude) {
+  int32_t sum = 0;
+  for (int i = 0; i < 4; i++)
+    sum += (int32_t)(lcg_next() % (2 * amplitude + 1)) - amplitude;
+  return sum / 2;
+}
+
+/*******************************************************************
+ * Traces, wheel noise and potentiometer wiper spikes
+ *******************************************************************/
+static trace_t trace_hold(void) {
+  trace_t trace;
+  lcg_state = 1;
+  for (int i = 0; i < 2000; i++) {
+    int32_t value = TRACE_CENTRE + noise(4);
+    if ((i % 97) == 50)
+      value += ((i / 97) % 2) ? 400 : -400;  // Single sample spike
+    trace.push_back(value);
+  }
+  return trace;
+}
+
+static trace_t trace_step(void) {
+  trace_t trace;
+  lcg_state = 2;
+  for (int i = 0; i < 600; i++)
+    trace.push_back(((i < 100) ? 1000 : 3000) + noise(4));
+  return trace;
+}
+
+static trace_t trace_sweep(void) {
+  trace_t trace;
+  lcg_state = 3;
+  for (int i = 0; i < 3000; i++)
+    trace.push_back(TRACE_CENTRE + (int32_t)(1500.0 * sin(2.0 * M_PI * i / (TRACE_RATE_HZ * 2.0))) + noise(4));
+  return trace;
+}
+
+static bool trace_load(const char *path, trace_t &trace) {
+  FILE *file = fopen(path, "r");
+  long value;
+
+  if (!file)
+    return false;
+  while (fscanf(file, "%ld", &value) == 1)
+    trace.push_back((int32_t)value);
+  fclose(file);
+  return !trace.empty();
+}
+
+/*******************************************************************
+ * Configurations under test
+ *******************************************************************/
+typedef struct {
+  const char *name;
+  int num_stages;
+  FILTER_stage_cfg_t stage[FILTER_MAX_STAGES];
+} config_t;
+
+static FILTER_stage_cfg_t median(int window) {
+  FILTER_stage_cfg_t cfg = {};
+  cfg.type = FILTER_MEDIAN;
+  cfg.window = window;
+  return cfg;
+}
+
+static FILTER_stage_cfg_t iir(int permille) {
+  FILTER_stage_cfg_t cfg = {};
+  cfg.type = FILTER_IIR;
+  cfg.alpha = (permille * FILTER_IIR_ONE) / 1000;
+  return cfg;
+}
+
+static FILTER_stage_cfg_t rate_limit(int step) {
+  FILTER_stage_cfg_t cfg = {};
+  cfg.type = FILTER_RATE_LIMIT;
+  cfg.step = step;
+  return cfg;
+}
+
+static FILTER_stage_cfg_t deadband(int width, int hysteresis) {
+  FILTER_stage_cfg_t cfg = {};
+  cfg.type = FILTER_DEADBAND;
+  cfg.centre = TRACE_CENTRE;
+  cfg.width = width;
+  cfg.hysteresis = hysteresis;
+  return cfg;
+}
+
+static const config_t configs[] = {
+    {"raw", 0, {}},
+    {"default", 3, {median(3), iir(500), deadband(2, 2)}},
+    {"responsive", 3, {median(3), iir(800), deadband(4, 2)}},
+    {"smooth", 4, {median(5), iir(200), rate_limit(60), deadband(6, 4)}},
+};
+
+static FILTER_chain_t chain;
+
+/*******************************************************************
+ * Helpers
+ *******************************************************************/
+static trace_t run(const config_t &config, const trace_t &input) {
+  trace_t output;
+
+  FILTER_chain_init(&chain, config.stage, config.num_stages, nullptr);
+  for (int32_t value : input)
+    output.push_back(FILTER_chain_run(&chain, value));
+  return output;
+}
+
+static double ms(double samples) {
+  return samples * 1000.0 / TRACE_RATE_HZ;
+}
+
+/* RMS around the centre and the number of output changes (jitter) */
+static void hold_figures(const trace_t &output, double &rms, int &changes, int32_t &peak) {
+  double sum = 0;
+  changes = 0;
+  peak = 0;
+  for (size_t i = 0; i < output.size(); i++) {
+    int32_t error = output[i] - TRACE_CENTRE;
+    sum += (double)error * error;
+    if (abs(error) > peak)
+      peak = abs(error);
+    if (i && output[i] != output[i - 1])
+      changes++;
+  }
+  rms = sqrt(sum / output.size());
+}
+
+/* Samples from the step until 10% and 90% of the step */
+static void step_figures(const trace_t &output, int &delay, int &rise) {
+  int t10 = -1, t90 = -1;
+  for (size_t i = 100; i < output.size(); i++) {
+    if (t10 < 0 && output[i] >= 1200)
+      t10 = (int)i - 100;
+    if (t90 < 0 && output[i] >= 2800)
+      t90 = (int)i - 100;
+  }
+  delay = t10;
+  rise = (t10 >= 0 && t90 >= 0) ? t90 - t10 : -1;
+}
+
+/* Lag with the smallest error against the input and that error */
+static void sweep_figures(const trace_t &input, const trace_t &output, int &lag, double &rms) {
+  rms = 1e12;
+  lag = 0;
+  for (int shift = 0; shift < 40; shift++) {
+    double sum = 0;
+    for (size_t i = 40; i < output.size(); i++) {
+      double error = output[i] - input[i - shift];
+      sum += error * error;
+    }
+    sum = sqrt(sum / (output.size() - 40));
+    if (sum < rms) {
+      rms = sum;
+      lag = shift;
+    }
+  }
+}
+
+/*******************************************************************
+ * SUITE SetUp
+ *******************************************************************/
+void setUp(void) {
+}
+
+/*******************************************************************
+ * SUITE TearDown
+ *******************************************************************/
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Median rejects single sample spikes
+ *******************************************************************/
+void test_median_spikes(void) {
+  const config_t config = {"median", 1, {median(3)}};
+  trace_t output = run(config, trace_hold());
+
+  for (int32_t value : output)
+    TEST_ASSERT_INT_WITHIN(10, TRACE_CENTRE, value);
+
+  /* Window is forced odd and at most FILTER_MEDIAN_MAX */
+  FILTER_stage_cfg_t cfg = median(8);
+  FILTER_chain_init(&chain, &cfg, 1, nullptr);
+  TEST_ASSERT_EQUAL(FILTER_MEDIAN_MAX, chain.stage[0].cfg.window);
+}
+
+/*******************************************************************
+ * TC Fixed-point IIR follows the floating point reference
+ *******************************************************************/
+void test_iir_reference(void) {
+  static const int alphas[] = {50, 200, 500, 800, 1000};
+  trace_t input = trace_sweep();
+
+  for (int permille : alphas) {
+    FILTER_stage_cfg_t cfg = iir(permille);
+    double alpha = (double)cfg.alpha / FILTER_IIR_ONE;
+    double y = input[0];
+
+    FILTER_chain_init(&chain, &cfg, 1, nullptr);
+    for (int32_t value : input) {
+      y += alpha * (value - y);
+      TEST_ASSERT_INT_WITHIN(1, (int32_t)lround(y), FILTER_chain_run(&chain, value));
+    }
+  }
+}
+
+/*******************************************************************
+ * TC Rate limit bounds the slope
+ *******************************************************************/
+void test_rate_limit(void) {
+  FILTER_stage_cfg_t cfg = rate_limit(25);
+  trace_t input = trace_step();
+  int32_t last = input[0];
+
+  FILTER_chain_init(&chain, &cfg, 1, nullptr);
+  for (int32_t value : input) {
+    int32_t output = FILTER_chain_run(&chain, value);
+    TEST_ASSERT_TRUE(abs(output - last) <= 25);
+    last = output;
+  }
+  TEST_ASSERT_INT_WITHIN(8, 3000, last);
+}
+
+/*******************************************************************
+ * TC Deadband holds the centre, leaving needs the hysteresis
+ *******************************************************************/
+void test_deadband_hysteresis(void) {
+  FILTER_stage_cfg_t cfg = deadband(5, 3);
+  static const int32_t input[] = {2047, 2052, 2055, 2056, 2054, 2052, 2053, 2037, 2041, 2043};
+  static const int32_t expect[] = {2047, 2047, 2047, 2056, 2054, 2047, 2047, 2037, 2041, 2047};
+
+  FILTER_chain_init(&chain, &cfg, 1, nullptr);
+  for (size_t i = 0; i < sizeof(input) / sizeof(input[0]); i++)
+    TEST_ASSERT_EQUAL(expect[i], FILTER_chain_run(&chain, input[i]));
+}
+
+/*******************************************************************
+ * TC Stage cost is measured and checked against the budget
+ *******************************************************************/
+static uint32_t fake_time = 0;
+static uint32_t fake_clock(void) {
+  return fake_time += 10;  // Every stage costs 10
+}
+
+void test_cost_budget(void) {
+  FILTER_stage_cfg_t cfg[2] = {median(3), iir(500)};
+  cfg[0].budget = 20;
+  cfg[1].budget = 5;
+
+  FILTER_chain_init(&chain, cfg, 2, fake_clock);
+  for (int i = 0; i < 10; i++)
+    FILTER_chain_run(&chain, TRACE_CENTRE);
+
+  TEST_ASSERT_EQUAL(10, chain.stage[0].cost_last);
+  TEST_ASSERT_EQUAL(10, chain.stage[0].cost_max);
+  TEST_ASSERT_EQUAL(0, chain.stage[0].over_budget);
+  TEST_ASSERT_EQUAL(10, chain.stage[1].over_budget);
+}
+
+/*******************************************************************
+ * TC Cost per sample and stage on the host
+ *******************************************************************/
+void test_benchmark(void) {
+  static const FILTER_stage_cfg_t stages[] = {median(3), median(7), iir(500), rate_limit(60), deadband(2, 2)};
+  trace_t input = trace_sweep();
+  volatile int32_t sink = 0;
+  char text[128];
+
+  for (const FILTER_stage_cfg_t &cfg : stages) {
+    FILTER_chain_init(&chain, &cfg, 1, nullptr);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCHMARK_SAMPLES; i++)
+      sink = FILTER_chain_run(&chain, input[i % input.size()]);
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count() / BENCHMARK_SAMPLES;
+    snprintf(text, sizeof(text), "%-10s %d: %5.1f ns/sample", FILTER_type_name(cfg.type),
+             (cfg.type == FILTER_MEDIAN) ? (int)cfg.window : 1, ns);
+    TEST_MESSAGE(text);
+
+    TEST_ASSERT_TRUE(ns < ((cfg.type == FILTER_MEDIAN) ? BUDGET_MEDIAN_NS : BUDGET_STAGE_NS));
+  }
+  (void)sink;
+}
+
+/*******************************************************************
+ * TC Latency and noise report per configuration
+ *******************************************************************/
+void test_trace_report(void) {
+  trace_t hold = trace_hold();
+  trace_t step = trace_step();
+  trace_t sweep = trace_sweep();
+  trace_t recorded;
+  const char *path = getenv("FILTER_TRACE");
+  char text[200];
+
+  TEST_MESSAGE("config      | hold rms  peak changes | step delay   rise   | sweep lag   rms");
+
+  for (const config_t &config : configs) {
+    double hold_rms, sweep_rms;
+    int changes, delay, rise, lag;
+    int32_t peak;
+
+    hold_figures(run(config, hold), hold_rms, changes, peak);
+    step_figures(run(config, step), delay, rise);
+    sweep_figures(sweep, run(config, sweep), lag, sweep_rms);
+
+    snprintf(text, sizeof(text), "%-11s | %8.2f %5d %7d | %5.1fms %6.1fms | %5.1fms %5.2f",
+             config.name, hold_rms, (int)peak, changes, ms(delay), ms(rise), ms(lag), sweep_rms);
+    TEST_MESSAGE(text);
+
+    TEST_ASSERT_TRUE(rise >= 0);
+  }
+
+  if (path && trace_load(path, recorded)) {
+    for (const config_t &config : configs) {
+      trace_t output = run(config, recorded);
+      double rms = 0;
+      int changes = 0, lag;
+
+      for (size_t i = 1; i < output.size(); i++)
+        changes += (output[i] != output[i - 1]);
+      sweep_figures(recorded, output, lag, rms);
+
+      snprintf(text, sizeof(text), "%-11s | %s: %zu samples, changes %d, lag %.1fms, rms vs input %.2f",
+               config.name, path, recorded.size(), changes, ms(lag), rms);
+      TEST_MESSAGE(text);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_median_spikes);
+  RUN_TEST(test_iir_reference);
+  RUN_TEST(test_rate_limit);
+  RUN_TEST(test_deadband_hysteresis);
+  RUN_TEST(test_cost_budget);
+  RUN_TEST(test_benchmark);
+  RUN_TEST(test_trace_report);
+  return UNITY_END();
+}
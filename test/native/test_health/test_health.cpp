@@ -0,0 +1,211 @@
+/*******************************************************************
+ * test_health.cpp
+ *
+ * CAN bus health, frame bit times, bus load, error trend, diagnosis
+ * and bus-off recovery backoff (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define MS 1000  // Clock in microseconds
+
+static CAN_frame_t frame(uint32_t id, bool ext, uint8_t length, uint8_t fill) {
+  CAN_frame_t f = {};
+  f.id = id;
+  f.ext = ext ? 1 : 0;
+  f.length = length;
+  memset(f.data, fill, sizeof(f.data));
+  return f;
+}
+
+static HEALTH_status_t status(uint16_t tec, uint16_t rec, uint32_t bus_errors = 0) {
+  HEALTH_status_t s;
+  s.tec = tec;
+  s.rec = rec;
+  s.state = HEALTH_state(tec, rec);
+  s.bus_errors = bus_errors;
+  return s;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Bits on the wire, reference values from a bit level model
+ *******************************************************************/
+void test_frame_bits(void) {
+  CAN_frame_t f = frame(0x123, false, 3, 0);
+
+  f.data[0] = 0x11;
+  f.data[1] = 0x22;
+  f.data[2] = 0x33;
+  TEST_ASSERT_EQUAL(72, HEALTH_frame_bits(&f));
+
+  f = frame(0x18EF1234, true, 8, 0);
+  for (int i = 0; i < 8; i++)
+    f.data[i] = (uint8_t)(0x11 * (i + 1));
+  TEST_ASSERT_EQUAL(135, HEALTH_frame_bits(&f));
+
+  f = frame(0x000, false, 8, 0x00);  // Worst case data, stuff bit every 4 bits
+  TEST_ASSERT_EQUAL(127, HEALTH_frame_bits(&f));
+
+  f = frame(0x555, false, 8, 0x55);  // Alternating bits
+  TEST_ASSERT_EQUAL(112, HEALTH_frame_bits(&f));
+
+  f = frame(0x7FF, false, 0, 0);
+  f.rtr = 1;
+  TEST_ASSERT_EQUAL(50, HEALTH_frame_bits(&f));
+
+  /* Without stuffing 111 (standard) and 131 (extended) bits, at most 24 and 29 more */
+  for (uint32_t id = 0; id < 0x800; id += 0x41) {
+    f = frame(id, false, 8, (uint8_t)id);
+    TEST_ASSERT_TRUE(HEALTH_frame_bits(&f) >= 111 && HEALTH_frame_bits(&f) <= 135);
+    f = frame(id << 18, true, 8, (uint8_t)id);
+    TEST_ASSERT_TRUE(HEALTH_frame_bits(&f) >= 131 && HEALTH_frame_bits(&f) <= 160);
+  }
+}
+
+/*******************************************************************
+ * TC Bus load over windows, quiet windows
+ *******************************************************************/
+void test_load(void) {
+  HEALTH_load_t load;
+
+  HEALTH_load_init(&load, 250000, 1000 * MS, 0);
+
+  /* 1000 frames of 125 bits in one second at 250 kbit/s: 50 % */
+  for (uint32_t i = 0; i < 1000; i++)
+    HEALTH_load_add(&load, 125, i * MS);
+  TEST_ASSERT_FALSE(HEALTH_load_update(&load, 999 * MS));
+  TEST_ASSERT_TRUE(HEALTH_load_update(&load, 1000 * MS));
+  TEST_ASSERT_EQUAL(500, load.load);
+  TEST_ASSERT_EQUAL(1000, load.frame_rate);
+
+  /* Half the traffic, closed by the next frame */
+  for (uint32_t i = 0; i < 500; i++)
+    HEALTH_load_add(&load, 125, 1000 * MS + 2 * i * MS);
+  HEALTH_load_add(&load, 125, 2000 * MS);
+  TEST_ASSERT_EQUAL(250, load.load);
+  TEST_ASSERT_EQUAL(500, load.load_max);
+
+  /* Quiet for three windows */
+  TEST_ASSERT_TRUE(HEALTH_load_update(&load, 5500 * MS));
+  TEST_ASSERT_EQUAL(0, load.load);
+  TEST_ASSERT_EQUAL(5000 * MS, load.start);
+}
+
+/*******************************************************************
+ * TC Error states and counter trend
+ *******************************************************************/
+void test_errors(void) {
+  HEALTH_errors_t errors;
+  HEALTH_status_t s;
+
+  TEST_ASSERT_EQUAL(HEALTH_ERROR_ACTIVE, HEALTH_state(95, 0));
+  TEST_ASSERT_EQUAL(HEALTH_ERROR_WARNING, HEALTH_state(0, 96));
+  TEST_ASSERT_EQUAL(HEALTH_ERROR_PASSIVE, HEALTH_state(128, 0));
+  TEST_ASSERT_EQUAL(HEALTH_BUS_OFF, HEALTH_state(256, 0));
+  TEST_ASSERT_EQUAL(HEALTH_ERROR_ACTIVE, HEALTH_state(HEALTH_COUNTER_UNKNOWN, HEALTH_COUNTER_UNKNOWN));
+
+  HEALTH_errors_init(&errors);
+  TEST_ASSERT_EQUAL(0, HEALTH_errors_trend(&errors, true));
+
+  for (uint16_t i = 0; i < 15; i++) {
+    s = status(8 * i, 3);
+    HEALTH_errors_add(&errors, &s);
+  }
+  TEST_ASSERT_EQUAL(8 * (HEALTH_TREND_SAMPLES - 1), HEALTH_errors_trend(&errors, true));  // Last samples only
+  TEST_ASSERT_EQUAL(0, HEALTH_errors_trend(&errors, false));
+  TEST_ASSERT_EQUAL(112, errors.tec_max);
+  TEST_ASSERT_EQUAL(HEALTH_ERROR_WARNING, errors.state);
+  TEST_ASSERT_EQUAL(1, errors.entered[HEALTH_ERROR_WARNING]);
+
+  s = status(256, 0);
+  HEALTH_errors_add(&errors, &s);
+  s = status(0, 0);
+  HEALTH_errors_add(&errors, &s);
+  TEST_ASSERT_EQUAL(1, errors.entered[HEALTH_BUS_OFF]);
+  TEST_ASSERT_EQUAL(1, errors.entered[HEALTH_ERROR_ACTIVE]);
+}
+
+/*******************************************************************
+ * TC Congested bus versus faulty node
+ *******************************************************************/
+void test_diagnose(void) {
+  HEALTH_errors_t errors;
+  HEALTH_load_t load;
+  HEALTH_status_t s;
+
+  HEALTH_load_init(&load, 500000, 1000 * MS, 0);
+  HEALTH_errors_init(&errors);
+  s = status(0, 0);
+  HEALTH_errors_add(&errors, &s);
+  HEALTH_errors_add(&errors, &s);
+  TEST_ASSERT_EQUAL(HEALTH_OK, HEALTH_diagnose(&load, &errors));
+
+  load.load = 900;  // Busy but clean
+  TEST_ASSERT_EQUAL(HEALTH_CONGESTED, HEALTH_diagnose(&load, &errors));
+
+  s = status(0, 40, 12);  // Errors seen on the bus
+  HEALTH_errors_add(&errors, &s);
+  TEST_ASSERT_EQUAL(HEALTH_BUS_ERRORS, HEALTH_diagnose(&load, &errors));
+
+  s = status(80, 40, 12);  // Own frames not acknowledged
+  HEALTH_errors_add(&errors, &s);
+  TEST_ASSERT_EQUAL(HEALTH_TX_ERRORS, HEALTH_diagnose(&load, &errors));
+
+  TEST_ASSERT_EQUAL_STRING("transmit-errors", HEALTH_verdict_name(HEALTH_TX_ERRORS));
+  TEST_ASSERT_EQUAL_STRING("bus-off", HEALTH_state_name(HEALTH_BUS_OFF));
+}
+
+/*******************************************************************
+ * TC Exponential backoff of the bus-off recovery
+ *******************************************************************/
+void test_backoff(void) {
+  HEALTH_backoff_t backoff;
+  uint32_t now = 0;
+
+  HEALTH_backoff_init(&backoff, 100 * MS, 1600 * MS, 10000 * MS);
+
+  /* Repeated bus-off: 100, 200, 400, 800, 1600, 1600 ms */
+  const uint32_t expected[] = {100, 200, 400, 800, 1600, 1600};
+  for (uint32_t delay : expected) {
+    HEALTH_backoff_bus_off(&backoff, now);
+    HEALTH_backoff_bus_off(&backoff, now + 10 * MS);  // Still bus-off, same recovery
+    TEST_ASSERT_FALSE(HEALTH_backoff_due(&backoff, now + delay * MS - 1));
+    TEST_ASSERT_TRUE(HEALTH_backoff_due(&backoff, now + delay * MS));
+    TEST_ASSERT_FALSE(HEALTH_backoff_due(&backoff, now + delay * MS));
+    now += delay * MS;
+  }
+  TEST_ASSERT_EQUAL(6, backoff.bus_offs);
+  TEST_ASSERT_EQUAL(6, backoff.recoveries);
+
+  /* Stable on the bus resets the delay */
+  HEALTH_backoff_ok(&backoff, now + 9999 * MS);
+  TEST_ASSERT_EQUAL(1600 * MS, backoff.delay);
+  HEALTH_backoff_ok(&backoff, now + 10000 * MS);
+  TEST_ASSERT_EQUAL(100 * MS, backoff.delay);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_frame_bits);
+  RUN_TEST(test_load);
+  RUN_TEST(test_errors);
+  RUN_TEST(test_diagnose);
+  RUN_TEST(test_backoff);
+  return UNITY_END();
+}
@@ -0,0 +1,370 @@
+/*******************************************************************
+ * test_isotp.cpp
+ *
+ * ISO-TP transport, two links on a simulated CAN bus: single and
+ * multi-frame loopback, flow control, errors and a throughput
+ * benchmark (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define BITRATE 500000
+#define BUS_QUEUE 64
+#define TESTER_ID 0x7E0
+#define ECU_ID 0x7E8
+#define TIMEOUT_US 1000000
+#define BENCHMARK_ROUNDS 200
+
+typedef struct {
+  CAN_frame_t frame[BUS_QUEUE];
+  int head;
+  int count;
+  int capacity;      // Frames accepted, a full queue refuses
+  uint32_t frames;
+  uint32_t flow_controls;
+  int drop;          // Index of a frame to lose, -1 is none
+} bus_t;
+
+typedef struct {
+  ISOTP_link_t link;
+  bus_t *bus;
+  uint16_t rx_length;   // Message bytes are a pattern of the offset
+  uint16_t rx_bytes;    // Bytes checked against the pattern
+  uint32_t rx_mismatch;
+  bool refuse;          // Sink refuses new messages
+  int tx_done;
+  int rx_done;
+  ISOTP_result_t tx_result;
+  ISOTP_result_t rx_result;
+} endpoint_t;
+
+static bus_t bus;
+static endpoint_t tester;
+static endpoint_t ecu;
+static uint32_t now;
+
+static uint8_t pattern(uint16_t offset) {
+  return (uint8_t)(offset * 7 + (offset >> 8));
+}
+
+/*******************************************************************
+ * Callbacks
+ *******************************************************************/
+static bool bus_send(const CAN_frame_t *frame, void *context) {
+  endpoint_t *ep = (endpoint_t *)context;
+  bus_t *b = ep->bus;
+
+  if (b->count >= b->capacity) {
+    return false;
+  }
+  if ((frame->data[0] >> 4) == 3) {
+    b->flow_controls++;
+  }
+  if (b->drop-- == 0) {
+    return true;  // Lost on the wire
+  }
+  b->frame[(b->head + b->count) % BUS_QUEUE] = *frame;
+  b->count++;
+  return true;
+}
+
+static void source(uint16_t offset, uint8_t *data, uint8_t length, void *context) {
+  (void)context;
+  for (uint8_t i = 0; i < length; i++) {
+    data[i] = pattern(offset + i);
+  }
+}
+
+static bool sink(uint16_t offset, const uint8_t *data, uint8_t length, uint16_t total, void *context) {
+  endpoint_t *ep = (endpoint_t *)context;
+
+  if (offset == 0) {
+    if (ep->refuse) {
+      return false;
+    }
+    ep->rx_length = total;
+    ep->rx_bytes = 0;
+  }
+  if (offset != ep->rx_bytes) {
+    ep->rx_mismatch++;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    if (data[i] != pattern(offset + i)) {
+      ep->rx_mismatch++;
+    }
+  }
+  ep->rx_bytes += length;
+  return true;
+}
+
+static void done(bool tx, ISOTP_result_t result, void *context) {
+  endpoint_t *ep = (endpoint_t *)context;
+
+  if (tx) {
+    ep->tx_done++;
+    ep->tx_result = result;
+  } else {
+    ep->rx_done++;
+    ep->rx_result = result;
+  }
+}
+
+static void endpoint_init(endpoint_t *ep, uint32_t tx_id, uint32_t rx_id, uint8_t block_size, uint8_t st_min) {
+  ISOTP_config_t config = {};
+
+  memset(ep, 0, sizeof(*ep));
+  config.tx_id = tx_id;
+  config.rx_id = rx_id;
+  config.block_size = block_size;
+  config.st_min = st_min;
+  config.padding = 0xCC;
+  config.timeout = TIMEOUT_US;
+  config.send = bus_send;
+  config.source = source;
+  config.sink = sink;
+  config.done = done;
+  config.context = ep;
+  ISOTP_init(&ep->link, &config);
+  ep->bus = &bus;
+}
+
+/*******************************************************************
+ * Bus simulation, frames take their bit time on the wire
+ *******************************************************************/
+static void run(uint32_t limit) {
+  const uint32_t end = now + limit;
+
+  while ((int32_t)(end - now) > 0) {
+    if (bus.count) {
+      CAN_frame_t frame = bus.frame[bus.head];
+      bus.head = (bus.head + 1) % BUS_QUEUE;
+      bus.count--;
+      bus.frames++;
+      now += (uint32_t)HEALTH_frame_bits(&frame) * 1000000ULL / BITRATE;
+
+      ISOTP_receive(&tester.link, &frame, now);
+      ISOTP_receive(&ecu.link, &frame, now);
+    }
+
+    ISOTP_poll(&tester.link, now);
+    ISOTP_poll(&ecu.link, now);
+
+    if (!bus.count) {
+      uint32_t wait = ISOTP_wait(&tester.link, now);
+      const uint32_t ecu_wait = ISOTP_wait(&ecu.link, now);
+
+      if (ecu_wait < wait) {
+        wait = ecu_wait;
+      }
+      if (wait == ISOTP_IDLE) {
+        return;
+      }
+      now += wait ? wait : 1;
+    }
+  }
+}
+
+void setUp(void) {
+  memset(&bus, 0, sizeof(bus));
+  bus.capacity = BUS_QUEUE;
+  bus.drop = -1;
+  now = 0xFFFF0000;  // Wraps during the tests
+  endpoint_init(&tester, TESTER_ID, ECU_ID, 0, 0);
+  endpoint_init(&ecu, ECU_ID, TESTER_ID, 0, 0);
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Single frame
+ *******************************************************************/
+void test_single_frame(void) {
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, 3, now));
+  TEST_ASSERT_EQUAL(1, tester.tx_done);
+  TEST_ASSERT_EQUAL(0x03, bus.frame[0].data[0]);
+  TEST_ASSERT_EQUAL(0xCC, bus.frame[0].data[4]);  // Padded to 8 bytes
+  TEST_ASSERT_EQUAL(8, bus.frame[0].length);
+  run(TIMEOUT_US);
+  TEST_ASSERT_EQUAL(3, ecu.rx_bytes);
+
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, 7, now));
+
+  run(TIMEOUT_US);
+  TEST_ASSERT_EQUAL(2, ecu.rx_done);
+  TEST_ASSERT_EQUAL(ISOTP_OK, ecu.rx_result);
+  TEST_ASSERT_EQUAL(7, ecu.rx_length);
+  TEST_ASSERT_EQUAL(7, ecu.rx_bytes);
+  TEST_ASSERT_EQUAL(0, ecu.rx_mismatch);
+
+  TEST_ASSERT_EQUAL(-1, ISOTP_send(&tester.link, 0, now));
+  TEST_ASSERT_EQUAL(-1, ISOTP_send(&tester.link, ISOTP_MAX_LENGTH + 1, now));
+  TEST_ASSERT_EQUAL(ISOTP_IDLE, ISOTP_wait(&tester.link, now));
+}
+
+/*******************************************************************
+ * TC Multi-frame loopback, both directions at once
+ *******************************************************************/
+void test_multi_frame(void) {
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, ISOTP_MAX_LENGTH, now));
+  TEST_ASSERT_EQUAL(-1, ISOTP_send(&tester.link, 20, now));  // Busy
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&ecu.link, 100, now));
+
+  run(10 * TIMEOUT_US);
+
+  TEST_ASSERT_EQUAL(1, tester.tx_done);
+  TEST_ASSERT_EQUAL(ISOTP_OK, tester.tx_result);
+  TEST_ASSERT_EQUAL(1, ecu.rx_done);
+  TEST_ASSERT_EQUAL(ISOTP_OK, ecu.rx_result);
+  TEST_ASSERT_EQUAL(ISOTP_MAX_LENGTH, ecu.rx_bytes);
+  TEST_ASSERT_EQUAL(0, ecu.rx_mismatch);
+
+  TEST_ASSERT_EQUAL(1, tester.rx_done);
+  TEST_ASSERT_EQUAL(100, tester.rx_bytes);
+  TEST_ASSERT_EQUAL(0, tester.rx_mismatch);
+
+  /* First frame and consecutive frames, one flow control for the other message */
+  TEST_ASSERT_EQUAL(1 + 585 + 1, tester.link.tx_frames);
+  TEST_ASSERT_EQUAL(1 + 14 + 1, ecu.link.tx_frames);
+  TEST_ASSERT_EQUAL(2, bus.flow_controls);
+  TEST_ASSERT_EQUAL(1 + 585 + 1 + 1 + 14 + 1, bus.frames);
+}
+
+/*******************************************************************
+ * TC Block size and STmin of the receiver pace the sender
+ *******************************************************************/
+void test_flow_control(void) {
+  endpoint_init(&ecu, ECU_ID, TESTER_ID, 8, 0xF5);  // 8 frames per block, 500 us apart
+  const uint32_t start = now;
+
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, 500, now));
+  run(10 * TIMEOUT_US);
+
+  /* 70 consecutive frames: 9 flow controls */
+  TEST_ASSERT_EQUAL(ISOTP_OK, ecu.rx_result);
+  TEST_ASSERT_EQUAL(500, ecu.rx_bytes);
+  TEST_ASSERT_EQUAL(0, ecu.rx_mismatch);
+  TEST_ASSERT_EQUAL(9, bus.flow_controls);
+  TEST_ASSERT_TRUE(now - start >= 61 * 500);  // STmin between the frames of a block
+
+  TEST_ASSERT_EQUAL(0, ISOTP_st_min(0));
+  TEST_ASSERT_EQUAL(127000, ISOTP_st_min(0x7F));
+  TEST_ASSERT_EQUAL(100, ISOTP_st_min(0xF1));
+  TEST_ASSERT_EQUAL(127000, ISOTP_st_min(0x80));
+}
+
+/*******************************************************************
+ * TC Lost frame, missing flow control, refused message
+ *******************************************************************/
+void test_errors(void) {
+  /* Third consecutive frame lost */
+  bus.drop = 4;
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, 100, now));
+  run(10 * TIMEOUT_US);
+  TEST_ASSERT_EQUAL(ISOTP_WRONG_SN, ecu.rx_result);
+  TEST_ASSERT_EQUAL(ISOTP_OK, tester.tx_result);  // The sender does not know
+
+  /* Nobody answers the first frame */
+  endpoint_init(&ecu, ECU_ID, 0x7E1, 0, 0);
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, 100, now));
+  run(10 * TIMEOUT_US);
+  TEST_ASSERT_EQUAL(ISOTP_TIMEOUT, tester.tx_result);
+  TEST_ASSERT_EQUAL(ISOTP_IDLE, ISOTP_wait(&tester.link, now));
+
+  /* Receiver refuses the length */
+  endpoint_init(&ecu, ECU_ID, TESTER_ID, 0, 0);
+  ecu.refuse = true;
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, 100, now));
+  run(10 * TIMEOUT_US);
+  TEST_ASSERT_EQUAL(ISOTP_OVERFLOW, tester.tx_result);
+  TEST_ASSERT_EQUAL(0, ecu.rx_done);
+
+  /* Sender stops after the first frame */
+  ecu.refuse = false;
+  CAN_frame_t first = {};
+  first.id = TESTER_ID;
+  first.length = 8;
+  first.data[0] = 0x10;
+  first.data[1] = 100;
+  ISOTP_receive(&ecu.link, &first, now);
+  run(10 * TIMEOUT_US);
+  TEST_ASSERT_EQUAL(ISOTP_TIMEOUT, ecu.rx_result);
+  TEST_ASSERT_EQUAL(6, ecu.rx_bytes);
+}
+
+/*******************************************************************
+ * TC Full transmit queue, frames wait and keep their order
+ *******************************************************************/
+void test_queue_full(void) {
+  bus.capacity = 0;
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, 100, now));  // First frame kept
+  TEST_ASSERT_TRUE(tester.link.has_pending);
+  TEST_ASSERT_EQUAL(0, ISOTP_wait(&tester.link, now));
+  ISOTP_poll(&tester.link, now);
+  TEST_ASSERT_TRUE(tester.link.has_pending);
+
+  bus.capacity = 2;  // Two frames at a time
+  run(10 * TIMEOUT_US);
+  TEST_ASSERT_EQUAL(ISOTP_OK, tester.tx_result);
+  TEST_ASSERT_EQUAL(ISOTP_OK, ecu.rx_result);
+  TEST_ASSERT_EQUAL(100, ecu.rx_bytes);
+  TEST_ASSERT_EQUAL(0, ecu.rx_mismatch);
+}
+
+/*******************************************************************
+ * TC Throughput on the simulated bus and of the state machines
+ *******************************************************************/
+void test_throughput(void) {
+  char text[160];
+
+  /* Bus time of one 4095 byte message at full speed */
+  const uint32_t start = now;
+  TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, ISOTP_MAX_LENGTH, now));
+  run(10 * TIMEOUT_US);
+  const double bus_seconds = (now - start) / 1e6;
+  const double bus_rate = ISOTP_MAX_LENGTH / bus_seconds;
+
+  /* Processing time without the bus */
+  uint64_t bytes = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+    TEST_ASSERT_EQUAL(0, ISOTP_send(&tester.link, ISOTP_MAX_LENGTH, now));
+    run(10 * TIMEOUT_US);
+    bytes += ecu.rx_bytes;
+  }
+  auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration<double>(end - begin).count();
+  const double rate = bytes / seconds;
+
+  snprintf(text, sizeof(text), "500 kbit/s bus: %.0f bytes/s payload, host: %.0f bytes/s, %.0fx the bus", bus_rate,
+           rate, rate / bus_rate);
+  TEST_MESSAGE(text);
+
+  TEST_ASSERT_EQUAL(BENCHMARK_ROUNDS + 1, ecu.link.rx_messages);
+  TEST_ASSERT_EQUAL(0, ecu.rx_mismatch);
+  TEST_ASSERT_TRUE(bus_rate > 25000);  // 7 of 8 bytes in a 111 to 135 bit frame
+  TEST_ASSERT_TRUE(rate > 20 * bus_rate);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_single_frame);
+  RUN_TEST(test_multi_frame);
+  RUN_TEST(test_flow_control);
+  RUN_TEST(test_errors);
+  RUN_TEST(test_queue_full);
+  RUN_TEST(test_throughput);
+  return UNITY_END();
+}
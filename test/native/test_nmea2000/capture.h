@@ -0,0 +1,153 @@
+/*******************************************************************
+ * capture.h
+ *
+ * NMEA2000 bus capture (candump -l format), two seconds of engine,
+ * rudder and thruster traffic with unrelated PGNs in between. The
+ * second engine dynamic message at 1.02s misses frame 2.
+ *
+ *******************************************************************/
+#ifndef CAPTURE_HEADER
+#define CAPTURE_HEADER
+
+static const char *capture[] = {
+    "(1718000000.000000) can0 18EEFF10#E803A01C008C64C0",
+    "(1718000000.001000) can0 18EEFF11#E903A01C018C64C0",
+    "(1718000000.002000) can0 18EEFF20#EA03A01C029650C0",
+    "(1718000000.003000) can0 18EEFF30#EB03A01C03A050C0",
+    "(1718000000.010000) can0 18EAFF05#00EE00",
+    "(1718000000.020000) can0 09F20010#007017FFFFFBFFFF",
+    "(1718000000.022000) can0 09F10D20#00F8FF7F0000FFFF",
+    "(1718000000.024000) can0 0DF40630#0001913200C85C3D",
+    "(1718000000.026000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.028000) can0 09FD0206#001002204EFAFFFF",
+    "(1718000000.030000) can0 09F20110#001A00A00FAC0DDB",
+    "(1718000000.030500) can0 09F20111#001A01A00FAC0DDB",
+    "(1718000000.031000) can0 09F20110#018D8C057B0040E2",
+    "(1718000000.031500) can0 09F20111#018D8C057B00F1FB",
+    "(1718000000.032000) can0 09F20110#020100DC052C01FF",
+    "(1718000000.032500) can0 09F20111#020900DC052C01FF",
+    "(1718000000.033000) can0 09F20110#03000000002D1EFF",
+    "(1718000000.033500) can0 09F20111#03000000002D1EFF",
+    "(1718000000.120000) can0 09F20010#007417FFFFFBFFFF",
+    "(1718000000.122000) can0 09F10D20#00F8FF7FD603FFFF",
+    "(1718000000.124000) can0 0DF40630#0101913200C8C03D",
+    "(1718000000.126000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.128000) can0 09FD0206#011002204EFAFFFF",
+    "(1718000000.220000) can0 09F20010#007817FFFFFBFFFF",
+    "(1718000000.222000) can0 09F10D20#00F8FF7F3F07FFFF",
+    "(1718000000.224000) can0 0DF40630#0201913200C8243E",
+    "(1718000000.226000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.228000) can0 09FD0206#021002204EFAFFFF",
+    "(1718000000.320000) can0 09F20010#007C17FFFFFBFFFF",
+    "(1718000000.322000) can0 09F10D20#00F8FF7FDC09FFFF",
+    "(1718000000.324000) can0 0DF40630#0301913200C8883E",
+    "(1718000000.326000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.328000) can0 09FD0206#031002204EFAFFFF",
+    "(1718000000.420000) can0 09F20010#008017FFFFFBFFFF",
+    "(1718000000.422000) can0 09F10D20#00F8FF7F640BFFFF",
+    "(1718000000.424000) can0 0DF40630#0401913200C8EC3E",
+    "(1718000000.426000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.428000) can0 09FD0206#041002204EFAFFFF",
+    "(1718000000.520000) can0 09F20010#008417FFFFFBFFFF",
+    "(1718000000.522000) can0 09F10D20#00F8FF7FAA0BFFFF",
+    "(1718000000.524000) can0 0DF40630#0501913200C8503F",
+    "(1718000000.526000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.528000) can0 09FD0206#051002204EFAFFFF",
+    "(1718000000.530000) can0 09F20110#201A00A00FAC0DDB",
+    "(1718000000.530500) can0 09F20111#201A01A00FAC0DDB",
+    "(1718000000.531000) can0 09F20110#218D8C057B0045E2",
+    "(1718000000.531500) can0 09F20111#218D8C057B00F6FB",
+    "(1718000000.532000) can0 09F20110#220100DC052C01FF",
+    "(1718000000.532500) can0 09F20111#220900DC052C01FF",
+    "(1718000000.533000) can0 09F20110#23000000002D1EFF",
+    "(1718000000.533500) can0 09F20111#23000000002D1EFF",
+    "(1718000000.620000) can0 09F20010#008817FFFFFBFFFF",
+    "(1718000000.622000) can0 09F10D20#00F8FF7FA80AFFFF",
+    "(1718000000.624000) can0 0DF40630#0601913200C8B43F",
+    "(1718000000.626000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.628000) can0 09FD0206#061002204EFAFFFF",
+    "(1718000000.720000) can0 09F20010#008C17FFFFFBFFFF",
+    "(1718000000.722000) can0 09F10D20#00F8FF7F7908FFFF",
+    "(1718000000.724000) can0 0DF40630#0701913200C81840",
+    "(1718000000.726000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.728000) can0 09FD0206#071002204EFAFFFF",
+    "(1718000000.820000) can0 09F20010#009017FFFFFBFFFF",
+    "(1718000000.822000) can0 09F10D20#00F8FF7F5C05FFFF",
+    "(1718000000.824000) can0 0DF40630#0801913200C87C40",
+    "(1718000000.826000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.828000) can0 09FD0206#081002204EFAFFFF",
+    "(1718000000.920000) can0 09F20010#009417FFFFFBFFFF",
+    "(1718000000.922000) can0 09F10D20#00F8FF7FA701FFFF",
+    "(1718000000.924000) can0 0DF40630#0901913200C8E040",
+    "(1718000000.926000) can0 09F80105#80161D1FC029CD02",
+    "(1718000000.928000) can0 09FD0206#091002204EFAFFFF",
+    "(1718000001.020000) can0 09F20010#009817FFFFFBFFFF",
+    "(1718000001.022000) can0 09F10D20#00F8FF7FC4FDFFFF",
+    "(1718000001.024000) can0 0DF40630#0A01913200C84441",
+    "(1718000001.026000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.028000) can0 09FD0206#0A1002204EFAFFFF",
+    "(1718000001.030000) can0 09F20110#401A00A00FAC0DDB",
+    "(1718000001.030500) can0 09F20111#401A01A00FAC0DDB",
+    "(1718000001.031000) can0 09F20110#418D8C057B004AE2",
+    "(1718000001.031500) can0 09F20111#418D8C057B00FBFB",
+    "(1718000001.032000) can0 09F20110#420100DC052C01FF",
+    "(1718000001.033000) can0 09F20110#43000000002D1EFF",
+    "(1718000001.033500) can0 09F20111#43000000002D1EFF",
+    "(1718000001.120000) can0 09F20010#009C17FFFFFBFFFF",
+    "(1718000001.122000) can0 09F10D20#00F8FF7F20FAFFFF",
+    "(1718000001.124000) can0 0DF40630#0B01913200C8A841",
+    "(1718000001.126000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.128000) can0 09FD0206#0B1002204EFAFFFF",
+    "(1718000001.220000) can0 09F20010#00A017FFFFFBFFFF",
+    "(1718000001.222000) can0 09F10D20#00F8FF7F22F7FFFF",
+    "(1718000001.224000) can0 0DF40630#0C01913200C80C42",
+    "(1718000001.226000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.228000) can0 09FD0206#0C1002204EFAFFFF",
+    "(1718000001.320000) can0 09F20010#00A417FFFFFBFFFF",
+    "(1718000001.322000) can0 09F10D20#00F8FF7F1DF5FFFF",
+    "(1718000001.324000) can0 0DF40630#0D01913200C87042",
+    "(1718000001.326000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.328000) can0 09FD0206#0D1002204EFAFFFF",
+    "(1718000001.420000) can0 09F20010#00A817FFFFFBFFFF",
+    "(1718000001.422000) can0 09F10D20#00F8FF7F4BF4FFFF",
+    "(1718000001.424000) can0 0DF40630#0E01913200C8D442",
+    "(1718000001.426000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.428000) can0 09FD0206#0E1002204EFAFFFF",
+    "(1718000001.520000) can0 09F20010#00AC17FFFFFBFFFF",
+    "(1718000001.522000) can0 09F10D20#00F8FF7FC3F4FFFF",
+    "(1718000001.524000) can0 0DF40630#0F01913200C83843",
+    "(1718000001.526000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.528000) can0 09FD0206#0F1002204EFAFFFF",
+    "(1718000001.530000) can0 09F20110#601A00A00FAC0DDB",
+    "(1718000001.530500) can0 09F20111#601A01A00FAC0DDB",
+    "(1718000001.531000) can0 09F20110#618D8C057B004FE2",
+    "(1718000001.531500) can0 09F20111#618D8C057B0000FC",
+    "(1718000001.532000) can0 09F20110#620100DC052C01FF",
+    "(1718000001.532500) can0 09F20111#620900DC052C01FF",
+    "(1718000001.533000) can0 09F20110#63000000002D1EFF",
+    "(1718000001.533500) can0 09F20111#63000000002D1EFF",
+    "(1718000001.620000) can0 09F20010#00B017FFFFFBFFFF",
+    "(1718000001.622000) can0 09F10D20#00F8FF7F78F6FFFF",
+    "(1718000001.624000) can0 0DF40630#1001913200C89C43",
+    "(1718000001.626000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.628000) can0 09FD0206#101002204EFAFFFF",
+    "(1718000001.720000) can0 09F20010#00B417FFFFFBFFFF",
+    "(1718000001.722000) can0 09F10D20#00F8FF7F39F9FFFF",
+    "(1718000001.724000) can0 0DF40630#1101913200C80044",
+    "(1718000001.726000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.728000) can0 09FD0206#111002204EFAFFFF",
+    "(1718000001.820000) can0 09F20010#00B817FFFFFBFFFF",
+    "(1718000001.822000) can0 09F10D20#00F8FF7FBAFCFFFF",
+    "(1718000001.824000) can0 0DF40630#1201913200C86444",
+    "(1718000001.826000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.828000) can0 09FD0206#121002204EFAFFFF",
+    "(1718000001.920000) can0 09F20010#00BC17FFFFFBFFFF",
+    "(1718000001.922000) can0 09F10D20#00F8FF7F9600FFFF",
+    "(1718000001.924000) can0 0DF40630#1301913200C8C844",
+    "(1718000001.926000) can0 09F80105#80161D1FC029CD02",
+    "(1718000001.928000) can0 09FD0206#131002204EFAFFFF",
+};
+
+#define CAPTURE_FRAMES (sizeof(capture) / sizeof(capture[0]))
+
+#endif  // CAPTURE_HEADER
@@ -0,0 +1,451 @@
+/*******************************************************************
+ * test_nmea2000.cpp
+ *
+ * NMEA2000 identifier codec, fast-packet transport, address claim
+ * and PGN codec, plus a bus capture replayed through the decoder
+ * (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "EBC_Utils.h"
+#include "capture.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define BUS_FRAMES_PER_SEC 1953  // 250 kbit/s, 128 bit extended frames back to back
+#define BENCHMARK_ROUNDS 2000
+
+typedef struct {
+  uint32_t ms;
+  uint32_t id;
+  uint8_t length;
+  uint8_t data[8];
+} capture_frame_t;
+
+typedef struct {
+  uint32_t frames;
+  uint32_t messages;
+  uint32_t rudder;
+  uint32_t thruster;
+  uint32_t engine_rapid;
+  uint32_t engine_dynamic;
+  uint32_t claims;
+  uint32_t requests;
+  uint32_t unknown;
+  double values[N2K_ENGINE_FIELDS];  // Last engine dynamic message
+  double rudder_position;
+  double thruster_values[N2K_THRUSTER_FIELDS];
+} decoder_t;
+
+static capture_frame_t frames[CAPTURE_FRAMES];
+static N2K_fp_pool_t pool;
+
+static int hex(char c) {
+  return (c <= '9') ? c - '0' : (c & ~0x20) - 'A' + 10;
+}
+
+/*******************************************************************
+ * Parses the capture, timestamps relative to the first frame
+ *******************************************************************/
+static void capture_load(void) {
+  double first = 0;
+
+  for (unsigned i = 0; i < CAPTURE_FRAMES; i++) {
+    double seconds;
+    unsigned id;
+    char payload[20];
+
+    TEST_ASSERT_EQUAL(3, sscanf(capture[i], "(%lf) %*s %x#%19s", &seconds, &id, payload));
+    if (i == 0)
+      first = seconds;
+
+    frames[i].ms = (uint32_t)lround((seconds - first) * 1000.0);
+    frames[i].id = id;
+    frames[i].length = (uint8_t)(strlen(payload) / 2);
+    for (int b = 0; b < frames[i].length; b++)
+      frames[i].data[b] = (uint8_t)((hex(payload[2 * b]) << 4) | hex(payload[2 * b + 1]));
+  }
+}
+
+/*******************************************************************
+ * Decoder as the TWAI glue runs it
+ *******************************************************************/
+static void decode_message(decoder_t *dec, const N2K_header_t *header, const uint8_t *data, uint8_t length) {
+  const N2K_pgn_t *pgn;
+  double values[N2K_ENGINE_FIELDS];
+
+  dec->messages++;
+
+  switch (header->pgn) {
+    case N2K_PGN_ADDRESS_CLAIM:
+      dec->claims++;
+      return;
+    case N2K_PGN_ISO_REQUEST:
+      dec->requests++;
+      return;
+  }
+
+  if (!(pgn = N2K_pgn_find(header->pgn))) {
+    dec->unknown++;
+    return;
+  }
+
+  N2K_decode(pgn, data, length, values);
+
+  switch (header->pgn) {
+    case N2K_PGN_RUDDER:
+      dec->rudder++;
+      dec->rudder_position = values[N2K_RUDDER_POSITION];
+      break;
+    case N2K_PGN_THRUSTER_STATUS:
+      dec->thruster++;
+      memcpy(dec->thruster_values, values, sizeof(dec->thruster_values));
+      break;
+    case N2K_PGN_ENGINE_RAPID:
+      dec->engine_rapid++;
+      break;
+    case N2K_PGN_ENGINE_DYNAMIC:
+      dec->engine_dynamic++;
+      memcpy(dec->values, values, sizeof(dec->values));
+      break;
+  }
+}
+
+static void decode_frame(decoder_t *dec, const capture_frame_t *f) {
+  N2K_header_t header;
+  N2K_message_t message;
+  const N2K_pgn_t *pgn;
+
+  dec->frames++;
+  N2K_id_decode(f->id, &header);
+
+  pgn = N2K_pgn_find(header.pgn);
+  if (pgn && pgn->fast) {
+    if (N2K_fp_receive(&pool, &header, f->data, f->length, f->ms, &message))
+      decode_message(dec, &message.header, message.data, message.length);
+    return;
+  }
+  decode_message(dec, &header, f->data, f->length);
+}
+
+void setUp(void) {
+  N2K_fp_init(&pool);
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Identifier, PDU1 carries a destination, PDU2 does not
+ *******************************************************************/
+void test_identifier(void) {
+  N2K_header_t header;
+
+  N2K_id_decode(0x09F10D20, &header);
+  TEST_ASSERT_EQUAL(2, header.priority);
+  TEST_ASSERT_EQUAL(N2K_PGN_RUDDER, header.pgn);
+  TEST_ASSERT_EQUAL(0x20, header.source);
+  TEST_ASSERT_EQUAL(N2K_ADDRESS_GLOBAL, header.destination);
+  TEST_ASSERT_EQUAL_HEX32(0x09F10D20, N2K_id_encode(&header));
+
+  N2K_id_decode(0x18EA2305, &header);
+  TEST_ASSERT_EQUAL(6, header.priority);
+  TEST_ASSERT_EQUAL(N2K_PGN_ISO_REQUEST, header.pgn);
+  TEST_ASSERT_EQUAL(0x05, header.source);
+  TEST_ASSERT_EQUAL(0x23, header.destination);
+  TEST_ASSERT_EQUAL_HEX32(0x18EA2305, N2K_id_encode(&header));
+}
+
+/*******************************************************************
+ * TC Fast-packet round trip for every payload length
+ *******************************************************************/
+void test_fast_packet_round_trip(void) {
+  N2K_header_t header = {2, N2K_PGN_ENGINE_DYNAMIC, 0x42, N2K_ADDRESS_GLOBAL};
+  N2K_message_t message;
+  uint8_t payload[N2K_FAST_PACKET_MAX];
+  uint8_t frame[8];
+
+  for (int i = 0; i < N2K_FAST_PACKET_MAX; i++)
+    payload[i] = (uint8_t)(i * 7 + 3);
+
+  TEST_ASSERT_EQUAL(1, N2K_fp_frames(6));
+  TEST_ASSERT_EQUAL(2, N2K_fp_frames(7));
+  TEST_ASSERT_EQUAL(4, N2K_fp_frames(26));
+  TEST_ASSERT_EQUAL(32, N2K_fp_frames(N2K_FAST_PACKET_MAX));
+
+  for (int length = 0; length <= N2K_FAST_PACKET_MAX; length++) {
+    const uint8_t frames_needed = N2K_fp_frames((uint8_t)length);
+    bool complete = false;
+
+    for (uint8_t index = 0; index < frames_needed; index++) {
+      N2K_fp_frame((uint8_t)(length & 7), payload, (uint8_t)length, index, frame);
+      TEST_ASSERT_FALSE(complete);
+      complete = N2K_fp_receive(&pool, &header, frame, 8, 0, &message);
+    }
+
+    TEST_ASSERT_TRUE(complete);
+    TEST_ASSERT_EQUAL(length, message.length);
+    TEST_ASSERT_EQUAL(0x42, message.header.source);
+    if (length)
+      TEST_ASSERT_EQUAL_MEMORY(payload, message.data, length);
+  }
+
+  TEST_ASSERT_EQUAL(N2K_FAST_PACKET_MAX + 1, pool.completed);
+  TEST_ASSERT_EQUAL(0, pool.lost);
+}
+
+/*******************************************************************
+ * TC Lost frames, a full pool and stale slots
+ *******************************************************************/
+void test_fast_packet_errors(void) {
+  N2K_header_t header = {2, N2K_PGN_ENGINE_DYNAMIC, 0, N2K_ADDRESS_GLOBAL};
+  N2K_message_t message;
+  uint8_t payload[26] = {0};
+  uint8_t frame[8];
+
+  /* Frame 1 missing, frame 2 is dropped with the slot */
+  N2K_fp_frame(1, payload, sizeof(payload), 0, frame);
+  TEST_ASSERT_FALSE(N2K_fp_receive(&pool, &header, frame, 8, 0, &message));
+  N2K_fp_frame(1, payload, sizeof(payload), 2, frame);
+  TEST_ASSERT_FALSE(N2K_fp_receive(&pool, &header, frame, 8, 0, &message));
+  TEST_ASSERT_EQUAL(1, pool.lost);
+  N2K_fp_frame(1, payload, sizeof(payload), 3, frame);
+  TEST_ASSERT_FALSE(N2K_fp_receive(&pool, &header, frame, 8, 0, &message));
+  TEST_ASSERT_EQUAL(1, pool.lost);
+
+  /* Fill the pool from different sources */
+  N2K_fp_frame(2, payload, sizeof(payload), 0, frame);
+  for (int source = 0; source < N2K_FP_SLOTS; source++) {
+    header.source = (uint8_t)source;
+    TEST_ASSERT_FALSE(N2K_fp_receive(&pool, &header, frame, 8, 100, &message));
+  }
+  header.source = N2K_FP_SLOTS;
+  TEST_ASSERT_FALSE(N2K_fp_receive(&pool, &header, frame, 8, 100 + N2K_FP_TIMEOUT, &message));
+  TEST_ASSERT_EQUAL(1, pool.dropped);
+
+  /* Stale slot is taken over */
+  TEST_ASSERT_FALSE(N2K_fp_receive(&pool, &header, frame, 8, 101 + N2K_FP_TIMEOUT, &message));
+  TEST_ASSERT_EQUAL(1, pool.timeouts);
+  for (uint8_t index = 1; index < 4; index++) {
+    N2K_fp_frame(2, payload, sizeof(payload), index, frame);
+    N2K_fp_receive(&pool, &header, frame, 8, 102 + N2K_FP_TIMEOUT, &message);
+  }
+  TEST_ASSERT_EQUAL(1, pool.completed);
+
+  /* Announced length beyond the maximum */
+  frame[0] = 0;
+  frame[1] = N2K_FAST_PACKET_MAX + 1;
+  TEST_ASSERT_FALSE(N2K_fp_receive(&pool, &header, frame, 8, 0, &message));
+  TEST_ASSERT_EQUAL(2, pool.lost);
+}
+
+/*******************************************************************
+ * TC Address claim contention
+ *******************************************************************/
+void test_address_claim(void) {
+  N2K_name_fields_t fields = {12345, 229, 0, 150, 40, 0, 4, true};
+  const uint64_t name = N2K_name(&fields);
+  N2K_claim_t claim;
+  uint8_t data[8];
+
+  TEST_ASSERT_EQUAL_HEX32(0xC0509600, (uint32_t)(name >> 32));
+  N2K_name_encode(name, data);
+  TEST_ASSERT_TRUE(name == N2K_name_decode(data, 8));
+
+  N2K_claim_init(&claim, name, 35);
+  TEST_ASSERT_EQUAL(35, claim.address);
+
+  /* Other address or own claim echoed, nothing to do */
+  TEST_ASSERT_FALSE(N2K_claim_received(&claim, 36, name - 1));
+  TEST_ASSERT_FALSE(N2K_claim_received(&claim, 35, name));
+
+  /* Higher NAME loses, address is defended */
+  TEST_ASSERT_TRUE(N2K_claim_received(&claim, 35, name + 1));
+  TEST_ASSERT_EQUAL(35, claim.address);
+
+  /* Lower NAME wins, move on */
+  TEST_ASSERT_TRUE(N2K_claim_received(&claim, 35, name - 1));
+  TEST_ASSERT_EQUAL(36, claim.address);
+  TEST_ASSERT_EQUAL(2, claim.conflicts);
+
+  /* Wraps to 0, gives up when back at the preferred address */
+  N2K_claim_init(&claim, name, N2K_ADDRESS_MAX);
+  TEST_ASSERT_TRUE(N2K_claim_received(&claim, N2K_ADDRESS_MAX, 0));
+  TEST_ASSERT_EQUAL(0, claim.address);
+  claim.preferred = 1;
+  TEST_ASSERT_TRUE(N2K_claim_received(&claim, 0, 0));
+  TEST_ASSERT_EQUAL(N2K_ADDRESS_NULL, claim.address);
+  TEST_ASSERT_FALSE(N2K_claim_received(&claim, N2K_ADDRESS_NULL, 0));
+
+  /* Not arbitrary address capable, cannot claim at once */
+  fields.arbitrary_address = false;
+  N2K_claim_init(&claim, N2K_name(&fields), 35);
+  TEST_ASSERT_TRUE(N2K_claim_received(&claim, 35, 0));
+  TEST_ASSERT_EQUAL(N2K_ADDRESS_NULL, claim.address);
+}
+
+/*******************************************************************
+ * TC ISO request and NAK
+ *******************************************************************/
+void test_request(void) {
+  uint8_t data[8];
+  uint32_t pgn;
+
+  N2K_request_encode(N2K_PGN_THRUSTER_STATUS, data);
+  TEST_ASSERT_TRUE(N2K_request_decode(data, 3, &pgn));
+  TEST_ASSERT_EQUAL(N2K_PGN_THRUSTER_STATUS, pgn);
+  TEST_ASSERT_FALSE(N2K_request_decode(data, 2, &pgn));
+
+  N2K_nak_encode(130306, data);
+  TEST_ASSERT_EQUAL(1, data[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x02, data[5]);
+  TEST_ASSERT_EQUAL_HEX8(0xFD, data[6]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, data[7]);
+}
+
+/*******************************************************************
+ * TC PGN codec, round trip, clamping and not available
+ *******************************************************************/
+void test_codec(void) {
+  const N2K_pgn_t *pgn = N2K_pgn_find(N2K_PGN_THRUSTER_STATUS);
+  double values[N2K_ENGINE_FIELDS];
+  double decoded[N2K_ENGINE_FIELDS];
+  uint8_t data[N2K_FAST_PACKET_MAX];
+
+  TEST_ASSERT_NOT_NULL(pgn);
+  TEST_ASSERT_NULL(N2K_pgn_find(130306));
+
+  values[N2K_THRUSTER_SID] = 7;
+  values[N2K_THRUSTER_IDENTIFIER] = 1;
+  values[N2K_THRUSTER_DIRECTION] = 1;
+  values[N2K_THRUSTER_POWER] = 1;
+  values[N2K_THRUSTER_RETRACT] = 2;
+  values[N2K_THRUSTER_SPEED] = NAN;
+  values[N2K_THRUSTER_EVENTS] = 0;
+  values[N2K_THRUSTER_TIMEOUT] = 1.0;
+  values[N2K_THRUSTER_AZIMUTH] = 1.5708;
+
+  TEST_ASSERT_EQUAL(8, N2K_encode(pgn, values, data));
+  TEST_ASSERT_EQUAL_HEX8(0x91, data[2]);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, data[3]);
+  TEST_ASSERT_EQUAL(N2K_THRUSTER_FIELDS, N2K_decode(pgn, data, 8, decoded));
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 2, decoded[N2K_THRUSTER_RETRACT]);
+  TEST_ASSERT_TRUE(isnan(decoded[N2K_THRUSTER_SPEED]));
+  TEST_ASSERT_FLOAT_WITHIN(0.00005, 1.5708, decoded[N2K_THRUSTER_AZIMUTH]);
+  TEST_ASSERT_FLOAT_WITHIN(0.0025, 1.0, decoded[N2K_THRUSTER_TIMEOUT]);
+
+  /* Signed fields, clamped short of the not available code */
+  pgn = N2K_pgn_find(N2K_PGN_RUDDER);
+  values[N2K_RUDDER_INSTANCE] = 0;
+  values[N2K_RUDDER_DIRECTION] = NAN;
+  values[N2K_RUDDER_ANGLE_ORDER] = 100.0;
+  values[N2K_RUDDER_POSITION] = -0.5236;
+  N2K_encode(pgn, values, data);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, data[1]);  // Direction and reserved bits
+  N2K_decode(pgn, data, 8, decoded);
+  TEST_ASSERT_FLOAT_WITHIN(0.00005, 3.2766, decoded[N2K_RUDDER_ANGLE_ORDER]);
+  TEST_ASSERT_FLOAT_WITHIN(0.00005, -0.5236, decoded[N2K_RUDDER_POSITION]);
+
+  /* Short payload, missing fields */
+  TEST_ASSERT_EQUAL(3, N2K_decode(pgn, data, 4, decoded));
+  TEST_ASSERT_TRUE(isnan(decoded[N2K_RUDDER_POSITION]));
+
+  /* Fast-packet PGN with a 32 bit field */
+  pgn = N2K_pgn_find(N2K_PGN_ENGINE_DYNAMIC);
+  for (int i = 0; i < N2K_ENGINE_FIELDS; i++)
+    values[i] = NAN;
+  values[N2K_ENGINE_HOURS] = 3600000.0;
+  values[N2K_ENGINE_ALTERNATOR] = -1.5;
+  TEST_ASSERT_EQUAL(26, N2K_encode(pgn, values, data));
+  N2K_decode(pgn, data, 26, decoded);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 3600000.0, decoded[N2K_ENGINE_HOURS]);
+  TEST_ASSERT_FLOAT_WITHIN(0.005, -1.5, decoded[N2K_ENGINE_ALTERNATOR]);
+  TEST_ASSERT_TRUE(isnan(decoded[N2K_ENGINE_TORQUE]));
+}
+
+/*******************************************************************
+ * TC Capture replay, decoded values
+ *******************************************************************/
+void test_capture(void) {
+  decoder_t dec = {};
+
+  capture_load();
+  for (unsigned i = 0; i < CAPTURE_FRAMES; i++)
+    decode_frame(&dec, &frames[i]);
+
+  TEST_ASSERT_EQUAL(CAPTURE_FRAMES, dec.frames);
+  TEST_ASSERT_EQUAL(4, dec.claims);
+  TEST_ASSERT_EQUAL(1, dec.requests);
+  TEST_ASSERT_EQUAL(20, dec.rudder);
+  TEST_ASSERT_EQUAL(20, dec.thruster);
+  TEST_ASSERT_EQUAL(20, dec.engine_rapid);
+  TEST_ASSERT_EQUAL(40, dec.unknown);
+  TEST_ASSERT_EQUAL(7, dec.engine_dynamic);  // One of engine 1 lost a frame
+  TEST_ASSERT_EQUAL(1, pool.lost);
+
+  /* Last message, engine 1 at 1.52s */
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1, dec.values[N2K_ENGINE_INSTANCE]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 654336, dec.values[N2K_ENGINE_HOURS]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 363.15, dec.values[N2K_ENGINE_TEMPERATURE]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 14.2, dec.values[N2K_ENGINE_ALTERNATOR]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 400000, dec.values[N2K_ENGINE_OIL_PRESSURE]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 45, dec.values[N2K_ENGINE_LOAD]);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 300000, dec.values[N2K_ENGINE_FUEL_PRESSURE]);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, sin(19 / 3.0) * 0.3, dec.rudder_position);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 2, dec.thruster_values[N2K_THRUSTER_RETRACT]);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001, M_PI / 2 + 0.19, dec.thruster_values[N2K_THRUSTER_AZIMUTH]);
+}
+
+/*******************************************************************
+ * TC Capture replay, decoder throughput against a full bus
+ *******************************************************************/
+void test_capture_throughput(void) {
+  decoder_t dec = {};
+  char text[128];
+
+  capture_load();
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+    for (unsigned i = 0; i < CAPTURE_FRAMES; i++) {
+      capture_frame_t f = frames[i];
+      f.ms += (uint32_t)round * 2000;
+      decode_frame(&dec, &f);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  const double seconds = std::chrono::duration<double>(end - begin).count();
+  const double rate = dec.frames / seconds;
+
+  snprintf(text, sizeof(text), "%u frames, %.0f frames/s, %.0fx a full 250 kbit/s bus", (unsigned)dec.frames, rate,
+           rate / BUS_FRAMES_PER_SEC);
+  TEST_MESSAGE(text);
+
+  TEST_ASSERT_EQUAL(BENCHMARK_ROUNDS * 7, dec.engine_dynamic);
+  TEST_ASSERT_TRUE(rate > 100.0 * BUS_FRAMES_PER_SEC);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_identifier);
+  RUN_TEST(test_fast_packet_round_trip);
+  RUN_TEST(test_fast_packet_errors);
+  RUN_TEST(test_address_claim);
+  RUN_TEST(test_request);
+  RUN_TEST(test_codec);
+  RUN_TEST(test_capture);
+  RUN_TEST(test_capture_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+/*******************************************************************
+ * test_page.cpp
+ *
+ * Page template rendering, entity tags and media types (host, pio
+ * test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+static const char TEMPLATE[] =
+    "<html><head><title>...</title></head><body>\n"
+    "<p>Program: <span id=\"program_name\">-</span></p>\n"
+    "<p>IP address: <span id=\"ip_address\">-</span></p>\n"
+    "<p><!--build--></p>\n"
+    "</body></html>\n";
+
+static const PAGE_field_t FIELDS[] = {
+    {"<span id=\"program_name\">", "</span>", "EBC-Retractable"},
+    {"<span id=\"ip_address\">", "</span>", "192.168.4.1"},
+    {"<!--build-->", nullptr, "A0.4"},
+    {"<title>", "</title>", "EBC-RCU"},
+};
+#define NUM_FIELDS (int)(sizeof(FIELDS) / sizeof(FIELDS[0]))
+
+static const char RENDERED[] =
+    "<html><head><title>EBC-RCU</title></head><body>\n"
+    "<p>Program: <span id=\"program_name\">EBC-Retractable</span></p>\n"
+    "<p>IP address: <span id=\"ip_address\">192.168.4.1</span></p>\n"
+    "<p>A0.4</p>\n"
+    "</body></html>\n";
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+/*******************************************************************
+ * TC Fields are replaced, markers kept, length measured up front
+ *******************************************************************/
+void test_render(void) {
+  char page[512];
+  const int length = PAGE_render(TEMPLATE, (int)strlen(TEMPLATE), FIELDS, NUM_FIELDS, nullptr, 0);
+
+  TEST_ASSERT_EQUAL((int)strlen(RENDERED), length);
+  TEST_ASSERT_EQUAL(length, PAGE_render(TEMPLATE, (int)strlen(TEMPLATE), FIELDS, NUM_FIELDS, page, length + 1));
+  TEST_ASSERT_EQUAL_STRING(RENDERED, page);
+
+  /* One byte short */
+  TEST_ASSERT_EQUAL(-1, PAGE_render(TEMPLATE, (int)strlen(TEMPLATE), FIELDS, NUM_FIELDS, page, length));
+  TEST_ASSERT_EQUAL_STRING("", page);
+}
+
+/*******************************************************************
+ * TC Unknown or unclosed markers are left as is
+ *******************************************************************/
+void test_unmatched(void) {
+  const char source[] = "<title>open <span id=\"ip_address\">- <!--build";
+  char page[128];
+
+  TEST_ASSERT_EQUAL((int)strlen(source),
+                    PAGE_render(source, (int)strlen(source), FIELDS, NUM_FIELDS, page, sizeof(page)));
+  TEST_ASSERT_EQUAL_STRING(source, page);
+
+  /* Not terminated, only the given length */
+  TEST_ASSERT_EQUAL(7, PAGE_render("<!--build-->", 7, FIELDS, NUM_FIELDS, page, sizeof(page)));
+  TEST_ASSERT_EQUAL_STRING("<!--bui", page);
+  TEST_ASSERT_EQUAL(0, PAGE_render("", 0, FIELDS, NUM_FIELDS, page, sizeof(page)));
+}
+
+/*******************************************************************
+ * TC Entity tags
+ *******************************************************************/
+void test_etag(void) {
+  char etag[PAGE_ETAG_SIZE];
+  char other[PAGE_ETAG_SIZE];
+  char header[64];
+
+  PAGE_etag(PAGE_hash(PAGE_HASH_INIT, RENDERED, (int)strlen(RENDERED)), etag);
+  TEST_ASSERT_EQUAL(PAGE_ETAG_SIZE - 1, (int)strlen(etag));
+  TEST_ASSERT_EQUAL('"', etag[0]);
+  TEST_ASSERT_EQUAL('"', etag[PAGE_ETAG_SIZE - 2]);
+
+  /* Another address, another tag */
+  PAGE_etag(PAGE_hash(PAGE_HASH_INIT, TEMPLATE, (int)strlen(TEMPLATE)), other);
+  TEST_ASSERT_TRUE(strcmp(etag, other) != 0);
+
+  /* Hashed in chunks, as a file is read */
+  const int half = (int)strlen(TEMPLATE) / 2;
+  PAGE_etag(PAGE_hash(PAGE_hash(PAGE_HASH_INIT, TEMPLATE, half), &TEMPLATE[half], (int)strlen(TEMPLATE) - half),
+            header);
+  TEST_ASSERT_EQUAL_STRING(other, header);
+
+  TEST_ASSERT_TRUE(PAGE_etag_match(etag, etag));
+  TEST_ASSERT_TRUE(PAGE_etag_match("*", etag));
+  snprintf(header, sizeof(header), "%s , W/%s ", other, etag);
+  TEST_ASSERT_TRUE(PAGE_etag_match(header, etag));
+  TEST_ASSERT_FALSE(PAGE_etag_match(other, etag));
+  TEST_ASSERT_FALSE(PAGE_etag_match("", etag));
+  TEST_ASSERT_FALSE(PAGE_etag_match(nullptr, etag));
+}
+
+/*******************************************************************
+ * TC Media types
+ *******************************************************************/
+void test_content_type(void) {
+  TEST_ASSERT_EQUAL_STRING("text/html", PAGE_content_type("/web/maintenance/index.html"));
+  TEST_ASSERT_EQUAL_STRING("text/css", PAGE_content_type("/web/maintenance/style.css"));
+  TEST_ASSERT_EQUAL_STRING("text/javascript", PAGE_content_type("/web/maintenance/websocket.js"));
+  TEST_ASSERT_EQUAL_STRING("application/json", PAGE_content_type("data.JSON"));
+  TEST_ASSERT_EQUAL_STRING("image/svg+xml", PAGE_content_type("logo.svg"));
+  TEST_ASSERT_EQUAL_STRING("font/woff2", PAGE_content_type("font.woff2"));
+  TEST_ASSERT_EQUAL_STRING("application/gzip", PAGE_content_type("style.css.gz"));
+  TEST_ASSERT_EQUAL_STRING("application/octet-stream", PAGE_content_type("/web.d/README"));
+  TEST_ASSERT_EQUAL_STRING("application/octet-stream", PAGE_content_type("firmware.elf"));
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_render);
+  RUN_TEST(test_unmatched);
+  RUN_TEST(test_etag);
+  RUN_TEST(test_content_type);
+  return UNITY_END();
+}
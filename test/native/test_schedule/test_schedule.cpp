@@ -0,0 +1,210 @@
+/*******************************************************************
+ * test_schedule.cpp
+ *
+ * CAN transmit schedule, release order, phase, jitter and deadline
+ * statistics against a simulated clock (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define MS 1000  // Clock in microseconds
+
+static SCHED_table_t table;
+
+static CAN_frame_t frame(uint32_t id) {
+  CAN_frame_t f = {};
+  f.id = id;
+  f.length = 2;
+  return f;
+}
+
+/*******************************************************************
+ * Runs the schedule from `start` to `end`, served every `step`,
+ * returns the identifiers in send order
+ *******************************************************************/
+static std::vector<uint32_t> run(uint32_t start, uint32_t end, uint32_t step) {
+  std::vector<uint32_t> sent;
+  CAN_frame_t f;
+
+  for (uint32_t now = start; (int32_t)(end - now) >= 0; now += step) {
+    while (SCHED_next(&table, now, &f) >= 0)
+      sent.push_back(f.id);
+  }
+  return sent;
+}
+
+static bool counter(CAN_frame_t *f, void *context) {
+  uint8_t *count = (uint8_t *)context;
+  f->data[0] = ++(*count);
+  return true;
+}
+
+static bool every_other(CAN_frame_t *f, void *context) {
+  int *calls = (int *)context;
+  (void)f;
+  return ((*calls)++ & 1) == 0;
+}
+
+void setUp(void) {
+  SCHED_init(&table);
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Period and phase
+ *******************************************************************/
+void test_period_phase(void) {
+  CAN_frame_t f = frame(0x100);
+
+  TEST_ASSERT_EQUAL(0, SCHED_add(&table, "a", &f, 100 * MS, 0, 1, nullptr, nullptr, 0));
+  f.id = 0x200;
+  TEST_ASSERT_EQUAL(1, SCHED_add(&table, "b", &f, 100 * MS, 50 * MS, 1, nullptr, nullptr, 0));
+
+  std::vector<uint32_t> sent = run(0, 399 * MS, MS);
+
+  TEST_ASSERT_EQUAL(8, sent.size());
+  for (size_t i = 0; i < sent.size(); i++)
+    TEST_ASSERT_EQUAL((i & 1) ? 0x200 : 0x100, sent[i]);
+
+  TEST_ASSERT_EQUAL(4, table.entry[0].sent);
+  TEST_ASSERT_EQUAL(0, table.entry[0].jitter_max);
+  TEST_ASSERT_EQUAL(0, table.entry[0].missed);
+  TEST_ASSERT_EQUAL(1, table.backlog_max);
+  TEST_ASSERT_EQUAL(1 * MS, SCHED_wait(&table, 399 * MS));
+}
+
+/*******************************************************************
+ * TC Priority decides between frames due at the same time,
+ * one-shot frames merge into the timeline
+ *******************************************************************/
+void test_priority_oneshot(void) {
+  CAN_frame_t f = frame(0x300);
+  CAN_frame_t out;
+
+  SCHED_add(&table, "low", &f, 10 * MS, 0, 5, nullptr, nullptr, 0);
+  f.id = 0x050;
+  SCHED_add(&table, "high", &f, 10 * MS, 0, 0, nullptr, nullptr, 0);
+  f.id = 0x7FF;
+  TEST_ASSERT_EQUAL(2, SCHED_once(&table, &f, 3, 0, 0));
+
+  TEST_ASSERT_EQUAL(1, SCHED_next(&table, 0, &out));
+  TEST_ASSERT_EQUAL(0x050, out.id);
+  TEST_ASSERT_EQUAL(3, table.backlog);
+  TEST_ASSERT_EQUAL(2, SCHED_next(&table, 0, &out));
+  TEST_ASSERT_EQUAL(0x7FF, out.id);
+  TEST_ASSERT_EQUAL(0, SCHED_next(&table, 0, &out));
+  TEST_ASSERT_EQUAL(0x300, out.id);
+  TEST_ASSERT_EQUAL(-1, SCHED_next(&table, 0, &out));
+
+  /* One-shot slot is free again */
+  TEST_ASSERT_EQUAL(2, table.num_entries);
+  TEST_ASSERT_EQUAL(2, SCHED_once(&table, &f, 3, 0, 5 * MS));
+  TEST_ASSERT_EQUAL(0, SCHED_wait(&table, 5 * MS));
+}
+
+/*******************************************************************
+ * TC Producer updates the payload in place, or skips a release
+ *******************************************************************/
+void test_producer(void) {
+  CAN_frame_t f = frame(0x123);
+  CAN_frame_t out;
+  uint8_t count = 0;
+  int calls = 0;
+
+  SCHED_add(&table, "count", &f, 10 * MS, 0, 0, counter, &count, 0);
+  for (int i = 1; i <= 3; i++) {
+    TEST_ASSERT_EQUAL(0, SCHED_next(&table, (i - 1) * 10 * MS, &out));
+    TEST_ASSERT_EQUAL(i, out.data[0]);
+    TEST_ASSERT_EQUAL(i, table.entry[0].frame.data[0]);
+  }
+
+  SCHED_init(&table);
+  SCHED_add(&table, "skip", &f, 10 * MS, 0, 0, every_other, &calls, 0);
+  std::vector<uint32_t> sent = run(0, 99 * MS, MS);
+
+  TEST_ASSERT_EQUAL(5, sent.size());
+  TEST_ASSERT_EQUAL(5, table.entry[0].skipped);
+  TEST_ASSERT_EQUAL(0, table.entry[0].missed);
+}
+
+/*******************************************************************
+ * TC Late service gives jitter, a stall gives deadline misses
+ *******************************************************************/
+void test_jitter_deadline(void) {
+  CAN_frame_t f = frame(0x010);
+  CAN_frame_t out;
+
+  SCHED_add(&table, "hb", &f, 100 * MS, 0, 0, nullptr, nullptr, 0);
+
+  TEST_ASSERT_EQUAL(0, SCHED_next(&table, 0, &out));
+  TEST_ASSERT_EQUAL(0, SCHED_next(&table, 103 * MS, &out));  // 3ms late
+  TEST_ASSERT_EQUAL(3 * MS, table.entry[0].jitter_last);
+  TEST_ASSERT_EQUAL(0, SCHED_next(&table, 200 * MS, &out));  // Next release on time
+  TEST_ASSERT_EQUAL(3 * MS, table.entry[0].jitter_last);
+  TEST_ASSERT_EQUAL(0, table.entry[0].missed);
+
+  /* Stall of 2.5 periods, releases at 300 and 400 are merged */
+  TEST_ASSERT_EQUAL(0, SCHED_next(&table, 450 * MS, &out));
+  TEST_ASSERT_EQUAL(-1, SCHED_next(&table, 450 * MS, &out));
+  TEST_ASSERT_EQUAL(2, table.entry[0].missed);
+  TEST_ASSERT_EQUAL(150 * MS, table.entry[0].jitter_max);
+  TEST_ASSERT_EQUAL(50 * MS, SCHED_wait(&table, 450 * MS));
+
+  SCHED_reset_stats(&table);
+  TEST_ASSERT_EQUAL(0, table.entry[0].missed);
+  TEST_ASSERT_EQUAL(0, table.entry[0].jitter_max);
+}
+
+/*******************************************************************
+ * TC Wrap-around of the clock
+ *******************************************************************/
+void test_wrap(void) {
+  CAN_frame_t f = frame(0x020);
+  const uint32_t start = UINT32_MAX - 250 * MS;
+
+  SCHED_add(&table, "wrap", &f, 100 * MS, 0, 0, nullptr, nullptr, start);
+  std::vector<uint32_t> sent = run(start, start + 499 * MS, MS);
+
+  TEST_ASSERT_EQUAL(5, sent.size());
+  TEST_ASSERT_EQUAL(0, table.entry[0].jitter_max);
+  TEST_ASSERT_EQUAL(0, table.entry[0].missed);
+}
+
+/*******************************************************************
+ * TC Full schedule, empty schedule
+ *******************************************************************/
+void test_full(void) {
+  CAN_frame_t f = frame(0x001);
+
+  TEST_ASSERT_EQUAL(SCHED_IDLE, SCHED_wait(&table, 0));
+  TEST_ASSERT_EQUAL(-1, SCHED_add(&table, "zero", &f, 0, 0, 0, nullptr, nullptr, 0));
+
+  for (int i = 0; i < SCHED_MAX_ENTRIES; i++)
+    TEST_ASSERT_EQUAL(i, SCHED_add(&table, "n", &f, 10 * MS, i * MS, 0, nullptr, nullptr, 0));
+
+  TEST_ASSERT_EQUAL(-1, SCHED_once(&table, &f, 0, 0, 0));
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_period_phase);
+  RUN_TEST(test_priority_oneshot);
+  RUN_TEST(test_producer);
+  RUN_TEST(test_jitter_deadline);
+  RUN_TEST(test_wrap);
+  RUN_TEST(test_full);
+  return UNITY_END();
+}
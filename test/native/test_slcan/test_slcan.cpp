@@ -0,0 +1,179 @@
+/*******************************************************************
+ * test_slcan.cpp
+ *
+ * SLCAN line reader, command parser and frame formatter (host,
+ * pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+static SLCAN_reader_t reader;
+
+/*******************************************************************
+ * Feeds text to the reader, returns the number of complete lines,
+ * the last one is left in reader.line
+ *******************************************************************/
+static int feed(const char *text) {
+  int lines = 0;
+
+  while (*text) {
+    if (SLCAN_reader_put(&reader, *text++))
+      lines++;
+  }
+  return lines;
+}
+
+void setUp(void) {
+  SLCAN_reader_init(&reader);
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Line reader, split input, empty and too long lines
+ *******************************************************************/
+void test_reader(void) {
+  TEST_ASSERT_EQUAL(0, feed("t1230"));
+  TEST_ASSERT_EQUAL(1, feed("\r"));
+  TEST_ASSERT_EQUAL_STRING("t1230", reader.line);
+
+  TEST_ASSERT_EQUAL(0, feed("\r\r\n"));
+
+  TEST_ASSERT_EQUAL(2, feed("O\rT1234567881122334455667788999999999999\rC\r"));
+  TEST_ASSERT_EQUAL_STRING("C", reader.line);
+  TEST_ASSERT_EQUAL(1, reader.overflows);
+}
+
+/*******************************************************************
+ * TC Transmit commands
+ *******************************************************************/
+void test_parse_frame(void) {
+  CAN_frame_t frame;
+  uint32_t argument;
+  const uint8_t data[] = {0x11, 0x22, 0xAB};
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_TRANSMIT, SLCAN_parse("t1233112233", &frame, &argument));
+  TEST_ASSERT_EQUAL_HEX32(0x123, frame.id);
+  TEST_ASSERT_EQUAL(0, frame.ext);
+  TEST_ASSERT_EQUAL(0, frame.rtr);
+  TEST_ASSERT_EQUAL(3, frame.length);
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_TRANSMIT, SLCAN_parse("T18EF123431122ab", &frame, &argument));
+  TEST_ASSERT_EQUAL_HEX32(0x18EF1234, frame.id);
+  TEST_ASSERT_EQUAL(1, frame.ext);
+  TEST_ASSERT_EQUAL_MEMORY(data, frame.data, 3);
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_TRANSMIT, SLCAN_parse("r7FF8", &frame, &argument));
+  TEST_ASSERT_EQUAL(1, frame.rtr);
+  TEST_ASSERT_EQUAL(8, frame.length);
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_TRANSMIT, SLCAN_parse("R1FFFFFFF0", &frame, &argument));
+  TEST_ASSERT_EQUAL(1, frame.ext);
+  TEST_ASSERT_EQUAL(0, frame.length);
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("t800", &frame, &argument));         // Identifier > 11 bit
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("T200000000", &frame, &argument));   // Identifier > 29 bit
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("t1239", &frame, &argument));        // Length > 8
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("t123211", &frame, &argument));      // Short data
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("t12311122", &frame, &argument));    // Long data
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("t1231G1", &frame, &argument));      // Not hex
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("t12", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("r12311", &frame, &argument));       // Data on RTR
+}
+
+/*******************************************************************
+ * TC Other commands
+ *******************************************************************/
+void test_parse_commands(void) {
+  CAN_frame_t frame;
+  uint32_t argument;
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_SETUP, SLCAN_parse("S6", &frame, &argument));
+  TEST_ASSERT_EQUAL(500000, argument);
+  TEST_ASSERT_EQUAL(SLCAN_CMD_SETUP, SLCAN_parse("S8", &frame, &argument));
+  TEST_ASSERT_EQUAL(1000000, argument);
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("S9", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("S", &frame, &argument));
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_OPEN, SLCAN_parse("O", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_LISTEN, SLCAN_parse("L", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_CLOSE, SLCAN_parse("C", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("Ox", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_FLAGS, SLCAN_parse("F", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_POLL, SLCAN_parse("A", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_VERSION, SLCAN_parse("V", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_SERIAL, SLCAN_parse("N", &frame, &argument));
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_TIMESTAMP, SLCAN_parse("Z1", &frame, &argument));
+  TEST_ASSERT_EQUAL(1, argument);
+  TEST_ASSERT_EQUAL(SLCAN_CMD_AUTOPOLL, SLCAN_parse("X0", &frame, &argument));
+  TEST_ASSERT_EQUAL(0, argument);
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("Z2", &frame, &argument));
+
+  TEST_ASSERT_EQUAL(SLCAN_CMD_IGNORED, SLCAN_parse("s031C", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_IGNORED, SLCAN_parse("M00000000", &frame, &argument));
+  TEST_ASSERT_EQUAL(SLCAN_CMD_INVALID, SLCAN_parse("?", &frame, &argument));
+}
+
+/*******************************************************************
+ * TC Formatter, round trip through the parser
+ *******************************************************************/
+void test_format(void) {
+  CAN_frame_t in = {};
+  CAN_frame_t out;
+  uint32_t argument;
+  char line[SLCAN_LINE_MAX];
+
+  in.id = 0x18EF1234;
+  in.ext = 1;
+  in.length = 8;
+  for (int i = 0; i < 8; i++)
+    in.data[i] = (uint8_t)(0x11 * (i + 1));
+
+  TEST_ASSERT_EQUAL(27, SLCAN_format(&in, false, 0, line, sizeof(line)));
+  TEST_ASSERT_EQUAL_STRING("T18EF123481122334455667788\r", line);
+
+  TEST_ASSERT_EQUAL(31, SLCAN_format(&in, true, 61234, line, sizeof(line)));
+  TEST_ASSERT_EQUAL_STRING("T18EF12348112233445566778804D2\r", line);
+  TEST_ASSERT_EQUAL(0, SLCAN_format(&in, true, 0, line, 31));  // No room for the terminator
+
+  in.id = 0x07F;
+  in.ext = 0;
+  in.length = 2;
+  SLCAN_format(&in, false, 0, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("t07F21122\r", line);
+
+  in.rtr = 1;
+  SLCAN_format(&in, false, 0, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("r07F2\r", line);
+
+  /* Round trip, without the carriage return */
+  in.rtr = 0;
+  in.id = 0x5A5;
+  in.length = 5;
+  line[SLCAN_format(&in, false, 0, line, sizeof(line)) - 1] = '\0';
+  TEST_ASSERT_EQUAL(SLCAN_CMD_TRANSMIT, SLCAN_parse(line, &out, &argument));
+  TEST_ASSERT_EQUAL_HEX32(in.id, out.id);
+  TEST_ASSERT_EQUAL(in.length, out.length);
+  TEST_ASSERT_EQUAL_MEMORY(in.data, out.data, in.length);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_reader);
+  RUN_TEST(test_parse_frame);
+  RUN_TEST(test_parse_commands);
+  RUN_TEST(test_format);
+  return UNITY_END();
+}
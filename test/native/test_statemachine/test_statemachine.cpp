@@ -0,0 +1,230 @@
+/*******************************************************************
+ * test_statemachine.cpp
+ *
+ * StateMachine vs. StaticStateMachine, equivalence and benchmark
+ * (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "StateMachineLib.h"
+#include "StaticStateMachine.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define BENCHMARK_TICKS 1000000
+#define EQUIVALENCE_TICKS 200000
+
+/*******************************************************************
+ * Controller shaped machine, 9 states and 26 transitions
+ *******************************************************************/
+enum TestStateIds {
+  S_init,
+  S_retracted,
+  S_retracting,
+  S_homing,
+  S_extended,
+  S_extending,
+  S_no_position,
+  S_emergency_stop,
+  S_maintenance,
+  S_NUM_STATES
+};
+
+/* Inputs driven by the test */
+static bool in_up, in_down, in_home, in_button_up, in_button_down, in_estop, in_maintenance, in_timeout;
+
+static bool fnTrue() { return true; }
+static bool fnUp() { return in_up && !in_down; }
+static bool fnNotUp() { return !in_up; }
+static bool fnDown() { return in_down && !in_up; }
+static bool fnNotDown() { return !in_down; }
+static bool fnHome() { return in_home; }
+static bool fnButtonUp() { return in_button_up; }
+static bool fnButtonDown() { return in_button_down; }
+static bool fnEstop() { return in_estop; }
+static bool fnNotEstop() { return !in_estop; }
+static bool fnMaintenance() { return in_maintenance; }
+static bool fnNotMaintenance() { return !in_maintenance; }
+static bool fnTimeout() { return in_timeout; }
+
+static constexpr StaticTransition test_transitions[] = {
+    {S_init, S_no_position, fnTrue},
+
+    {S_no_position, S_extended, fnDown},
+    {S_no_position, S_extending, fnButtonDown},
+    {S_no_position, S_homing, fnButtonUp},
+    {S_no_position, S_retracted, fnUp},
+    {S_no_position, S_emergency_stop, fnEstop},
+    {S_no_position, S_maintenance, fnMaintenance},
+
+    {S_homing, S_retracting, fnHome},
+    {S_homing, S_no_position, fnTimeout},
+    {S_homing, S_emergency_stop, fnEstop},
+
+    {S_retracting, S_retracted, fnUp},
+    {S_retracting, S_no_position, fnTimeout},
+    {S_retracting, S_emergency_stop, fnEstop},
+
+    {S_retracted, S_extending, fnButtonDown},
+    {S_retracted, S_no_position, fnNotUp},
+    {S_retracted, S_emergency_stop, fnEstop},
+    {S_retracted, S_maintenance, fnMaintenance},
+
+    {S_extending, S_extended, fnDown},
+    {S_extending, S_no_position, fnTimeout},
+    {S_extending, S_emergency_stop, fnEstop},
+
+    {S_extended, S_homing, fnButtonUp},
+    {S_extended, S_no_position, fnNotDown},
+    {S_extended, S_emergency_stop, fnEstop},
+    {S_extended, S_maintenance, fnMaintenance},
+
+    {S_emergency_stop, S_no_position, fnNotEstop},
+
+    {S_maintenance, S_no_position, fnNotMaintenance},
+};
+
+static constexpr auto test_table = StaticStateMachineCompile<S_NUM_STATES>(test_transitions);
+static_assert(test_table.Valid, "Invalid state in transition table");
+static_assert(test_table.numTransitions == 26, "Controller has 26 transitions");
+
+static StaticStateMachine<S_NUM_STATES, test_table.numTransitions> static_machine(test_table);
+static StateMachine dynamic_machine(S_NUM_STATES, 26);
+
+/*******************************************************************
+ * Helpers
+ *******************************************************************/
+static void setup_dynamic(void) {
+  for (auto &transition : test_transitions)
+    dynamic_machine.AddTransition(transition.InputState, transition.OutputState, transition.Condition);
+}
+
+static void inputs_clear(void) {
+  in_up = in_down = in_home = in_button_up = in_button_down = false;
+  in_estop = in_maintenance = in_timeout = false;
+}
+
+/* Deterministic pseudo random inputs, events are rare like on the boat */
+static uint32_t lcg_state = 12345;
+static uint32_t lcg_next(void) {
+  lcg_state = lcg_state * 1664525u + 1013904223u;
+  return lcg_state >> 8;
+}
+
+static void inputs_random(void) {
+  uint32_t r = lcg_next();
+
+  in_up = (r & 0x0003) == 0;
+  in_down = (r & 0x000C) == 0;
+  in_home = (r & 0x0030) == 0;
+  in_button_up = (r & 0x03C0) == 0;
+  in_button_down = (r & 0x3C00) == 0;
+  in_estop = (r & 0x3C000) == 0;
+  in_maintenance = (r & 0x3C0000) == 0;
+  in_timeout = (r & 0x0C00000) == 0;
+}
+
+template <typename Machine>
+static double benchmark_ns(Machine &machine, uint8_t state) {
+  volatile bool changed = false;
+
+  machine.SetState(state, false, false);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int tick = 0; tick < BENCHMARK_TICKS; tick++)
+    changed = machine.Update();
+  auto end = std::chrono::steady_clock::now();
+
+  (void)changed;
+  return std::chrono::duration<double, std::nano>(end - begin).count() / BENCHMARK_TICKS;
+}
+
+/*******************************************************************
+ * SUITE SetUp
+ *******************************************************************/
+void setUp(void) {
+  inputs_clear();
+  static_machine.SetState(S_init, false, false);
+  dynamic_machine.SetState(S_init, false, false);
+}
+
+/*******************************************************************
+ * SUITE TearDown
+ *******************************************************************/
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Table is sorted and the spans cover all transitions
+ *******************************************************************/
+void test_table_spans(void) {
+  TEST_ASSERT_EQUAL(0, test_table.First[0]);
+  TEST_ASSERT_EQUAL(26, test_table.First[S_NUM_STATES]);
+
+  for (int state = 0; state < S_NUM_STATES; state++) {
+    for (int i = test_table.First[state]; i < test_table.First[state + 1]; i++)
+      TEST_ASSERT_EQUAL(state, test_table.Transitions[i].InputState);
+  }
+
+  /* Declaration order is kept within a state (priority) */
+  TEST_ASSERT_TRUE(test_table.Transitions[test_table.First[S_no_position]].Condition == fnDown);
+  TEST_ASSERT_TRUE(test_table.Transitions[test_table.First[S_no_position + 1] - 1].Condition == fnMaintenance);
+}
+
+/*******************************************************************
+ * TC Both implementations follow the same states
+ *******************************************************************/
+void test_equivalence(void) {
+  for (int tick = 0; tick < EQUIVALENCE_TICKS; tick++) {
+    inputs_random();
+
+    bool changed_static = static_machine.Update();
+    bool changed_dynamic = dynamic_machine.Update();
+
+    TEST_ASSERT_EQUAL(changed_dynamic, changed_static);
+    TEST_ASSERT_EQUAL(dynamic_machine.GetState(), static_machine.GetState());
+  }
+}
+
+/*******************************************************************
+ * TC Update() cost in steady state (no transition fires)
+ *******************************************************************/
+void test_benchmark(void) {
+  static const uint8_t states[] = {S_no_position, S_retracted, S_extended};
+  static const char *names[] = {"no-position", "retracted", "extended"};
+  char text[128];
+
+  inputs_clear();
+  in_up = true;  // Keeps no-position/retracted/extended stable
+  in_down = true;
+
+  for (unsigned i = 0; i < sizeof(states); i++) {
+    double dynamic_ns = benchmark_ns(dynamic_machine, states[i]);
+    double static_ns = benchmark_ns(static_machine, states[i]);
+
+    snprintf(text, sizeof(text), "%-12s StateMachine: %6.1f ns, StaticStateMachine: %6.1f ns per Update()",
+             names[i], dynamic_ns, static_ns);
+    TEST_MESSAGE(text);
+
+    TEST_ASSERT_EQUAL(states[i], static_machine.GetState());
+    TEST_ASSERT_EQUAL(states[i], dynamic_machine.GetState());
+  }
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  setup_dynamic();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_table_spans);
+  RUN_TEST(test_equivalence);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
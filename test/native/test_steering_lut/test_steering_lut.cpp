@@ -0,0 +1,179 @@
+/*******************************************************************
+ * test_steering_lut.cpp
+ *
+ * Steering lookup table, equivalence with the double map() math
+ * and microbenchmark (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define BENCHMARK_ROUNDS 200
+
+/*******************************************************************
+ * Reference, the steering math before the lookup table
+ * (STEERWHEEL_get_linear() and AZIMUTH_set_steering())
+ *******************************************************************/
+static long arduino_map(long x, long in_min, long in_max, long out_min, long out_max) {
+  const long run = in_max - in_min;
+  if (run == 0) {
+    return -1;
+  }
+  const long rise = out_max - out_min;
+  const long delta = x - in_min;
+  return (delta * rise) / run + out_min;
+}
+
+static long arduino_constrain(long x, long low, long high) {
+  return (x < low) ? low : ((x > high) ? high : x);
+}
+
+static int reference_linear(long value, long left, long middle, long right) {
+  if (((left < middle) && (middle < right)) ||
+      ((left > middle) && (middle > right))) {
+    if (value < middle) {
+      value = (int)arduino_map(value, left, middle, LINEAR_MIN, LINEAR_MIDDLE - 1);
+    } else {
+      value = (int)arduino_map(value, middle, right, LINEAR_MIDDLE, LINEAR_MAX);
+    }
+  }
+
+  value = arduino_constrain(value, LINEAR_MIN, LINEAR_MAX);
+  return value;
+}
+
+static int reference_output(int value, long left, long middle, long right) {
+  if (((left < middle) && (middle < right)) ||
+      ((left > middle) && (middle > right))) {
+    if (value < LINEAR_MIDDLE) {
+      value = arduino_map(value, LINEAR_MIN, LINEAR_MIDDLE, left, middle);
+    } else {
+      value = arduino_map(value, LINEAR_MIDDLE, LINEAR_MAX, middle, right);
+    }
+  }
+
+  value = arduino_constrain(value, 0, 4095);
+  return value;
+}
+
+/*******************************************************************
+ * Calibrations under test
+ *******************************************************************/
+typedef struct {
+  const char *name;
+  STEERING_wheel_cal_t wheel;
+  STEERING_azimuth_cal_t azimuth;
+} calibration_t;
+
+static const calibration_t calibrations[] = {
+    {"defaults", {4095, 2047, 0}, {0, 2047, 4095}},
+    {"typical", {310, 1985, 3720}, {420, 2110, 3650}},
+    {"inverted", {3890, 2002, 140}, {3700, 1900, 300}},
+    {"asymmetric", {100, 600, 4000}, {1000, 1200, 4095}},
+    {"narrow", {2040, 2048, 2056}, {2000, 2048, 2100}},
+    {"not monotonic", {1000, 3000, 2000}, {3000, 1000, 2000}},
+    {"equal", {2048, 2048, 2048}, {0, 0, 0}},
+};
+
+static STEERING_lut_t lut;
+
+/*******************************************************************
+ * SUITE SetUp
+ *******************************************************************/
+void setUp(void) {
+}
+
+/*******************************************************************
+ * SUITE TearDown
+ *******************************************************************/
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Lookup table equals the reference for all 4096 inputs
+ *******************************************************************/
+void test_lut_equivalence(void) {
+  for (const calibration_t &cal : calibrations) {
+    STEERING_lut_build(&lut, &cal.wheel, &cal.azimuth);
+
+    for (int adc = 0; adc < STEERING_LUT_SIZE; adc++) {
+      int linear = reference_linear(adc, cal.wheel.left, cal.wheel.middle, cal.wheel.right);
+      int output = reference_output(linear, cal.azimuth.low, cal.azimuth.middle, cal.azimuth.high);
+
+      TEST_ASSERT_EQUAL_MESSAGE(linear, lut.linear[adc], cal.name);
+      TEST_ASSERT_EQUAL_MESSAGE(output, lut.dac[adc], cal.name);
+    }
+  }
+}
+
+/*******************************************************************
+ * TC Single functions equal the reference
+ *******************************************************************/
+void test_functions_equivalence(void) {
+  for (const calibration_t &cal : calibrations) {
+    for (long value = -16; value <= LINEAR_MAX + 16; value++) {
+      TEST_ASSERT_EQUAL(reference_linear(value, cal.wheel.left, cal.wheel.middle, cal.wheel.right),
+                        STEERING_wheel_linear(&cal.wheel, value));
+      TEST_ASSERT_EQUAL(reference_output(value, cal.azimuth.low, cal.azimuth.middle, cal.azimuth.high),
+                        STEERING_azimuth_output(&cal.azimuth, value));
+    }
+  }
+}
+
+/*******************************************************************
+ * TC Cost per sample, map() math vs. table lookup
+ *******************************************************************/
+void test_benchmark(void) {
+  const calibration_t &cal = calibrations[1];
+  volatile long sink = 0;
+  char text[128];
+
+  STEERING_lut_build(&lut, &cal.wheel, &cal.azimuth);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+    for (int adc = 0; adc < STEERING_LUT_SIZE; adc++) {
+      int linear = reference_linear(adc, cal.wheel.left, cal.wheel.middle, cal.wheel.right);
+      sink = reference_output(linear, cal.azimuth.low, cal.azimuth.middle, cal.azimuth.high);
+    }
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+    for (int adc = 0; adc < STEERING_LUT_SIZE; adc++) {
+      sink = lut.dac[adc];
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+    STEERING_lut_build(&lut, &cal.wheel, &cal.azimuth);
+  }
+  auto build = std::chrono::steady_clock::now();
+  (void)sink;
+
+  double samples = (double)BENCHMARK_ROUNDS * STEERING_LUT_SIZE;
+  double map_ns = std::chrono::duration<double, std::nano>(middle - begin).count() / samples;
+  double lut_ns = std::chrono::duration<double, std::nano>(end - middle).count() / samples;
+  double build_us = std::chrono::duration<double, std::micro>(build - end).count() / BENCHMARK_ROUNDS;
+
+  snprintf(text, sizeof(text), "map(): %.2f ns/sample, table: %.2f ns/sample, table build: %.1f us",
+           map_ns, lut_ns, build_us);
+  TEST_MESSAGE(text);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_lut_equivalence);
+  RUN_TEST(test_functions_equivalence);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
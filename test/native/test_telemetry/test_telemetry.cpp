@@ -0,0 +1,204 @@
+/*******************************************************************
+ * test_telemetry.cpp
+ *
+ * Websocket telemetry cache, change detection, coalesced frames and
+ * tick statistics (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define FRAME_SIZE 256
+#define MS 1000  // Clock in microseconds
+
+static TELEM_cache_t cache;
+static char frame[FRAME_SIZE];
+static int malformed;  // Frames that are not one JSON object
+
+/* All frames of one tick, concatenated, returns the frame count */
+static int flush(char *text, bool all) {
+  uint16_t cursor = 0;
+  int frames = 0;
+  int length;
+
+  text[0] = '\0';
+  while ((length = TELEM_frame(&cache, frame, sizeof(frame), all, &cursor)) > 0) {
+    if ((frame[0] != '{') || (frame[length - 1] != '}') || (length != (int)strlen(frame))) {
+      malformed++;
+    }
+    strcat(text, frame);
+    frames++;
+  }
+  return frames;
+}
+
+void setUp(void) {
+  TELEM_init(&cache);
+  malformed = 0;
+}
+
+void tearDown(void) {
+  TEST_ASSERT_EQUAL(0, malformed);
+}
+
+/*******************************************************************
+ * TC Change detection
+ *******************************************************************/
+void test_change(void) {
+  TEST_ASSERT_EQUAL(1, TELEM_set(&cache, "lift_up", "true", false));
+  TEST_ASSERT_EQUAL(1, TELEM_set(&cache, "azimuth_actual", "512", false));
+  TEST_ASSERT_EQUAL(2, cache.num_keys);
+  TEST_ASSERT_EQUAL(2, cache.num_dirty);
+
+  /* Same value again before the tick, still dirty once */
+  TEST_ASSERT_EQUAL(1, TELEM_set(&cache, "lift_up", "true", false));
+  TEST_ASSERT_EQUAL(2, cache.num_dirty);
+  TEST_ASSERT_EQUAL_STRING("512", TELEM_get(&cache, "azimuth_actual"));
+  TEST_ASSERT_NULL(TELEM_get(&cache, "lift_down"));
+
+  char text[512];
+  TEST_ASSERT_EQUAL(1, flush(text, false));
+  TEST_ASSERT_EQUAL(0, cache.num_dirty);
+  TEST_ASSERT_NOT_NULL(strstr(text, "\"lift_up\":true"));
+  TEST_ASSERT_NOT_NULL(strstr(text, "\"azimuth_actual\":512"));
+
+  /* Unchanged values are not sent again, forced ones are */
+  TEST_ASSERT_EQUAL(0, TELEM_set(&cache, "lift_up", "true", false));
+  TEST_ASSERT_EQUAL(0, flush(text, false));
+  TEST_ASSERT_EQUAL(1, TELEM_set(&cache, "azimuth_actual", "513", false));
+  TEST_ASSERT_EQUAL(1, TELEM_set(&cache, "lift_up", "true", true));
+  TEST_ASSERT_EQUAL(1, flush(text, false));
+  TEST_ASSERT_EQUAL(strlen("{\"lift_up\":true,\"azimuth_actual\":513}"), strlen(text));  // Slot order
+  TEST_ASSERT_NOT_NULL(strstr(text, "\"lift_up\":true"));
+  TEST_ASSERT_NOT_NULL(strstr(text, "\"azimuth_actual\":513"));
+  TEST_ASSERT_EQUAL(1, cache.changed);
+  TEST_ASSERT_EQUAL(2, cache.unchanged);
+}
+
+/*******************************************************************
+ * TC A burst of changes is coalesced, split over frames that fit
+ *******************************************************************/
+void test_coalesce(void) {
+  char key[TELEM_KEY_MAX];
+  char value[TELEM_VALUE_MAX];
+  char text[4096];
+
+  for (int i = 0; i < 40; i++) {
+    snprintf(key, sizeof(key), "value_%02d", i);
+    snprintf(value, sizeof(value), "%d", i * 1000);
+    TEST_ASSERT_EQUAL(1, TELEM_set(&cache, key, value, false));
+  }
+
+  const int frames = flush(text, false);
+  TEST_ASSERT_GREATER_THAN(1, frames);
+  TEST_ASSERT_LESS_THAN(40 / 4, frames);  // Several pairs per frame
+  for (int i = 0; i < 40; i++) {
+    char pair[48];
+    snprintf(pair, sizeof(pair), "\"value_%02d\":%d", i, i * 1000);
+    TEST_ASSERT_NOT_NULL(strstr(text, pair));
+  }
+
+  /* A new client gets everything, nothing is left dirty */
+  TELEM_touch_all(&cache);
+  TEST_ASSERT_EQUAL(40, cache.num_dirty);
+  TEST_ASSERT_EQUAL(frames, flush(text, false));
+  TEST_ASSERT_EQUAL(frames, flush(text, true));
+  TEST_ASSERT_EQUAL(0, cache.num_dirty);
+}
+
+/*******************************************************************
+ * TC Limits
+ *******************************************************************/
+void test_limits(void) {
+  char key[TELEM_KEY_MAX + 8];
+  char value[TELEM_VALUE_MAX + 8];
+  uint16_t cursor = 0;
+
+  memset(key, 'k', sizeof(key));
+  key[TELEM_KEY_MAX] = '\0';
+  TEST_ASSERT_EQUAL(-1, TELEM_set(&cache, key, "1", false));
+  key[TELEM_KEY_MAX - 1] = '\0';
+  memset(value, '9', sizeof(value));
+  value[TELEM_VALUE_MAX - 1] = '\0';
+  TEST_ASSERT_EQUAL(1, TELEM_set(&cache, key, value, false));  // Longest pair fits a minimal frame
+  TEST_ASSERT_EQUAL(TELEM_FRAME_MIN - 1, TELEM_frame(&cache, frame, TELEM_FRAME_MIN, false, &cursor));
+  TEST_ASSERT_EQUAL(0, TELEM_frame(&cache, frame, TELEM_FRAME_MIN - 1, true, &cursor));
+
+  TELEM_init(&cache);
+  for (int i = 0; i < TELEM_MAX_SLOTS; i++) {
+    snprintf(key, sizeof(key), "k%d", i);
+    TEST_ASSERT_EQUAL(1, TELEM_set(&cache, key, "0", false));
+  }
+  TEST_ASSERT_EQUAL(-1, TELEM_set(&cache, "one_more", "0", false));
+  TEST_ASSERT_EQUAL(1, TELEM_set(&cache, "k7", "0", false));  // Existing keys still found, not sent yet
+  TEST_ASSERT_EQUAL(1, cache.rejected);
+}
+
+/*******************************************************************
+ * TC Statistics
+ *******************************************************************/
+void test_stats(void) {
+  TELEM_stats_t stats;
+
+  TELEM_stats_init(&stats, 1000 * MS, 0);
+  for (int tick = 1; tick <= 10; tick++) {
+    TELEM_stats_tick(&stats, 1, 200, 10, 50 + tick, tick * 100 * MS);
+  }
+  TEST_ASSERT_EQUAL(10, stats.ticks);
+  TEST_ASSERT_EQUAL(10, stats.frames);
+  TEST_ASSERT_EQUAL(2000, stats.bytes);
+  TEST_ASSERT_EQUAL(100, stats.pairs);
+  TEST_ASSERT_EQUAL(60, stats.serialize_last);
+  TEST_ASSERT_EQUAL(60, stats.serialize_max);
+  TEST_ASSERT_EQUAL(2000, stats.byte_rate);
+}
+
+/*******************************************************************
+ * TC Frames per tick, one frame per changed key before
+ *******************************************************************/
+void test_frames_per_tick(void) {
+  const char *keys[] = {"lift_up",        "lift_down",       "lift_home",        "lift_enabled",
+                        "azimuth_actual", "azimuth_manual",  "azimuth_enabled",  "azimuth_home",
+                        "steerwheel_actual", "steerwheel_linear", "emergency_stop", "maintenance_enabled",
+                        "dmc_rpm",        "dmc_current",     "dmc_voltage",      "dmc_temperature",
+                        "can_twai_load",  "can_twai_state",  "can_twai_verdict", "can_twai_bus_offs"};
+  const int num_keys = sizeof(keys) / sizeof(keys[0]);
+  char value[16];
+  char text[2048];
+  int bytes = 0;
+  int pair_bytes = 0;
+
+  for (int i = 0; i < num_keys; i++) {
+    snprintf(value, sizeof(value), "%d", 100 + i);
+    TELEM_set(&cache, keys[i], value, false);
+    pair_bytes += (int)strlen(keys[i]) + (int)strlen(value) + 5;  // {"":}
+  }
+
+  const int frames = flush(text, false);
+  bytes = (int)strlen(text);
+  TEST_ASSERT_LESS_THAN(num_keys, frames);
+  TEST_ASSERT_LESS_THAN(pair_bytes, bytes);
+
+  snprintf(text, sizeof(text), "%d changed keys: %d frame(s), %d bytes (was %d frames, %d bytes)", num_keys, frames,
+           bytes, num_keys, pair_bytes);
+  TEST_MESSAGE(text);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_change);
+  RUN_TEST(test_coalesce);
+  RUN_TEST(test_limits);
+  RUN_TEST(test_stats);
+  RUN_TEST(test_frames_per_tick);
+  return UNITY_END();
+}
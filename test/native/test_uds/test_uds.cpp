@@ -0,0 +1,394 @@
+/*******************************************************************
+ * test_uds.cpp
+ *
+ * UDS diagnostic server: services, sessions, negative responses and
+ * streamed DID transfers over an ISO-TP loopback
+ * (host, pio test -e native)
+ *
+ *******************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "EBC_Utils.h"
+
+/*******************************************************************
+ * Definitions
+ *******************************************************************/
+#define S3_US 5000000
+#define BLOCK_LENGTH 300  // Read only DID, several hundred bytes
+#define TABLE_LENGTH 20   // Writable DID, multi-frame write
+#define VALUE_MAX 1000
+#define TESTER_ID 0x7E0
+#define ECU_ID 0x7E8
+#define BUS_QUEUE 64
+
+static UDS_server_t server;
+static int32_t value;
+static int32_t staged;
+static uint8_t table[TABLE_LENGTH];
+static uint8_t table_staged[TABLE_LENGTH];
+static uint32_t routine_runs;
+static uint8_t response[512];
+
+/*******************************************************************
+ * DIDs and routines
+ *******************************************************************/
+static void value_read(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  (void)context;
+  for (uint16_t i = 0; i < length; i++) {
+    data[i] = (uint8_t)(value >> (8 * (3 - (offset + i))));
+  }
+}
+
+static void value_write(uint16_t offset, const uint8_t *data, uint16_t length, void *context) {
+  (void)context;
+  for (uint16_t i = 0; i < length; i++) {
+    const int shift = 8 * (3 - (offset + i));
+    staged = (int32_t)(((uint32_t)staged & ~(0xFFu << shift)) | ((uint32_t)data[i] << shift));
+  }
+}
+
+static uint8_t value_commit(void *context) {
+  (void)context;
+  if ((staged < 0) || (staged > VALUE_MAX)) {
+    return UDS_NRC_OUT_OF_RANGE;
+  }
+  value = staged;
+  return 0;
+}
+
+static void block_read(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  (void)context;
+  for (uint16_t i = 0; i < length; i++) {
+    data[i] = (uint8_t)((offset + i) * 3);
+  }
+}
+
+static void table_read(uint16_t offset, uint8_t *data, uint16_t length, void *context) {
+  memcpy(data, (const uint8_t *)context + offset, length);
+}
+
+static void table_write(uint16_t offset, const uint8_t *data, uint16_t length, void *context) {
+  (void)context;
+  memcpy(&table_staged[offset], data, length);
+}
+
+static uint8_t table_commit(void *context) {
+  memcpy(context, table_staged, TABLE_LENGTH);
+  return 0;
+}
+
+static uint8_t count_routine(uint8_t control, uint8_t *result, uint8_t *length, void *context) {
+  uint32_t *runs = (uint32_t *)context;
+
+  switch (control) {
+    case UDS_ROUTINE_START:
+      (*runs)++;
+      *length = 0;
+      return 0;
+    case UDS_ROUTINE_RESULTS:
+      result[0] = (uint8_t)*runs;
+      *length = 1;
+      return 0;
+    default:
+      return UDS_NRC_CONDITIONS_NOT_CORRECT;
+  }
+}
+
+static const UDS_did_t dids[] = {
+    {0x0100, "value", 4, value_read, value_write, value_commit, nullptr},
+    {0x0200, "block", BLOCK_LENGTH, block_read, nullptr, nullptr, nullptr},
+    {0x0300, "table", TABLE_LENGTH, table_read, table_write, table_commit, table},
+};
+
+static const UDS_routine_t routines[] = {
+    {0x0201, "count", count_routine, &routine_runs},
+};
+
+/*******************************************************************
+ * Request and response as ISO-TP delivers them, 6 then 7 bytes
+ *******************************************************************/
+static uint16_t request(const uint8_t *data, uint16_t length, uint32_t now) {
+  uint16_t offset = 0;
+
+  while (offset < length) {
+    uint16_t chunk = (length <= 7) ? length : ((offset == 0) ? 6 : 7);
+    if (chunk > length - offset) {
+      chunk = length - offset;
+    }
+    if (!UDS_request_data(offset, &data[offset], (uint8_t)chunk, length, &server)) {
+      return 0xFFFF;
+    }
+    offset += chunk;
+  }
+
+  const uint16_t response_length = UDS_request_done(&server, now);
+  for (offset = 0; offset < response_length; offset += 7) {
+    const uint8_t chunk = (response_length - offset > 7) ? 7 : (uint8_t)(response_length - offset);
+    UDS_response_data(offset, &response[offset], chunk, &server);
+  }
+  UDS_response_done(&server);
+  return response_length;
+}
+
+void setUp(void) {
+  value = 42;
+  routine_runs = 0;
+  memset(table, 0, sizeof(table));
+  UDS_init(&server, dids, 3, routines, 1, S3_US);
+}
+
+void tearDown(void) {
+}
+
+/*******************************************************************
+ * TC Read data by identifier, negative responses
+ *******************************************************************/
+void test_read(void) {
+  const uint8_t read_value[] = {0x22, 0x01, 0x00};
+  const uint8_t read_unknown[] = {0x22, 0x01, 0x01};
+  const uint8_t read_two[] = {0x22, 0x01, 0x00, 0x02, 0x00};
+  const uint8_t unknown_service[] = {0x27, 0x01};
+
+  TEST_ASSERT_EQUAL(7, request(read_value, sizeof(read_value), 0));
+  const uint8_t expected[] = {0x62, 0x01, 0x00, 0x00, 0x00, 0x00, 42};
+  TEST_ASSERT_EQUAL_MEMORY(expected, response, sizeof(expected));
+
+  TEST_ASSERT_EQUAL(3, request(read_unknown, sizeof(read_unknown), 0));
+  TEST_ASSERT_EQUAL(UDS_NEGATIVE_RESPONSE, response[0]);
+  TEST_ASSERT_EQUAL(UDS_SID_READ_DID, response[1]);
+  TEST_ASSERT_EQUAL(UDS_NRC_OUT_OF_RANGE, response[2]);
+
+  TEST_ASSERT_EQUAL(3, request(read_two, sizeof(read_two), 0));
+  TEST_ASSERT_EQUAL(UDS_NRC_INCORRECT_LENGTH, response[2]);
+
+  TEST_ASSERT_EQUAL(3, request(unknown_service, sizeof(unknown_service), 0));
+  TEST_ASSERT_EQUAL(UDS_NRC_SERVICE_NOT_SUPPORTED, response[2]);
+
+  TEST_ASSERT_EQUAL(4, server.requests);
+  TEST_ASSERT_EQUAL(3, server.negative);
+}
+
+/*******************************************************************
+ * TC Sessions, write data by identifier
+ *******************************************************************/
+void test_write(void) {
+  const uint8_t write_value[] = {0x2E, 0x01, 0x00, 0x00, 0x00, 0x01, 0xF4};
+  const uint8_t write_range[] = {0x2E, 0x01, 0x00, 0x00, 0x00, 0x13, 0x88};
+  const uint8_t write_short[] = {0x2E, 0x01, 0x00, 0x00, 0x01};
+  const uint8_t write_block[] = {0x2E, 0x02, 0x00, 0x00};
+  const uint8_t extended[] = {0x10, 0x03};
+  const uint8_t tester_present[] = {0x3E, 0x80};
+
+  TEST_ASSERT_EQUAL(3, request(write_value, sizeof(write_value), 0));
+  TEST_ASSERT_EQUAL(UDS_NRC_NOT_IN_SESSION, response[2]);
+  TEST_ASSERT_EQUAL(42, value);
+
+  TEST_ASSERT_EQUAL(6, request(extended, sizeof(extended), 0));
+  const uint8_t session[] = {0x50, 0x03, 0x00, 0x32, 0x01, 0xF4};
+  TEST_ASSERT_EQUAL_MEMORY(session, response, sizeof(session));
+
+  TEST_ASSERT_EQUAL(3, request(write_value, sizeof(write_value), 1000));
+  TEST_ASSERT_EQUAL(0x6E, response[0]);
+  TEST_ASSERT_EQUAL(500, value);
+
+  TEST_ASSERT_EQUAL(3, request(write_range, sizeof(write_range), 2000));
+  TEST_ASSERT_EQUAL(UDS_NRC_OUT_OF_RANGE, response[2]);
+  TEST_ASSERT_EQUAL(500, value);
+
+  TEST_ASSERT_EQUAL(3, request(write_short, sizeof(write_short), 3000));
+  TEST_ASSERT_EQUAL(UDS_NRC_INCORRECT_LENGTH, response[2]);
+
+  TEST_ASSERT_EQUAL(3, request(write_block, sizeof(write_block), 4000));
+  TEST_ASSERT_EQUAL(UDS_NRC_OUT_OF_RANGE, response[2]);  // Read only
+
+  /* Tester present without response keeps the session */
+  TEST_ASSERT_EQUAL(0, request(tester_present, sizeof(tester_present), S3_US));
+  UDS_poll(&server, 2 * S3_US - 1);
+  TEST_ASSERT_EQUAL(UDS_SESSION_EXTENDED, server.session);
+  UDS_poll(&server, 2 * S3_US);
+  TEST_ASSERT_EQUAL(UDS_SESSION_DEFAULT, server.session);
+}
+
+/*******************************************************************
+ * TC Routine control
+ *******************************************************************/
+void test_routine(void) {
+  const uint8_t extended[] = {0x10, 0x83};  // No response
+  const uint8_t start[] = {0x31, 0x01, 0x02, 0x01};
+  const uint8_t stop[] = {0x31, 0x02, 0x02, 0x01};
+  const uint8_t results[] = {0x31, 0x03, 0x02, 0x01};
+  const uint8_t unknown[] = {0x31, 0x01, 0x02, 0x02};
+  const uint8_t control[] = {0x31, 0x04, 0x02, 0x01};
+
+  TEST_ASSERT_EQUAL(3, request(start, sizeof(start), 0));
+  TEST_ASSERT_EQUAL(UDS_NRC_NOT_IN_SESSION, response[2]);
+
+  TEST_ASSERT_EQUAL(0, request(extended, sizeof(extended), 0));
+  TEST_ASSERT_EQUAL(4, request(start, sizeof(start), 0));
+  TEST_ASSERT_EQUAL(4, request(start, sizeof(start), 0));
+  const uint8_t started[] = {0x71, 0x01, 0x02, 0x01};
+  TEST_ASSERT_EQUAL_MEMORY(started, response, sizeof(started));
+
+  TEST_ASSERT_EQUAL(5, request(results, sizeof(results), 0));
+  TEST_ASSERT_EQUAL(2, response[4]);
+
+  TEST_ASSERT_EQUAL(3, request(stop, sizeof(stop), 0));
+  TEST_ASSERT_EQUAL(UDS_NRC_CONDITIONS_NOT_CORRECT, response[2]);
+  TEST_ASSERT_EQUAL(3, request(unknown, sizeof(unknown), 0));
+  TEST_ASSERT_EQUAL(UDS_NRC_OUT_OF_RANGE, response[2]);
+  TEST_ASSERT_EQUAL(3, request(control, sizeof(control), 0));
+  TEST_ASSERT_EQUAL(UDS_NRC_SUBFUNCTION_NOT_SUPPORTED, response[2]);
+}
+
+/*******************************************************************
+ * ISO-TP loopback, tester and server on one bus
+ *******************************************************************/
+typedef struct {
+  CAN_frame_t frame[BUS_QUEUE];
+  int head;
+  int count;
+} bus_t;
+
+static bus_t bus;
+static ISOTP_link_t tester_link;
+static ISOTP_link_t server_link;
+static const uint8_t *tester_request;
+static uint16_t tester_received;
+static bool tester_done;
+
+static bool bus_send(const CAN_frame_t *frame, void *context) {
+  (void)context;
+  if (bus.count >= BUS_QUEUE) {
+    return false;
+  }
+  bus.frame[(bus.head + bus.count++) % BUS_QUEUE] = *frame;
+  return true;
+}
+
+static void tester_source(uint16_t offset, uint8_t *data, uint8_t length, void *context) {
+  (void)context;
+  memcpy(data, &tester_request[offset], length);
+}
+
+static bool tester_sink(uint16_t offset, const uint8_t *data, uint8_t length, uint16_t total, void *context) {
+  (void)total;
+  (void)context;
+  memcpy(&response[offset], data, length);
+  tester_received = offset + length;
+  return true;
+}
+
+static void tester_done_fn(bool tx, ISOTP_result_t result, void *context) {
+  (void)context;
+  if (!tx && (result == ISOTP_OK)) {
+    tester_done = true;
+  }
+}
+
+/* Glue of the target: complete request in, response out */
+static void server_done(bool tx, ISOTP_result_t result, void *context) {
+  (void)context;
+  if (tx) {
+    UDS_response_done(&server);
+    return;
+  }
+  if (result == ISOTP_OK) {
+    const uint16_t length = UDS_request_done(&server, 0);
+    if (length) {
+      ISOTP_send(&server_link, length, 0);
+    }
+  }
+}
+
+static void loopback_init(void) {
+  ISOTP_config_t config = {};
+
+  memset(&bus, 0, sizeof(bus));
+  config.tx_id = TESTER_ID;
+  config.rx_id = ECU_ID;
+  config.padding = 0xAA;
+  config.timeout = 1000000;
+  config.send = bus_send;
+  config.source = tester_source;
+  config.sink = tester_sink;
+  config.done = tester_done_fn;
+  ISOTP_init(&tester_link, &config);
+
+  config.tx_id = ECU_ID;
+  config.rx_id = TESTER_ID;
+  config.block_size = 4;
+  config.source = UDS_response_data;
+  config.sink = UDS_request_data;
+  config.done = server_done;
+  config.context = &server;
+  ISOTP_init(&server_link, &config);
+}
+
+static uint16_t transfer(const uint8_t *data, uint16_t length) {
+  tester_request = data;
+  tester_received = 0;
+  tester_done = false;
+  ISOTP_send(&tester_link, length, 0);
+
+  for (int step = 0; (step < 10000) && !tester_done; step++) {
+    while (bus.count) {
+      CAN_frame_t frame = bus.frame[bus.head];
+      bus.head = (bus.head + 1) % BUS_QUEUE;
+      bus.count--;
+      ISOTP_receive(&tester_link, &frame, 0);
+      ISOTP_receive(&server_link, &frame, 0);
+    }
+    ISOTP_poll(&tester_link, 0);
+    ISOTP_poll(&server_link, 0);
+  }
+  return tester_done ? tester_received : 0;
+}
+
+/*******************************************************************
+ * TC Streamed multi-frame read and write over ISO-TP
+ *******************************************************************/
+void test_isotp_loopback(void) {
+  const uint8_t read_block[] = {0x22, 0x02, 0x00};
+  const uint8_t extended[] = {0x10, 0x03};
+  uint8_t write_table[3 + TABLE_LENGTH] = {0x2E, 0x03, 0x00};
+  const uint8_t read_table[] = {0x22, 0x03, 0x00};
+
+  loopback_init();
+
+  TEST_ASSERT_EQUAL(3 + BLOCK_LENGTH, transfer(read_block, sizeof(read_block)));
+  TEST_ASSERT_EQUAL(0x62, response[0]);
+  for (int i = 0; i < BLOCK_LENGTH; i++) {
+    TEST_ASSERT_EQUAL((uint8_t)(i * 3), response[3 + i]);
+  }
+  TEST_ASSERT_FALSE(server.responding);
+
+  TEST_ASSERT_EQUAL(6, transfer(extended, sizeof(extended)));
+  for (int i = 0; i < TABLE_LENGTH; i++) {
+    write_table[3 + i] = (uint8_t)(0xA0 + i);
+  }
+  TEST_ASSERT_EQUAL(3, transfer(write_table, sizeof(write_table)));
+  TEST_ASSERT_EQUAL(0x6E, response[0]);
+  TEST_ASSERT_EQUAL_MEMORY(&write_table[3], table, TABLE_LENGTH);
+
+  TEST_ASSERT_EQUAL(3 + TABLE_LENGTH, transfer(read_table, sizeof(read_table)));
+  TEST_ASSERT_EQUAL_MEMORY(&write_table[3], &response[3], TABLE_LENGTH);
+
+  /* A request while the response is being sent is refused */
+  server.responding = true;
+  TEST_ASSERT_FALSE(UDS_request_data(0, read_table, sizeof(read_table), sizeof(read_table), &server));
+  TEST_ASSERT_EQUAL(1, server.busy);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(test_read);
+  RUN_TEST(test_write);
+  RUN_TEST(test_routine);
+  RUN_TEST(test_isotp_loopback);
+  return UNITY_END();
+}